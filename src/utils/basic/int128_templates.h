@@ -35,9 +35,15 @@
 // 128 bit integer is not added to standard
 // Adding some trait expressions to handle 128 bits
 //
+// libstdc++ (GCC 5+) defines integral traits & hash for __int128 when
+// __GLIBCXX_TYPE_INT_N_0 is defined i.e. in non strict (gnu++) modes.
+// libstdc++ (GCC 11+) defines numeric_limits for __int128 in all modes.
+// Traits already defined by the library are not redefined.
+//
 namespace std {
 //-----------------------------------------------------------------------------
 
+#ifndef __GLIBCXX_TYPE_INT_N_0
 //
 // IsArithmetic which derives from IsIntegralType:
 // GCC 4.8 already supports __int128 but only 
@@ -65,7 +71,9 @@ struct hash<asarcar::uint128_t> {
     return (value & std::numeric_limits<uint64_t>::max()) ^ (value >> 64);
   }
 };  
+#endif // __GLIBCXX_TYPE_INT_N_0
 
+#if !defined(_GLIBCXX_RELEASE) || (_GLIBCXX_RELEASE < 11)
 // numeric_limits
 template <>
 struct numeric_limits<asarcar::int128_t> {
@@ -89,6 +97,7 @@ struct numeric_limits<asarcar::uint128_t> {
   }
 
 };
+#endif // _GLIBCXX_RELEASE
 
 //-----------------------------------------------------------------------------
 } // namespace std
@@ -0,0 +1,218 @@
+// Copyright 2016 asarcar Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+//! @file     slab_alloc.h
+//! @brief    Allocation policies for node based containers
+//! @detail   A container parameterized by an allocation policy creates
+//!           objects with Alloc::New<T>(args...) and owns them with
+//!           std::unique_ptr<T, Alloc::Deleter<T>>. Deleter is stateless
+//!           so the unique_ptr stays the size of a pointer.
+//!           1. HeapAlloc: every object is a separate new/delete.
+//!           2. SlabAlloc: objects are carved out of CHUNK_SIZE chunks
+//!              aligned to CHUNK_SIZE. A chunk serves a single size class
+//!              (slab). Freed slots are kept in a per chunk free list and
+//!              reused. The chunk header is found by masking the object
+//!              address, so Deleter needs no reference to the allocator.
+//!              Clear releases all chunks in O(#chunks) without running
+//!              destructors of live objects: the container is expected to
+//!              drop its (unique) pointers to them with release().
+//!           Neither policy is thread safe.
+//! @author   Arijit Sarcar <sarcar_a@yahoo.com>
+
+#ifndef _UTILS_BASIC_SLAB_ALLOC_H_
+#define _UTILS_BASIC_SLAB_ALLOC_H_
+
+// C++ Standard Headers
+#include <array>            // std::array
+#include <cstddef>          // std::max_align_t
+#include <memory>           // std::unique_ptr
+#include <new>              // placement new
+#include <utility>          // std::forward
+#include <vector>           // std::vector
+// C Standard Headers
+#include <cstdlib>          // posix_memalign
+// Google Headers
+#include <glog/logging.h>   // CHECK
+// Local Headers
+#include "utils/basic/basictypes.h"
+
+namespace asarcar {
+//-----------------------------------------------------------------------------
+
+class HeapAlloc {
+ public:
+  // Clear does not release memory of live objects
+  static constexpr bool BULK_FREE = false;
+  template <typename T>
+  using Deleter = std::default_delete<T>;
+
+  HeapAlloc() = default;
+  ~HeapAlloc() = default;
+  HeapAlloc(const HeapAlloc&)             = delete;
+  HeapAlloc& operator =(const HeapAlloc&) = delete;
+  HeapAlloc(HeapAlloc&&)                  = default;
+  HeapAlloc& operator =(HeapAlloc&&)      = default;
+
+  template <typename T, typename... Args>
+  inline T* New(Args&&... args) {
+    return new T(std::forward<Args>(args)...);
+  }
+  inline void Clear() {}
+  inline void Splice(HeapAlloc*) {}
+  // Bytes used: live bytes as reported by the container
+  inline size_t MemSize(size_t live_bytes) const { return live_bytes; }
+};
+
+class SlabAlloc {
+ public:
+  // Clear releases memory of live objects
+  static constexpr bool   BULK_FREE     = true;
+  static constexpr size_t CHUNK_SIZE    = 1 << 16;
+  static constexpr size_t ALIGN         = alignof(std::max_align_t);
+  static constexpr size_t NUM_CLASSES   = 16;
+  static constexpr size_t MAX_OBJ_SIZE  = NUM_CLASSES*ALIGN;
+
+  template <typename T>
+  struct Deleter {
+    inline void operator()(T* p) const {
+      p->~T();
+      SlabAlloc::Free(p);
+    }
+  };
+
+  SlabAlloc() : state_p_{new State{}} {}
+  ~SlabAlloc() { if (state_p_ != nullptr) Clear(); }
+  SlabAlloc(const SlabAlloc&)             = delete;
+  SlabAlloc& operator =(const SlabAlloc&) = delete;
+  // Chunks refer to the (heap allocated) state: moves keep them valid
+  SlabAlloc(SlabAlloc&&)                  = default;
+  SlabAlloc& operator =(SlabAlloc&&)      = delete;
+
+  template <typename T, typename... Args>
+  inline T* New(Args&&... args) {
+    static_assert(sizeof(T) <= MAX_OBJ_SIZE, "object too large for slab");
+    static_assert(alignof(T) <= ALIGN, "object alignment exceeds slab's");
+    return new (Allocate(ClassOf(sizeof(T)))) T(std::forward<Args>(args)...);
+  }
+  // Releases all chunks: live objects are not destroyed
+  inline void Clear() {
+    for (Chunk* c : state_p_->chunks)
+      free(c);
+    state_p_->chunks.clear();
+    state_p_->classes = {};
+  }
+  // Takes over chunks of other_p i.e. objects allocated by other_p are
+  // now owned by this: O(#chunks)
+  inline void Splice(SlabAlloc* other_p) {
+    State& other = *other_p->state_p_;
+    for (Chunk* c : other.chunks) {
+      c->state_p = state_p_.get();
+      state_p_->chunks.push_back(c);
+    }
+    for (size_t sc=0; sc<other.classes.size(); ++sc) {
+      Chunk* c = other.classes[sc].partial_p;
+      while (c != nullptr) {
+        Chunk* next_p = c->partial_p;
+        c->partial_p = state_p_->classes[sc].partial_p;
+        state_p_->classes[sc].partial_p = c;
+        c = next_p;
+      }
+    }
+    other.chunks.clear();
+    other.classes = {};
+  }
+  inline size_t NumChunks() const { return state_p_->chunks.size(); }
+  // Bytes used: all chunks irrespective of live bytes
+  inline size_t MemSize(size_t = 0) const { return NumChunks()*CHUNK_SIZE; }
+
+ private:
+  struct Slot { Slot* next_p; };
+  struct State;
+  // Header at the start of every chunk
+  struct alignas(ALIGN) Chunk {
+    State*  state_p;
+    size_t  size_class;
+    Slot*   free_p;      // freed slots
+    char*   bump_p;      // never allocated slots start here
+    Chunk*  partial_p;   // next chunk of size class with free slots
+    bool    partial;     // in partial list of size class
+  };
+  struct SlabList {
+    Chunk*  current_p = nullptr; // chunk bump allocated from
+    Chunk*  partial_p = nullptr; // chunks with freed slots
+  };
+  struct State {
+    std::vector<Chunk*>                     chunks;
+    std::array<SlabList, NUM_CLASSES + 1>   classes;
+  };
+  std::unique_ptr<State> state_p_;
+
+  static inline size_t ClassOf(size_t size) {
+    return (size + ALIGN - 1)/ALIGN;
+  }
+  static inline char* ChunkEnd(Chunk* c) {
+    return reinterpret_cast<char*>(c) + CHUNK_SIZE;
+  }
+
+  inline void* Allocate(size_t sc) {
+    SlabList& cls = state_p_->classes[sc];
+    // Reuse freed slot
+    while (cls.partial_p != nullptr) {
+      Chunk* c = cls.partial_p;
+      if (c->free_p != nullptr) {
+        Slot* s = c->free_p;
+        c->free_p = s->next_p;
+        return s;
+      }
+      c->partial = false;
+      cls.partial_p = c->partial_p;
+    }
+    // Bump allocate: start new chunk when current is exhausted
+    Chunk* c = cls.current_p;
+    if ((c == nullptr) || (c->bump_p + sc*ALIGN > ChunkEnd(c)))
+      c = cls.current_p = NewChunk(sc);
+    void* p = c->bump_p;
+    c->bump_p += sc*ALIGN;
+    return p;
+  }
+  inline Chunk* NewChunk(size_t sc) {
+    void* mem_p = nullptr;
+    CHECK_EQ(posix_memalign(&mem_p, CHUNK_SIZE, CHUNK_SIZE), 0)
+        << "slab chunk allocation failed";
+    Chunk* c = new (mem_p) Chunk{state_p_.get(), sc, nullptr,
+                                 reinterpret_cast<char*>(mem_p) + sizeof(Chunk),
+                                 nullptr, false};
+    state_p_->chunks.push_back(c);
+    return c;
+  }
+  static inline void Free(void* p) {
+    Chunk* c = reinterpret_cast<Chunk*>(
+        reinterpret_cast<uintptr_t>(p) & ~(CHUNK_SIZE - 1));
+    Slot*  s = static_cast<Slot*>(p);
+    s->next_p = c->free_p;
+    c->free_p = s;
+    if (!c->partial) {
+      SlabList& cls = c->state_p->classes[c->size_class];
+      c->partial   = true;
+      c->partial_p = cls.partial_p;
+      cls.partial_p = c;
+    }
+  }
+};
+
+//-----------------------------------------------------------------------------
+} // namespace asarcar
+
+#endif // _UTILS_BASIC_SLAB_ALLOC_H_
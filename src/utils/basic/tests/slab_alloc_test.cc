@@ -0,0 +1,134 @@
+// Copyright 2016 asarcar Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Author: Arijit Sarcar <sarcar_a@yahoo.com>
+
+// Standard C++ Headers
+#include <iostream>
+#include <memory>           // std::unique_ptr
+#include <set>              // std::set
+#include <vector>           // std::vector
+// Standard C Headers
+// Google Headers
+#include <glog/logging.h>   
+// Local Headers
+#include "utils/basic/basictypes.h"
+#include "utils/basic/init.h"
+#include "utils/basic/slab_alloc.h"
+
+using namespace asarcar;
+using namespace std;
+
+// Flag Declarations
+DECLARE_bool(auto_test);
+
+class SlabAllocTester {
+ public:
+  void Run(void) {
+    // Objects of different sizes are aligned & owned by a pointer sized
+    // unique_ptr
+    {
+      SlabAlloc a{};
+      UPtr<Small> s_p{a.New<Small>(1)};
+      UPtr<Large> l_p{a.New<Large>(2)};
+      CHECK_EQ(sizeof(s_p), sizeof(Small*));
+      CHECK_EQ(s_p->val, 1);
+      CHECK_EQ(l_p->val, 2);
+      CHECK_EQ(reinterpret_cast<uintptr_t>(l_p.get()) % SlabAlloc::ALIGN, 0);
+      CHECK_EQ(a.NumChunks(), 2); // one slab per size class
+    }
+
+    // Destructor runs when unique_ptr is destroyed. Freed slots are
+    // reused before new chunks are allocated.
+    {
+      SlabAlloc            a{};
+      vector<UPtr<Small>>  v;
+      int                  num_dtor = Small::num_dtor;
+      for (int i=0; i<kNumObjs; ++i)
+        v.emplace_back(a.New<Small>(i));
+      size_t num_chunks = a.NumChunks();
+      CHECK_GT(num_chunks, 1);
+      CHECK_EQ(a.MemSize(), num_chunks*SlabAlloc::CHUNK_SIZE);
+
+      set<Small*> freed;
+      for (int i=0; i<kNumObjs; i+=2) {
+        freed.insert(v.at(i).get());
+        v.at(i).reset(nullptr);
+      }
+      CHECK_EQ(Small::num_dtor, num_dtor + kNumObjs/2);
+      for (int i=0; i<kNumObjs; i+=2) {
+        v.at(i).reset(a.New<Small>(i));
+        CHECK(freed.count(v.at(i).get()) == 1);
+      }
+      CHECK_EQ(a.NumChunks(), num_chunks);
+      for (int i=0; i<kNumObjs; ++i)
+        CHECK_EQ(v.at(i)->val, i);
+
+      // Bulk free: destructors do not run
+      for (auto& p : v)
+        p.release();
+      a.Clear();
+      CHECK_EQ(a.NumChunks(), 0);
+      CHECK_EQ(Small::num_dtor, num_dtor + kNumObjs/2);
+
+      UPtr<Small> s_p{a.New<Small>(7)};
+      CHECK_EQ(s_p->val, 7);
+    }
+
+    // HeapAlloc policy
+    {
+      HeapAlloc   a{};
+      int         num_dtor = Small::num_dtor;
+      {
+        std::unique_ptr<Small, HeapAlloc::Deleter<Small>> s_p{a.New<Small>(3)};
+        CHECK_EQ(s_p->val, 3);
+      }
+      CHECK_EQ(Small::num_dtor, num_dtor + 1);
+      CHECK_EQ(a.MemSize(64), 64);
+    }
+
+    LOG(INFO) << "SlabAlloc Tests Passed";
+  }
+
+ private:
+  static constexpr int kNumObjs = 10000;
+  struct Small {
+    static int num_dtor;
+    int val;
+    explicit Small(int v) : val{v} {}
+    ~Small() { ++num_dtor; }
+  };
+  struct Large {
+    int  val;
+    char buf[200];
+    explicit Large(int v) : val{v} {}
+  };
+  template <typename T>
+  using UPtr = std::unique_ptr<T, SlabAlloc::Deleter<T>>;
+};
+
+constexpr int SlabAllocTester::kNumObjs;
+int SlabAllocTester::Small::num_dtor = 0;
+
+int main(int argc, char **argv) {
+  Init::InitEnv(&argc, &argv);
+
+  SlabAllocTester tester;
+  tester.Run();
+
+  return 0;
+}
+
+DEFINE_bool(auto_test, false, 
+            "test run programmatically (when true) or manually (when false)");
@@ -0,0 +1,203 @@
+// Copyright 2016 asarcar Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Author: Arijit Sarcar <sarcar_a@yahoo.com>
+
+// Standard C++ Headers
+#include <sstream>      // ostringstream
+#include <thread>       // this_thread::yield
+// Standard C Headers
+// Google Headers
+#include <glog/logging.h>
+// Local Headers
+#include "utils/concur/barrier.h"
+
+using namespace std;
+
+namespace asarcar { namespace utils { namespace concur {
+//-----------------------------------------------------------------------------
+
+namespace {
+// Busy waits until done(*word_p) holds. Parties of a bulk synchronous
+// phase typically arrive close together: spin for a short duration before
+// yielding and finally sleeping on the futex. Spinning on a uniprocessor
+// only delays the party we are waiting for: sleep right away.
+template <typename Pred>
+void SpinThenWait(atomic_int* word_p, Futex* f_p, Pred done) {
+  static const int kMaxSpins = (thread::hardware_concurrency() > 1) ? 1000 : 0;
+  for (int num_iter=0; num_iter < kMaxSpins; ++num_iter) {
+    if (done(word_p->load()))
+      return;
+    // pause: prevents speculative execution and the branch mispredict
+    // penalty when we leave the loop (see SpinLock::lock)
+    __asm volatile ("pause" ::: "memory");
+  }
+
+  this_thread::yield();
+
+  // Wait on futex only with the value that was observed to not satisfy
+  // done: if the word changed in between, FUTEX_WAIT returns immediately
+  // and we reevaluate. Otherwise, we are guaranteed to be woken up as
+  // the releasing party changes the word before it calls Wake.
+  for (int saved = word_p->load(); !done(saved); saved = word_p->load())
+    f_p->Wait(saved);
+}
+
+// Releasing party wakes all sleepers: the futex syscall is skipped when no
+// one sleeps. Safe as the word was modified (seq_cst) before num_ is read,
+// and a sleeper increments num_ (seq_cst) before it checks the word.
+inline void WakeAll(Futex* f_p) {
+  if (f_p->Num() > 0)
+    PCHECK(f_p->Wake(true) >= 0);
+}
+} // namespace
+
+//-----------------------------------------------------------------------------
+// Latch
+//-----------------------------------------------------------------------------
+// A waiter spinning on count_ may return & destroy the latch as soon as
+// count_ reaches zero i.e. before the last CountDown reads f_ to wake
+// sleepers. wakers_ is incremented before count_ is decremented & is
+// decremented after f_ is last accessed: Wait returns only once it drains.
+void Latch::CountDown(int n) {
+  DCHECK_GT(n, 0);
+  ++wakers_;
+  int val = (count_ -= n);
+  DCHECK_GE(val, 0) << "Latch counted down below zero";
+  if (val == 0)
+    WakeAll(&f_);
+  --wakers_; // latch may be destroyed hereafter
+}
+
+void Latch::Wait(void) {
+  SpinThenWait(&count_, &f_, [](int val) { return val == 0; });
+  // every CountDown incremented wakers_ before count_ reached zero:
+  // remaining ones are at most a FUTEX_WAKE away from leaving
+  while (wakers_ > 0)
+    this_thread::yield();
+}
+
+string Latch::to_string(void) {
+  ostringstream oss;
+  oss << "Latch: count=" << count_ << ": wakers=" << wakers_
+      << ": futex=" << f_.to_string();
+  return oss.str();
+}
+
+ostream& operator<<(ostream& os, Latch& l) {
+  os << l.to_string();
+  return os;
+}
+
+//-----------------------------------------------------------------------------
+// Barrier
+//-----------------------------------------------------------------------------
+bool Barrier::ArriveAndWait(void) {
+  // Phase has to be read before we arrive: the last party may advance
+  // the phase as soon as we arrive
+  int phase = phase_;
+
+  if (arrived_.fetch_add(1) + 1 < parties_) {
+    SpinThenWait(&phase_, &f_, [phase](int val) { return val != phase; });
+    return false;
+  }
+
+  // Last party: no party can leave (or arrive at the next phase) until the
+  // phase advances. Reset state and run the completion function first.
+  arrived_ = 0;
+  if (fn_)
+    fn_();
+  ++phase_;
+  WakeAll(&f_);
+
+  return true;
+}
+
+string Barrier::to_string(void) {
+  ostringstream oss;
+  oss << "Barrier: parties=" << parties_ << ": arrived=" << arrived_
+      << ": phase=" << phase_ << ": futex=" << f_.to_string();
+  return oss.str();
+}
+
+ostream& operator<<(ostream& os, Barrier& b) {
+  os << b.to_string();
+  return os;
+}
+
+//-----------------------------------------------------------------------------
+// Phaser
+//-----------------------------------------------------------------------------
+constexpr int Phaser::MAX_PARTIES;
+
+int Phaser::Register(void) {
+  uint64_t state = state_;
+  uint64_t next;
+  do {
+    CHECK_LT(Parties(state), MAX_PARTIES);
+    next = State(Phase(state), Parties(state) + 1, Unarrived(state) + 1);
+  } while (!state_.compare_exchange_weak(state, next));
+
+  return Phase(state);
+}
+
+int Phaser::Arrive(bool deregister) {
+  uint64_t state = state_;
+  uint64_t next;
+  bool     advance;
+  do {
+    int parties   = Parties(state);
+    int unarrived = Unarrived(state);
+    DCHECK_GT(unarrived, 0) << "Arrival of an unregistered party";
+    parties  -= deregister ? 1 : 0;
+    advance   = (unarrived == 1);
+    // Last arrival advances phase & resets unarrived for the next phase
+    next = advance ?
+        State(static_cast<uint32_t>(Phase(state)) + 1, parties, parties) :
+        State(Phase(state), parties, unarrived - 1);
+  } while (!state_.compare_exchange_weak(state, next));
+
+  if (advance) {
+    ++phase_;
+    WakeAll(&f_);
+  }
+
+  return Phase(state);
+}
+
+int Phaser::AwaitAdvance(int phase) {
+  // phase_ lags the phase of state_ while an advancing party is between
+  // its state_ CAS & ++phase_: phase may be ahead of phase_. Wrap around
+  // safe comparison of val > phase.
+  SpinThenWait(&phase_, &f_, [phase](int val) {
+      return static_cast<int>(static_cast<uint32_t>(val) -
+                              static_cast<uint32_t>(phase)) > 0;
+    });
+  return Phase();
+}
+
+string Phaser::to_string(void) {
+  ostringstream oss;
+  oss << "Phaser: phase=" << Phase() << ": parties=" << Parties()
+      << ": unarrived=" << Unarrived() << ": futex=" << f_.to_string();
+  return oss.str();
+}
+
+ostream& operator<<(ostream& os, Phaser& p) {
+  os << p.to_string();
+  return os;
+}
+
+//-----------------------------------------------------------------------------
+} } } // namespace asarcar { namespace utils { namespace concur {
@@ -0,0 +1,195 @@
+// Copyright 2016 asarcar Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef _UTILS_CONCUR_BARRIER_H_
+#define _UTILS_CONCUR_BARRIER_H_
+
+//! @file   barrier.h
+//! @brief  Phase synchronization primitives: Latch, Barrier, and Phaser
+//! @detail Bulk synchronous workloads (compute, exchange, compute, ...)
+//!         require all parties to rendezvous before the next phase begins.
+//!         1. Latch:   single use count down. Waiters released when count
+//!                     reaches zero.
+//!         2. Barrier: reusable rendezvous of a fixed number of parties. The
+//!                     last party to arrive executes the completion function
+//!                     before any party is released into the next phase.
+//!         3. Phaser:  reusable rendezvous where parties may register and
+//!                     deregister dynamically between (or during) phases.
+//!         All primitives busy wait for a short duration (the common case in
+//!         bulk synchronous phases is that parties arrive close together) and
+//!         then sleep on a Futex. The releasing party wakes all sleeping
+//!         parties with a single FUTEX_WAKE syscall, and skips the syscall
+//!         altogether when no party is sleeping.
+//!
+//! @author Arijit Sarcar <sarcar_a@yahoo.com>
+
+// C++ Standard Headers
+#include <atomic>       // std::atomic_int
+#include <functional>   // std::function
+#include <iostream>     // std::ostream
+// C Standard Headers
+// Google Headers
+#include <glog/logging.h>
+// Local Headers
+#include "utils/basic/basictypes.h"
+#include "utils/concur/futex.h"
+
+//! @addtogroup utils
+//! @{
+
+//! Namespace used for all concurrency utility routines
+namespace asarcar { namespace utils { namespace concur {
+//-----------------------------------------------------------------------------
+
+//! @class    Latch
+//! @brief    Single use count down latch
+class Latch {
+ public:
+  explicit Latch(int count): count_{count}, wakers_{0}, f_{&count_} {
+    DCHECK_GE(count, 0);
+  }
+  ~Latch() = default;
+  // Prevent bad usage: copy and assignment of Latch
+  Latch(const Latch&)             = delete;
+  Latch& operator =(const Latch&) = delete;
+  Latch(Latch&&)                  = delete;
+  Latch& operator =(Latch&&)      = delete;
+
+  // Decrements the count: waiters released when count reaches zero
+  void CountDown(int n = 1);
+  // Returns true if count reached zero: never blocks. The latch may be
+  // destroyed once TryWait or Wait returns true
+  inline bool TryWait(void) { return (count_ == 0 && wakers_ == 0); }
+  // Blocks until count reaches zero & no count down touches the latch
+  void Wait(void);
+  // CountDown followed by Wait
+  inline void ArriveAndWait(int n = 1) { CountDown(n); Wait(); }
+
+  std::string to_string(void);
+  friend std::ostream& operator<<(std::ostream& os, Latch& l);
+
+ private:
+  std::atomic_int count_;
+  // # CountDown in flight: a waiter may observe count_ == 0 before the
+  // last CountDown wakes sleepers through f_
+  std::atomic_int wakers_;
+  Futex           f_;
+};
+
+//! @class    Barrier
+//! @brief    Reusable barrier for a fixed number of parties
+class Barrier {
+ public:
+  using CompletionFn = std::function<void(void)>;
+  explicit Barrier(int parties, CompletionFn fn = CompletionFn{}):
+      parties_{parties}, arrived_{0}, phase_{0}, f_{&phase_},
+      fn_{std::move(fn)} {DCHECK_GT(parties, 0);}
+  ~Barrier() = default;
+  // Prevent bad usage: copy and assignment of Barrier
+  Barrier(const Barrier&)             = delete;
+  Barrier& operator =(const Barrier&) = delete;
+  Barrier(Barrier&&)                  = delete;
+  Barrier& operator =(Barrier&&)      = delete;
+
+  // Blocks until all parties arrive. The last party to arrive runs the
+  // completion function and returns true: all other parties return false
+  bool ArriveAndWait(void);
+  // Number of completed phases
+  inline int Phase(void) const { return phase_; }
+  inline int Parties(void) const { return parties_; }
+
+  std::string to_string(void);
+  friend std::ostream& operator<<(std::ostream& os, Barrier& b);
+
+ private:
+  const int        parties_;
+  std::atomic_int  arrived_; // # parties arrived in current phase
+  std::atomic_int  phase_;   // futex word: incremented at every phase
+  Futex            f_;
+  CompletionFn     fn_;
+};
+
+//! @class    Phaser
+//! @brief    Reusable barrier with dynamic registration of parties
+class Phaser {
+ public:
+  // # parties limited by the bits reserved for it in state_
+  static constexpr int MAX_PARTIES = 0xFFFF;
+  explicit Phaser(int parties = 0):
+      state_{State(0, parties, parties)}, phase_{0}, f_{&phase_} {
+    DCHECK_GE(parties, 0); DCHECK_LE(parties, MAX_PARTIES);
+  }
+  ~Phaser() = default;
+  // Prevent bad usage: copy and assignment of Phaser
+  Phaser(const Phaser&)             = delete;
+  Phaser& operator =(const Phaser&) = delete;
+  Phaser(Phaser&&)                  = delete;
+  Phaser& operator =(Phaser&&)      = delete;
+
+  // Adds a party: the party is expected to arrive in the current phase.
+  // Returns the phase at registration.
+  int Register(void);
+  // Arrives without waiting for others: returns the phase arrived at
+  inline int Arrive(void) { return Arrive(false); }
+  // Arrives and deregisters the party: returns the phase arrived at
+  inline int ArriveAndDeregister(void) { return Arrive(true); }
+  // Blocks until the phase advances beyond phase passed: returns new phase
+  int AwaitAdvance(int phase);
+  // Arrive followed by AwaitAdvance: returns the new phase
+  inline int ArriveAndAwaitAdvance(void) { return AwaitAdvance(Arrive()); }
+
+  inline int Phase(void) const { return Phase(state_); }
+  inline int Parties(void) const { return Parties(state_); }
+  inline int Unarrived(void) const { return Unarrived(state_); }
+
+  std::string to_string(void);
+  friend std::ostream& operator<<(std::ostream& os, Phaser& p);
+
+ private:
+  // state_ packs phase (bits 32-63), # registered parties (bits 16-31), and
+  // # parties yet to arrive in current phase (bits 0-15): registration,
+  // arrival, and phase advance are applied atomically w.r.t. each other.
+  // phase_ trails the phase in state_: it is only the futex word parties
+  // sleep on and is incremented (after state_) once per phase advance.
+  // Hence phase_ may lag the phase returned by Arrive: AwaitAdvance(phase)
+  // waits until phase_ is past phase rather than until it differs.
+  std::atomic<uint64_t> state_;
+  std::atomic_int       phase_;
+  Futex                 f_;
+
+  static inline uint64_t State(uint64_t phase, uint64_t parties,
+                               uint64_t unarrived) {
+    return (((phase & 0xFFFFFFFF) << 32) | (parties << 16) | unarrived);
+  }
+  static inline int Phase(uint64_t state) {
+    return static_cast<int>(state >> 32);
+  }
+  static inline int Parties(uint64_t state) {
+    return static_cast<int>((state >> 16) & MAX_PARTIES);
+  }
+  static inline int Unarrived(uint64_t state) {
+    return static_cast<int>(state & MAX_PARTIES);
+  }
+  int Arrive(bool deregister);
+};
+
+std::ostream& operator<<(std::ostream& os, Latch& l);
+std::ostream& operator<<(std::ostream& os, Barrier& b);
+std::ostream& operator<<(std::ostream& os, Phaser& p);
+
+//-----------------------------------------------------------------------------
+} } } // namespace asarcar { namespace utils { namespace concur {
+
+#endif // _UTILS_CONCUR_BARRIER_H_
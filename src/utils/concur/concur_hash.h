@@ -23,6 +23,10 @@
 //!         implementation based on: paper "High performance 
 //!         dynamic lock-free hash tables and list-based sets" 
 //!         - Maged Michael, SPAA 2002.
+//!         MapT: map of Key to ValuePtr with the std::unordered_map
+//!         interface subset insert/find/end/erase/clear/size e.g.
+//!         ds::FlatHashMap (utils/ds/flat_hash_map.h) saves the bucket
+//!         node allocation & pointer hop per entry of std::unordered_map.
 //! @author Arijit Sarcar <sarcar_a@yahoo.com>
 
 // C++ Standard Headers
@@ -41,12 +45,13 @@
 //! Namespace used for all concurrency utility routines
 namespace asarcar { namespace utils { namespace concur {
 //-----------------------------------------------------------------------------
-template <typename Key, typename Value, typename LockType = SpinLock>
+template <typename Key, typename Value, typename LockType = SpinLock,
+          template <typename...> class MapT = std::unordered_map>
 class ConcurHash {
  public:
   using ValuePtr = std::shared_ptr<Value>;
  private:
-  using KVMap    = std::unordered_map<Key, ValuePtr>;
+  using KVMap    = MapT<Key, ValuePtr>;
   using KVIter   = typename KVMap::iterator;
   using KVElem   = std::pair<Key, ValuePtr>;
  public:
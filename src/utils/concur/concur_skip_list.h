@@ -0,0 +1,377 @@
+// Copyright 2016 asarcar Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+//! @file   concur_skip_list.h
+//! @brief  Concurrent Skip List: ordered set safe under concurrent access
+//! @detail Lazy Skip List with optimistic locking - "A Simple Optimistic
+//!         Skiplist Algorithm" - Herlihy, Lev, Luchangco & Shavit, 2007.
+//!         1. Find & ordered traversal (InOrder/Range) take no locks and
+//!            never block.
+//!         2. Insert/Remove traverse without locks, then lock only the
+//!            predecessors (and victim) of the node, validate that the
+//!            predecessors are still adjacent, and link/unlink.
+//!            A node is logically removed (marked) before it is unlinked,
+//!            and logically present only once linked at all its levels.
+//!         3. Nodes are allocated at their exact height: forward pointers
+//!            trail the node in the same allocation.
+//!         4. Unlinked nodes are retired to EpochMgr: they are deleted only
+//!            after all concurrent readers that may observe them are done.
+//!         Thread Safety: All methods except constructor & destructor are
+//!         thread safe.
+//! @author Arijit Sarcar <sarcar_a@yahoo.com>
+
+#ifndef _UTILS_CONCUR_CONCUR_SKIP_LIST_H_
+#define _UTILS_CONCUR_CONCUR_SKIP_LIST_H_
+
+// C++ Standard Headers
+#include <atomic>           // std::atomic
+#include <functional>       // std::function
+#include <iomanip>          // std::setw
+#include <iostream>         // std::ostream
+#include <new>              // placement new
+#include <random>           // std::random_device
+#include <sstream>          // std::ostringstream
+#include <string>           // std::string
+#include <thread>           // std::this_thread
+// C Standard Headers
+// Google Headers
+#include <glog/logging.h>
+// Local Headers
+#include "utils/concur/epoch.h"     // EpochMgr
+#include "utils/concur/spin_lock.h" // SpinLock
+
+//! @addtogroup concur
+//! @{
+
+namespace asarcar { namespace utils { namespace concur {
+//-----------------------------------------------------------------------------
+
+template <typename T, typename LockType = SpinLock>
+class ConcurSkipList {
+ public:
+  // Supports ~2^32 entries with logarithmic search path
+  static constexpr uint32_t MAX_LEVEL = 32;
+  using AccFn = const std::function<uint32_t(const T&)>&;
+
+  ConcurSkipList() : head_p_{NewNode(T{}, MAX_LEVEL)}, top_{1}, size_{0} {
+    head_p_->linked = true;
+  }
+  // Not thread safe: no other thread may access the list
+  ~ConcurSkipList() {
+    NodePtr np = head_p_;
+    while (np != nullptr) {
+      NodePtr next_np = np->Next(0);
+      DeleteNode(np);
+      np = next_np;
+    }
+  }
+  // Prevent bad usage: copy and assignment of ConcurSkipList
+  ConcurSkipList(const ConcurSkipList&)             = delete;
+  ConcurSkipList& operator =(const ConcurSkipList&) = delete;
+  ConcurSkipList(ConcurSkipList&&)                  = delete;
+  ConcurSkipList& operator =(ConcurSkipList&&)      = delete;
+
+  inline size_t Size(void) const { return size_; }
+  inline bool Empty(void) const { return (size_ == 0); }
+
+  // Returns true if val exists
+  bool Find(const T& val) const;
+  // Returns false if val already exists: insert failed
+  bool Insert(T&& val);
+  inline bool Insert(const T& val) { return Insert(T{val}); }
+  // Returns false if val does not exist: remove failed
+  bool Remove(const T& val);
+
+  //! @fn         InOrder traverses the elements in ascending order
+  //! @param[in]  function executed on every element
+  //! @returns    accumulated result
+  //! @detail     Elements inserted or removed concurrently may or may not
+  //!             be visited. Traversal is never blocked.
+  inline uint32_t InOrder(AccFn fn) const { return Scan(nullptr, nullptr, fn); }
+  //! @fn         Range traverses the elements in [lo, hi) in ascending order
+  inline uint32_t Range(const T& lo, const T& hi, AccFn fn) const {
+    return Scan(&lo, &hi, fn);
+  }
+
+  std::string to_string(void) const;
+
+ private:
+  class Node;
+  using NodePtr = Node*;
+  using NodePtrArray = NodePtr[MAX_LEVEL];
+
+  // Forward pointers are laid out right after the node in the same
+  // allocation: node occupies sizeof(Node) + height * sizeof(NextPtr)
+  class Node {
+   public:
+    using NextPtr = std::atomic<NodePtr>;
+    Node(T&& v, uint32_t h) :
+        val{std::move(v)}, height{h}, marked{false}, linked{false}, lck{} {
+      for (uint32_t l=0; l<height; ++l)
+        new (&Next(l)) NextPtr{nullptr};
+    }
+    inline NextPtr& Next(uint32_t l) {
+      DCHECK_LT(l, height);
+      return reinterpret_cast<NextPtr*>(this + 1)[l];
+    }
+    const T               val;
+    const uint32_t        height;
+    std::atomic_bool      marked; // logically removed
+    std::atomic_bool      linked; // logically present: linked at all levels
+    LockType              lck;
+  };
+  static_assert(sizeof(Node) % alignof(typename Node::NextPtr) == 0,
+                "forward pointers trailing Node are not aligned");
+
+  NodePtr                 head_p_;
+  std::atomic<uint32_t>   top_;  // max height of any node inserted
+  std::atomic<size_t>     size_;
+
+  static NodePtr NewNode(T&& val, uint32_t height) {
+    void *mem = ::operator new(sizeof(Node) +
+                               height * sizeof(typename Node::NextPtr));
+    return new (mem) Node{std::move(val), height};
+  }
+  static void DeleteNode(void *p) {
+    static_cast<NodePtr>(p)->~Node();
+    ::operator delete(p);
+  }
+
+  //! @fn        RandomLevel
+  //! @details   Level k is chosen with probability 1/2^k: # trailing zeros
+  //!            of a random word drawn from a per thread xorshift generator
+  static uint32_t RandomLevel(void) {
+    static thread_local uint64_t x = std::random_device{}() | 1;
+    x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+    uint32_t level = __builtin_ctzll(x | (1ULL << (MAX_LEVEL - 1))) + 1;
+    return level;
+  }
+
+  // Fills predecessor and successor of val at levels [0, top).
+  // Returns the highest level at which val was found, -1 if not found.
+  int FindNode(const T& val, NodePtrArray& preds, NodePtrArray& succs,
+               uint32_t top) const;
+  static void Unlock(NodePtrArray& preds, int highest_locked);
+  uint32_t Scan(const T* lo_p, const T* hi_p, AccFn fn) const;
+};
+
+template <typename T, typename LockType>
+constexpr uint32_t ConcurSkipList<T, LockType>::MAX_LEVEL;
+
+template <typename T, typename LockType>
+int ConcurSkipList<T, LockType>::
+FindNode(const T& val, NodePtrArray& preds, NodePtrArray& succs,
+         uint32_t top) const {
+  int     lfound = -1;
+  NodePtr pred   = head_p_;
+  for (int l = static_cast<int>(top) - 1; l >= 0; --l) {
+    NodePtr curr = pred->Next(l);
+    while (curr != nullptr && curr->val < val) {
+      pred = curr;
+      curr = pred->Next(l);
+    }
+    if (lfound == -1 && curr != nullptr && !(val < curr->val))
+      lfound = l;
+    preds[l] = pred;
+    succs[l] = curr;
+  }
+  return lfound;
+}
+
+// Unlock the distinct predecessors locked at levels [0, highest_locked]
+template <typename T, typename LockType>
+void ConcurSkipList<T, LockType>::
+Unlock(NodePtrArray& preds, int highest_locked) {
+  NodePtr prev_pred = nullptr;
+  for (int l = 0; l <= highest_locked; ++l) {
+    if (preds[l] != prev_pred)
+      preds[l]->lck.unlock();
+    prev_pred = preds[l];
+  }
+}
+
+template <typename T, typename LockType>
+bool ConcurSkipList<T, LockType>::Find(const T& val) const {
+  EpochMgr::Guard g{};
+  NodePtr pred = head_p_;
+  for (int l = static_cast<int>(top_) - 1; l >= 0; --l) {
+    NodePtr curr = pred->Next(l);
+    while (curr != nullptr && curr->val < val) {
+      pred = curr;
+      curr = pred->Next(l);
+    }
+    if (curr != nullptr && !(val < curr->val))
+      return (curr->linked && !curr->marked);
+  }
+  return false;
+}
+
+template <typename T, typename LockType>
+bool ConcurSkipList<T, LockType>::Insert(T&& val) {
+  uint32_t     height = RandomLevel();
+  NodePtrArray preds, succs;
+
+  // Publish height before linking: searches starting at top_ reach node
+  uint32_t top = top_;
+  while (top < height && !top_.compare_exchange_weak(top, height));
+  top = std::max(top, height);
+
+  EpochMgr::Guard g{};
+  while (true) {
+    int lfound = FindNode(val, preds, succs, top);
+    if (lfound != -1) {
+      NodePtr found = succs[lfound];
+      if (!found->marked) {
+        // concurrent insert of val in progress: wait until it is present
+        while (!found->linked)
+          std::this_thread::yield();
+        return false;
+      }
+      // concurrent remove of val in progress: retry until unlinked
+      continue;
+    }
+
+    // Lock predecessors bottom up (descending keys) and validate that
+    // neither pred nor succ was removed and that they are still adjacent
+    int     highest_locked = -1;
+    NodePtr prev_pred      = nullptr;
+    bool    valid          = true;
+    for (uint32_t l = 0; valid && l < height; ++l) {
+      NodePtr pred = preds[l], succ = succs[l];
+      if (pred != prev_pred) {
+        pred->lck.lock();
+        highest_locked = l;
+        prev_pred = pred;
+      }
+      valid = !pred->marked && (succ == nullptr || !succ->marked) &&
+          (pred->Next(l) == succ);
+    }
+    if (!valid) {
+      Unlock(preds, highest_locked);
+      continue;
+    }
+
+    NodePtr np = NewNode(std::move(val), height);
+    for (uint32_t l = 0; l < height; ++l)
+      np->Next(l).store(succs[l], std::memory_order_relaxed);
+    // linking at level 0 makes node reachable: publish fully built node
+    for (uint32_t l = 0; l < height; ++l)
+      preds[l]->Next(l).store(np, std::memory_order_release);
+    np->linked = true;
+    Unlock(preds, highest_locked);
+    ++size_;
+    return true;
+  }
+}
+
+template <typename T, typename LockType>
+bool ConcurSkipList<T, LockType>::Remove(const T& val) {
+  NodePtr      victim    = nullptr;
+  bool         is_marked = false;
+  NodePtrArray preds, succs;
+
+  EpochMgr::Guard g{};
+  while (true) {
+    int lfound = FindNode(val, preds, succs, top_);
+    if (lfound != -1)
+      victim = succs[lfound];
+    // Remove only a present node found at its top level: victim was
+    // found at a lower level when its upper levels are still being linked
+    if (!is_marked &&
+        (lfound == -1 || !victim->linked || victim->marked ||
+         static_cast<int>(victim->height) - 1 != lfound))
+      return false;
+
+    if (!is_marked) {
+      victim->lck.lock();
+      if (victim->marked) {
+        victim->lck.unlock();
+        return false;
+      }
+      victim->marked = true; // logically removed
+      is_marked = true;
+    }
+
+    int     highest_locked = -1;
+    NodePtr prev_pred      = nullptr;
+    bool    valid          = true;
+    for (uint32_t l = 0; valid && l < victim->height; ++l) {
+      NodePtr pred = preds[l];
+      if (pred != prev_pred) {
+        pred->lck.lock();
+        highest_locked = l;
+        prev_pred = pred;
+      }
+      valid = !pred->marked && (pred->Next(l) == victim);
+    }
+    if (!valid) {
+      Unlock(preds, highest_locked);
+      continue;
+    }
+
+    for (int l = static_cast<int>(victim->height) - 1; l >= 0; --l)
+      preds[l]->Next(l).store(victim->Next(l), std::memory_order_release);
+    victim->lck.unlock();
+    Unlock(preds, highest_locked);
+    --size_;
+    // Concurrent readers may still be traversing victim
+    EpochMgr::Singleton()->Retire(victim, &DeleteNode);
+    return true;
+  }
+}
+
+template <typename T, typename LockType>
+uint32_t ConcurSkipList<T, LockType>::
+Scan(const T* lo_p, const T* hi_p, AccFn fn) const {
+  EpochMgr::Guard g{};
+  NodePtr np = head_p_;
+  // Skip to the last node < lo using all levels
+  if (lo_p != nullptr) {
+    for (int l = static_cast<int>(top_) - 1; l >= 0; --l) {
+      for (NodePtr next = np->Next(l);
+           next != nullptr && next->val < *lo_p; next = np->Next(l))
+        np = next;
+    }
+  }
+
+  uint32_t acc = 0;
+  for (np = np->Next(0); np != nullptr; np = np->Next(0)) {
+    if (hi_p != nullptr && !(np->val < *hi_p))
+      break;
+    if (np->linked && !np->marked)
+      acc += fn(np->val);
+  }
+  return acc;
+}
+
+template <typename T, typename LockType>
+std::string ConcurSkipList<T, LockType>::to_string(void) const {
+  std::ostringstream oss;
+  oss << "ConcurSkipList: Size=" << Size() << ": top=" << top_ << ": [";
+  InOrder([&oss](const T& val) { oss << " " << val; return 1; });
+  oss << " ]";
+  return oss.str();
+}
+
+template <typename T, typename LockType>
+std::ostream& operator<<(std::ostream& os, const ConcurSkipList<T, LockType>& s) {
+  os << s.to_string();
+  return os;
+}
+
+//-----------------------------------------------------------------------------
+} } } // namespace asarcar { namespace utils { namespace concur {
+
+#endif // _UTILS_CONCUR_CONCUR_SKIP_LIST_H_
@@ -0,0 +1,176 @@
+// Copyright 2016 asarcar Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Author: Arijit Sarcar <sarcar_a@yahoo.com>
+
+// Standard C++ Headers
+#include <algorithm>    // std::partition
+#include <sstream>      // ostringstream
+#include <thread>       // this_thread::yield
+// Standard C Headers
+// Google Headers
+#include <glog/logging.h>
+// Local Headers
+#include "utils/concur/epoch.h"
+
+using namespace std;
+
+namespace asarcar { namespace utils { namespace concur {
+//-----------------------------------------------------------------------------
+
+constexpr int      EpochMgr::MAX_THREADS;
+constexpr size_t   EpochMgr::RECLAIM_THRESHOLD;
+constexpr uint64_t EpochMgr::QUIESCENT;
+
+EpochMgr::~EpochMgr() {
+  // Process exit: no thread is expected to be in a critical section
+  for (auto& slot : slots_)
+    for (auto& r : slot.retired)
+      r.deleter(r.ptr);
+  for (auto& r : orphans_)
+    r.deleter(r.ptr);
+}
+
+// Slot is claimed on first use by a thread & released when thread exits
+EpochMgr::Slot* EpochMgr::MySlot(void) {
+  struct SlotHandle {
+    EpochMgr* mgr_p;
+    Slot*     slot_p;
+    ~SlotHandle() { if (slot_p != nullptr) mgr_p->ReleaseSlot(slot_p); }
+  };
+  static thread_local SlotHandle handle{this, nullptr};
+
+  if (handle.slot_p != nullptr)
+    return handle.slot_p;
+
+  for (auto& slot : slots_) {
+    bool in_use = false;
+    if (slot.in_use.compare_exchange_strong(in_use, true)) {
+      handle.slot_p = &slot;
+      return handle.slot_p;
+    }
+  }
+  LOG(FATAL) << "More than " << MAX_THREADS << " threads using EpochMgr";
+  return nullptr;
+}
+
+void EpochMgr::ReleaseSlot(Slot* slot_p) {
+  DCHECK_EQ(slot_p->nest, 0) << "Thread exited inside critical section";
+  {
+    lock_guard<mutex> lkg{orphans_lck_};
+    orphans_.insert(orphans_.end(),
+                    slot_p->retired.begin(), slot_p->retired.end());
+  }
+  slot_p->retired.clear();
+  slot_p->epoch = QUIESCENT;
+  slot_p->in_use = false;
+}
+
+void EpochMgr::Enter(void) {
+  Slot* slot_p = MySlot();
+  if (slot_p->nest++ > 0)
+    return;
+  // Announce the current epoch: recheck as the epoch may have advanced
+  // (without taking us into account) before our announcement was visible
+  uint64_t epoch;
+  do {
+    epoch = epoch_;
+    slot_p->epoch = epoch;
+  } while (epoch != epoch_);
+}
+
+void EpochMgr::Exit(void) {
+  Slot* slot_p = MySlot();
+  DCHECK_GT(slot_p->nest, 0);
+  if (--slot_p->nest > 0)
+    return;
+  slot_p->epoch.store(QUIESCENT, memory_order_release);
+}
+
+bool EpochMgr::TryAdvance(void) {
+  uint64_t epoch = epoch_;
+  for (auto& slot : slots_) {
+    if (!slot.in_use)
+      continue;
+    uint64_t e = slot.epoch;
+    if (e != QUIESCENT && e != epoch)
+      return false;
+  }
+  // Failure implies some other thread advanced the epoch
+  epoch_.compare_exchange_strong(epoch, epoch + 1);
+  return true;
+}
+
+void EpochMgr::Reclaim(RetiredList* list_p, uint64_t epoch) {
+  auto it = partition(list_p->begin(), list_p->end(),
+                      [epoch](const Retired& r) {return r.epoch + 2 > epoch;});
+  for (auto del_it = it; del_it != list_p->end(); ++del_it)
+    del_it->deleter(del_it->ptr);
+  num_retired_ -= static_cast<size_t>(list_p->end() - it);
+  list_p->erase(it, list_p->end());
+}
+
+void EpochMgr::Retire(void *ptr, Deleter deleter) {
+  Slot* slot_p = MySlot();
+  // Epoch is read after the caller unlinked ptr: threads entering after
+  // this epoch is observed can not reach ptr
+  slot_p->retired.push_back(Retired{ptr, deleter, epoch_});
+  ++num_retired_;
+  if (slot_p->retired.size() < RECLAIM_THRESHOLD)
+    return;
+
+  TryAdvance();
+  Reclaim(&slot_p->retired, epoch_);
+  if (orphans_lck_.try_lock()) {
+    Reclaim(&orphans_, epoch_);
+    orphans_lck_.unlock();
+  }
+}
+
+void EpochMgr::Synchronize(void) {
+  Slot* slot_p = MySlot();
+  DCHECK_EQ(slot_p->nest, 0) << "Synchronize called in critical section";
+
+  uint64_t target = epoch_ + 2;
+  while (epoch_ < target) {
+    if (!TryAdvance())
+      this_thread::yield();
+  }
+
+  Reclaim(&slot_p->retired, epoch_);
+  lock_guard<mutex> lkg{orphans_lck_};
+  Reclaim(&orphans_, epoch_);
+}
+
+string EpochMgr::to_string(void) {
+  ostringstream oss;
+  int num_threads = 0, num_active = 0;
+  for (auto& slot : slots_) {
+    if (!slot.in_use)
+      continue;
+    ++num_threads;
+    num_active += (slot.epoch != QUIESCENT) ? 1 : 0;
+  }
+  oss << "EpochMgr: epoch=" << epoch_ << ": num_threads=" << num_threads
+      << ": num_active=" << num_active << ": num_retired=" << num_retired_;
+  return oss.str();
+}
+
+ostream& operator<<(ostream& os, EpochMgr& e) {
+  os << e.to_string();
+  return os;
+}
+
+//-----------------------------------------------------------------------------
+} } } // namespace asarcar { namespace utils { namespace concur {
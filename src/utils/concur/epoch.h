@@ -0,0 +1,157 @@
+// Copyright 2016 asarcar Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+//! @file   epoch.h
+//! @brief  Epoch based memory reclamation for lock free readers
+//! @detail Readers of a concurrent structure access nodes inside an
+//!         EpochMgr::Guard and never block. Writers unlink a node and
+//!         Retire it instead of deleting it. The node is deleted once
+//!         every thread that may have observed it has left its critical
+//!         section i.e. after a grace period.
+//!         1. The global epoch advances from e to e+1 only when every
+//!            thread inside a critical section has announced epoch e.
+//!         2. A node retired in epoch e is unreachable by threads entering
+//!            in epoch e+1 or later: it is safe to delete once the global
+//!            epoch reaches e+2.
+//!         Retired nodes are kept in per thread lists: Retire never takes
+//!         a lock. Lists of exiting threads are handed over to the manager.
+//!
+//!         Example Usage:
+//!         { EpochMgr::Guard g; ... read nodes ... } // reader
+//!         { unlink node; EpochMgr::Singleton()->Retire(node); } // writer
+//!
+//! @author Arijit Sarcar <sarcar_a@yahoo.com>
+
+#ifndef _UTILS_CONCUR_EPOCH_H_
+#define _UTILS_CONCUR_EPOCH_H_
+
+// C++ Standard Headers
+#include <array>        // std::array
+#include <atomic>       // std::atomic
+#include <iostream>     // std::ostream
+#include <mutex>        // std::mutex
+#include <string>       // std::string
+#include <vector>       // std::vector
+// C Standard Headers
+// Google Headers
+#include <glog/logging.h>
+// Local Headers
+#include "utils/basic/proc_info.h"  // CACHE_LINE_SIZE
+
+//! @addtogroup concur
+//! @{
+
+namespace asarcar { namespace utils { namespace concur {
+//-----------------------------------------------------------------------------
+
+class EpochMgr {
+ public:
+  // Max # of threads concurrently participating in epoch reclamation
+  static constexpr int      MAX_THREADS = 256;
+  // # retired nodes of a thread beyond which reclamation is attempted
+  static constexpr size_t   RECLAIM_THRESHOLD = 64;
+  using Deleter = void (*)(void *);
+
+  static inline EpochMgr* Singleton(void) {
+    static EpochMgr singleton{};
+    return &singleton;
+  }
+
+  // RAII critical section: nodes observed inside the guard are not
+  // deleted until the guard is destroyed. Guards may be nested.
+  class Guard {
+   public:
+    Guard() : mgr_p_{EpochMgr::Singleton()} { mgr_p_->Enter(); }
+    ~Guard() { mgr_p_->Exit(); }
+    Guard(const Guard&)             = delete;
+    Guard& operator =(const Guard&) = delete;
+    Guard(Guard&&)                  = delete;
+    Guard& operator =(Guard&&)      = delete;
+   private:
+    EpochMgr* mgr_p_;
+  };
+
+  ~EpochMgr();
+  EpochMgr(const EpochMgr&)             = delete;
+  EpochMgr& operator =(const EpochMgr&) = delete;
+  EpochMgr(EpochMgr&&)                  = delete;
+  EpochMgr& operator =(EpochMgr&&)      = delete;
+
+  void Enter(void);
+  void Exit(void);
+
+  // Defers deleting ptr until a grace period has elapsed
+  template <typename T>
+  inline void Retire(T* ptr) {
+    Retire(static_cast<void *>(ptr),
+           [](void *p) { delete static_cast<T*>(p); });
+  }
+  void Retire(void *ptr, Deleter deleter);
+
+  // Blocks until a grace period elapses and deletes all nodes retired
+  // prior to the call by this thread and by exited threads.
+  // Must not be called inside a critical section.
+  void Synchronize(void);
+
+  inline uint64_t Epoch(void) const { return epoch_; }
+  // # nodes retired but not yet deleted: debugging aid
+  inline size_t NumRetired(void) const { return num_retired_; }
+
+  std::string to_string(void);
+  friend std::ostream& operator<<(std::ostream& os, EpochMgr& e);
+
+ private:
+  // Epoch announced by a thread outside its critical section
+  static constexpr uint64_t QUIESCENT = 0;
+
+  struct Retired {
+    void*    ptr;
+    Deleter  deleter;
+    uint64_t epoch;
+  };
+  using RetiredList = std::vector<Retired>;
+
+  // One slot per participating thread. Slots are cache aligned as each
+  // is written by its owner on every Enter/Exit.
+  struct Slot {
+    std::atomic<uint64_t> epoch{QUIESCENT};
+    std::atomic_bool      in_use{false};
+    int                   nest{0};
+    RetiredList           retired{};
+  } __attribute__ ((aligned (CACHE_LINE_SIZE)));
+
+  EpochMgr() : epoch_{QUIESCENT + 1}, num_retired_{0}, slots_{},
+               orphans_lck_{}, orphans_{} {}
+
+  std::atomic<uint64_t>         epoch_;
+  std::atomic<size_t>           num_retired_;
+  std::array<Slot, MAX_THREADS> slots_;
+  std::mutex                    orphans_lck_;
+  RetiredList                   orphans_; // retired nodes of exited threads
+
+  Slot* MySlot(void);
+  void  ReleaseSlot(Slot* slot_p);
+  // Advances global epoch if all threads in critical section observed it
+  bool  TryAdvance(void);
+  // Deletes nodes in list retired at least two epochs before epoch
+  void  Reclaim(RetiredList* list_p, uint64_t epoch);
+};
+
+std::ostream& operator<<(std::ostream& os, EpochMgr& e);
+
+//-----------------------------------------------------------------------------
+} } } // namespace asarcar { namespace utils { namespace concur {
+
+#endif // _UTILS_CONCUR_EPOCH_H_
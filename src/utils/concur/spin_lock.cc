@@ -135,8 +135,12 @@ void SpinLock::unlock(void) {
   // Ideally: signal only one if threads waiting for EXCLUSICE lock only
   // Otherwise: signal FIFO way threads waiting for SHARED/EXCLUSIVE locks
   // Since: we are implementing a simple spinlock we just wake everyone
-  // and let them fight it out
-  PCHECK(f_.Wake(true) >= 0);
+  // and let them fight it out.
+  // Skip the syscall when no one sleeps: val_ is modified (seq_cst) before
+  // num_ is read, and a waiter increments num_ (seq_cst) before the kernel
+  // compares val_ with the value it saw: that wait returns immediately.
+  if (f_.Num() > 0)
+    PCHECK(f_.Wake(true) >= 0);
 
   return;
 }
@@ -163,8 +167,9 @@ void SpinLock::Downgrade(void) {
   // Ideally: signal only one if threads waiting for EXCLUSICE lock only
   // Otherwise: signal FIFO way threads waiting for SHARED/EXCLUSIVE locks
   // Since: we are implementing a simple spinlock we just wake everyone
-  // and let them fight it out
-  PCHECK(f_.Wake(true) >= 0);
+  // and let them fight it out. Skip the syscall when no one sleeps (unlock).
+  if (f_.Num() > 0)
+    PCHECK(f_.Wake(true) >= 0);
 
   return;
 }
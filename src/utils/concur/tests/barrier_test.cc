@@ -0,0 +1,328 @@
+// Copyright 2016 asarcar Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Author: Arijit Sarcar <sarcar_a@yahoo.com>
+
+// Standard C++ Headers
+#include <atomic>           // std::atomic
+#include <functional>       // std::function
+#include <iostream>         // std::cout
+#include <memory>           // std::unique_ptr
+#include <thread>           // std::thread
+#include <vector>           // std::vector
+// Standard C Headers
+// Google Headers
+#include <glog/logging.h>
+// Local Headers
+#include "utils/basic/basictypes.h"
+#include "utils/basic/clock.h"
+#include "utils/basic/init.h"
+#include "utils/concur/barrier.h"
+#include "utils/concur/cv_guard.h"
+#include "utils/concur/spin_lock.h"
+
+using namespace asarcar;
+using namespace asarcar::utils;
+using namespace asarcar::utils::concur;
+
+using namespace std;
+
+// Declarations
+DECLARE_bool(auto_test);
+DECLARE_bool(benchmark);
+
+class BarrierTester {
+ public:
+  BarrierTester() {}
+  ~BarrierTester() = default;
+
+  void LatchTest();
+  void LatchDestroyTest();
+  void BarrierTest();
+  void PhaserBasicTest();
+  void PhaserDynamicTest();
+  void PhaserArriveTest();
+  void BarrierBenchmarkTest();
+
+ private:
+  static constexpr const char* kUnitStr = "us";
+  static constexpr int kNumThreads      = 4;
+  static constexpr int kNumRounds       = 100;
+  static constexpr int kNumLatches      = 1000;
+  static constexpr int kNumBenchRounds  = 1000;
+
+  // Naive barrier (counter & generation protected by a lock, waiters
+  // sleep on a condition variable): baseline when benchmarking Barrier
+  class CVBarrier {
+   public:
+    explicit CVBarrier(int parties) : parties_{parties} {}
+    void ArriveAndWait(void);
+   private:
+    const int           parties_;
+    int                 arrived_{0};
+    int                 phase_{0};
+    SpinLock            sl_{};
+    CV<SpinLock>        cv_{sl_};
+  };
+
+  template <typename BarrierType>
+  Clock::TimeDuration BarrierBenchmarkHelper(int num_threads);
+};
+
+constexpr const char* BarrierTester::kUnitStr;
+constexpr int BarrierTester::kNumThreads;
+constexpr int BarrierTester::kNumRounds;
+constexpr int BarrierTester::kNumLatches;
+constexpr int BarrierTester::kNumBenchRounds;
+
+void BarrierTester::CVBarrier::ArriveAndWait(void) {
+  bool last = false;
+  int  phase;
+  {
+    function<void(void)> arrive = [this, &last, &phase]() {
+      phase = phase_;
+      if (++arrived_ == parties_) {
+        arrived_ = 0; ++phase_; last = true;
+      }
+    };
+    CvWg<> wg{cv_, arrive, [this, &phase]() {return phase_ != phase;}};
+  }
+  if (last) {
+    CvSg<> sg{cv_, true};
+  }
+}
+
+// 1. Latch not released until count reaches zero.
+// 2. Waiters released once all threads count down.
+void BarrierTester::LatchTest() {
+  Latch         l{kNumThreads};
+  atomic_int    count{0};
+  vector<thread> th;
+
+  CHECK(!l.TryWait());
+  for (int i=0; i<kNumThreads; ++i) {
+    th.emplace_back([&l, &count]() {
+        ++count;
+        l.ArriveAndWait();
+        CHECK_EQ(count, kNumThreads);
+      });
+  }
+  l.Wait();
+  CHECK(l.TryWait());
+  CHECK_EQ(count, kNumThreads);
+  for (auto &t : th)
+    t.join();
+
+  LOG(INFO) << __FUNCTION__ << " passed";
+  return;
+}
+
+// Latch destroyed as soon as Wait returns (fork join pattern): the last
+// CountDown must not touch the latch once the waiter is released. Heap
+// allocated so that ASAN flags any use after free.
+void BarrierTester::LatchDestroyTest() {
+  for (int i=0; i<kNumLatches; ++i) {
+    unique_ptr<Latch> l_p{new Latch{1}};
+    thread            t{[&l_p]() { l_p->CountDown(); }};
+    l_p->Wait();
+    l_p.reset();
+    t.join();
+  }
+
+  LOG(INFO) << __FUNCTION__ << " passed";
+  return;
+}
+
+// kNumThreads threads rendezvous kNumRounds times:
+// 1. Every thread observes work of all threads in the round before it.
+// 2. Completion function runs exactly once per round & before release.
+// 3. Exactly one thread per round is the last to arrive.
+void BarrierTester::BarrierTest() {
+  atomic_int work{0};
+  atomic_int last{0};
+  int        completed = 0;
+  Barrier    b{kNumThreads, [&completed, &work]() {
+      CHECK_EQ(work, (completed+1)*kNumThreads); ++completed;
+    }};
+  vector<thread> th;
+
+  for (int i=0; i<kNumThreads; ++i) {
+    th.emplace_back([&b, &work, &last, &completed]() {
+        for (int r=0; r<kNumRounds; ++r) {
+          ++work;
+          if (b.ArriveAndWait())
+            ++last;
+          CHECK_GE(work, (r+1)*kNumThreads);
+          CHECK_GE(completed, r+1);
+        }
+      });
+  }
+  for (auto &t : th)
+    t.join();
+
+  CHECK_EQ(b.Phase(), kNumRounds);
+  CHECK_EQ(completed, kNumRounds);
+  CHECK_EQ(last, kNumRounds);
+  LOG(INFO) << "Barrier: " << b;
+
+  LOG(INFO) << __FUNCTION__ << " passed";
+  return;
+}
+
+// Single threaded: phase advances when all registered parties arrive.
+// Registration and deregistration change parties of current phase.
+void BarrierTester::PhaserBasicTest() {
+  Phaser p{1};
+  CHECK_EQ(p.Phase(), 0);
+  CHECK_EQ(p.Arrive(), 0);
+  CHECK_EQ(p.Phase(), 1);
+  CHECK_EQ(p.Unarrived(), 1);
+
+  CHECK_EQ(p.Register(), 1);
+  CHECK_EQ(p.Parties(), 2);
+  CHECK_EQ(p.Unarrived(), 2);
+  CHECK_EQ(p.Arrive(), 1);
+  CHECK_EQ(p.Phase(), 1);
+  CHECK_EQ(p.ArriveAndDeregister(), 1);
+  CHECK_EQ(p.Phase(), 2);
+  CHECK_EQ(p.Parties(), 1);
+  CHECK_EQ(p.Unarrived(), 1);
+  // phase already advanced: returns immediately
+  CHECK_EQ(p.AwaitAdvance(1), 2);
+  CHECK_EQ(p.ArriveAndDeregister(), 2);
+  CHECK_EQ(p.Parties(), 0);
+
+  LOG(INFO) << __FUNCTION__ << " passed";
+  return;
+}
+
+// Main thread registers workers and deregisters once they start. Worker
+// i participates for i+1 phases and deregisters: remaining workers keep
+// advancing phases without waiting for the deregistered ones.
+void BarrierTester::PhaserDynamicTest() {
+  Phaser         p{1};
+  vector<thread> th;
+
+  for (int i=0; i<kNumThreads; ++i) {
+    p.Register();
+    th.emplace_back([&p, i]() {
+        for (int r=0; r<=i; ++r)
+          CHECK_EQ(p.ArriveAndAwaitAdvance(), r+1);
+        CHECK_EQ(p.ArriveAndDeregister(), i+1);
+      });
+  }
+  CHECK_EQ(p.ArriveAndDeregister(), 0);
+  for (auto &t : th)
+    t.join();
+
+  CHECK_EQ(p.Parties(), 0);
+  CHECK_EQ(p.Phase(), kNumThreads+1);
+  LOG(INFO) << "Phaser: " << p;
+
+  LOG(INFO) << __FUNCTION__ << " passed";
+  return;
+}
+
+// Main thread arrives without waiting & learns of the advance from
+// Phase() (or AwaitAdvance) while the worker arrives and awaits: the
+// advancing worker may still be between its state & futex word updates
+// when main arrives at the next phase. AwaitAdvance of that phase must
+// not return before the phase completes.
+void BarrierTester::PhaserArriveTest() {
+  Phaser     p{2};
+  atomic_int work{0};
+  thread     t{[&p, &work]() {
+      for (int r=0; r<kNumRounds; ++r) {
+        ++work;
+        CHECK_EQ(p.ArriveAndAwaitAdvance(), r+1);
+      }
+    }};
+
+  for (int r=0; r<kNumRounds; ++r) {
+    int phase = p.Arrive();
+    CHECK_EQ(phase, r);
+    if (r % 2 == 0) {
+      while (p.Phase() == phase)
+        this_thread::yield();
+    } else {
+      CHECK_EQ(p.AwaitAdvance(phase), phase+1);
+    }
+    CHECK_GE(work, r+1);
+  }
+  t.join();
+
+  CHECK_EQ(p.Phase(), kNumRounds);
+  LOG(INFO) << "Phaser: " << p;
+
+  LOG(INFO) << __FUNCTION__ << " passed";
+  return;
+}
+
+template <typename BarrierType>
+Clock::TimeDuration BarrierTester::BarrierBenchmarkHelper(int num_threads) {
+  BarrierType    b{num_threads};
+  vector<thread> th;
+  auto fn = [&b]() {
+    for (int r=0; r<kNumBenchRounds; ++r)
+      b.ArriveAndWait();
+  };
+
+  Clock::TimePoint now = Clock::USecs();
+  for (int i=1; i<num_threads; ++i)
+    th.emplace_back(fn);
+  fn();
+  for (auto &t : th)
+    t.join();
+
+  return (Clock::USecs() - now);
+}
+
+// Rendezvous kNumBenchRounds times with 2, 4, ..., 64 threads using
+// Barrier and a naive CV based barrier: report latency per round.
+void BarrierTester::BarrierBenchmarkTest() {
+  for (int n=2; n<=64; n*=2) {
+    Clock::TimeDuration durC = BarrierBenchmarkHelper<CVBarrier>(n);
+    Clock::TimeDuration durB = BarrierBenchmarkHelper<Barrier>(n);
+    LOG(INFO) << "Time: " << kNumBenchRounds << " rounds of " << n
+              << " threads for CVBarrier/Barrier = " << durC << "/" << durB
+              << kUnitStr << ": per round = "
+              << static_cast<double>(durC)/kNumBenchRounds << "/"
+              << static_cast<double>(durB)/kNumBenchRounds << kUnitStr
+              << ": SpeedUp = "
+              << static_cast<double>(durC)/static_cast<double>(durB);
+  }
+
+  return;
+}
+
+int main(int argc, char *argv[]) {
+  Init::InitEnv(&argc, &argv);
+
+  BarrierTester test{};
+  test.LatchTest();
+  test.LatchDestroyTest();
+  test.BarrierTest();
+  test.PhaserBasicTest();
+  test.PhaserDynamicTest();
+  test.PhaserArriveTest();
+  if (FLAGS_benchmark)
+    test.BarrierBenchmarkTest();
+
+  return 0;
+}
+
+DEFINE_bool(auto_test, false,
+            "test run programmatically (when true) or manually (when false)");
+DEFINE_bool(benchmark, false,
+            "test run when benchmarking barrier against naive CV barrier");
@@ -18,6 +18,7 @@
 #include <array>
 #include <atomic>
 #include <thread>
+#include <unordered_map>
 // Standard C Headers
 // Google Headers
 #include <glog/logging.h>
@@ -25,10 +26,12 @@
 #include "utils/basic/init.h"
 #include "utils/concur/concur_hash.h"
 #include "utils/concur/thread_pool.h"
+#include "utils/ds/flat_hash_map.h"
 
 using namespace asarcar;
 using namespace asarcar::utils;
 using namespace asarcar::utils::concur;
+using namespace asarcar::utils::ds;
 using namespace std;
 
 // Declarations
@@ -62,7 +65,7 @@ struct hash<String> {
 };
 }
 
-template <typename T>
+template <typename T, template <typename...> class MapT = unordered_map>
 class ConcurHashTester {
  public:
   ConcurHashTester(): cmap_{}, size_{0} {}
@@ -70,7 +73,7 @@ class ConcurHashTester {
   void ConcurSimpleTest(void);
   void ConcurStressTest(void);
  private:
-  using MapType   = ConcurHash<T,T>;
+  using MapType   = ConcurHash<T,T,SpinLock,MapT>;
   using ValPtr    = typename MapType::ValuePtr;
 
   MapType      cmap_;  
@@ -85,11 +88,11 @@ class ConcurHashTester {
   static void EraseOp(ConcurHashTester *p);
 };
 
-template <typename T>
-constexpr int ConcurHashTester<T>::kNumThreads;
+template <typename T, template <typename...> class MapT>
+constexpr int ConcurHashTester<T,MapT>::kNumThreads;
 
-template <typename T>
-void ConcurHashTester<T>::SanityTest(void) {
+template <typename T, template <typename...> class MapT>
+void ConcurHashTester<T,MapT>::SanityTest(void) {
   CHECK(cmap_.Find(1) == nullptr);
 
   CHECK_EQ(*cmap_.Insert(1, 2), 2);
@@ -105,8 +108,8 @@ void ConcurHashTester<T>::SanityTest(void) {
   CHECK_EQ(cmap_.Size(), 0);
 }
 
-template <typename T>
-void ConcurHashTester<T>::ConcurSimpleTest(void) {
+template <typename T, template <typename...> class MapT>
+void ConcurHashTester<T,MapT>::ConcurSimpleTest(void) {
   auto tpool_p = make_shared<ThreadPool<>>(kNumThreads);
   for (int i=0; i<kNumThreads; ++i)
     tpool_p->AddTask(bind(&SameKeyOp, this, T{5}, i));
@@ -115,8 +118,8 @@ void ConcurHashTester<T>::ConcurSimpleTest(void) {
   CHECK_EQ(cmap_.Size(),0);
 }
 
-template <typename T>
-void ConcurHashTester<T>::ConcurStressTest(void) {
+template <typename T, template <typename...> class MapT>
+void ConcurHashTester<T,MapT>::ConcurStressTest(void) {
   auto tpool_p = make_shared<ThreadPool<>>(kNumThreads);
   for (int i=0; i<kNumThreads/2; ++i) {
     tpool_p->AddTask(bind(&InsertOp, this));
@@ -127,8 +130,8 @@ void ConcurHashTester<T>::ConcurStressTest(void) {
   CHECK_EQ(size_, cmap_.Size());
 }
 
-template <typename T>
-void ConcurHashTester<T>::SameKeyOp(ConcurHashTester *p, 
+template <typename T, template <typename...> class MapT>
+void ConcurHashTester<T,MapT>::SameKeyOp(ConcurHashTester *p, 
                                     const T& k, 
                                     const int threadNum) {
   int val, cur_val; 
@@ -151,8 +154,8 @@ void ConcurHashTester<T>::SameKeyOp(ConcurHashTester *p,
   }
 }
 
-template <typename T>
-void ConcurHashTester<T>::InsertOp(ConcurHashTester *p) {
+template <typename T, template <typename...> class MapT>
+void ConcurHashTester<T,MapT>::InsertOp(ConcurHashTester *p) {
   for (int i=0; i<kMaxVal; ++i) {
     ValPtr vp = p->cmap_.Insert(T{i >> (kMaxBits - kLessBits)}, T{i});
     if (vp == nullptr)
@@ -161,8 +164,8 @@ void ConcurHashTester<T>::InsertOp(ConcurHashTester *p) {
   }
 }
 
-template <typename T>
-void ConcurHashTester<T>::EraseOp(ConcurHashTester *p) {
+template <typename T, template <typename...> class MapT>
+void ConcurHashTester<T,MapT>::EraseOp(ConcurHashTester *p) {
   for (int i=0; i<kMaxVal; ++i) {
     if (p->cmap_.Erase(T{i >> (kMaxBits - kLessBits)}))
       --p->size_;
@@ -192,6 +195,19 @@ int main(int argc, char *argv[]) {
   LOG(INFO) << "ConcurrentHash: Complex(K/V: {int,string}) Key/Val "
             << "Concurrent Stress Test Passed";
 
+  ConcurHashTester<int, FlatHashMap> chf;
+  chf.SanityTest();
+  chf.ConcurSimpleTest();
+  chf.ConcurStressTest();
+  LOG(INFO) << "ConcurrentHash: FlatHashMap POD(K/V: Int) Key/Val "
+            << "Sanity, Concurrent Simple & Stress Tests Passed";
+  ConcurHashTester<String, FlatHashMap> chfs;
+  chfs.SanityTest();
+  chfs.ConcurSimpleTest();
+  chfs.ConcurStressTest();
+  LOG(INFO) << "ConcurrentHash: FlatHashMap Complex(K/V: {int,string}) "
+            << "Key/Val Sanity, Concurrent Simple & Stress Tests Passed";
+
   if (FLAGS_auto_test)
     return 0;
 
@@ -0,0 +1,326 @@
+// Copyright 2016 asarcar Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Author: Arijit Sarcar <sarcar_a@yahoo.com>
+
+// Standard C++ Headers
+#include <algorithm>        // std::shuffle
+#include <atomic>           // std::atomic
+#include <iostream>         // std::cout
+#include <random>           // std::default_random_engine
+#include <thread>           // std::thread
+#include <vector>           // std::vector
+// Standard C Headers
+// Google Headers
+#include <glog/logging.h>
+// Local Headers
+#include "utils/basic/basictypes.h"
+#include "utils/basic/clock.h"
+#include "utils/basic/init.h"
+#include "utils/concur/barrier.h"
+#include "utils/concur/concur_skip_list.h"
+#include "utils/concur/epoch.h"
+#include "utils/concur/lock_guard.h"
+#include "utils/concur/spin_lock.h"
+#include "utils/ds/skip_lists.h"
+#include "utils/ds/treap.h"
+
+using namespace asarcar;
+using namespace asarcar::utils;
+using namespace asarcar::utils::concur;
+
+using namespace std;
+
+// Declarations
+DECLARE_bool(auto_test);
+DECLARE_bool(benchmark);
+
+class ConcurSkipListTester {
+ public:
+  using CSkipList = ConcurSkipList<uint32_t>;
+  ConcurSkipListTester() {}
+  ~ConcurSkipListTester() = default;
+
+  void BasicTest();
+  void ConcurDisjointTest();
+  void ConcurSameKeyTest();
+  void ReclaimTest();
+  void BenchmarkTest();
+
+ private:
+  static constexpr const char* kUnitStr   = "us";
+  static constexpr int      kNumThreads   = 4;
+  static constexpr uint32_t kNumKeys      = 1 << 12;
+  static constexpr uint32_t kNumHotKeys   = 16;
+  static constexpr int      kNumHotOps    = 10000;
+  static constexpr uint32_t kNumBenchKeys = 1 << 16;
+  static constexpr int      kNumBenchOps  = 1 << 20;
+
+  // Ordered sets with a common interface used for benchmarking:
+  // SkipList and Treap are serialized with a SpinLock
+  struct LockedSkipList {
+    SkipList<uint32_t, kNumBenchKeys> sl;
+    SpinLock                          lck;
+    inline bool Find(uint32_t k) {
+      LockGuard<SpinLock> lkg{lck}; return sl.Find(k) != sl.end();
+    }
+    inline bool Insert(uint32_t k) {
+      LockGuard<SpinLock> lkg{lck}; return sl.Insert(uint32_t{k}).second;
+    }
+    inline bool Remove(uint32_t k) {
+      LockGuard<SpinLock> lkg{lck}; return sl.Remove(k).second;
+    }
+  };
+  struct LockedTreap {
+    Treap<uint32_t, uint32_t> t;
+    SpinLock                  lck;
+    inline bool Find(uint32_t k) {
+      LockGuard<SpinLock> lkg{lck}; return t.Find(k) != t.end();
+    }
+    inline bool Insert(uint32_t k) {
+      LockGuard<SpinLock> lkg{lck};
+      return t.Emplace(uint32_t{k}, uint32_t{k}).second;
+    }
+    inline bool Remove(uint32_t k) {
+      LockGuard<SpinLock> lkg{lck}; return t.Delete(k);
+    }
+  };
+  struct ConcurSet {
+    CSkipList s;
+    inline bool Find(uint32_t k) { return s.Find(k); }
+    inline bool Insert(uint32_t k) { return s.Insert(k); }
+    inline bool Remove(uint32_t k) { return s.Remove(k); }
+  };
+
+  static bool Ascending(const CSkipList& s);
+  template <typename Set>
+  Clock::TimeDuration BenchmarkHelper(int num_threads);
+};
+
+constexpr const char* ConcurSkipListTester::kUnitStr;
+constexpr int      ConcurSkipListTester::kNumThreads;
+constexpr uint32_t ConcurSkipListTester::kNumKeys;
+constexpr uint32_t ConcurSkipListTester::kNumHotKeys;
+constexpr int      ConcurSkipListTester::kNumHotOps;
+constexpr uint32_t ConcurSkipListTester::kNumBenchKeys;
+constexpr int      ConcurSkipListTester::kNumBenchOps;
+
+bool ConcurSkipListTester::Ascending(const CSkipList& s) {
+  bool     first = true, ascending = true;
+  uint32_t prev  = 0;
+  s.InOrder([&first, &ascending, &prev](const uint32_t& val) {
+      ascending = ascending && (first || prev < val);
+      first = false; prev = val;
+      return 1;
+    });
+  return ascending;
+}
+
+// 1. Insert shuffled keys: duplicate inserts fail.
+// 2. InOrder visits keys in ascending order. Range visits [lo, hi).
+// 3. Remove even keys: removes of absent keys fail.
+void ConcurSkipListTester::BasicTest() {
+  CSkipList        s{};
+  vector<uint32_t> keys(kNumKeys);
+  for (uint32_t i=0; i<kNumKeys; ++i)
+    keys.at(i) = i;
+  shuffle(keys.begin(), keys.end(), default_random_engine{});
+
+  CHECK(s.Empty());
+  CHECK(!s.Find(0));
+  CHECK(!s.Remove(0));
+  for (auto k : keys)
+    CHECK(s.Insert(k));
+  for (auto k : keys)
+    CHECK(!s.Insert(k));
+  CHECK_EQ(s.Size(), kNumKeys);
+  CHECK(s.Find(kNumKeys-1));
+  CHECK(!s.Find(kNumKeys));
+
+  uint32_t expected = 0;
+  CHECK_EQ(s.InOrder([&expected](const uint32_t& val) {
+        CHECK_EQ(val, expected++); return 1;
+      }), kNumKeys);
+  expected = 10;
+  CHECK_EQ(s.Range(10, 20, [&expected](const uint32_t& val) {
+        CHECK_EQ(val, expected++); return 1;
+      }), 10);
+  CHECK_EQ(s.Range(kNumKeys, kNumKeys+10, [](const uint32_t&) {return 1;}), 0);
+
+  for (uint32_t k=0; k<kNumKeys; k+=2)
+    CHECK(s.Remove(k));
+  for (uint32_t k=0; k<kNumKeys; k+=2)
+    CHECK(!s.Remove(k));
+  CHECK_EQ(s.Size(), kNumKeys/2);
+  CHECK(!s.Find(0));
+  CHECK(s.Find(1));
+  CHECK_EQ(s.Range(0, 10, [](const uint32_t& val) {
+        CHECK_EQ(val % 2, 1); return 1;
+      }), 5);
+
+  LOG(INFO) << __FUNCTION__ << " passed";
+  return;
+}
+
+// Thread i inserts keys k with k % kNumThreads == i, and after all threads
+// complete insertion removes its odd keys. Reader concurrently validates
+// that traversal is always in ascending order.
+void ConcurSkipListTester::ConcurDisjointTest() {
+  CSkipList      s{};
+  Barrier        b{kNumThreads};
+  atomic_bool    done{false};
+  vector<thread> th;
+
+  thread reader{[&s, &done]() {
+      while (!done)
+        CHECK(Ascending(s));
+    }};
+  for (int i=0; i<kNumThreads; ++i) {
+    th.emplace_back([&s, &b, i]() {
+        for (uint32_t k=i; k<kNumKeys; k+=kNumThreads)
+          CHECK(s.Insert(k));
+        b.ArriveAndWait();
+        for (uint32_t k=i; k<kNumKeys; k+=kNumThreads)
+          CHECK(s.Find(k));
+        for (uint32_t k=i; k<kNumKeys; k+=kNumThreads)
+          if (k % 2 == 1)
+            CHECK(s.Remove(k));
+      });
+  }
+  for (auto &t : th)
+    t.join();
+  done = true;
+  reader.join();
+
+  CHECK_EQ(s.Size(), kNumKeys/2);
+  CHECK(Ascending(s));
+  for (uint32_t k=0; k<kNumKeys; ++k)
+    CHECK_EQ(s.Find(k), (k % 2 == 0));
+
+  LOG(INFO) << __FUNCTION__ << " passed";
+  return;
+}
+
+// All threads insert & remove the same few keys: every key is inserted
+// or removed successfully by exactly one thread at a time, so successful
+// inserts - successful removes equals final size.
+void ConcurSkipListTester::ConcurSameKeyTest() {
+  CSkipList      s{};
+  atomic_int     num_ins{0}, num_rem{0};
+  vector<thread> th;
+
+  for (int i=0; i<kNumThreads; ++i) {
+    th.emplace_back([&s, &num_ins, &num_rem, i]() {
+        default_random_engine gen(i);
+        uniform_int_distribution<uint32_t> dis(0, kNumHotKeys-1);
+        for (int j=0; j<kNumHotOps; ++j) {
+          uint32_t k = dis(gen);
+          if (j % 2 == 0)
+            num_ins += s.Insert(k) ? 1 : 0;
+          else
+            num_rem += s.Remove(k) ? 1 : 0;
+        }
+      });
+  }
+  for (auto &t : th)
+    t.join();
+
+  CHECK_EQ(static_cast<int>(s.Size()), num_ins - num_rem);
+  CHECK_EQ(s.InOrder([](const uint32_t&) {return 1;}), s.Size());
+  CHECK(Ascending(s));
+  LOG(INFO) << "Inserts=" << num_ins << ": Removes=" << num_rem
+            << ": " << s;
+
+  LOG(INFO) << __FUNCTION__ << " passed";
+  return;
+}
+
+// Removed nodes retired by all threads are reclaimed after grace period
+void ConcurSkipListTester::ReclaimTest() {
+  EpochMgr::Singleton()->Synchronize();
+  CHECK_EQ(EpochMgr::Singleton()->NumRetired(), 0);
+  LOG(INFO) << *EpochMgr::Singleton();
+
+  LOG(INFO) << __FUNCTION__ << " passed";
+  return;
+}
+
+// Half the keys are populated. Each thread executes its share of
+// kNumBenchOps operations on random keys: 80% Find, 10% Insert, 10% Remove
+template <typename Set>
+Clock::TimeDuration ConcurSkipListTester::BenchmarkHelper(int num_threads) {
+  Set            set;
+  vector<thread> th;
+  for (uint32_t k=0; k<kNumBenchKeys; k+=2)
+    set.Insert(k);
+
+  auto fn = [&set, num_threads](int i) {
+    default_random_engine gen(i);
+    uniform_int_distribution<uint32_t> dis(0, kNumBenchKeys-1);
+    for (int j=0; j<kNumBenchOps/num_threads; ++j) {
+      uint32_t k = dis(gen);
+      switch (j % 10) {
+        case 0:  set.Insert(k); break;
+        case 5:  set.Remove(k); break;
+        default: set.Find(k); break;
+      }
+    }
+  };
+
+  Clock::TimePoint now = Clock::USecs();
+  for (int i=1; i<num_threads; ++i)
+    th.emplace_back(fn, i);
+  fn(0);
+  for (auto &t : th)
+    t.join();
+
+  return (Clock::USecs() - now);
+}
+
+void ConcurSkipListTester::BenchmarkTest() {
+  for (int n=1; n<=32; n*=2) {
+    Clock::TimeDuration durS = BenchmarkHelper<LockedSkipList>(n);
+    Clock::TimeDuration durT = BenchmarkHelper<LockedTreap>(n);
+    Clock::TimeDuration durC = BenchmarkHelper<ConcurSet>(n);
+    LOG(INFO) << "Time: " << kNumBenchOps << " ops by " << n
+              << " threads for Locked SkipList/Locked Treap/ConcurSkipList = "
+              << durS << "/" << durT << "/" << durC << kUnitStr
+              << ": Mops/sec = "
+              << static_cast<double>(kNumBenchOps)/durS << "/"
+              << static_cast<double>(kNumBenchOps)/durT << "/"
+              << static_cast<double>(kNumBenchOps)/durC;
+  }
+
+  return;
+}
+
+int main(int argc, char *argv[]) {
+  Init::InitEnv(&argc, &argv);
+
+  ConcurSkipListTester test{};
+  test.BasicTest();
+  test.ConcurDisjointTest();
+  test.ConcurSameKeyTest();
+  test.ReclaimTest();
+  if (FLAGS_benchmark)
+    test.BenchmarkTest();
+
+  return 0;
+}
+
+DEFINE_bool(auto_test, false,
+            "test run programmatically (when true) or manually (when false)");
+DEFINE_bool(benchmark, false,
+            "test run when benchmarking concurrent skip list against "
+            "locked SkipList and locked Treap");
@@ -0,0 +1,159 @@
+// Copyright 2016 asarcar Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Author: Arijit Sarcar <sarcar_a@yahoo.com>
+
+// Standard C++ Headers
+#include <atomic>           // std::atomic
+#include <iostream>         // std::cout
+#include <thread>           // std::thread
+#include <vector>           // std::vector
+// Standard C Headers
+// Google Headers
+#include <glog/logging.h>
+// Local Headers
+#include "utils/basic/basictypes.h"
+#include "utils/basic/init.h"
+#include "utils/concur/barrier.h"
+#include "utils/concur/epoch.h"
+
+using namespace asarcar;
+using namespace asarcar::utils;
+using namespace asarcar::utils::concur;
+
+using namespace std;
+
+// Declarations
+DECLARE_bool(auto_test);
+
+class EpochTester {
+ public:
+  EpochTester() {}
+  ~EpochTester() = default;
+
+  void GuardTest();
+  void ReaderBlocksReclaimTest();
+  void ConcurRetireTest();
+
+ private:
+  static constexpr int kNumThreads = 4;
+  static constexpr int kNumRetire  = 1000;
+
+  // Counts # objects deleted
+  struct Obj {
+    static atomic_int num_deleted;
+    int val;
+    explicit Obj(int v) : val{v} {}
+    ~Obj() { val = -1; ++num_deleted; }
+  };
+
+  EpochMgr* mgr_p_ = EpochMgr::Singleton();
+};
+
+constexpr int EpochTester::kNumThreads;
+constexpr int EpochTester::kNumRetire;
+atomic_int EpochTester::Obj::num_deleted{0};
+
+// 1. Nested guards: epoch does not advance past the outermost guard.
+// 2. Synchronize deletes retired objects once no guard is held.
+void EpochTester::GuardTest() {
+  uint64_t epoch = mgr_p_->Epoch();
+  int      num_deleted = Obj::num_deleted;
+  {
+    EpochMgr::Guard g1{};
+    {
+      EpochMgr::Guard g2{};
+      mgr_p_->Retire(new Obj{1});
+    }
+    // still in critical section: object retired but not deleted
+    CHECK_EQ(Obj::num_deleted, num_deleted);
+  }
+  mgr_p_->Synchronize();
+  CHECK_EQ(Obj::num_deleted, num_deleted + 1);
+  CHECK_GE(mgr_p_->Epoch(), epoch + 2);
+  CHECK_EQ(mgr_p_->NumRetired(), 0);
+
+  LOG(INFO) << __FUNCTION__ << " passed";
+  return;
+}
+
+// Reader observes object & remains in critical section while writer
+// retires it along with many more: object is not deleted until the
+// reader exits critical section.
+void EpochTester::ReaderBlocksReclaimTest() {
+  Obj*    obj_p = new Obj{7};
+  Barrier b{2};
+  thread  th{[&b, obj_p]() {
+      EpochMgr::Guard g{};
+      b.ArriveAndWait(); // reader observed obj
+      b.ArriveAndWait(); // writer retired obj
+      CHECK_EQ(obj_p->val, 7);
+    }};
+
+  b.ArriveAndWait();
+  int num_deleted = Obj::num_deleted;
+  mgr_p_->Retire(obj_p);
+  // exceed reclaim threshold: reclaim attempted but obj_p protected
+  for (int i=0; i<static_cast<int>(EpochMgr::RECLAIM_THRESHOLD)*2; ++i)
+    mgr_p_->Retire(new Obj{i});
+  CHECK_EQ(Obj::num_deleted, num_deleted);
+  b.ArriveAndWait();
+  th.join();
+
+  mgr_p_->Synchronize();
+  CHECK_EQ(Obj::num_deleted,
+           num_deleted + 1 + static_cast<int>(EpochMgr::RECLAIM_THRESHOLD)*2);
+
+  LOG(INFO) << __FUNCTION__ << " passed";
+  return;
+}
+
+// Threads concurrently retire objects in critical sections and exit:
+// retired objects of exited threads are reclaimed by Synchronize.
+void EpochTester::ConcurRetireTest() {
+  int            num_deleted = Obj::num_deleted;
+  vector<thread> th;
+  for (int i=0; i<kNumThreads; ++i) {
+    th.emplace_back([this]() {
+        for (int j=0; j<kNumRetire; ++j) {
+          EpochMgr::Guard g{};
+          mgr_p_->Retire(new Obj{j});
+        }
+      });
+  }
+  for (auto &t : th)
+    t.join();
+
+  mgr_p_->Synchronize();
+  CHECK_EQ(Obj::num_deleted, num_deleted + kNumThreads*kNumRetire);
+  CHECK_EQ(mgr_p_->NumRetired(), 0);
+  LOG(INFO) << *mgr_p_;
+
+  LOG(INFO) << __FUNCTION__ << " passed";
+  return;
+}
+
+int main(int argc, char *argv[]) {
+  Init::InitEnv(&argc, &argv);
+
+  EpochTester test{};
+  test.GuardTest();
+  test.ReaderBlocksReclaimTest();
+  test.ConcurRetireTest();
+
+  return 0;
+}
+
+DEFINE_bool(auto_test, false,
+            "test run programmatically (when true) or manually (when false)");
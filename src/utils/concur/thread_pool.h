@@ -66,6 +66,8 @@ class ThreadPool {
     task_q_.Push(std::move(fn));
   }
 
+  inline size_t NumThreads(void) const { return task_ths_.size(); }
+
  private:
   ConcurBlockQ<F>                           task_q_;
   asarcar::utils::ds::Elist<std::thread>    task_ths_;
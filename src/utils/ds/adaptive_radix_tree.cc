@@ -0,0 +1,741 @@
+// Copyright 2015 asarcar Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Author: Arijit Sarcar <sarcar_a@yahoo.com>
+
+
+// Standard C++ Headers
+#include <algorithm>        // std::min
+#include <sstream>          // std::ostringstream
+// Standard C Headers
+#include <cstring>          // memcpy
+#if defined(__SSE2__)
+#include <emmintrin.h>      // SSE2 intrinsics
+#endif
+// Google Headers
+#include <glog/logging.h>   
+// Local Headers
+#include "utils/ds/adaptive_radix_tree.h"
+
+using namespace std;
+
+namespace asarcar { namespace utils { namespace ds {
+//-----------------------------------------------------------------------------
+namespace {
+// Node4 & Node16: keys are kept sorted for ordered iteration
+template <typename Node>
+inline void InsertSorted(Node* n_p, uint8_t b, uintptr_t r) {
+  int i = n_p->num_children;
+  for (; (i > 0) && (n_p->keys[i - 1] > b); --i) {
+    n_p->keys[i]     = n_p->keys[i - 1];
+    n_p->children[i] = n_p->children[i - 1];
+  }
+  n_p->keys[i]     = b;
+  n_p->children[i] = r;
+  ++n_p->num_children;
+}
+
+template <typename Node>
+inline void RemoveSorted(Node* n_p, uint8_t b) {
+  int i = 0;
+  while (n_p->keys[i] != b)
+    ++i;
+  for (--n_p->num_children; i < n_p->num_children; ++i) {
+    n_p->keys[i]     = n_p->keys[i + 1];
+    n_p->children[i] = n_p->children[i + 1];
+  }
+  n_p->children[i] = 0;
+}
+
+// Copies sorted keys & children of Node4/Node16 from_p to to_p
+template <typename From, typename To>
+inline void CopySorted(const From* from_p, To* to_p) {
+  for (int i=0; i<from_p->num_children; ++i) {
+    to_p->keys[i]     = from_p->keys[i];
+    to_p->children[i] = from_p->children[i];
+  }
+  to_p->num_children = from_p->num_children;
+}
+} // namespace
+
+template <typename Value>
+constexpr size_t AdaptiveRadixTree<Value>::MAX_PREFIX_LEN;
+
+template <typename Value>
+AdaptiveRadixTree<Value>&
+AdaptiveRadixTree<Value>::operator =(AdaptiveRadixTree&& other) {
+  if (this == &other)
+    return *this;
+  Clear();
+  root_       = other.root_;
+  value_size_ = other.value_size_;
+  for (int t=0; t<NUM_TYPES; ++t) {
+    num_nodes_[t]       = other.num_nodes_[t];
+    other.num_nodes_[t] = 0;
+  }
+  other.root_       = 0;
+  other.value_size_ = 0;
+  return *this;
+}
+
+template <typename Value>
+void AdaptiveRadixTree<Value>::Clear() {
+  FreeTree(root_);
+  root_       = 0;
+  value_size_ = 0;
+}
+
+template <typename Value>
+size_t AdaptiveRadixTree<Value>::MemSize() const {
+  return (num_nodes_[NODE4]*sizeof(Node4) + num_nodes_[NODE16]*sizeof(Node16) +
+          num_nodes_[NODE48]*sizeof(Node48) +
+          num_nodes_[NODE256]*sizeof(Node256) + value_size_*sizeof(Leaf));
+}
+
+template <typename Value>
+std::string AdaptiveRadixTree<Value>::to_string(void) const {
+  ostringstream oss;
+  oss << "#keys " << Size() << ": #nodes 4/16/48/256 " << num_nodes_[NODE4]
+      << "/" << num_nodes_[NODE16] << "/" << num_nodes_[NODE48] << "/"
+      << num_nodes_[NODE256] << ": #bytes " << MemSize();
+  return oss.str();
+}
+
+template <typename Value>
+ItA<Value> AdaptiveRadixTree<Value>::Begin() const {
+  ItA<Value> it{this, nullptr};
+  it.seeked_ = true;
+  it.leaf_p_ = Descend(root_, &it.path_);
+  return it;
+}
+
+// Optimistic: prefixes are skipped on the way down. The key is compared
+// once against the leaf reached.
+template <typename Value>
+ItA<Value> AdaptiveRadixTree<Value>::Find(const std::string& key) const {
+  Ref    r     = root_;
+  size_t depth = 0;
+  while (r != 0) {
+    if (IsLeaf(r)) {
+      Leaf* l_p = AsLeaf(r);
+      return (l_p->kv.first == key) ? ItA<Value>{this, l_p} : End();
+    }
+    Inner* n_p = AsInner(r);
+    depth += n_p->prefix_len;
+    if (depth >= key.size()) {
+      if ((depth == key.size()) && (n_p->leaf_p != nullptr) &&
+          (n_p->leaf_p->kv.first == key))
+        return ItA<Value>{this, n_p->leaf_p};
+      return End();
+    }
+    Ref* c_p = FindChild(n_p, key[depth]);
+    if (c_p == nullptr)
+      return End();
+    r = *c_p;
+    ++depth;
+  }
+  return End();
+}
+
+// Pessimistic: prefixes are compared on the way down, so the leaf of
+// every inner node passed is a prefix of key.
+template <typename Value>
+ItA<Value>
+AdaptiveRadixTree<Value>::LongestPrefixMatch(const std::string& key) const {
+  Leaf*  best_p = nullptr;
+  Ref    r      = root_;
+  size_t depth  = 0;
+  while (r != 0) {
+    if (IsLeaf(r)) {
+      Leaf*         l_p = AsLeaf(r);
+      const string& lk  = l_p->kv.first;
+      if ((lk.size() <= key.size()) &&
+          (memcmp(lk.data() + depth, key.data() + depth,
+                  lk.size() - depth) == 0))
+        best_p = l_p;
+      break;
+    }
+    Inner* n_p = AsInner(r);
+    if (PrefixMatch(n_p, key, depth) < n_p->prefix_len)
+      break;
+    depth += n_p->prefix_len;
+    if (n_p->leaf_p != nullptr)
+      best_p = n_p->leaf_p;
+    if (depth == key.size())
+      break;
+    Ref* c_p = FindChild(n_p, key[depth]);
+    if (c_p == nullptr)
+      break;
+    r = *c_p;
+    ++depth;
+  }
+  return ItA<Value>{this, best_p};
+}
+
+template <typename Value>
+typename AdaptiveRadixTree<Value>::InsertRetType
+AdaptiveRadixTree<Value>::Insert(KeyValue kv) {
+  const string& key   = kv.first;
+  Ref*          ref_p = &root_;
+  size_t        depth = 0;
+  // key is moved into the new leaf: callers place it last
+  auto place = [](Node4* n_p, Leaf* l_p, size_t d) {
+    if (l_p->kv.first.size() == d)
+      n_p->leaf_p = l_p;
+    else
+      InsertSorted(n_p, l_p->kv.first[d], ToRef(l_p));
+  };
+
+  while (true) {
+    Ref r = *ref_p;
+    if (r == 0) {
+      Leaf* l_p = new Leaf{std::move(kv)};
+      *ref_p = ToRef(l_p);
+      ++value_size_;
+      return {ItA<Value>{this, l_p}, true};
+    }
+
+    if (IsLeaf(r)) {
+      // Lazy expansion: split leaf into a Node4 with the common bytes
+      Leaf*         l_p = AsLeaf(r);
+      const string& lk  = l_p->kv.first;
+      if (lk == key)
+        return {ItA<Value>{this, l_p}, false};
+      size_t m   = 0;
+      size_t lim = std::min(lk.size(), key.size()) - depth;
+      while ((m < lim) && (lk[depth + m] == key[depth + m]))
+        ++m;
+      Node4* n_p  = NewNode<Node4>(NODE4);
+      SetPrefix(n_p, key, depth, m);
+      Leaf*  nl_p = new Leaf{std::move(kv)};
+      place(n_p, l_p, depth + m);
+      place(n_p, nl_p, depth + m);
+      *ref_p = ToRef(n_p);
+      ++value_size_;
+      return {ItA<Value>{this, nl_p}, true};
+    }
+
+    Inner* n_p = AsInner(r);
+    size_t m   = PrefixMatch(n_p, key, depth);
+    if (m < n_p->prefix_len) {
+      // Path compression: split prefix of n_p at the first mismatch
+      Node4*  p_p = NewNode<Node4>(NODE4);
+      SetPrefix(p_p, key, depth, m);
+      uint8_t b;
+      if (n_p->prefix_len <= MAX_PREFIX_LEN) {
+        b = n_p->prefix[m];
+        n_p->prefix_len -= m + 1;
+        memmove(n_p->prefix, n_p->prefix + m + 1, n_p->prefix_len);
+      } else {
+        const string& lk = MinLeaf(r)->kv.first;
+        b = lk[depth + m];
+        n_p->prefix_len -= m + 1;
+        memcpy(n_p->prefix, lk.data() + depth + m + 1,
+               std::min(static_cast<size_t>(n_p->prefix_len), MAX_PREFIX_LEN));
+      }
+      InsertSorted(p_p, b, r);
+      Leaf* nl_p = new Leaf{std::move(kv)};
+      place(p_p, nl_p, depth + m);
+      *ref_p = ToRef(p_p);
+      ++value_size_;
+      return {ItA<Value>{this, nl_p}, true};
+    }
+
+    depth += n_p->prefix_len;
+    if (depth == key.size()) {
+      if (n_p->leaf_p != nullptr)
+        return {ItA<Value>{this, n_p->leaf_p}, false};
+      n_p->leaf_p = new Leaf{std::move(kv)};
+      ++value_size_;
+      return {ItA<Value>{this, n_p->leaf_p}, true};
+    }
+    uint8_t b   = key[depth];
+    Ref*    c_p = FindChild(n_p, b);
+    if (c_p == nullptr) {
+      Leaf* nl_p = new Leaf{std::move(kv)};
+      AddChild(ref_p, n_p, b, ToRef(nl_p));
+      ++value_size_;
+      return {ItA<Value>{this, nl_p}, true};
+    }
+    ref_p = c_p;
+    ++depth;
+  }
+}
+
+template <typename Value>
+ItA<Value> AdaptiveRadixTree<Value>::Erase(ItA<Value> it) {
+  DCHECK(it.art_p_ == this);
+  DCHECK(it.leaf_p_ != nullptr);
+  ItA<Value> next = it;
+  ++next;
+  // Leaves are not moved when nodes shrink: next leaf stays valid
+  Erase(it.leaf_p_->kv.first);
+  return ItA<Value>{this, next.leaf_p_};
+}
+
+// Leaf is freed last: key may be the key of the leaf erased
+template <typename Value>
+size_t AdaptiveRadixTree<Value>::Erase(const std::string& key) {
+  Ref*   ref_p        = &root_;
+  Ref*   parent_ref_p = nullptr;
+  Inner* parent_p     = nullptr;
+  size_t depth        = 0;
+  while (*ref_p != 0) {
+    Ref r = *ref_p;
+    if (IsLeaf(r)) {
+      Leaf* l_p = AsLeaf(r);
+      if (l_p->kv.first != key)
+        return 0;
+      if (parent_p == nullptr)
+        root_ = 0;
+      else
+        RemoveChild(parent_ref_p, parent_p, key[depth - 1]);
+      --value_size_;
+      delete l_p;
+      return 1;
+    }
+    Inner* n_p = AsInner(r);
+    depth += n_p->prefix_len;
+    if (depth >= key.size()) {
+      Leaf* l_p = n_p->leaf_p;
+      if ((depth > key.size()) || (l_p == nullptr) || (l_p->kv.first != key))
+        return 0;
+      n_p->leaf_p = nullptr;
+      Compact(ref_p, n_p);
+      --value_size_;
+      delete l_p;
+      return 1;
+    }
+    Ref* c_p = FindChild(n_p, key[depth]);
+    if (c_p == nullptr)
+      return 0;
+    parent_ref_p = ref_p;
+    parent_p     = n_p;
+    ref_p        = c_p;
+    ++depth;
+  }
+  return 0;
+}
+
+template <typename Value>
+template <typename Node>
+Node* AdaptiveRadixTree<Value>::NewNode(NodeType type, const Inner* from_p) {
+  Node* n_p = new Node();
+  n_p->type = type;
+  if (from_p != nullptr) {
+    n_p->prefix_len = from_p->prefix_len;
+    memcpy(n_p->prefix, from_p->prefix, MAX_PREFIX_LEN);
+    n_p->leaf_p     = from_p->leaf_p;
+  }
+  ++num_nodes_[type];
+  return n_p;
+}
+
+template <typename Value>
+void AdaptiveRadixTree<Value>::FreeNode(Inner* n_p) {
+  --num_nodes_[n_p->type];
+  switch (n_p->type) {
+    case NODE4:  delete static_cast<Node4*>(n_p); break;
+    case NODE16: delete static_cast<Node16*>(n_p); break;
+    case NODE48: delete static_cast<Node48*>(n_p); break;
+    default:     delete static_cast<Node256*>(n_p); break;
+  }
+}
+
+template <typename Value>
+void AdaptiveRadixTree<Value>::FreeTree(Ref r) {
+  if (r == 0)
+    return;
+  if (IsLeaf(r)) {
+    delete AsLeaf(r);
+    return;
+  }
+  Inner* n_p = AsInner(r);
+  int    b   = -1;
+  for (Ref c = NextChild(n_p, 0, &b); c != 0; c = NextChild(n_p, b + 1, &b))
+    FreeTree(c);
+  delete n_p->leaf_p;
+  FreeNode(n_p);
+}
+
+template <typename Value>
+typename AdaptiveRadixTree<Value>::Ref*
+AdaptiveRadixTree<Value>::FindChild(Inner* n_p, uint8_t b) {
+  switch (n_p->type) {
+    case NODE4: {
+      Node4* n4_p = static_cast<Node4*>(n_p);
+      for (int i=0; i<n4_p->num_children; ++i) {
+        if (n4_p->keys[i] == b)
+          return &n4_p->children[i];
+      }
+      return nullptr;
+    }
+    case NODE16: {
+      Node16* n16_p = static_cast<Node16*>(n_p);
+#if defined(__SSE2__)
+      // Compare b against all 16 keys at once: bits past num_children
+      // are masked off
+      __m128i  cmp  = _mm_cmpeq_epi8(
+          _mm_set1_epi8(static_cast<char>(b)),
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(n16_p->keys)));
+      uint32_t mask = _mm_movemask_epi8(cmp) &
+          ((1U << n16_p->num_children) - 1);
+      return (mask == 0) ? nullptr : &n16_p->children[__builtin_ctz(mask)];
+#else
+      for (int i=0; i<n16_p->num_children; ++i) {
+        if (n16_p->keys[i] == b)
+          return &n16_p->children[i];
+      }
+      return nullptr;
+#endif
+    }
+    case NODE48: {
+      Node48* n48_p = static_cast<Node48*>(n_p);
+      uint8_t idx   = n48_p->index[b];
+      return (idx == 0) ? nullptr : &n48_p->children[idx - 1];
+    }
+    default: {
+      Node256* n256_p = static_cast<Node256*>(n_p);
+      return (n256_p->children[b] == 0) ? nullptr : &n256_p->children[b];
+    }
+  }
+}
+
+template <typename Value>
+typename AdaptiveRadixTree<Value>::Ref
+AdaptiveRadixTree<Value>::NextChild(const Inner* n_p, int from, int* b_p) {
+  switch (n_p->type) {
+    case NODE4:
+    case NODE16: {
+      const uint8_t* keys_p = (n_p->type == NODE4) ?
+          static_cast<const Node4*>(n_p)->keys :
+          static_cast<const Node16*>(n_p)->keys;
+      const Ref*     children_p = (n_p->type == NODE4) ?
+          static_cast<const Node4*>(n_p)->children :
+          static_cast<const Node16*>(n_p)->children;
+      for (int i=0; i<n_p->num_children; ++i) {
+        if (keys_p[i] >= from) {
+          *b_p = keys_p[i];
+          return children_p[i];
+        }
+      }
+      return 0;
+    }
+    case NODE48: {
+      const Node48* n48_p = static_cast<const Node48*>(n_p);
+      for (int b=from; b<256; ++b) {
+        if (n48_p->index[b] != 0) {
+          *b_p = b;
+          return n48_p->children[n48_p->index[b] - 1];
+        }
+      }
+      return 0;
+    }
+    default: {
+      const Node256* n256_p = static_cast<const Node256*>(n_p);
+      for (int b=from; b<256; ++b) {
+        if (n256_p->children[b] != 0) {
+          *b_p = b;
+          return n256_p->children[b];
+        }
+      }
+      return 0;
+    }
+  }
+}
+
+template <typename Value>
+void AdaptiveRadixTree<Value>::AddChild(Ref* ref_p, Inner* n_p, uint8_t b,
+                                        Ref r) {
+  switch (n_p->type) {
+    case NODE4: {
+      Node4* n4_p = static_cast<Node4*>(n_p);
+      if (n4_p->num_children < 4) {
+        InsertSorted(n4_p, b, r);
+        return;
+      }
+      Node16* n16_p = NewNode<Node16>(NODE16, n4_p);
+      CopySorted(n4_p, n16_p);
+      InsertSorted(n16_p, b, r);
+      *ref_p = ToRef(n16_p);
+      FreeNode(n4_p);
+      return;
+    }
+    case NODE16: {
+      Node16* n16_p = static_cast<Node16*>(n_p);
+      if (n16_p->num_children < 16) {
+        InsertSorted(n16_p, b, r);
+        return;
+      }
+      Node48* n48_p = NewNode<Node48>(NODE48, n16_p);
+      for (int i=0; i<n16_p->num_children; ++i) {
+        n48_p->index[n16_p->keys[i]] = i + 1;
+        n48_p->children[i]           = n16_p->children[i];
+      }
+      n48_p->num_children = n16_p->num_children;
+      *ref_p = ToRef(n48_p);
+      FreeNode(n16_p);
+      AddChild(ref_p, n48_p, b, r);
+      return;
+    }
+    case NODE48: {
+      Node48* n48_p = static_cast<Node48*>(n_p);
+      if (n48_p->num_children < 48) {
+        int slot = 0;
+        while (n48_p->children[slot] != 0)
+          ++slot;
+        n48_p->children[slot] = r;
+        n48_p->index[b]       = slot + 1;
+        ++n48_p->num_children;
+        return;
+      }
+      Node256* n256_p = NewNode<Node256>(NODE256, n48_p);
+      for (int i=0; i<256; ++i) {
+        if (n48_p->index[i] != 0)
+          n256_p->children[i] = n48_p->children[n48_p->index[i] - 1];
+      }
+      n256_p->children[b]  = r;
+      n256_p->num_children = n48_p->num_children + 1;
+      *ref_p = ToRef(n256_p);
+      FreeNode(n48_p);
+      return;
+    }
+    default: {
+      Node256* n256_p = static_cast<Node256*>(n_p);
+      n256_p->children[b] = r;
+      ++n256_p->num_children;
+      return;
+    }
+  }
+}
+
+// Shrink thresholds are below the grow thresholds: alternating inserts &
+// erases at a boundary do not reallocate every time
+template <typename Value>
+void AdaptiveRadixTree<Value>::RemoveChild(Ref* ref_p, Inner* n_p,
+                                           uint8_t b) {
+  switch (n_p->type) {
+    case NODE4:
+      RemoveSorted(static_cast<Node4*>(n_p), b);
+      Compact(ref_p, n_p);
+      return;
+    case NODE16: {
+      Node16* n16_p = static_cast<Node16*>(n_p);
+      RemoveSorted(n16_p, b);
+      if (n16_p->num_children > 3)
+        return;
+      Node4* n4_p = NewNode<Node4>(NODE4, n16_p);
+      CopySorted(n16_p, n4_p);
+      *ref_p = ToRef(n4_p);
+      FreeNode(n16_p);
+      return;
+    }
+    case NODE48: {
+      Node48* n48_p = static_cast<Node48*>(n_p);
+      n48_p->children[n48_p->index[b] - 1] = 0;
+      n48_p->index[b]                      = 0;
+      if (--n48_p->num_children > 12)
+        return;
+      Node16* n16_p = NewNode<Node16>(NODE16, n48_p);
+      for (int i=0; i<256; ++i) {
+        if (n48_p->index[i] != 0)
+          InsertSorted(n16_p, i, n48_p->children[n48_p->index[i] - 1]);
+      }
+      *ref_p = ToRef(n16_p);
+      FreeNode(n48_p);
+      return;
+    }
+    default: {
+      Node256* n256_p = static_cast<Node256*>(n_p);
+      n256_p->children[b] = 0;
+      if (--n256_p->num_children > 37)
+        return;
+      Node48* n48_p = NewNode<Node48>(NODE48, n256_p);
+      for (int i=0; i<256; ++i) {
+        if (n256_p->children[i] != 0) {
+          n48_p->children[n48_p->num_children] = n256_p->children[i];
+          n48_p->index[i] = ++n48_p->num_children;
+        }
+      }
+      *ref_p = ToRef(n48_p);
+      FreeNode(n256_p);
+      return;
+    }
+  }
+}
+
+template <typename Value>
+void AdaptiveRadixTree<Value>::Compact(Ref* ref_p, Inner* n_p) {
+  if (n_p->num_children == 0) {
+    *ref_p = (n_p->leaf_p == nullptr) ? 0 : ToRef(n_p->leaf_p);
+    FreeNode(n_p);
+    return;
+  }
+  if ((n_p->num_children > 1) || (n_p->leaf_p != nullptr))
+    return;
+  int b = 0;
+  Ref c = NextChild(n_p, 0, &b);
+  if (!IsLeaf(c)) {
+    // Child prefix: prefix of n_p, key byte of child, prefix of child
+    Inner*  c_p = AsInner(c);
+    uint8_t buf[MAX_PREFIX_LEN];
+    size_t  len = std::min(static_cast<size_t>(n_p->prefix_len),
+                           MAX_PREFIX_LEN);
+    memcpy(buf, n_p->prefix, len);
+    if (len < MAX_PREFIX_LEN)
+      buf[len++] = b;
+    memcpy(buf + len, c_p->prefix,
+           std::min(static_cast<size_t>(c_p->prefix_len),
+                    MAX_PREFIX_LEN - len));
+    c_p->prefix_len += n_p->prefix_len + 1;
+    memcpy(c_p->prefix, buf, MAX_PREFIX_LEN);
+  }
+  *ref_p = c;
+  FreeNode(n_p);
+}
+
+template <typename Value>
+const typename AdaptiveRadixTree<Value>::Leaf*
+AdaptiveRadixTree<Value>::MinLeaf(Ref r) {
+  while (!IsLeaf(r)) {
+    const Inner* n_p = AsInner(r);
+    if (n_p->leaf_p != nullptr)
+      return n_p->leaf_p;
+    int b = 0;
+    r = NextChild(n_p, 0, &b);
+  }
+  return AsLeaf(r);
+}
+
+template <typename Value>
+size_t AdaptiveRadixTree<Value>::PrefixMatch(const Inner* n_p,
+                                             const std::string& key,
+                                             size_t depth) {
+  size_t len    = std::min(static_cast<size_t>(n_p->prefix_len),
+                           key.size() - depth);
+  size_t stored = std::min(len, MAX_PREFIX_LEN);
+  size_t i      = 0;
+  for (; i<stored; ++i) {
+    if (n_p->prefix[i] != static_cast<uint8_t>(key[depth + i]))
+      return i;
+  }
+  if (i == len)
+    return i;
+  // Bytes past MAX_PREFIX_LEN: compare against a leaf of the subtree
+  const string& lk = MinLeaf(ToRef(n_p))->kv.first;
+  for (; i<len; ++i) {
+    if (lk[depth + i] != key[depth + i])
+      return i;
+  }
+  return i;
+}
+
+template <typename Value>
+void AdaptiveRadixTree<Value>::SetPrefix(Inner* n_p, const std::string& key,
+                                         size_t depth, size_t len) {
+  n_p->prefix_len = len;
+  memcpy(n_p->prefix, key.data() + depth, std::min(len, MAX_PREFIX_LEN));
+}
+
+template <typename Value>
+void AdaptiveRadixTree<Value>::Seek(const Leaf* l_p,
+                                    std::vector<Frame>* path_p) const {
+  const string& key   = l_p->kv.first;
+  Ref           r     = root_;
+  size_t        depth = 0;
+  path_p->clear();
+  while (!IsLeaf(r)) {
+    Inner* n_p = AsInner(r);
+    depth += n_p->prefix_len;
+    if (depth == key.size()) {
+      DCHECK(n_p->leaf_p == l_p);
+      path_p->push_back({n_p, 0});
+      return;
+    }
+    uint8_t b = key[depth];
+    path_p->push_back({n_p, b + 1});
+    r = *FindChild(n_p, b);
+    ++depth;
+  }
+  DCHECK(AsLeaf(r) == l_p);
+}
+
+template <typename Value>
+typename AdaptiveRadixTree<Value>::Leaf*
+AdaptiveRadixTree<Value>::Descend(Ref r, std::vector<Frame>* path_p) const {
+  while (r != 0) {
+    if (IsLeaf(r))
+      return AsLeaf(r);
+    Inner* n_p = AsInner(r);
+    path_p->push_back({n_p, 0});
+    if (n_p->leaf_p != nullptr)
+      return n_p->leaf_p;
+    int b = 0;
+    r = NextChild(n_p, 0, &b);
+    path_p->back().next = b + 1;
+  }
+  return nullptr;
+}
+
+template <typename Value>
+typename AdaptiveRadixTree<Value>::Leaf*
+AdaptiveRadixTree<Value>::Next(std::vector<Frame>* path_p) const {
+  while (!path_p->empty()) {
+    Frame& f = path_p->back();
+    int    b = 0;
+    Ref    r = (f.next < 256) ? NextChild(f.node_p, f.next, &b) : 0;
+    if (r != 0) {
+      f.next = b + 1;
+      return Descend(r, path_p);
+    }
+    path_p->pop_back();
+  }
+  return nullptr;
+}
+
+template <typename Value>
+ItA<Value>& ItA<Value>::operator++() {
+  DCHECK(leaf_p_ != nullptr);
+  if (!seeked_) {
+    art_p_->Seek(leaf_p_, &path_);
+    seeked_ = true;
+  }
+  leaf_p_ = art_p_->Next(&path_);
+  return *this;
+}
+
+template <typename Value>
+std::ostream& operator << (std::ostream& os,
+                           const AdaptiveRadixTree<Value>& art) {
+  os << art.to_string();
+  return os;
+}
+
+//-----------------------------------------------------------------------------
+// Instantiate the AdaptiveRadixTree class for the RadixTrie Value types
+template class AdaptiveRadixTree<void*>;
+template class ItA<void*>;
+template std::ostream& operator << (std::ostream &os,
+                                    const AdaptiveRadixTree<void*>&);
+template class AdaptiveRadixTree<string>;
+template class ItA<string>;
+template std::ostream& operator << (std::ostream &os,
+                                    const AdaptiveRadixTree<string>&);
+template class AdaptiveRadixTree<uint32_t>;
+template class ItA<uint32_t>;
+template std::ostream& operator << (std::ostream &os,
+                                    const AdaptiveRadixTree<uint32_t>&);
+
+//-----------------------------------------------------------------------------
+} } } // namespace asarcar { namespace utils { namespace ds {
@@ -0,0 +1,258 @@
+// Copyright 2015 asarcar Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+//! @file   adaptive_radix_tree.h
+//! @brief  Adaptive Radix Tree (ART) keyed on byte strings
+//! @detail RadixTrie branches on one bit at a time: a 20 byte key may take
+//!         160 binary levels. ART branches on a whole byte per level and
+//!         keeps the fan-out of a node adaptive to its # of children:
+//!         1. Node4:   up to 4 sorted key bytes and children.
+//!         2. Node16:  up to 16 sorted key bytes: searched with SIMD.
+//!         3. Node48:  256 byte index into up to 48 children.
+//!         4. Node256: 256 children indexed by key byte.
+//!         Nodes grow (shrink) to the next larger (smaller) type on insert
+//!         (erase).
+//!         Path compression: an inner node with a single child is merged
+//!         into the child i.e. a node stores the bytes (prefix) shared by
+//!         its subtree. Only MAX_PREFIX_LEN bytes are stored: longer
+//!         prefixes are compared against a leaf of the subtree.
+//!         Lazy expansion: a subtree with a single key is the leaf itself.
+//!         Leaves store the full key so lookups compare the key once at
+//!         the leaf instead of every prefix on the way down.
+//!         A key that is a prefix of another key is stored as the leaf of
+//!         the inner node where it ends.
+//!
+//!         Reference: Leis, Kemper & Neumann, "The Adaptive Radix Tree:
+//!         ARTful Indexing for Main-Memory Databases", ICDE 2013.
+//!
+//!         Complexity
+//!         - Find/Insert/Erase/LongestPrefixMatch(S): O(n) [n: bytes in S]
+//!         - Iteration: keys in lexicographic (byte) order; ++ is O(1)
+//!           amortized.
+//!         - Thread Safety: NOT thread safe i.e. NOT internally synchronized.
+//! @author Arijit Sarcar <sarcar_a@yahoo.com>
+
+#ifndef _UTILS_DS_ADAPTIVE_RADIX_TREE_H_
+#define _UTILS_DS_ADAPTIVE_RADIX_TREE_H_
+
+// C++ Standard Headers
+#include <iostream>         // std::ostream
+#include <string>           // std::string
+#include <utility>          // std::pair
+#include <vector>           // std::vector
+// C Standard Headers
+// Google Headers
+#include <glog/logging.h>   // DCHECK
+// Local Headers
+#include "utils/basic/basictypes.h"
+
+// Method implementations are in the .cc file: instantiations are supported
+// for the Value types of the RadixTrie instantiations.
+
+//! @addtogroup ds
+//! @{
+
+namespace asarcar { namespace utils { namespace ds {
+//-----------------------------------------------------------------------------
+
+// Forward Declarations
+template <typename Value>
+class AdaptiveRadixTree;
+
+template <typename Value>
+class ItA;
+
+template <typename Value>
+std::ostream& operator << (std::ostream& os,
+                           const AdaptiveRadixTree<Value>& art);
+
+template <typename Value>
+class AdaptiveRadixTree {
+ public:
+  using KeyValue      = std::pair<std::string, Value>;
+  using KeyValuePtr   = KeyValue*;
+  using InsertRetType = std::pair<ItA<Value>, bool>;
+  friend class ItA<Value>;
+
+  static constexpr size_t MAX_PREFIX_LEN = 8;
+
+  AdaptiveRadixTree() = default;
+  ~AdaptiveRadixTree() { Clear(); }
+  AdaptiveRadixTree(const AdaptiveRadixTree&)             = delete;
+  AdaptiveRadixTree& operator =(const AdaptiveRadixTree&) = delete;
+  AdaptiveRadixTree(AdaptiveRadixTree&& other) { *this = std::move(other); }
+  AdaptiveRadixTree& operator =(AdaptiveRadixTree&& other);
+
+  inline size_t Size() const { return value_size_; }
+  // # inner nodes
+  inline size_t NSize() const {
+    return (num_nodes_[NODE4] + num_nodes_[NODE16] + num_nodes_[NODE48] +
+            num_nodes_[NODE256]);
+  }
+  inline bool Empty() const { return (value_size_ == 0); }
+  void Clear();
+  // Bytes used by nodes & leaves: excludes memory owned by keys and values
+  // (e.g. std::string bytes past the small string buffer)
+  size_t MemSize() const;
+  std::string to_string(void) const;
+
+  ItA<Value> Begin() const;
+  inline ItA<Value> End() const { return ItA<Value>{this, nullptr}; }
+  ItA<Value> Find(const std::string& key) const;
+  // Key value with the longest key that is a prefix of key
+  ItA<Value> LongestPrefixMatch(const std::string& key) const;
+
+  // Intentionally we pass input param by value: refer RadixTrie::Insert
+  InsertRetType Insert(KeyValue kv);
+  // Erases key value at it: returns iterator to the next key value
+  ItA<Value> Erase(ItA<Value> it);
+  // Erases key value of key: returns # key values erased
+  size_t Erase(const std::string& key);
+
+  // Avoid: operator for first insert - refer RadixTrie::operator[]
+  inline Value& operator[] (std::string key) {
+    InsertRetType ret = Insert({std::move(key), Value{}});
+    return ret.first->second;
+  }
+
+ private:
+  enum NodeType : uint8_t { NODE4 = 0, NODE16, NODE48, NODE256, NUM_TYPES };
+  struct Leaf {
+    explicit Leaf(KeyValue&& k) : kv{std::move(k)} {}
+    KeyValue kv;
+  };
+  // Child reference: tagged pointer i.e. low bit set for a Leaf
+  using Ref = uintptr_t;
+  struct Inner {
+    NodeType type;
+    uint16_t num_children;
+    uint32_t prefix_len;               // bytes shared by the subtree
+    uint8_t  prefix[MAX_PREFIX_LEN];   // first MAX_PREFIX_LEN of them
+    Leaf*    leaf_p;                   // key ending at this node
+  };
+  struct Node4 : Inner {
+    uint8_t keys[4];
+    Ref     children[4];
+  };
+  struct Node16 : Inner {
+    uint8_t keys[16];
+    Ref     children[16];
+  };
+  struct Node48 : Inner {
+    uint8_t index[256];                // 0: none, else slot + 1
+    Ref     children[48];
+  };
+  struct Node256 : Inner {
+    Ref     children[256];
+  };
+  // Iterator: an inner node on the path to the current leaf and the
+  // smallest key byte of its children not visited yet (256: none)
+  struct Frame {
+    const Inner* node_p;
+    int          next;
+  };
+
+  Ref    root_                = 0;
+  size_t value_size_          = 0;
+  size_t num_nodes_[NUM_TYPES]= {};
+
+  static inline bool   IsLeaf(Ref r) { return (r & 1) != 0; }
+  static inline Leaf*  AsLeaf(Ref r) { return reinterpret_cast<Leaf*>(r & ~1); }
+  static inline Inner* AsInner(Ref r) { return reinterpret_cast<Inner*>(r); }
+  static inline Ref    ToRef(Leaf* l_p) {
+    return reinterpret_cast<Ref>(l_p) | 1;
+  }
+  static inline Ref    ToRef(const Inner* n_p) {
+    return reinterpret_cast<Ref>(n_p);
+  }
+
+  // New node of type: header (prefix & leaf) is copied from from_p
+  template <typename Node>
+  Node* NewNode(NodeType type, const Inner* from_p = nullptr);
+  void  FreeNode(Inner* n_p);
+  void  FreeTree(Ref r);
+
+  // Slot of child of n_p with key byte b or nullptr
+  static Ref* FindChild(Inner* n_p, uint8_t b);
+  // Child with the smallest key byte >= from: *b_p is set to the byte.
+  // Returns 0 when none.
+  static Ref  NextChild(const Inner* n_p, int from, int* b_p);
+  // Adds child r with key byte b to n_p stored at *ref_p: grows n_p
+  // (updating *ref_p) when full
+  void AddChild(Ref* ref_p, Inner* n_p, uint8_t b, Ref r);
+  // Removes child with key byte b from n_p stored at *ref_p: shrinks
+  // n_p (updating *ref_p) when sparse
+  void RemoveChild(Ref* ref_p, Inner* n_p, uint8_t b);
+  // Replaces n_p at *ref_p with its only leaf or child (path compression)
+  void Compact(Ref* ref_p, Inner* n_p);
+
+  // A leaf of the subtree: carries the full prefix of every inner node
+  static const Leaf* MinLeaf(Ref r);
+  // # prefix bytes of n_p matching key from depth
+  static size_t PrefixMatch(const Inner* n_p, const std::string& key,
+                            size_t depth);
+  // Sets prefix of n_p to len bytes of key from depth
+  static void   SetPrefix(Inner* n_p, const std::string& key, size_t depth,
+                          size_t len);
+
+  // Iteration: path (frames) from the root to leaf l_p
+  void Seek(const Leaf* l_p, std::vector<Frame>* path_p) const;
+  // Leftmost leaf of r: frames of the inner nodes visited are pushed
+  Leaf* Descend(Ref r, std::vector<Frame>* path_p) const;
+  // Leaf after the leaf at the end of path
+  Leaf* Next(std::vector<Frame>* path_p) const;
+};
+
+template <typename Value>
+class ItA {
+ public:
+  friend class AdaptiveRadixTree<Value>;
+  ItA() = default;
+  inline bool operator ==(const ItA& other) const {
+    return ((art_p_ == other.art_p_) && (leaf_p_ == other.leaf_p_));
+  }
+  inline bool operator !=(const ItA& other) const {
+    return !this->operator==(other);
+  }
+  ItA& operator++();
+  inline typename AdaptiveRadixTree<Value>::KeyValue&
+  operator* () const {
+    DCHECK(leaf_p_ != nullptr);
+    return leaf_p_->kv;
+  }
+  inline typename AdaptiveRadixTree<Value>::KeyValuePtr
+  operator-> () const {
+    DCHECK(leaf_p_ != nullptr);
+    return &leaf_p_->kv;
+  }
+
+ private:
+  using Tree = AdaptiveRadixTree<Value>;
+  ItA(const Tree* art_p, typename Tree::Leaf* leaf_p) :
+      art_p_{art_p}, leaf_p_{leaf_p} {}
+
+  const Tree*                       art_p_  = nullptr;
+  typename Tree::Leaf*              leaf_p_ = nullptr;
+  // Path to leaf_p_: built on the first ++ of an iterator returned by a
+  // lookup, so lookups do not pay for it
+  std::vector<typename Tree::Frame> path_;
+  bool                              seeked_ = false;
+};
+
+//-----------------------------------------------------------------------------
+} } } // namespace asarcar { namespace utils { namespace ds {
+
+#endif // _UTILS_DS_ADAPTIVE_RADIX_TREE_H_
@@ -0,0 +1,636 @@
+// Copyright 2014 asarcar Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+//! @file   bplus_tree.h
+//! @brief  B+ Tree: ordered map with many keys per cache line aligned node
+//! @detail Treap and SkipList hold one key per node: every comparison of a
+//!         search chases a pointer i.e. a cache miss once the map outgrows
+//!         L2. B+ Tree nodes are NodeBytes (a multiple of CACHE_LINE_SIZE)
+//!         and cache line aligned:
+//!         - Keys of a node are sorted in a contiguous array & searched by a
+//!           branchless binary search: one miss per level of height
+//!           log_B(n), B = keys per node.
+//!         - (K,V)s live only in leaves. Leaves are doubly linked: range
+//!           scans walk leaf arrays with no search.
+//!         - Find/Emplace/Remove: O(log n). Remove borrows from or merges
+//!           with a sibling when a node falls below half full.
+//!         - Memory: nodes are at least half full i.e. at most 2x of
+//!           sizeof(K) + sizeof(V) per key plus one pointer per leaf key
+//!           fraction of inner nodes.
+//!         - Iterators are invalidated by Emplace & Remove.
+//!         - Thread Safety: NOT thread safe. For concurrent R/RW access use
+//!           synchronization.
+//! @author Arijit Sarcar <sarcar_a@yahoo.com>
+
+#ifndef _UTILS_DS_BPLUS_TREE_H_
+#define _UTILS_DS_BPLUS_TREE_H_
+
+// C++ Standard Headers
+#include <algorithm>        // std::move, std::copy, ...
+#include <iostream>         // std::ostream
+#include <new>              // placement new
+#include <type_traits>      // std::is_same
+#include <utility>          // std::pair
+// C Standard Headers
+#include <cstdlib>          // posix_memalign, free
+// Google Headers
+#include <glog/logging.h>   // CHECK, DCHECK
+// Local Headers
+#include "utils/basic/basictypes.h"
+#include "utils/basic/proc_info.h"  // CACHE_LINE_SIZE
+
+//! @addtogroup utils
+//! @{
+
+namespace asarcar { namespace utils {
+//-----------------------------------------------------------------------------
+
+// Forward Declarations
+template <typename K, typename V, size_t NodeBytes = 4*CACHE_LINE_SIZE>
+class BPlusTree;
+
+template <typename K, typename V, size_t NodeBytes>
+class BPlusTreeCIter;
+
+template <typename K, typename V, size_t NodeBytes>
+std::ostream& operator << (std::ostream& os,
+                           const BPlusTree<K,V,NodeBytes>& t);
+
+// Assumed following "Concepts" defined.
+// 1. K ordering: Ki < Kj
+// 2. K/V Initialization and Creation: default, copy and move assign ctors
+// 3. ostream operators defined: os << K
+template <typename K, typename V, size_t NodeBytes>
+class BPlusTree {
+ private:
+  struct Node;
+  struct Leaf;
+  struct Inner;
+  static constexpr uint32_t atLeast4(size_t n) { return (n < 4) ? 4 : n; }
+ public:
+  static_assert(NodeBytes % CACHE_LINE_SIZE == 0,
+                "node size must be a multiple of cache line size");
+  // Keys per leaf & inner node: as many as fit NodeBytes (at least 4)
+  static constexpr uint32_t LEAF_CAP  = atLeast4(
+      (NodeBytes - 3*sizeof(void*))/(sizeof(K) + sizeof(V)));
+  static constexpr uint32_t INNER_CAP = atLeast4(
+      (NodeBytes - 2*sizeof(void*))/(sizeof(K) + sizeof(void*)));
+  // Nodes other than root have at least MIN keys
+  static constexpr uint32_t LEAF_MIN  = LEAF_CAP/2;
+  static constexpr uint32_t INNER_MIN = INNER_CAP/2;
+  // Inner nodes have >= 3 children: height <= log3(2^64)
+  static constexpr uint32_t MAX_HEIGHT = 48;
+
+  BPlusTree() = default;
+  ~BPlusTree() {
+    if (_root != nullptr)
+      freeTree(_root, _height);
+  }
+  BPlusTree(const BPlusTree&)             = delete;
+  BPlusTree& operator =(const BPlusTree&) = delete;
+
+  // Iterator
+  friend class BPlusTreeCIter<K,V,NodeBytes>;
+  using  ItC   = BPlusTreeCIter<K,V,NodeBytes>;
+  // type returned for Modify operations Emplace
+  using  ModPr = std::pair<ItC,bool>;
+
+  inline ItC begin(void) const {
+    return ItC{this, _head, 0};
+  }
+  inline ItC last(void) const {
+    return (_tail == nullptr) ? end() : ItC{this, _tail, _tail->n - 1};
+  }
+  inline ItC end(void) const {
+    return ItC{this, nullptr, 0};
+  }
+
+  // Operations: Find/Emplace/Remove...
+  // Iterator == end() if element not found
+  ItC Find(const K& key) const {
+    if (_root == nullptr)
+      return end();
+    Leaf*    lp  = findLeaf(key);
+    uint32_t pos = lowerBound(lp->keys, lp->n, key);
+    if (pos == lp->n || key < lp->keys[pos])
+      return end();
+    return ItC{this, lp, pos};
+  }
+
+  // LowerBound: first element with key >= key or end()
+  ItC LowerBound(const K& key) const {
+    if (_root == nullptr)
+      return end();
+    Leaf*    lp  = findLeaf(key);
+    uint32_t pos = lowerBound(lp->keys, lp->n, key);
+    if (pos == lp->n)
+      return ItC{this, lp->next, 0};
+    return ItC{this, lp, pos};
+  }
+
+  // Scan: calls fn(key, val) for keys in [lo, hi) walking leaf arrays.
+  // Returns # keys visited.
+  template <typename Fn>
+  size_t Scan(const K& lo, const K& hi, const Fn& fn) const {
+    if (_root == nullptr)
+      return 0;
+    size_t   num = 0;
+    Leaf*    lp  = findLeaf(lo);
+    uint32_t pos = lowerBound(lp->keys, lp->n, lo);
+    for (; lp != nullptr; lp = lp->next, pos = 0) {
+      for (; pos < lp->n; ++pos, ++num) {
+        if (!(lp->keys[pos] < hi))
+          return num;
+        fn(lp->keys[pos], lp->vals[pos]);
+      }
+    }
+    return num;
+  }
+
+  // Constructs element in place and Inserts to BPlusTree if key does not
+  // exist. Returns <Iterator,false> if element exists (insert failed) else
+  // <iterator, true>
+  ModPr Emplace(K&& key, V&& val) {
+    if (_root == nullptr) {
+      _root   = _head = _tail = newNode<Leaf>();
+      _height = 1;
+    }
+    Inner*   path[MAX_HEIGHT];
+    uint32_t idx[MAX_HEIGHT];
+    uint32_t depth = 0;
+    Leaf*    lp    = findLeaf(key, path, idx, &depth);
+    uint32_t pos   = lowerBound(lp->keys, lp->n, key);
+    if (pos < lp->n && !(key < lp->keys[pos]))
+      return ModPr{ItC{this, lp, pos}, false};
+
+    ++_num_keys;
+    if (lp->n < LEAF_CAP) {
+      insertLeaf(lp, pos, std::move(key), std::move(val));
+      return ModPr{ItC{this, lp, pos}, true};
+    }
+
+    // Full leaf: split at mid and insert in the half of pos
+    Leaf*    rp  = newNode<Leaf>();
+    uint32_t mid = (LEAF_CAP + 1)/2;
+    std::move(lp->keys + mid, lp->keys + lp->n, rp->keys);
+    std::move(lp->vals + mid, lp->vals + lp->n, rp->vals);
+    rp->n = lp->n - mid;
+    lp->n = mid;
+    rp->next = lp->next;
+    rp->prev = lp;
+    if (rp->next != nullptr)
+      rp->next->prev = rp;
+    else
+      _tail = rp;
+    lp->next = rp;
+    if (pos > mid) {
+      lp   = rp;
+      pos -= mid;
+    }
+    insertLeaf(lp, pos, std::move(key), std::move(val));
+    ModPr pr{ItC{this, lp, pos}, true};
+
+    // Insert separator of split node in parent: parent may split in turn
+    K     sep   = rp->keys[0];
+    Node* child = rp;
+    while (depth > 0) {
+      Inner*   ip = path[--depth];
+      uint32_t i  = idx[depth];
+      if (ip->n < INNER_CAP) {
+        insertInner(ip, i, std::move(sep), child);
+        return pr;
+      }
+      // Key h of the INNER_CAP + 1 keys (ip's & sep) moves up: halves
+      // keep h = INNER_MIN & INNER_CAP - h >= INNER_MIN keys
+      Inner*   sp = newNode<Inner>();
+      uint32_t h  = INNER_CAP/2;
+      if (i == h) {
+        // sep moves up: child heads the new node
+        std::move(ip->keys + h, ip->keys + ip->n, sp->keys);
+        std::copy(ip->child + h + 1, ip->child + ip->n + 1, sp->child + 1);
+        sp->child[0] = child;
+        sp->n = ip->n - h;
+        ip->n = h;
+      } else {
+        // key m of ip moves up: sep goes to the half it falls in
+        uint32_t m  = (i < h) ? h - 1 : h;
+        K        up = std::move(ip->keys[m]);
+        std::move(ip->keys + m + 1, ip->keys + ip->n, sp->keys);
+        std::copy(ip->child + m + 1, ip->child + ip->n + 1, sp->child);
+        sp->n = ip->n - m - 1;
+        ip->n = m;
+        if (i <= m)
+          insertInner(ip, i, std::move(sep), child);
+        else
+          insertInner(sp, i - m - 1, std::move(sep), child);
+        sep = std::move(up);
+      }
+      DCHECK_GE(ip->n, INNER_MIN);
+      DCHECK_GE(sp->n, INNER_MIN);
+      child = sp;
+    }
+    CHECK_LT(_height, MAX_HEIGHT);
+    Inner* root    = newNode<Inner>();
+    root->n        = 1;
+    root->keys[0]  = std::move(sep);
+    root->child[0] = _root;
+    root->child[1] = child;
+    _root          = root;
+    ++_height;
+    return pr;
+  }
+
+  // Removes element. Returns true if element existed.
+  bool Remove(const K& key) {
+    if (_root == nullptr)
+      return false;
+    Inner*   path[MAX_HEIGHT];
+    uint32_t idx[MAX_HEIGHT];
+    uint32_t depth = 0;
+    Leaf*    lp    = findLeaf(key, path, idx, &depth);
+    uint32_t pos   = lowerBound(lp->keys, lp->n, key);
+    if (pos == lp->n || key < lp->keys[pos])
+      return false;
+
+    --_num_keys;
+    std::move(lp->keys + pos + 1, lp->keys + lp->n, lp->keys + pos);
+    std::move(lp->vals + pos + 1, lp->vals + lp->n, lp->vals + pos);
+    --lp->n;
+    if (depth == 0) {
+      if (lp->n == 0) {
+        freeNode(lp);
+        _root   = _head = _tail = nullptr;
+        _height = 0;
+      }
+      return true;
+    }
+    if (lp->n >= LEAF_MIN)
+      return true;
+
+    // Leaf underflow: borrow from a sibling or merge with one
+    Inner*   pp    = path[depth - 1];
+    uint32_t i     = idx[depth - 1];
+    Leaf*    left  = (i > 0) ? static_cast<Leaf*>(pp->child[i - 1]) : nullptr;
+    Leaf*    right = (i < pp->n) ?
+        static_cast<Leaf*>(pp->child[i + 1]) : nullptr;
+    if (left != nullptr && left->n > LEAF_MIN) {
+      std::move_backward(lp->keys, lp->keys + lp->n, lp->keys + lp->n + 1);
+      std::move_backward(lp->vals, lp->vals + lp->n, lp->vals + lp->n + 1);
+      lp->keys[0] = std::move(left->keys[left->n - 1]);
+      lp->vals[0] = std::move(left->vals[left->n - 1]);
+      --left->n;
+      ++lp->n;
+      pp->keys[i - 1] = lp->keys[0];
+      return true;
+    }
+    if (right != nullptr && right->n > LEAF_MIN) {
+      lp->keys[lp->n] = std::move(right->keys[0]);
+      lp->vals[lp->n] = std::move(right->vals[0]);
+      ++lp->n;
+      std::move(right->keys + 1, right->keys + right->n, right->keys);
+      std::move(right->vals + 1, right->vals + right->n, right->vals);
+      --right->n;
+      pp->keys[i] = right->keys[0];
+      return true;
+    }
+    if (left != nullptr) {
+      mergeLeaf(left, lp);
+      removeInner(pp, i - 1);
+    } else {
+      mergeLeaf(lp, right);
+      removeInner(pp, i);
+    }
+
+    // Inner underflow propagates up to root
+    for (--depth; depth > 0; --depth) {
+      Inner* ip = path[depth];
+      if (ip->n >= INNER_MIN)
+        return true;
+      rebalanceInner(ip, path[depth - 1], idx[depth - 1]);
+    }
+    Inner* root = static_cast<Inner*>(_root);
+    if (root->n == 0) {
+      _root = root->child[0];
+      freeNode(root);
+      --_height;
+    }
+    return true;
+  }
+
+  // Size: returns number of (K,V)s in the tree
+  inline size_t Size(void) const { return _num_keys; }
+  // Height: # of levels i.e. nodes on a root to leaf path
+  inline uint32_t Height(void) const { return _height; }
+  // Bytes of all nodes
+  inline size_t MemSize(void) const {
+    return _num_leaves*sizeof(Leaf) + _num_inners*sizeof(Inner);
+  }
+
+  // helper function to allow chained cout cmds: example
+  // cout << "BPlusTree: " << endl << t << endl << "---------" << endl;
+  friend std::ostream& operator << <>(std::ostream& os,
+                                      const BPlusTree<K,V,NodeBytes>& t);
+
+ private:
+  struct Node {
+    uint32_t n = 0; // # keys
+  };
+  struct alignas(CACHE_LINE_SIZE) Leaf : Node {
+    Leaf* prev = nullptr;
+    Leaf* next = nullptr;
+    K     keys[LEAF_CAP];
+    V     vals[LEAF_CAP];
+  };
+  // child[i] holds keys in [keys[i-1], keys[i])
+  struct alignas(CACHE_LINE_SIZE) Inner : Node {
+    K     keys[INNER_CAP];
+    Node* child[INNER_CAP + 1];
+  };
+
+  Node*    _root       = nullptr;
+  Leaf*    _head       = nullptr;
+  Leaf*    _tail       = nullptr;
+  uint32_t _height     = 0;
+  size_t   _num_keys   = 0;
+  size_t   _num_leaves = 0;
+  size_t   _num_inners = 0;
+
+  //! @fn         lowerBound
+  //! @param[in]  keys: sorted array of n keys
+  //! @returns    # keys < key. Branchless: halves range with a conditional
+  //!             move instead of a hard to predict branch.
+  static inline uint32_t lowerBound(const K* keys, uint32_t n, const K& key) {
+    if (n == 0)
+      return 0;
+    const K* base = keys;
+    while (n > 1) {
+      uint32_t half = n/2;
+      base = (base[half] < key) ? base + half : base;
+      n   -= half;
+    }
+    return static_cast<uint32_t>(base - keys) + (*base < key);
+  }
+
+  //! @fn         upperBound
+  //! @param[in]  keys: sorted array of n keys
+  //! @returns    # keys <= key: branchless as lowerBound
+  static inline uint32_t upperBound(const K* keys, uint32_t n, const K& key) {
+    if (n == 0)
+      return 0;
+    const K* base = keys;
+    while (n > 1) {
+      uint32_t half = n/2;
+      base = !(key < base[half]) ? base + half : base;
+      n   -= half;
+    }
+    return static_cast<uint32_t>(base - keys) + !(key < *base);
+  }
+
+  // Leaf of key
+  inline Leaf* findLeaf(const K& key) const {
+    Node* np = _root;
+    for (uint32_t h = _height; h > 1; --h) {
+      Inner* ip = static_cast<Inner*>(np);
+      np = ip->child[upperBound(ip->keys, ip->n, key)];
+    }
+    return static_cast<Leaf*>(np);
+  }
+
+  // Leaf of key: records inner nodes & child indices of the path
+  inline Leaf* findLeaf(const K& key, Inner** path, uint32_t* idx,
+                        uint32_t* depth_p) const {
+    Node* np = _root;
+    for (uint32_t h = _height; h > 1; --h) {
+      Inner*   ip = static_cast<Inner*>(np);
+      uint32_t i  = upperBound(ip->keys, ip->n, key);
+      path[*depth_p]  = ip;
+      idx[(*depth_p)++] = i;
+      np = ip->child[i];
+    }
+    return static_cast<Leaf*>(np);
+  }
+
+  static inline void insertLeaf(Leaf* lp, uint32_t pos, K&& key, V&& val) {
+    DCHECK_LT(lp->n, LEAF_CAP);
+    std::move_backward(lp->keys + pos, lp->keys + lp->n, lp->keys + lp->n + 1);
+    std::move_backward(lp->vals + pos, lp->vals + lp->n, lp->vals + lp->n + 1);
+    lp->keys[pos] = std::move(key);
+    lp->vals[pos] = std::move(val);
+    ++lp->n;
+  }
+
+  // inserts key at i and child at i + 1
+  static inline void insertInner(Inner* ip, uint32_t i, K&& key, Node* child) {
+    DCHECK_LT(ip->n, INNER_CAP);
+    std::move_backward(ip->keys + i, ip->keys + ip->n, ip->keys + ip->n + 1);
+    std::copy_backward(ip->child + i + 1, ip->child + ip->n + 1,
+                       ip->child + ip->n + 2);
+    ip->keys[i]      = std::move(key);
+    ip->child[i + 1] = child;
+    ++ip->n;
+  }
+
+  // removes key at i and child at i + 1
+  static inline void removeInner(Inner* ip, uint32_t i) {
+    std::move(ip->keys + i + 1, ip->keys + ip->n, ip->keys + i);
+    std::copy(ip->child + i + 2, ip->child + ip->n + 1, ip->child + i + 1);
+    --ip->n;
+  }
+
+  // appends rp to lp & frees rp
+  void mergeLeaf(Leaf* lp, Leaf* rp) {
+    DCHECK_LE(lp->n + rp->n, LEAF_CAP);
+    std::move(rp->keys, rp->keys + rp->n, lp->keys + lp->n);
+    std::move(rp->vals, rp->vals + rp->n, lp->vals + lp->n);
+    lp->n += rp->n;
+    lp->next = rp->next;
+    if (lp->next != nullptr)
+      lp->next->prev = lp;
+    else
+      _tail = lp;
+    freeNode(rp);
+  }
+
+  // ip at child index i of pp has INNER_MIN - 1 keys: rotate a key through
+  // pp from a sibling with spare keys or merge with a sibling
+  void rebalanceInner(Inner* ip, Inner* pp, uint32_t i) {
+    Inner* left  = (i > 0) ? static_cast<Inner*>(pp->child[i - 1]) : nullptr;
+    Inner* right = (i < pp->n) ? static_cast<Inner*>(pp->child[i + 1]) : nullptr;
+    if (left != nullptr && left->n > INNER_MIN) {
+      std::move_backward(ip->keys, ip->keys + ip->n, ip->keys + ip->n + 1);
+      std::copy_backward(ip->child, ip->child + ip->n + 1,
+                         ip->child + ip->n + 2);
+      ip->keys[0]     = std::move(pp->keys[i - 1]);
+      ip->child[0]    = left->child[left->n];
+      pp->keys[i - 1] = std::move(left->keys[left->n - 1]);
+      --left->n;
+      ++ip->n;
+      return;
+    }
+    if (right != nullptr && right->n > INNER_MIN) {
+      ip->keys[ip->n]      = std::move(pp->keys[i]);
+      ip->child[ip->n + 1] = right->child[0];
+      pp->keys[i]          = std::move(right->keys[0]);
+      std::move(right->keys + 1, right->keys + right->n, right->keys);
+      std::copy(right->child + 1, right->child + right->n + 1, right->child);
+      --right->n;
+      ++ip->n;
+      return;
+    }
+    if (left != nullptr) {
+      mergeInner(left, ip, std::move(pp->keys[i - 1]));
+      removeInner(pp, i - 1);
+    } else {
+      mergeInner(ip, right, std::move(pp->keys[i]));
+      removeInner(pp, i);
+    }
+  }
+
+  // appends separator key & rp to lp & frees rp
+  void mergeInner(Inner* lp, Inner* rp, K&& key) {
+    DCHECK_LE(lp->n + rp->n + 1, INNER_CAP);
+    lp->keys[lp->n] = std::move(key);
+    std::move(rp->keys, rp->keys + rp->n, lp->keys + lp->n + 1);
+    std::copy(rp->child, rp->child + rp->n + 1, lp->child + lp->n + 1);
+    lp->n += rp->n + 1;
+    freeNode(rp);
+  }
+
+  // Nodes are cache line aligned: C++11 new does not honor over alignment
+  template <typename N>
+  inline N* newNode(void) {
+    void* mem_p = nullptr;
+    CHECK_EQ(posix_memalign(&mem_p, CACHE_LINE_SIZE, sizeof(N)), 0)
+        << "B+ tree node allocation failed";
+    ++numNodes<N>();
+    return new (mem_p) N();
+  }
+  template <typename N>
+  inline void freeNode(N* np) {
+    --numNodes<N>();
+    np->~N();
+    free(np);
+  }
+  template <typename N>
+  inline size_t& numNodes(void) {
+    return std::is_same<N, Leaf>::value ? _num_leaves : _num_inners;
+  }
+
+  void freeTree(Node* np, uint32_t height) {
+    if (height == 1) {
+      freeNode(static_cast<Leaf*>(np));
+      return;
+    }
+    Inner* ip = static_cast<Inner*>(np);
+    for (uint32_t i=0; i<=ip->n; ++i)
+      freeTree(ip->child[i], height - 1);
+    freeNode(ip);
+  }
+};
+
+template <typename K, typename V, size_t NodeBytes>
+constexpr uint32_t BPlusTree<K,V,NodeBytes>::LEAF_CAP;
+template <typename K, typename V, size_t NodeBytes>
+constexpr uint32_t BPlusTree<K,V,NodeBytes>::INNER_CAP;
+template <typename K, typename V, size_t NodeBytes>
+constexpr uint32_t BPlusTree<K,V,NodeBytes>::LEAF_MIN;
+template <typename K, typename V, size_t NodeBytes>
+constexpr uint32_t BPlusTree<K,V,NodeBytes>::INNER_MIN;
+template <typename K, typename V, size_t NodeBytes>
+constexpr uint32_t BPlusTree<K,V,NodeBytes>::MAX_HEIGHT;
+
+// Const iterator: (leaf, position) in the linked leaves. end(): no leaf.
+template <typename K, typename V, size_t NodeBytes>
+class BPlusTreeCIter {
+ public:
+  using Tr        = BPlusTree<K,V,NodeBytes>;
+  using TreePtr   = const Tr*;
+  using Leaf      = typename Tr::Leaf;
+  using ItC       = typename Tr::ItC;
+  using KVPtrPair = std::pair<const K*, V*>;
+  BPlusTreeCIter(TreePtr trp, Leaf* lp, uint32_t pos) :
+      _trp{trp}, _leaf{lp}, _pos{pos} { getKVP(); }
+  inline const KVPtrPair& operator*() {
+    DCHECK(_leaf != nullptr);
+    return _kvp;
+  }
+  inline ItC& operator++() {
+    DCHECK(_leaf != nullptr);
+    if (++_pos == _leaf->n) {
+      _leaf = _leaf->next;
+      _pos  = 0;
+    }
+    getKVP();
+    return *this;
+  }
+  inline ItC& operator--() {
+    if (_leaf == nullptr || _pos == 0) {
+      _leaf = (_leaf == nullptr) ? _trp->_tail : _leaf->prev;
+      DCHECK(_leaf != nullptr);
+      _pos  = _leaf->n;
+    }
+    --_pos;
+    getKVP();
+    return *this;
+  }
+  inline bool operator==(const ItC &other) const {
+    return (_trp == other._trp && _leaf == other._leaf &&
+            _pos == other._pos);
+  }
+  inline bool operator!=(const ItC &other) const {
+    return !this->operator==(other);
+  }
+
+ private:
+  TreePtr     _trp;
+  Leaf*       _leaf;
+  uint32_t    _pos;
+  KVPtrPair   _kvp;
+  inline void getKVP(void) {
+    _kvp.first  = (_leaf != nullptr) ? &_leaf->keys[_pos] : nullptr;
+    _kvp.second = (_leaf != nullptr) ? &_leaf->vals[_pos] : nullptr;
+  }
+};
+
+// BPlusTree Output
+// helper function to allow chained cout cmds: example
+// cout << "BPlusTree: " << endl << t << endl << "---------" << endl;
+template <typename K, typename V, size_t NodeBytes>
+std::ostream& operator << (std::ostream& os,
+                           const BPlusTree<K,V,NodeBytes>& t) {
+  using Tr = BPlusTree<K,V,NodeBytes>;
+  os << std::endl << "#************************#" << std::endl;
+  os << "# BPLUS TREE:            #" << std::endl;
+  os << "#------------------------#" << std::endl;
+  os << "# Size=" << t.Size() << ": Height=" << t.Height()
+     << ": Keys/Leaf=" << Tr::LEAF_CAP << ": Keys/Inner=" << Tr::INNER_CAP
+     << std::endl;
+  os << "##########################" << std::endl;
+  // leaves in order: keys of a leaf on one line
+  for (auto lp = t._head; lp != nullptr; lp = lp->next) {
+    os << "[";
+    for (uint32_t i=0; i<lp->n; ++i)
+      os << " " << lp->keys[i];
+    os << " ]" << std::endl;
+  }
+  os << "#************************#" << std::endl;
+
+  return os;
+}
+
+//-----------------------------------------------------------------------------
+} } // namespace asarcar { namespace utils {
+
+#endif // _UTILS_DS_BPLUS_TREE_H_
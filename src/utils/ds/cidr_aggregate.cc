@@ -0,0 +1,178 @@
+// Copyright 2015 asarcar Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Author: Arijit Sarcar <sarcar_a@yahoo.com>
+
+
+// Standard C++ Headers
+#include <sstream>          // std::ostringstream
+// Standard C Headers
+// Google Headers
+#include <glog/logging.h>   
+// Local Headers
+#include "utils/ds/cidr_aggregate.h"
+
+using namespace std;
+using namespace asarcar::utils::nwk;
+
+namespace asarcar { namespace utils { namespace ds {
+//-----------------------------------------------------------------------------
+namespace {
+inline uint32_t Addr(const IPv4Prefix& p) { return p.ip().to_scalar(); }
+
+inline uint32_t Mask(size_t len) {
+  return (len == 0) ? 0 : (0xFFFFFFFF << (IPv4::MAX_LEN - len));
+}
+
+// a covers b: b is a or a more specific of a
+inline bool Covers(const IPv4Prefix& a, const IPv4Prefix& b) {
+  return ((a.size() <= b.size()) &&
+          (((Addr(a) ^ Addr(b)) & Mask(a.size())) == 0));
+}
+
+// Trie order of IPv4 prefixes is (address, length) order: a prefix
+// precedes its more specifics, which share its (masked) address
+inline bool TrieLess(const IPv4Prefix& a, const IPv4Prefix& b) {
+  return ((Addr(a) < Addr(b)) ||
+          ((Addr(a) == Addr(b)) && (a.size() < b.size())));
+}
+
+// Drops prefixes whose nearest kept covering prefix has an equal value:
+// stack holds the kept prefixes covering the current one
+template <typename Value>
+size_t RemoveCovered(vector<pair<IPv4Prefix, Value>>* kvs_p) {
+  vector<pair<IPv4Prefix, Value>>& kvs = *kvs_p;
+  vector<size_t> stack;
+  size_t         out = 0;
+  for (size_t i=0; i<kvs.size(); ++i) {
+    while (!stack.empty() && !Covers(kvs[stack.back()].first, kvs[i].first))
+      stack.pop_back();
+    if (!stack.empty() && (kvs[stack.back()].second == kvs[i].second))
+      continue;
+    if (out != i)
+      kvs[out] = std::move(kvs[i]);
+    stack.push_back(out++);
+  }
+  size_t num_covered = kvs.size() - out;
+  kvs.resize(out);
+  return num_covered;
+}
+} // namespace
+
+std::string AggregateStats::to_string(void) const {
+  ostringstream oss;
+  oss << "#prefixes " << num_in << " -> " << num_out << " (-"
+      << ((num_in == 0) ? 0 : 100.0*(num_in - num_out)/num_in) << "%): #covered "
+      << num_covered << ": #merged " << num_merged;
+  return oss.str();
+}
+
+// 1. Covered prefixes are dropped.
+// 2. Prefixes are bucketed by length: a bucket is in address order.
+//    From /32 up, adjacent siblings with equal values in a bucket are
+//    replaced by their parent, merged (in address order) into the next
+//    bucket where the merged parent overrides a parent in the table.
+// 3. Buckets are merged back in trie order & merged parents that are now
+//    covered are dropped.
+template <typename Value>
+AggregateStats Aggregate(vector<pair<IPv4Prefix, Value>>* kvs_p) {
+  using KeyValue = pair<IPv4Prefix, Value>;
+  vector<KeyValue>& kvs = *kvs_p;
+  AggregateStats    stats;
+  stats.num_in      = kvs.size();
+  stats.num_covered = RemoveCovered(&kvs);
+
+  vector<vector<KeyValue>> buckets(IPv4::MAX_LEN + 1);
+  for (auto& kv : kvs)
+    buckets[kv.first.size()].push_back(std::move(kv));
+  for (int len=IPv4::MAX_LEN; len>0; --len) {
+    vector<KeyValue>& bucket = buckets[len];
+    vector<KeyValue>  kept, parents;
+    for (size_t i=0; i<bucket.size(); ++i) {
+      uint32_t bit = 1U << (IPv4::MAX_LEN - len);
+      if ((i + 1 < bucket.size()) && ((Addr(bucket[i].first) & bit) == 0) &&
+          (Addr(bucket[i + 1].first) == (Addr(bucket[i].first) | bit)) &&
+          (bucket[i].second == bucket[i + 1].second)) {
+        parents.push_back({IPv4Prefix{Addr(bucket[i].first), len - 1},
+                std::move(bucket[i].second)});
+        ++stats.num_merged;
+        ++i;
+        continue;
+      }
+      kept.push_back(std::move(bucket[i]));
+    }
+    bucket = std::move(kept);
+    if (parents.empty())
+      continue;
+    vector<KeyValue>& up = buckets[len - 1];
+    vector<KeyValue>  merged;
+    merged.reserve(up.size() + parents.size());
+    size_t j = 0;
+    for (auto& kv : up) {
+      while ((j < parents.size()) && (Addr(parents[j].first) < Addr(kv.first)))
+        merged.push_back(std::move(parents[j++]));
+      if ((j < parents.size()) && (parents[j].first == kv.first))
+        continue; // overridden by merged parent
+      merged.push_back(std::move(kv));
+    }
+    while (j < parents.size())
+      merged.push_back(std::move(parents[j++]));
+    up = std::move(merged);
+  }
+
+  // 33 way merge in trie order
+  kvs.clear();
+  vector<size_t> heads(buckets.size(), 0);
+  while (true) {
+    int best = -1;
+    for (size_t len=0; len<buckets.size(); ++len) {
+      if ((heads[len] < buckets[len].size()) &&
+          ((best < 0) || TrieLess(buckets[len][heads[len]].first,
+                                  buckets[best][heads[best]].first)))
+        best = len;
+    }
+    if (best < 0)
+      break;
+    kvs.push_back(std::move(buckets[best][heads[best]++]));
+  }
+  stats.num_covered += RemoveCovered(&kvs);
+  stats.num_out      = kvs.size();
+  return stats;
+}
+
+template <typename Value, typename Alloc>
+AggregateStats Aggregate(RadixTrie<IPv4Prefix, Value, Alloc>* rt_p) {
+  vector<pair<IPv4Prefix, Value>> kvs;
+  kvs.reserve(rt_p->Size());
+  for (auto it = rt_p->Begin(); it != rt_p->End(); ++it)
+    kvs.push_back(*it);
+  AggregateStats stats = Aggregate(&kvs);
+  rt_p->Clear();
+  rt_p->BulkLoad(std::move(kvs));
+  return stats;
+}
+
+//-----------------------------------------------------------------------------
+// Instantiate Aggregate for the RadixTrie IPv4Prefix instantiations
+template AggregateStats Aggregate(vector<pair<IPv4Prefix, void*>>*);
+template AggregateStats Aggregate(vector<pair<IPv4Prefix, string>>*);
+template AggregateStats Aggregate(vector<pair<IPv4Prefix, uint32_t>>*);
+template AggregateStats Aggregate(RadixTrie<IPv4Prefix, void*, HeapAlloc>*);
+template AggregateStats Aggregate(RadixTrie<IPv4Prefix, string, HeapAlloc>*);
+template AggregateStats Aggregate(RadixTrie<IPv4Prefix, uint32_t, HeapAlloc>*);
+template AggregateStats Aggregate(RadixTrie<IPv4Prefix, void*, SlabAlloc>*);
+template AggregateStats Aggregate(RadixTrie<IPv4Prefix, string, SlabAlloc>*);
+
+//-----------------------------------------------------------------------------
+} } } // namespace asarcar { namespace utils { namespace ds {
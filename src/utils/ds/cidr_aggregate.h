@@ -0,0 +1,77 @@
+// Copyright 2015 asarcar Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+//! @file   cidr_aggregate.h
+//! @brief  Aggregation of IPv4 prefix tables (routes, ACLs)
+//! @detail Input tables carry redundant prefixes that bloat the RadixTrie
+//!         and lengthen lookups. Aggregate rewrites a table into a smaller
+//!         one with the same longest prefix match result (value) for every
+//!         address:
+//!         1. Covered prefixes: a prefix whose nearest covering prefix has
+//!            the same value is dropped e.g. 10.1.0.0/24 under 10.0.0.0/8.
+//!         2. Siblings: prefixes of length L differing only in bit L with
+//!            the same value are replaced by their parent of length L - 1
+//!            e.g. 10.0.0.0/25 + 10.0.0.128/25 = 10.0.0.0/24. A parent
+//!            already in the table is overridden: its siblings cover it.
+//!            Merged parents merge further up.
+//!         Values are compared with operator ==.
+//!
+//!         Complexity
+//!         - Aggregate: O(n * 32) [n: # prefixes] i.e. linear in n.
+//! @author Arijit Sarcar <sarcar_a@yahoo.com>
+
+#ifndef _UTILS_DS_CIDR_AGGREGATE_H_
+#define _UTILS_DS_CIDR_AGGREGATE_H_
+
+// C++ Standard Headers
+#include <string>           // std::string
+#include <utility>          // std::pair
+#include <vector>           // std::vector
+// C Standard Headers
+// Google Headers
+// Local Headers
+#include "utils/basic/basictypes.h"
+#include "utils/ds/radix_trie.h"
+#include "utils/nwk/ipv4_prefix.h"
+
+//! @addtogroup ds
+//! @{
+
+namespace asarcar { namespace utils { namespace ds {
+//-----------------------------------------------------------------------------
+
+// Size reduction of an aggregation
+struct AggregateStats {
+  size_t num_in      = 0;  // # prefixes before
+  size_t num_out     = 0;  // # prefixes after
+  size_t num_covered = 0;  // # prefixes dropped as covered
+  size_t num_merged  = 0;  // # sibling pairs merged into their parent
+  std::string to_string(void) const;
+};
+
+// kvs: sorted in trie order (e.g. read off a RadixTrie) without duplicate
+// prefixes. Output stays sorted in trie order.
+template <typename Value>
+AggregateStats Aggregate(std::vector<std::pair<nwk::IPv4Prefix, Value>>* kvs_p);
+
+// Aggregates the key values of rt_p & reloads it (BulkLoad)
+template <typename Value, typename Alloc>
+AggregateStats Aggregate(RadixTrie<nwk::IPv4Prefix, Value, Alloc>* rt_p);
+
+//-----------------------------------------------------------------------------
+} } } // namespace asarcar { namespace utils { namespace ds {
+
+#endif // _UTILS_DS_CIDR_AGGREGATE_H_
@@ -0,0 +1,149 @@
+// Copyright 2015 asarcar Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Author: Arijit Sarcar <sarcar_a@yahoo.com>
+
+
+// Standard C++ Headers
+// Standard C Headers
+#if defined(__x86_64__)
+#include <immintrin.h>      // SSE & AVX intrinsics
+#endif
+// Google Headers
+#include <glog/logging.h>   // CHECK
+// Local Headers
+#include "utils/basic/proc_info.h"
+#include "utils/ds/common_prefix.h"
+
+using namespace std;
+
+namespace asarcar { namespace utils { namespace ds {
+//-----------------------------------------------------------------------------
+
+constexpr size_t CommonPrefix::WORD_BITS;
+constexpr size_t CommonPrefix::INLINE_WORDS;
+
+std::atomic<CommonPrefix::Fn> CommonPrefix::fn_{&CommonPrefix::Resolve};
+
+CommonPrefix::Level CommonPrefix::Supported(void) {
+#if defined(__x86_64__)
+  const auto& flags = ProcInfo::Singleton()->Flags();
+  if (flags.count("avx2") != 0)
+    return Level::AVX2;
+  if (flags.count("sse2") != 0)
+    return Level::SSE2;
+#endif
+  return Level::SCALAR;
+}
+
+CommonPrefix::Level CommonPrefix::Get(void) {
+  Fn fn = fn_.load(std::memory_order_relaxed);
+  if (fn == &Resolve)
+    return Supported();
+  return (fn == &Avx2Fn) ? Level::AVX2 :
+      ((fn == &Sse2Fn) ? Level::SSE2 : Level::SCALAR);
+}
+
+void CommonPrefix::Set(Level level) {
+  CHECK(static_cast<int>(level) <= static_cast<int>(Supported()))
+      << "common prefix kernel " << ToString(level) << " not supported";
+  fn_.store(FnOf(level), std::memory_order_relaxed);
+}
+
+std::string CommonPrefix::ToString(Level level) {
+  switch (level) {
+    case Level::AVX2:  return "avx2";
+    case Level::SSE2:  return "sse2";
+    default:           return "scalar";
+  }
+}
+
+// Racing first callers resolve to the same kernel: relaxed store suffices
+size_t CommonPrefix::Resolve(const uint64_t* w1, const uint64_t* w2,
+                             size_t num_words) {
+  Fn fn = FnOf(Supported());
+  fn_.store(fn, std::memory_order_relaxed);
+  return fn(w1, w2, num_words);
+}
+
+CommonPrefix::Fn CommonPrefix::FnOf(Level level) {
+  switch (level) {
+    case Level::AVX2:  return &Avx2Fn;
+    case Level::SSE2:  return &Sse2Fn;
+    default:           return &ScalarFn;
+  }
+}
+
+size_t CommonPrefix::ScalarFn(const uint64_t* w1, const uint64_t* w2,
+                              size_t num_words) {
+  return Scalar(w1, w2, num_words);
+}
+
+#if defined(__x86_64__)
+// Bytes of a word are contiguous: byte mask bit b is byte b%8 of word
+// b/8 of the block. The mismatching bit is found in the first mismatching
+// word (MSB first order is within a word, not across its bytes).
+// pcmpeqb & pmovmskb are SSE2: SSE4.2 string compares (pcmpestri) only
+// add latency for a plain equality scan.
+__attribute__((target("sse2")))
+size_t CommonPrefix::Sse2Fn(const uint64_t* w1, const uint64_t* w2,
+                            size_t num_words) {
+  constexpr size_t BLOCK_WORDS = sizeof(__m128i)/sizeof(uint64_t);
+  size_t i = 0;
+  for (; i + BLOCK_WORDS <= num_words; i += BLOCK_WORDS) {
+    __m128i  a    = _mm_loadu_si128(reinterpret_cast<const __m128i*>(w1 + i));
+    __m128i  b    = _mm_loadu_si128(reinterpret_cast<const __m128i*>(w2 + i));
+    uint32_t mask = ~static_cast<uint32_t>(
+        _mm_movemask_epi8(_mm_cmpeq_epi8(a, b))) & 0xFFFF;
+    if (mask != 0) {
+      size_t j = i + __builtin_ctz(mask)/sizeof(uint64_t);
+      return j*WORD_BITS + __builtin_clzll(w1[j] ^ w2[j]);
+    }
+  }
+  return i*WORD_BITS + Scalar(w1 + i, w2 + i, num_words - i);
+}
+
+__attribute__((target("avx2")))
+size_t CommonPrefix::Avx2Fn(const uint64_t* w1, const uint64_t* w2,
+                            size_t num_words) {
+  constexpr size_t BLOCK_WORDS = sizeof(__m256i)/sizeof(uint64_t);
+  size_t i = 0;
+  for (; i + BLOCK_WORDS <= num_words; i += BLOCK_WORDS) {
+    __m256i  a    = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(w1 + i));
+    __m256i  b    = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(w2 + i));
+    uint32_t mask = ~static_cast<uint32_t>(
+        _mm256_movemask_epi8(_mm256_cmpeq_epi8(a, b)));
+    if (mask != 0) {
+      size_t j = i + __builtin_ctz(mask)/sizeof(uint64_t);
+      return j*WORD_BITS + __builtin_clzll(w1[j] ^ w2[j]);
+    }
+  }
+  return i*WORD_BITS + Scalar(w1 + i, w2 + i, num_words - i);
+}
+#else
+size_t CommonPrefix::Sse2Fn(const uint64_t* w1, const uint64_t* w2,
+                            size_t num_words) {
+  return Scalar(w1, w2, num_words);
+}
+
+size_t CommonPrefix::Avx2Fn(const uint64_t* w1, const uint64_t* w2,
+                            size_t num_words) {
+  return Scalar(w1, w2, num_words);
+}
+#endif
+
+//-----------------------------------------------------------------------------
+} } } // namespace asarcar { namespace utils { namespace ds {
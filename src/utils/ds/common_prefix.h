@@ -0,0 +1,100 @@
+// Copyright 2015 asarcar Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+//! @file     common_prefix.h
+//! @brief    Length of the common prefix of two bit strings
+//! @details  Bit strings are arrays of 64 bit words holding bits MSB first
+//!           (see StringPrefix). The first mismatching word is found by
+//!           comparing 16 (SSE2) or 32 (AVX2) bytes at a time: movemask
+//!           of the byte compare and ctz locate the word and XOR & count
+//!           leading zeros locate the bit within it.
+//!           The kernel is picked at first use from the processor flags
+//!           (ProcInfo::Flags): avx2, then sse2, else a scalar loop.
+//!           Short strings (<= INLINE_WORDS words) skip the dispatch.
+//! @author   Arijit Sarcar <sarcar_a@yahoo.com>
+
+#ifndef _UTILS_DS_COMMON_PREFIX_H_
+#define _UTILS_DS_COMMON_PREFIX_H_
+
+// C++ Standard Headers
+#include <atomic>           // std::atomic
+#include <string>           // std::string
+// C Standard Headers
+// Google Headers
+// Local Headers
+#include "utils/basic/basictypes.h"
+
+//! @addtogroup ds
+//! @{
+
+namespace asarcar { namespace utils { namespace ds {
+//-----------------------------------------------------------------------------
+
+class CommonPrefix {
+ public:
+  enum class Level { SCALAR = 0, SSE2, AVX2 };
+  static constexpr size_t WORD_BITS    = 64;
+  static constexpr size_t INLINE_WORDS = 2;
+
+  // # of leading bits equal in w1 & w2 of num_words words each:
+  // num_words*WORD_BITS when all words are equal
+  static inline size_t Bits(const uint64_t* w1, const uint64_t* w2,
+                            size_t num_words) {
+    if (num_words > INLINE_WORDS)
+      return fn_.load(std::memory_order_relaxed)(w1, w2, num_words);
+    return Scalar(w1, w2, num_words);
+  }
+
+  // Best level supported by the processor
+  static Level Supported(void);
+  // Kernel in use: Set overrides the one picked from the processor flags
+  // (benchmarks & tests). Set to a level not Supported is a fatal error.
+  static Level Get(void);
+  static void  Set(Level level);
+  static std::string ToString(Level level);
+
+ private:
+  using Fn = size_t (*)(const uint64_t*, const uint64_t*, size_t);
+  static std::atomic<Fn> fn_;
+
+  static inline size_t Scalar(const uint64_t* w1, const uint64_t* w2,
+                              size_t num_words) {
+    for (size_t i=0; i<num_words; ++i) {
+      uint64_t x = w1[i] ^ w2[i];
+      if (x != 0)
+        return i*WORD_BITS + __builtin_clzll(x);
+    }
+    return num_words*WORD_BITS;
+  }
+  // Resolves fn_ on first call and forwards to the resolved kernel
+  static size_t Resolve(const uint64_t* w1, const uint64_t* w2,
+                        size_t num_words);
+  // Kernels: target attributes let SSE2/AVX2 code be built without
+  // raising the baseline instruction set of the whole library
+  static size_t ScalarFn(const uint64_t* w1, const uint64_t* w2,
+                         size_t num_words);
+  static size_t Sse2Fn(const uint64_t* w1, const uint64_t* w2,
+                       size_t num_words);
+  static size_t Avx2Fn(const uint64_t* w1, const uint64_t* w2,
+                       size_t num_words);
+  // Kernel of level
+  static Fn FnOf(Level level);
+};
+
+//-----------------------------------------------------------------------------
+} } } // namespace asarcar { namespace utils { namespace ds {
+
+#endif // _UTILS_DS_COMMON_PREFIX_H_
@@ -0,0 +1,428 @@
+// Copyright 2016 asarcar Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Author: Arijit Sarcar <sarcar_a@yahoo.com>
+
+// Standard C++ Headers
+#include <sstream>          // std::ostringstream
+// Standard C Headers
+// Google Headers
+#include <glog/logging.h>
+// Local Headers
+#include "utils/concur/epoch.h"
+#include "utils/concur/lock_guard.h"
+#include "utils/ds/concur_radix_trie.h"
+#include "utils/ds/string_prefix.h"
+#include "utils/nwk/ipv4_prefix.h"
+
+using namespace std;
+using namespace asarcar::utils::concur;
+using namespace asarcar::utils::nwk;
+
+namespace asarcar { namespace utils { namespace ds {
+//-----------------------------------------------------------------------------
+
+// Readers: Acquire loads of root, child & keyvalue pointers pair with the
+// release stores of the writer: a reader observes a node (or keyvalue)
+// only after it is fully constructed.
+
+template <typename Key, typename Value>
+bool ConcurRadixTrie<Key,Value>::Find(const Key& key, KeyValue* kv_p) const {
+  EpochMgr::Guard g{};
+  NodePtr node_p = root_p_.load(memory_order_acquire);
+  Key     k      = key;
+
+  while (node_p != nullptr) {
+    size_t len_key  = k.size();
+    size_t len_node = node_p->key.size();
+    if ((len_node > len_key) || (k.prefix(node_p->key).size() < len_node))
+      return false;
+    if (len_node == len_key) {
+      KeyValuePtr kvp = node_p->keyvalue_p.load(memory_order_acquire);
+      if (kvp == nullptr)
+        return false;
+      if (kv_p != nullptr)
+        *kv_p = *kvp;
+      return true;
+    }
+    size_t child_idx = k[len_node];
+    k = k.substr(len_node, (len_key - len_node));
+    node_p = node_p->children_p.at(child_idx).load(memory_order_acquire);
+  }
+
+  return false;
+}
+
+template <typename Key, typename Value>
+bool ConcurRadixTrie<Key,Value>::
+LongestPrefixMatch(const Key& key, KeyValue* kv_p) const {
+  EpochMgr::Guard g{};
+  NodePtr     node_p  = root_p_.load(memory_order_acquire);
+  KeyValuePtr lm_kv_p = nullptr;
+  Key         k       = key;
+
+  // Descend while node key is subsumed within key: remember the last
+  // node with value (no parent pointers to traverse up)
+  while (node_p != nullptr) {
+    size_t len_key  = k.size();
+    size_t len_node = node_p->key.size();
+    if ((len_node > len_key) || (k.prefix(node_p->key).size() < len_node))
+      break;
+    KeyValuePtr kvp = node_p->keyvalue_p.load(memory_order_acquire);
+    lm_kv_p = (kvp != nullptr) ? kvp : lm_kv_p;
+    if (len_node == len_key)
+      break;
+    size_t child_idx = k[len_node];
+    k = k.substr(len_node, (len_key - len_node));
+    node_p = node_p->children_p.at(child_idx).load(memory_order_acquire);
+  }
+
+  if (lm_kv_p == nullptr)
+    return false;
+  *kv_p = *lm_kv_p;
+  return true;
+}
+
+template <typename Key, typename Value>
+uint32_t ConcurRadixTrie<Key,Value>::InOrder(AccFn fn) const {
+  EpochMgr::Guard g{};
+  return InOrder(root_p_.load(memory_order_acquire), fn);
+}
+
+template <typename Key, typename Value>
+uint32_t ConcurRadixTrie<Key,Value>::InOrder(NodePtr node_p, AccFn fn) const {
+  if (node_p == nullptr)
+    return 0;
+  uint32_t    acc = 0;
+  KeyValuePtr kvp = node_p->keyvalue_p.load(memory_order_acquire);
+  if (kvp != nullptr)
+    acc += fn(*kvp);
+  for (auto& child : node_p->children_p)
+    acc += InOrder(child.load(memory_order_acquire), fn);
+  return acc;
+}
+
+//-----------------------------------------------------------------------------
+// Writers: lck_ is held. Nodes are read with plain (relaxed) semantics as
+// only the writer modifies them. New nodes are published with release.
+//-----------------------------------------------------------------------------
+template <typename Key, typename Value>
+typename ConcurRadixTrie<Key,Value>::NodePtr
+ConcurRadixTrie<Key,Value>::LongestPrefixMatchNode(const Key& key,
+                                                   Slot** slot_pp,
+                                                   Slot** parent_slot_pp,
+                                                   NodePtr* first_mm_node_pp,
+                                                   size_t* lm_key_len_p,
+                                                   size_t* lp_key_len_p) {
+  Slot*   slot_p        = &root_p_;
+  Slot*   parent_slot_p = nullptr;
+  NodePtr parent_p      = nullptr;
+  NodePtr node_p        = slot_p->load(memory_order_relaxed);
+  Key     k             = key;
+
+  *first_mm_node_pp = nullptr;
+  *lm_key_len_p = *lp_key_len_p = 0;
+
+  while (node_p != nullptr) {
+    size_t len_key    = k.size();
+    size_t len_node   = node_p->key.size();
+    size_t len_common = k.prefix(node_p->key).size();
+    *lp_key_len_p += len_common;
+    *slot_pp        = slot_p;
+    *parent_slot_pp = parent_slot_p;
+
+    // Node Key is not subsumed within key - longest match is the parent
+    if (len_common < len_node) {
+      *first_mm_node_pp = node_p;
+      return parent_p;
+    }
+
+    *lm_key_len_p += len_common;
+    // Exact match
+    if (len_common == len_key)
+      return node_p;
+
+    size_t child_idx = k[len_common];
+    k = k.substr(len_common, (len_key - len_common));
+    parent_slot_p = slot_p;
+    parent_p      = node_p;
+    slot_p        = &node_p->children_p.at(child_idx);
+    node_p        = slot_p->load(memory_order_relaxed);
+  }
+
+  // Empty slot where the remainder of the key would be attached
+  *slot_pp        = slot_p;
+  *parent_slot_pp = parent_slot_p;
+  return parent_p;
+}
+
+template <typename Key, typename Value>
+bool ConcurRadixTrie<Key,Value>::Insert(KeyValue kv) {
+  LockGuard<LockType> lkg{lck_};
+  return Upsert(std::move(kv), false);
+}
+
+template <typename Key, typename Value>
+bool ConcurRadixTrie<Key,Value>::Update(KeyValue kv) {
+  LockGuard<LockType> lkg{lck_};
+  return Upsert(std::move(kv), true);
+}
+
+// Cases: refer RadixTrie::Insert
+// a. First mismatch node found: split node i.e. replace it with
+//    a new node (common key) whose children are a copy of the split
+//    node (remainder key) and optionally a new sibling leaf.
+// b. Empty trie: new root.
+// c. Exact match: publish new keyvalue.
+// d. Longest match node found with shorter key: new leaf.
+template <typename Key, typename Value>
+bool ConcurRadixTrie<Key,Value>::Upsert(KeyValue&& kv, bool replace) {
+  size_t  key_len = kv.first.size();
+  Slot*   slot_p;
+  Slot*   parent_slot_p;
+  NodePtr first_mm_node_p;
+  size_t  lm_key_len, lp_key_len;
+  NodePtr lm_node_p = LongestPrefixMatchNode(kv.first, &slot_p, &parent_slot_p,
+                                             &first_mm_node_p,
+                                             &lm_key_len, &lp_key_len);
+  DCHECK_LE(lm_key_len, lp_key_len);
+  DCHECK_LE(lp_key_len, key_len);
+
+  // a.
+  if (first_mm_node_p != nullptr) {
+    NodePtr node_p  = first_mm_node_p;
+    int     len     = lp_key_len - lm_key_len;
+    int     node_len= node_p->key.size();
+    DCHECK_LT(len, node_len);
+    size_t  child_idx = node_p->key[len];
+    NodePtr child_p =
+        new Node{node_p->key.substr(len, node_len - len),
+                 node_p->keyvalue_p.load(memory_order_relaxed),
+                 node_p->Child(Node::LEFT_CHILD),
+                 node_p->Child(Node::RIGHT_CHILD)};
+    NodePtr split_p = new Node{node_p->key.substr(0, len)};
+    split_p->children_p.at(child_idx).store(child_p, memory_order_relaxed);
+    node_size_ += 1;
+    if (lp_key_len < key_len) {
+      // a.1 two children branch
+      NodePtr sibling_p =
+          new Node{kv.first.substr(lp_key_len, key_len - lp_key_len),
+                   new KeyValue{std::move(kv)}};
+      split_p->children_p.at(Node::RIGHT_CHILD - child_idx).
+          store(sibling_p, memory_order_relaxed);
+      node_size_ += 1;
+    } else {
+      // a.2 one child branch: split node holds keyvalue
+      split_p->keyvalue_p.store(new KeyValue{std::move(kv)},
+                                memory_order_relaxed);
+    }
+    ++value_size_;
+    slot_p->store(split_p, memory_order_release);
+    // node's keyvalue and children were handed over to child
+    RetireNode(node_p);
+    return true;
+  }
+
+  // b.
+  if (lm_node_p == nullptr) {
+    DCHECK(slot_p == &root_p_);
+    DCHECK(root_p_.load() == nullptr);
+    Key key{kv.first};
+    root_p_.store(new Node{std::move(key), new KeyValue{std::move(kv)}},
+                  memory_order_release);
+    ++node_size_; ++value_size_;
+    return true;
+  }
+
+  // c.
+  if (lm_key_len == key_len) {
+    KeyValuePtr old_kv_p = lm_node_p->keyvalue_p.load(memory_order_relaxed);
+    if ((old_kv_p != nullptr) && !replace)
+      return false;
+    lm_node_p->keyvalue_p.store(new KeyValue{std::move(kv)},
+                                memory_order_release);
+    if (old_kv_p != nullptr) {
+      RetireKeyValue(old_kv_p);
+      return false;
+    }
+    ++value_size_;
+    return true;
+  }
+
+  // d.
+  DCHECK_EQ(lm_key_len, lp_key_len);
+  DCHECK(slot_p->load() == nullptr);
+  NodePtr child_p = new Node{kv.first.substr(lm_key_len, key_len - lm_key_len),
+                             new KeyValue{std::move(kv)}};
+  slot_p->store(child_p, memory_order_release);
+  ++node_size_; ++value_size_;
+  return true;
+}
+
+// Cases: refer RadixTrie::Erase
+// a. Node has both children: unpublish keyvalue.
+// b. Node is leaf: unlink node. Parent without value is left with a single
+//    child: merge parent into the child (case c for parent).
+// c. Node has one child: merge node into the child.
+template <typename Key, typename Value>
+bool ConcurRadixTrie<Key,Value>::Erase(const Key& key) {
+  LockGuard<LockType> lkg{lck_};
+  Slot*   slot_p;
+  Slot*   parent_slot_p;
+  NodePtr first_mm_node_p;
+  size_t  lm_key_len, lp_key_len;
+  NodePtr node_p = LongestPrefixMatchNode(key, &slot_p, &parent_slot_p,
+                                          &first_mm_node_p,
+                                          &lm_key_len, &lp_key_len);
+  if ((first_mm_node_p != nullptr) || (node_p == nullptr) ||
+      (lm_key_len != key.size()))
+    return false;
+  KeyValuePtr kv_p = node_p->keyvalue_p.load(memory_order_relaxed);
+  if (kv_p == nullptr)
+    return false;
+  DCHECK(slot_p->load() == node_p);
+
+  NodePtr lchild_p = node_p->Child(Node::LEFT_CHILD);
+  NodePtr rchild_p = node_p->Child(Node::RIGHT_CHILD);
+  --value_size_;
+
+  // a.
+  if ((lchild_p != nullptr) && (rchild_p != nullptr)) {
+    node_p->keyvalue_p.store(nullptr, memory_order_release);
+    RetireKeyValue(kv_p);
+    return true;
+  }
+
+  // b.
+  if ((lchild_p == nullptr) && (rchild_p == nullptr)) {
+    slot_p->store(nullptr, memory_order_release);
+    --node_size_;
+    RetireKeyValue(kv_p);
+    RetireNode(node_p);
+    if (parent_slot_p != nullptr &&
+        parent_slot_p->load()->keyvalue_p.load(memory_order_relaxed) == nullptr)
+      Compact(parent_slot_p);
+    return true;
+  }
+
+  // c. node is unpublished by Compact: node's keyvalue is not handed over
+  node_p->keyvalue_p.store(nullptr, memory_order_relaxed);
+  Compact(slot_p);
+  RetireKeyValue(kv_p);
+  return true;
+}
+
+template <typename Key, typename Value>
+void ConcurRadixTrie<Key,Value>::Compact(Slot* slot_p) {
+  NodePtr node_p   = slot_p->load(memory_order_relaxed);
+  NodePtr lchild_p = node_p->Child(Node::LEFT_CHILD);
+  NodePtr rchild_p = node_p->Child(Node::RIGHT_CHILD);
+  DCHECK(node_p->keyvalue_p.load() == nullptr);
+  DCHECK((lchild_p == nullptr) != (rchild_p == nullptr));
+
+  NodePtr child_p = (lchild_p != nullptr) ? lchild_p : rchild_p;
+  slot_p->store(NewMergedNode(node_p->key, child_p), memory_order_release);
+  --node_size_;
+  RetireNode(node_p);
+  RetireNode(child_p);
+}
+
+template <typename Key, typename Value>
+typename ConcurRadixTrie<Key,Value>::NodePtr
+ConcurRadixTrie<Key,Value>::NewMergedNode(const Key& pref, NodePtr node_p) {
+  return new Node{pref + node_p->key,
+                  node_p->keyvalue_p.load(memory_order_relaxed),
+                  node_p->Child(Node::LEFT_CHILD),
+                  node_p->Child(Node::RIGHT_CHILD)};
+}
+
+template <typename Key, typename Value>
+void ConcurRadixTrie<Key,Value>::Clear() {
+  LockGuard<LockType> lkg{lck_};
+  NodePtr root_p = root_p_.exchange(nullptr);
+  node_size_ = 0;
+  value_size_ = 0;
+  RetireTree(root_p);
+}
+
+template <typename Key, typename Value>
+void ConcurRadixTrie<Key,Value>::DeleteTree(NodePtr node_p) {
+  if (node_p == nullptr)
+    return;
+  for (auto& child : node_p->children_p)
+    DeleteTree(child.load(memory_order_relaxed));
+  delete node_p->keyvalue_p.load(memory_order_relaxed);
+  delete node_p;
+}
+
+template <typename Key, typename Value>
+void ConcurRadixTrie<Key,Value>::RetireNode(NodePtr node_p) {
+  EpochMgr::Singleton()->Retire(node_p);
+}
+
+template <typename Key, typename Value>
+void ConcurRadixTrie<Key,Value>::RetireKeyValue(KeyValuePtr kv_p) {
+  EpochMgr::Singleton()->Retire(kv_p);
+}
+
+template <typename Key, typename Value>
+void ConcurRadixTrie<Key,Value>::RetireTree(NodePtr node_p) {
+  if (node_p == nullptr)
+    return;
+  for (auto& child : node_p->children_p)
+    RetireTree(child.load(memory_order_relaxed));
+  KeyValuePtr kv_p = node_p->keyvalue_p.load(memory_order_relaxed);
+  if (kv_p != nullptr)
+    RetireKeyValue(kv_p);
+  RetireNode(node_p);
+}
+
+template <typename Key, typename Value>
+std::string ConcurRadixTrie<Key,Value>::to_string(void) const {
+  std::ostringstream oss;
+  oss << "#nodes " << NSize() << ": #values " << Size() << std::endl;
+  oss << "---------------------------" << std::endl;
+  InOrder([&oss](const KeyValue& kv) {
+      oss << "<" << kv.first << "," << kv.second << ">" << std::endl;
+      return 1;
+    });
+  oss << "===========================" << std::endl;
+  return oss.str();
+}
+
+template <typename Key, typename Value>
+std::ostream& operator << (std::ostream& os,
+                           const ConcurRadixTrie<Key,Value>& rt) {
+  os << rt.to_string();
+  return os;
+}
+
+//-----------------------------------------------------------------------------
+// Instantiate the ConcurRadixTrie class for IPv4Prefix & StringPrefix
+template class ConcurRadixTrie<IPv4Prefix, void*>;
+template std::ostream& operator << (std::ostream &os,
+                                    const ConcurRadixTrie<IPv4Prefix, void*>&);
+template class ConcurRadixTrie<StringPrefix, void*>;
+template std::ostream& operator << (std::ostream &os,
+                                    const ConcurRadixTrie<StringPrefix, void*>&);
+
+// Test Instantiation for string as value
+template class ConcurRadixTrie<IPv4Prefix, string>;
+template std::ostream& operator << (std::ostream &os,
+                                    const ConcurRadixTrie<IPv4Prefix, string>&);
+template class ConcurRadixTrie<StringPrefix, string>;
+template std::ostream& operator << (std::ostream &os,
+                                    const ConcurRadixTrie<StringPrefix, string>&);
+//-----------------------------------------------------------------------------
+} } } // namespace asarcar { namespace utils { namespace ds {
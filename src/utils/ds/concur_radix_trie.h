@@ -0,0 +1,171 @@
+// Copyright 2016 asarcar Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+//! @file   concur_radix_trie.h
+//! @brief  Radix Trie with lock free readers and serialized writers (RCU)
+//! @detail Forwarding path looks up (Find/LongestPrefixMatch) from many
+//!         threads while a control thread applies updates.
+//!         1. Readers take no locks: they traverse inside an epoch critical
+//!            section (EpochMgr::Guard) & never block or retry.
+//!         2. Writers are serialized by a single lock. A published node is
+//!            never modified in place except for its child and keyvalue
+//!            pointers, which are swapped atomically. A node whose key
+//!            changes (split or merge) is replaced by a new copy that is
+//!            linked with a single atomic child pointer swap.
+//!         3. Replaced nodes & key values are retired and deleted after a
+//!            grace period i.e. when no reader may still hold them.
+//!         The trie has the same shape as RadixTrie i.e. a binary path
+//!         compressed trie. Nodes do not maintain parent pointers: a reader
+//!         remembers the longest match as it descends.
+//!         Readers copy results out: no references into the trie outlive
+//!         the critical section.
+//!
+//!         Complexity
+//!         - Find/LongestPrefixMatch/Insert/Erase(S): log(n) [n: length of S]
+//!         - Thread Safety: All methods except constructor & destructor are
+//!           thread safe.
+//! @author Arijit Sarcar <sarcar_a@yahoo.com>
+
+#ifndef _UTILS_DS_CONCUR_RADIX_TRIE_H_
+#define _UTILS_DS_CONCUR_RADIX_TRIE_H_
+
+// C++ Standard Headers
+#include <array>            // std::array
+#include <atomic>           // std::atomic
+#include <functional>       // std::function
+#include <iostream>         // std::ostream
+#include <string>           // std::string
+#include <utility>          // std::pair
+// C Standard Headers
+// Google Headers
+// Local Headers
+#include "utils/concur/spin_lock.h"
+
+//! @addtogroup ds
+//! @{
+
+namespace asarcar { namespace utils { namespace ds {
+//-----------------------------------------------------------------------------
+
+// Forward Declarations
+template <typename Key, typename Value>
+class ConcurRadixTrie;
+
+template <typename Key, typename Value>
+std::ostream& operator << (std::ostream& os,
+                           const ConcurRadixTrie<Key,Value>& r);
+
+template <typename Key, typename Value>
+class ConcurRadixTrie {
+ public:
+  using KeyValue    = std::pair<Key,Value>;
+  using KeyValuePtr = KeyValue*;
+  using AccFn       = const std::function<uint32_t(const KeyValue&)>&;
+
+ private:
+  class Node;
+  using NodePtr = Node*;
+  class Node {
+   public:
+    static constexpr size_t NUM_CHILDREN= 2;
+    static constexpr size_t LEFT_CHILD  = 0;
+    static constexpr size_t RIGHT_CHILD = 1;
+    Node(Key k, KeyValuePtr kv = nullptr,
+         NodePtr lchild_p = nullptr, NodePtr rchild_p = nullptr) :
+        key{std::move(k)}, keyvalue_p{kv} {
+      children_p.at(LEFT_CHILD).store(lchild_p, std::memory_order_relaxed);
+      children_p.at(RIGHT_CHILD).store(rchild_p, std::memory_order_relaxed);
+    }
+    // Node does not own keyvalue & children: they may be handed over to
+    // the node that replaces this node
+    ~Node() = default;
+    inline NodePtr Child(size_t idx) const { return children_p.at(idx); }
+    const Key                 key; // immutable once published
+    std::atomic<KeyValuePtr>  keyvalue_p;
+    std::array<std::atomic<NodePtr>, NUM_CHILDREN> children_p;
+  };
+
+ public:
+  ConcurRadixTrie() : lck_{}, root_p_{nullptr}, node_size_{0}, value_size_{0} {}
+  // Not thread safe: no other thread may access the trie
+  ~ConcurRadixTrie() { DeleteTree(root_p_); }
+  ConcurRadixTrie(const ConcurRadixTrie&)             = delete;
+  ConcurRadixTrie& operator =(const ConcurRadixTrie&) = delete;
+  ConcurRadixTrie(ConcurRadixTrie&&)                  = delete;
+  ConcurRadixTrie& operator =(ConcurRadixTrie&&)      = delete;
+
+  inline size_t Size() const { return value_size_; }
+  inline size_t NSize() const { return node_size_; }
+  inline bool Empty() const { return (value_size_ == 0); }
+  void Clear();
+
+  // Readers: lock free. Results are copied to *kv_p when found.
+  bool Find(const Key& key, KeyValue* kv_p = nullptr) const;
+  bool LongestPrefixMatch(const Key& key, KeyValue* kv_p) const;
+  //! @fn         InOrder traverses key values in trie (RadixTrie) order
+  //! @param[in]  function executed on every key value
+  //! @returns    accumulated result
+  uint32_t InOrder(AccFn fn) const;
+
+  // Writers: serialized.
+  // Insert fails (returns false) if key exists.
+  bool Insert(KeyValue kv);
+  // Inserts key value or atomically replaces value of an existing key.
+  // Returns true if key was newly inserted.
+  bool Update(KeyValue kv);
+  // Erase fails (returns false) if key does not exist.
+  bool Erase(const Key& key);
+
+  std::string to_string(void) const;
+
+ private:
+  using LockType = concur::SpinLock;
+  LockType                  lck_; // serializes writers
+  std::atomic<NodePtr>      root_p_;
+  std::atomic<size_t>       node_size_;
+  std::atomic<size_t>       value_size_;
+
+  using Slot = std::atomic<NodePtr>; // root or child pointer
+
+  // Finds node with longest match to key along with the first mismatching
+  // node - refer RadixTrie::LongestPrefixMatchNode. slot_pp is set to the
+  // slot of the last node visited (first mismatch node, exact match node,
+  // or the empty child slot where key would be attached), and
+  // parent_slot_pp to the slot of its parent.
+  // Writer only: assumes trie does not change underneath.
+  NodePtr LongestPrefixMatchNode(const Key& key,
+                                 Slot** slot_pp,
+                                 Slot** parent_slot_pp,
+                                 NodePtr* first_mm_node_pp,
+                                 size_t* lm_key_len_p,
+                                 size_t* lp_key_len_p);
+  bool Upsert(KeyValue&& kv, bool replace);
+  // Replaces node by a copy with key prefixed by pref: copy adopts node's
+  // keyvalue and children. Returns copy.
+  NodePtr NewMergedNode(const Key& pref, NodePtr node_p);
+  // Merges a valueless node with a single child into the child
+  void Compact(Slot* slot_p);
+
+  uint32_t InOrder(NodePtr node_p, AccFn fn) const;
+  static void DeleteTree(NodePtr node_p);
+  static void RetireNode(NodePtr node_p);
+  static void RetireTree(NodePtr node_p);
+  static void RetireKeyValue(KeyValuePtr kv_p);
+};
+
+//-----------------------------------------------------------------------------
+} } } // namespace asarcar { namespace utils { namespace ds {
+
+#endif // _UTILS_DS_CONCUR_RADIX_TRIE_H_
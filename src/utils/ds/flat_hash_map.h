@@ -0,0 +1,377 @@
+// Copyright 2016 asarcar Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+//! @file   flat_hash_map.h
+//! @brief  Open addressing hash map with SIMD probed control bytes
+//! @detail Swiss table layout: (K,V)s are stored inline in one slot array
+//!         i.e. no node allocation per entry & no pointer hop per lookup.
+//!         A parallel array holds one control byte per slot: empty, deleted
+//!         (tombstone) or the 7 low bits (h2) of the hash of a full slot.
+//!         - Lookup: the high bits of the hash (h1) pick the first group
+//!           of 16 control bytes. SSE2 compares h2 against all 16 at once
+//!           and only matches compare keys. A group with an empty byte ends
+//!           the probe. Groups are probed quadratically.
+//!         - Erase: leaves a tombstone only if the slot was in a full group
+//!           window i.e. a probe may have passed it; otherwise the slot is
+//!           empty again. Tombstones are reclaimed by inserts & rehash.
+//!         - Max load factor 7/8: table doubles (or is rehashed in place
+//!           when mostly tombstones) once full.
+//!         - Inline slots suit small values: box large ones (e.g. as
+//!           ConcurHash does with shared_ptr) to keep probing cache dense.
+//!         - Subset of std::unordered_map interface: may serve as the map
+//!           of ConcurHash. Rehash invalidates iterators & references.
+//!         - Thread Safety: NOT thread safe. For concurrent R/RW access use
+//!           synchronization.
+//! @author Arijit Sarcar <sarcar_a@yahoo.com>
+
+#ifndef _UTILS_DS_FLAT_HASH_MAP_H_
+#define _UTILS_DS_FLAT_HASH_MAP_H_
+
+// C++ Standard Headers
+#include <algorithm>        // std::max
+#include <functional>       // std::hash, std::equal_to
+#include <new>              // placement new, operator new
+#include <type_traits>      // std::conditional
+#include <utility>          // std::pair
+// C Standard Headers
+#include <cstring>          // memset, memcpy
+#if defined(__SSE2__)
+#include <emmintrin.h>      // SSE2 intrinsics
+#endif
+// Google Headers
+#include <glog/logging.h>   // DCHECK
+// Local Headers
+#include "utils/basic/basictypes.h"
+
+//! @addtogroup utils
+//! @{
+
+namespace asarcar { namespace utils { namespace ds {
+//-----------------------------------------------------------------------------
+
+template <typename K, typename V, typename Hash = std::hash<K>,
+          typename Eq = std::equal_to<K>>
+class FlatHashMap {
+ public:
+  using key_type    = K;
+  using mapped_type = V;
+  // Key of an element must not be modified
+  using value_type  = std::pair<K, V>;
+
+  // Control bytes probed at once
+  static constexpr size_t  GROUP_WIDTH  = 16;
+  static constexpr int8_t  CTRL_EMPTY   = -128; // 0b10000000
+  static constexpr int8_t  CTRL_DELETED = -2;   // 0b11111110
+  // Control bytes < CTRL_SENTINEL are empty or deleted
+  static constexpr int8_t  CTRL_SENTINEL = -1;
+
+  template <bool Const>
+  class Iter {
+   public:
+    using Map   = typename std::conditional<Const, const FlatHashMap,
+                                            FlatHashMap>::type;
+    using Value = typename std::conditional<Const, const value_type,
+                                            value_type>::type;
+    Iter(Map* map_p, size_t i) : map_p_{map_p}, i_{i} { skip(); }
+    inline Value& operator*() const { return map_p_->slots_[i_]; }
+    inline Value* operator->() const { return &map_p_->slots_[i_]; }
+    inline Iter& operator++() {
+      ++i_;
+      skip();
+      return *this;
+    }
+    inline bool operator==(const Iter& o) const { return i_ == o.i_; }
+    inline bool operator!=(const Iter& o) const { return i_ != o.i_; }
+   private:
+    friend class FlatHashMap;
+    Map*   map_p_;
+    size_t i_;
+    // advance to the next full slot or end (capacity)
+    inline void skip(void) {
+      while (i_ < map_p_->cap_ && map_p_->ctrl_[i_] < 0)
+        ++i_;
+    }
+  };
+  using iterator       = Iter<false>;
+  using const_iterator = Iter<true>;
+
+  FlatHashMap() = default;
+  ~FlatHashMap() {
+    destroy();
+  }
+  FlatHashMap(const FlatHashMap&)             = delete;
+  FlatHashMap& operator =(const FlatHashMap&) = delete;
+
+  inline iterator       begin(void)       { return iterator{this, 0}; }
+  inline iterator       end(void)         { return iterator{this, cap_}; }
+  inline const_iterator begin(void) const { return const_iterator{this, 0}; }
+  inline const_iterator end(void)   const { return const_iterator{this, cap_}; }
+
+  inline size_t size(void)     const { return size_; }
+  inline bool   empty(void)    const { return size_ == 0; }
+  // # slots: power of 2 (or 0 before first insert)
+  inline size_t capacity(void) const { return cap_; }
+  // Bytes of slot & control arrays
+  inline size_t MemSize(void)  const {
+    return (cap_ == 0) ? 0 :
+        cap_*sizeof(value_type) + cap_ + GROUP_WIDTH;
+  }
+
+  iterator find(const K& key) {
+    return iterator{this, findIndex(key)};
+  }
+  const_iterator find(const K& key) const {
+    return const_iterator{this, findIndex(key)};
+  }
+  inline size_t count(const K& key) const {
+    return (findIndex(key) == cap_) ? 0 : 1;
+  }
+
+  // Inserts if key does not exist. Returns <iterator, true> if inserted
+  // else <iterator to existing element, false>
+  std::pair<iterator, bool> insert(value_type&& kv) {
+    return emplace(std::move(kv.first), std::move(kv.second));
+  }
+  std::pair<iterator, bool> emplace(K&& key, V&& val) {
+    size_t h = hash(key);
+    size_t i = findIndex(key, h);
+    if (i != cap_)
+      return std::pair<iterator, bool>{iterator{this, i}, false};
+    i = prepareInsert(h);
+    new (&slots_[i]) value_type{std::move(key), std::move(val)};
+    ++size_;
+    return std::pair<iterator, bool>{iterator{this, i}, true};
+  }
+
+  // Returns # elements erased (0 or 1)
+  size_t erase(const K& key) {
+    size_t i = findIndex(key);
+    if (i == cap_)
+      return 0;
+    eraseIndex(i);
+    return 1;
+  }
+  inline void erase(iterator it) {
+    DCHECK_LT(it.i_, cap_);
+    eraseIndex(it.i_);
+  }
+
+  // Removes all elements: keeps capacity
+  void clear(void) {
+    for (size_t i=0; i<cap_; ++i)
+      if (ctrl_[i] >= 0)
+        slots_[i].~value_type();
+    if (cap_ != 0)
+      memset(ctrl_, CTRL_EMPTY, cap_ + GROUP_WIDTH);
+    size_       = 0;
+    tombstones_ = 0;
+    growth_     = maxLoad(cap_);
+  }
+
+  // Capacity to hold n elements without rehash
+  void reserve(size_t n) {
+    size_t cap = GROUP_WIDTH;
+    while (maxLoad(cap) < n)
+      cap <<= 1;
+    if (cap > cap_)
+      rehash(cap);
+  }
+
+ private:
+  int8_t*     ctrl_       = nullptr; // cap_ + GROUP_WIDTH bytes: last
+                                     // GROUP_WIDTH clone the first
+  value_type* slots_      = nullptr;
+  size_t      cap_        = 0;
+  size_t      size_       = 0;
+  size_t      tombstones_ = 0;
+  size_t      growth_     = 0;       // inserts to empty slots before rehash
+
+  // Mask of 16 control bytes: bit i set if byte i matches
+  class Group {
+   public:
+#if defined(__SSE2__)
+    explicit Group(const int8_t* p) :
+        ctrl_{_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))} {}
+    inline uint32_t Match(int8_t h2) const {
+      return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrl_));
+    }
+    inline uint32_t MatchEmptyOrDeleted(void) const {
+      return _mm_movemask_epi8(
+          _mm_cmpgt_epi8(_mm_set1_epi8(CTRL_SENTINEL), ctrl_));
+    }
+   private:
+    __m128i ctrl_;
+#else
+    explicit Group(const int8_t* p) { memcpy(ctrl_, p, GROUP_WIDTH); }
+    inline uint32_t Match(int8_t h2) const {
+      uint32_t mask = 0;
+      for (size_t i=0; i<GROUP_WIDTH; ++i)
+        mask |= static_cast<uint32_t>(ctrl_[i] == h2) << i;
+      return mask;
+    }
+    inline uint32_t MatchEmptyOrDeleted(void) const {
+      uint32_t mask = 0;
+      for (size_t i=0; i<GROUP_WIDTH; ++i)
+        mask |= static_cast<uint32_t>(ctrl_[i] < CTRL_SENTINEL) << i;
+      return mask;
+    }
+   private:
+    int8_t ctrl_[GROUP_WIDTH];
+#endif
+   public:
+    inline uint32_t MatchEmpty(void) const { return Match(CTRL_EMPTY); }
+  };
+
+  static inline size_t maxLoad(size_t cap) { return cap - cap/8; }
+
+  // Hash is mixed as std::hash of integers is identity: h1 (high bits)
+  // picks the group, h2 (low 7 bits) is stored in the control byte
+  inline size_t hash(const K& key) const {
+    uint64_t h = static_cast<uint64_t>(Hash{}(key));
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return static_cast<size_t>(h);
+  }
+  static inline size_t  h1(size_t h) { return h >> 7; }
+  static inline int8_t  h2(size_t h) { return static_cast<int8_t>(h & 0x7F); }
+
+  inline size_t findIndex(const K& key) const {
+    return (cap_ == 0) ? cap_ : findIndex(key, hash(key));
+  }
+  // Index of key or cap_ when absent
+  size_t findIndex(const K& key, size_t h) const {
+    if (cap_ == 0)
+      return cap_;
+    size_t mask = cap_ - 1, pos = h1(h) & mask;
+    for (size_t step = GROUP_WIDTH; ; pos = (pos + step) & mask,
+             step += GROUP_WIDTH) {
+      Group g{ctrl_ + pos};
+      for (uint32_t m = g.Match(h2(h)); m != 0; m &= m - 1) {
+        size_t i = (pos + __builtin_ctz(m)) & mask;
+        if (Eq{}(slots_[i].first, key))
+          return i;
+      }
+      if (g.MatchEmpty() != 0)
+        return cap_;
+      DCHECK_LE(step, cap_) << "probe of full table";
+    }
+  }
+
+  // First empty or deleted slot of the probe sequence of h
+  size_t findFirstNonFull(size_t h) const {
+    size_t mask = cap_ - 1, pos = h1(h) & mask;
+    for (size_t step = GROUP_WIDTH; ; pos = (pos + step) & mask,
+             step += GROUP_WIDTH) {
+      uint32_t m = Group{ctrl_ + pos}.MatchEmptyOrDeleted();
+      if (m != 0)
+        return (pos + __builtin_ctz(m)) & mask;
+    }
+  }
+
+  // Claims slot for hash h: rehashes when no empty slot may be consumed
+  size_t prepareInsert(size_t h) {
+    size_t i = (cap_ == 0) ? 0 : findFirstNonFull(h);
+    if (cap_ == 0 || (growth_ == 0 && ctrl_[i] != CTRL_DELETED)) {
+      // mostly tombstones: rehash in place else double
+      rehash((cap_ != 0 && size_ < maxLoad(cap_)/2) ? cap_ :
+             std::max(2*cap_, GROUP_WIDTH));
+      i = findFirstNonFull(h);
+    }
+    if (ctrl_[i] == CTRL_DELETED)
+      --tombstones_;
+    else
+      --growth_;
+    setCtrl(i, h2(h));
+    return i;
+  }
+
+  // Slot i may be emptied if no probe ever passed it i.e. every window of
+  // GROUP_WIDTH bytes containing i has an empty byte
+  void eraseIndex(size_t i) {
+    slots_[i].~value_type();
+    --size_;
+    size_t   before   = (i - GROUP_WIDTH) & (cap_ - 1);
+    uint32_t empty_a  = Group{ctrl_ + i}.MatchEmpty();
+    uint32_t empty_b  = Group{ctrl_ + before}.MatchEmpty();
+    bool     was_never_full = empty_a != 0 && empty_b != 0 &&
+        (__builtin_ctz(empty_a) + __builtin_clz(empty_b << 16)) <
+        static_cast<int>(GROUP_WIDTH);
+    if (was_never_full) {
+      setCtrl(i, CTRL_EMPTY);
+      ++growth_;
+    } else {
+      setCtrl(i, CTRL_DELETED);
+      ++tombstones_;
+    }
+  }
+
+  // bytes of the first group are cloned past the end for wrapped loads
+  inline void setCtrl(size_t i, int8_t c) {
+    ctrl_[i] = c;
+    if (i < GROUP_WIDTH)
+      ctrl_[cap_ + i] = c;
+  }
+
+  // Moves all elements to a table of cap slots: drops tombstones
+  void rehash(size_t cap) {
+    DCHECK(cap >= GROUP_WIDTH && (cap & (cap - 1)) == 0);
+    DCHECK_LE(size_, maxLoad(cap));
+    int8_t*     old_ctrl  = ctrl_;
+    value_type* old_slots = slots_;
+    size_t      old_cap   = cap_;
+    ctrl_  = new int8_t[cap + GROUP_WIDTH];
+    slots_ = static_cast<value_type*>(
+        ::operator new(cap*sizeof(value_type)));
+    cap_   = cap;
+    memset(ctrl_, CTRL_EMPTY, cap + GROUP_WIDTH);
+    tombstones_ = 0;
+    growth_     = maxLoad(cap) - size_;
+    for (size_t i=0; i<old_cap; ++i) {
+      if (old_ctrl[i] < 0)
+        continue;
+      size_t h = hash(old_slots[i].first);
+      size_t j = findFirstNonFull(h);
+      setCtrl(j, h2(h));
+      new (&slots_[j]) value_type{std::move(old_slots[i])};
+      old_slots[i].~value_type();
+    }
+    delete [] old_ctrl;
+    ::operator delete(old_slots);
+  }
+
+  void destroy(void) {
+    clear();
+    delete [] ctrl_;
+    ::operator delete(slots_);
+    ctrl_  = nullptr;
+    slots_ = nullptr;
+    cap_   = 0;
+  }
+};
+
+template <typename K, typename V, typename Hash, typename Eq>
+constexpr size_t FlatHashMap<K,V,Hash,Eq>::GROUP_WIDTH;
+template <typename K, typename V, typename Hash, typename Eq>
+constexpr int8_t FlatHashMap<K,V,Hash,Eq>::CTRL_EMPTY;
+template <typename K, typename V, typename Hash, typename Eq>
+constexpr int8_t FlatHashMap<K,V,Hash,Eq>::CTRL_DELETED;
+template <typename K, typename V, typename Hash, typename Eq>
+constexpr int8_t FlatHashMap<K,V,Hash,Eq>::CTRL_SENTINEL;
+
+//-----------------------------------------------------------------------------
+} } } // namespace asarcar { namespace utils { namespace ds {
+
+#endif // _UTILS_DS_FLAT_HASH_MAP_H_
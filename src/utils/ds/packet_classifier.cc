@@ -0,0 +1,309 @@
+// Copyright 2015 asarcar Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Author: Arijit Sarcar <sarcar_a@yahoo.com>
+
+
+// Standard C++ Headers
+#include <algorithm>        // std::stable_sort
+#include <sstream>          // std::ostringstream
+// Standard C Headers
+// Google Headers
+#include <glog/logging.h>   
+// Local Headers
+#include "utils/ds/packet_classifier.h"
+#include "utils/ds/radix_trie.h"
+
+using namespace std;
+using namespace asarcar::utils::nwk;
+
+namespace asarcar { namespace utils { namespace ds {
+//-----------------------------------------------------------------------------
+constexpr int    PacketRule::ANY_PROTO;
+constexpr size_t PacketClassifier::DEFAULT_MAX_PENDING;
+constexpr size_t PacketClassifier::WORD_BITS;
+constexpr size_t PacketClassifier::NUM_PORTS;
+constexpr size_t PacketClassifier::NUM_PROTOS;
+constexpr int    PacketClassifier::PENDING;
+
+namespace {
+inline uint64_t Bit(size_t n) { return 1ULL << (n % 64); }
+inline size_t   Ctz(uint64_t x) { return __builtin_ctzll(x); }
+// Vector index of addr: value of its longest matching prefix.
+// 0.0.0.0/0 is loaded so every address has a route
+inline size_t   AddrVec(const Poptrie<uint32_t>& addrs, uint32_t addr) {
+  const Poptrie<uint32_t>::KeyValue* route_p =
+      addrs.LongestPrefixMatch(IPv4{addr});
+  DCHECK(route_p != nullptr) << IPv4{addr};
+  return route_p->second;
+}
+} // namespace
+
+bool PacketRule::Matches(uint32_t src_addr, uint32_t dst_addr,
+                         uint16_t src_port, uint16_t dst_port,
+                         uint8_t protocol) const {
+  return ((IPv4Prefix{src_addr, static_cast<int>(src.size())} == src) &&
+          (IPv4Prefix{dst_addr, static_cast<int>(dst.size())} == dst) &&
+          (sport.first <= src_port) && (src_port <= sport.second) &&
+          (dport.first <= dst_port) && (dst_port <= dport.second) &&
+          ((proto == ANY_PROTO) || (proto == protocol)));
+}
+
+std::string PacketRule::to_string(void) const {
+  ostringstream oss;
+  oss << "id " << id << " priority " << priority << ": " << src << " -> "
+      << dst << ": ports " << sport.first << "-" << sport.second << " -> "
+      << dport.first << "-" << dport.second << ": proto ";
+  if (proto == ANY_PROTO)
+    oss << "*";
+  else
+    oss << proto;
+  return oss.str();
+}
+
+void PacketClassifier::Build(std::vector<PacketRule> rules) {
+  stable_sort(rules.begin(), rules.end(),
+              [](const PacketRule& a, const PacketRule& b) {
+                return a.priority < b.priority;
+              });
+  rules_ = std::move(rules);
+  live_.assign(rules_.size(), true);
+  pending_.clear();
+  num_erased_ = 0;
+  ids_.clear();
+  for (size_t r=0; r<rules_.size(); ++r) {
+    const PacketRule& rule = rules_[r];
+    CHECK_LE(rule.sport.first, rule.sport.second) << rule.to_string();
+    CHECK_LE(rule.dport.first, rule.dport.second) << rule.to_string();
+    CHECK(ids_.emplace(rule.id, r).second) << "duplicate " << rule.to_string();
+  }
+  num_words_   = (rules_.size() + WORD_BITS - 1)/WORD_BITS;
+  num_summary_ = (num_words_ + WORD_BITS - 1)/WORD_BITS;
+
+  BuildAddr(SRC);
+  BuildAddr(DST);
+  BuildPort(SPORT);
+  BuildPort(DPORT);
+  BuildProto();
+}
+
+bool PacketClassifier::Insert(PacketRule rule) {
+  CHECK_LE(rule.sport.first, rule.sport.second) << rule.to_string();
+  CHECK_LE(rule.dport.first, rule.dport.second) << rule.to_string();
+  if (!ids_.emplace(rule.id, PENDING).second)
+    return false;
+  pending_.push_back(std::move(rule));
+  if (pending_.size() > max_pending_)
+    Rebuild();
+  return true;
+}
+
+bool PacketClassifier::Erase(uint32_t id) {
+  auto it = ids_.find(id);
+  if (it == ids_.end())
+    return false;
+  int r = it->second;
+  ids_.erase(it);
+  if (r == PENDING) {
+    pending_.erase(find_if(pending_.begin(), pending_.end(),
+                           [id](const PacketRule& rule) {
+                             return rule.id == id;
+                           }));
+    return true;
+  }
+  // Rule no longer matches any protocol: summaries may stay set
+  live_[r] = false;
+  size_t n = fields_[PROTO].words.size()/max(num_words_, size_t{1});
+  for (size_t v=0; v<n; ++v)
+    fields_[PROTO].words[v*num_words_ + r/WORD_BITS] &= ~Bit(r);
+  if (++num_erased_ > max_pending_)
+    Rebuild();
+  return true;
+}
+
+void PacketClassifier::Rebuild(void) {
+  vector<PacketRule> rules;
+  rules.reserve(Size());
+  for (size_t r=0; r<rules_.size(); ++r) {
+    if (live_[r])
+      rules.push_back(std::move(rules_[r]));
+  }
+  for (auto& rule : pending_)
+    rules.push_back(std::move(rule));
+  Build(std::move(rules));
+}
+
+// Rules are compiled in priority order: the first rule set in the AND of
+// the field bit vectors is the match. Pending rules are compiled later
+// i.e. follow compiled rules of equal priority.
+const PacketRule* PacketClassifier::Classify(const PacketHeader& hdr) const {
+  const size_t vec[NUM_FIELDS] = {
+    AddrVec(addrs_[SRC], hdr.src),
+    AddrVec(addrs_[DST], hdr.dst),
+    ports_[SPORT - SPORT][hdr.sport],
+    ports_[DPORT - SPORT][hdr.dport],
+    protos_[hdr.proto]
+  };
+  const uint64_t* words[NUM_FIELDS];
+  const uint64_t* summary[NUM_FIELDS];
+  for (int f=0; f<NUM_FIELDS; ++f) {
+    words[f]   = fields_[f].words.data() + vec[f]*num_words_;
+    summary[f] = fields_[f].summary.data() + vec[f]*num_summary_;
+  }
+
+  const PacketRule* match_p = nullptr;
+  for (size_t s=0; (s<num_summary_) && (match_p == nullptr); ++s) {
+    uint64_t sum = summary[SRC][s] & summary[DST][s] & summary[SPORT][s] &
+        summary[DPORT][s] & summary[PROTO][s];
+    while (sum != 0) {
+      size_t   w    = s*WORD_BITS + Ctz(sum);
+      uint64_t word = words[SRC][w] & words[DST][w] & words[SPORT][w] &
+          words[DPORT][w] & words[PROTO][w];
+      if (word != 0) {
+        match_p = &rules_[w*WORD_BITS + Ctz(word)];
+        break;
+      }
+      sum &= sum - 1;
+    }
+  }
+  for (const PacketRule& rule : pending_) {
+    if (((match_p == nullptr) || (rule.priority < match_p->priority)) &&
+        rule.Matches(hdr.src, hdr.dst, hdr.sport, hdr.dport, hdr.proto))
+      match_p = &rule;
+  }
+  return match_p;
+}
+
+size_t PacketClassifier::MemSize(void) const {
+  size_t bytes = sizeof(protos_);
+  for (int f=0; f<NUM_FIELDS; ++f)
+    bytes += (fields_[f].words.size() + fields_[f].summary.size())*
+        sizeof(uint64_t);
+  for (auto& addr : addrs_)
+    bytes += addr.MemSize();
+  for (auto& port : ports_)
+    bytes += port.size()*sizeof(uint16_t);
+  return bytes;
+}
+
+std::string PacketClassifier::to_string(void) const {
+  ostringstream oss;
+  oss << "#rules " << Size() << ": #pending " << pending_.size()
+      << ": #erased " << num_erased_ << ": #vectors";
+  for (int f=0; f<NUM_FIELDS; ++f)
+    oss << ((f == 0) ? " " : "/")
+        << fields_[f].summary.size()/max(num_summary_, size_t{1});
+  oss << ": " << MemSize() << " bytes";
+  return oss.str();
+}
+
+void PacketClassifier::Reset(FieldIdx f, size_t n) {
+  fields_[f].words.assign(n*num_words_, 0);
+  fields_[f].summary.assign(n*num_summary_, 0);
+}
+
+void PacketClassifier::Set(FieldIdx f, size_t v, size_t r) {
+  size_t w = r/WORD_BITS;
+  fields_[f].words[v*num_words_ + w]     |= Bit(r);
+  fields_[f].summary[v*num_summary_ + w/WORD_BITS] |= Bit(w);
+}
+
+// Distinct prefixes are loaded in trie order i.e. (address, length)
+// order: the value of a prefix (& its Poptrie route) is its vector index.
+// A rule is set in the vectors of prefixes in the subtree of its prefix.
+void PacketClassifier::BuildAddr(FieldIdx f) {
+  auto prefix = [f](const PacketRule& rule) -> const IPv4Prefix& {
+    return (f == SRC) ? rule.src : rule.dst;
+  };
+  vector<IPv4Prefix> keys{IPv4Prefix{}};
+  keys.reserve(rules_.size() + 1);
+  for (auto& rule : rules_)
+    keys.push_back(prefix(rule));
+  auto less = [](const IPv4Prefix& a, const IPv4Prefix& b) {
+    return ((a.ip().to_scalar() < b.ip().to_scalar()) ||
+            ((a.ip().to_scalar() == b.ip().to_scalar()) &&
+             (a.size() < b.size())));
+  };
+  sort(keys.begin(), keys.end(), less);
+  keys.erase(unique(keys.begin(), keys.end()), keys.end());
+
+  vector<pair<IPv4Prefix, uint32_t>> kvs;
+  kvs.reserve(keys.size());
+  for (size_t v=0; v<keys.size(); ++v)
+    kvs.push_back({keys[v], v});
+  RadixTrie<IPv4Prefix, uint32_t> rt;
+  rt.BulkLoad(std::move(kvs));
+
+  Reset(f, keys.size());
+  for (size_t r=0; r<rules_.size(); ++r) {
+    for (auto it = rt.SubtreeBegin(prefix(rules_[r])); it != rt.End(); ++it)
+      Set(f, it->second, r);
+  }
+  addrs_[f].Build(rt);
+}
+
+// Interval i is [starts[i], starts[i + 1]): range boundaries are interval
+// boundaries i.e. a rule is set in the vectors of the intervals of its
+// first & last port and those in between
+void PacketClassifier::BuildPort(FieldIdx f) {
+  auto range = [f](const PacketRule& rule) -> const PortRange& {
+    return (f == SPORT) ? rule.sport : rule.dport;
+  };
+  vector<int> starts{0};
+  starts.reserve(2*rules_.size() + 2);
+  for (auto& rule : rules_) {
+    starts.push_back(range(rule).first);
+    starts.push_back(range(rule).second + 1);
+  }
+  sort(starts.begin(), starts.end());
+  starts.erase(unique(starts.begin(), starts.end()), starts.end());
+  if (starts.back() == NUM_PORTS)
+    starts.pop_back();
+  starts.push_back(NUM_PORTS);
+
+  vector<uint16_t>& index = ports_[f - SPORT];
+  index.resize(NUM_PORTS);
+  for (size_t i=0; i+1<starts.size(); ++i)
+    fill(index.begin() + starts[i], index.begin() + starts[i + 1], i);
+
+  Reset(f, starts.size() - 1);
+  for (size_t r=0; r<rules_.size(); ++r) {
+    const PortRange& pr = range(rules_[r]);
+    for (size_t i=index[pr.first]; i<=index[pr.second]; ++i)
+      Set(f, i, r);
+  }
+}
+
+// Vector 0: rules of any protocol. Vector of a protocol in rules: rules
+// of the protocol & of any protocol.
+void PacketClassifier::BuildProto(void) {
+  protos_.fill(0);
+  size_t n = 1;
+  for (auto& rule : rules_) {
+    if ((rule.proto != PacketRule::ANY_PROTO) && (protos_[rule.proto] == 0))
+      protos_[rule.proto] = n++;
+  }
+  Reset(PROTO, n);
+  for (size_t r=0; r<rules_.size(); ++r) {
+    if (rules_[r].proto != PacketRule::ANY_PROTO) {
+      Set(PROTO, protos_[rules_[r].proto], r);
+      continue;
+    }
+    for (size_t v=0; v<n; ++v)
+      Set(PROTO, v, r);
+  }
+}
+
+//-----------------------------------------------------------------------------
+} } } // namespace asarcar { namespace utils { namespace ds {
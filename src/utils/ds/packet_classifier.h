@@ -0,0 +1,175 @@
+// Copyright 2015 asarcar Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+//! @file   packet_classifier.h
+//! @brief  Multi-field (5 tuple) packet classification
+//! @detail Rules match on source & destination prefix, source &
+//!         destination port range and protocol. A linear scan of the rules
+//!         costs O(#rules) per packet. PacketClassifier compiles rules into
+//!         per field lookup structures and bit vectors (Lakshman &
+//!         Stiliadis, "High-Speed Policy-based Packet Forwarding Using
+//!         Efficient Multi-dimensional Range Matching", SIGCOMM 1998):
+//!         1. Rules are ordered by priority: bit i of a bit vector is the
+//!            i-th rule in priority order.
+//!         2. Address fields: distinct rule prefixes (& 0.0.0.0/0) are
+//!            compiled into a Poptrie. The bit vector of a prefix has the
+//!            rules whose prefix covers it: the longest match of an address
+//!            identifies the rules matching the address.
+//!         3. Port fields: rule range boundaries split [0, 65535] into
+//!            elementary intervals. A direct table maps a port to its
+//!            interval whose bit vector has the rules overlapping it.
+//!         4. Protocol: a direct table maps a protocol to its bit vector.
+//!         Classify ANDs the five bit vectors: the first set bit is the
+//!         highest priority match. A summary bit per bit vector word (set
+//!         when the word is non zero) skips runs of zero words i.e. words
+//!         are read only where all summaries have a set bit.
+//!         Incremental updates: inserted rules are kept in a pending list
+//!         scanned linearly at Classify. Erased rules are cleared from the
+//!         protocol bit vectors. The rules are compiled again (Rebuild)
+//!         once the pending or erased rules exceed max_pending.
+//!
+//!         Complexity [n: # rules, p: # distinct prefixes of a field]
+//!         - Classify: O(n/64) worst case + O(# pending)
+//!         - Build: O(n * log n + p * n/64 + # (rule, covered prefix))
+//!         - Memory: O((p_src + p_dst + # intervals + # protocols) * n/64)
+//!         - Thread Safety: Classify is thread safe. Updates are not.
+//! @author Arijit Sarcar <sarcar_a@yahoo.com>
+
+#ifndef _UTILS_DS_PACKET_CLASSIFIER_H_
+#define _UTILS_DS_PACKET_CLASSIFIER_H_
+
+// C++ Standard Headers
+#include <array>            // std::array
+#include <string>           // std::string
+#include <unordered_map>    // std::unordered_map
+#include <utility>          // std::pair
+#include <vector>           // std::vector
+// C Standard Headers
+// Google Headers
+// Local Headers
+#include "utils/basic/basictypes.h"
+#include "utils/ds/poptrie.h"
+#include "utils/nwk/ipv4_prefix.h"
+
+//! @addtogroup ds
+//! @{
+
+namespace asarcar { namespace utils { namespace ds {
+//-----------------------------------------------------------------------------
+
+using PortRange = std::pair<uint16_t, uint16_t>; // [first, second]
+
+struct PacketRule {
+  static constexpr int ANY_PROTO = -1;
+  uint32_t        id;        // unique: identifies the rule on updates
+  uint32_t        priority;  // lower value is higher priority
+  nwk::IPv4Prefix src;
+  nwk::IPv4Prefix dst;
+  PortRange       sport;
+  PortRange       dport;
+  int             proto;     // ANY_PROTO or [0, 255]
+
+  PacketRule(uint32_t id_ = 0, uint32_t priority_ = 0,
+             nwk::IPv4Prefix src_ = {}, nwk::IPv4Prefix dst_ = {},
+             PortRange sport_ = {0, 0xFFFF}, PortRange dport_ = {0, 0xFFFF},
+             int proto_ = ANY_PROTO) :
+      id{id_}, priority{priority_}, src{src_}, dst{dst_}, sport{sport_},
+      dport{dport_}, proto{proto_} {}
+  bool Matches(uint32_t src_addr, uint32_t dst_addr, uint16_t src_port,
+               uint16_t dst_port, uint8_t protocol) const;
+  std::string to_string(void) const;
+};
+
+struct PacketHeader {
+  uint32_t src;
+  uint32_t dst;
+  uint16_t sport;
+  uint16_t dport;
+  uint8_t  proto;
+};
+
+class PacketClassifier {
+ public:
+  static constexpr size_t DEFAULT_MAX_PENDING = 256;
+
+  explicit PacketClassifier(size_t max_pending = DEFAULT_MAX_PENDING) :
+      max_pending_{max_pending} { Build({}); }
+  ~PacketClassifier() = default;
+  PacketClassifier(const PacketClassifier&)             = delete;
+  PacketClassifier& operator =(const PacketClassifier&) = delete;
+  PacketClassifier(PacketClassifier&&)                  = default;
+  PacketClassifier& operator =(PacketClassifier&&)      = default;
+
+  // Compiles rules: discards previously compiled & pending rules.
+  // Rule ids are unique. Rules of equal priority match in input order.
+  void Build(std::vector<PacketRule> rules);
+  // Adds rule to the pending rules: false when id exists
+  bool Insert(PacketRule rule);
+  // Removes rule with id: false when id does not exist
+  bool Erase(uint32_t id);
+  // Compiles the live & pending rules
+  void Rebuild(void);
+
+  // Highest priority rule matching hdr or nullptr
+  const PacketRule* Classify(const PacketHeader& hdr) const;
+
+  // # rules: compiled & pending
+  inline size_t Size(void) const { return ids_.size(); }
+  inline size_t NumPending(void) const { return pending_.size(); }
+  // Bytes used by the compiled lookup structures & bit vectors
+  size_t MemSize(void) const;
+  std::string to_string(void) const;
+
+ private:
+  enum FieldIdx {SRC = 0, DST, SPORT, DPORT, PROTO, NUM_FIELDS};
+  static constexpr size_t WORD_BITS  = 64;
+  static constexpr size_t NUM_PORTS  = 1 << 16;
+  static constexpr size_t NUM_PROTOS = 1 << 8;
+  static constexpr int    PENDING    = -1; // ids_ slot of a pending rule
+
+  // Bit vectors of a field: vector v occupies [v*num_words_, +num_words_)
+  // of words & [v*num_summary_, +num_summary_) of summary
+  struct BitVectors {
+    std::vector<uint64_t> words;
+    std::vector<uint64_t> summary;
+  };
+
+  size_t                                max_pending_;
+  size_t                                num_erased_  = 0;
+  size_t                                num_words_   = 0;
+  size_t                                num_summary_ = 0;
+  std::vector<PacketRule>               rules_;     // priority order
+  std::vector<bool>                     live_;      // rules_[i] not erased
+  std::vector<PacketRule>               pending_;
+  std::unordered_map<uint32_t, int>     ids_;       // id -> rules_ index
+  std::array<BitVectors, NUM_FIELDS>    fields_;
+  std::array<Poptrie<uint32_t>, 2>      addrs_;     // SRC & DST
+  std::array<std::vector<uint16_t>, 2>  ports_;     // SPORT & DPORT
+  std::array<uint16_t, NUM_PROTOS>      protos_;
+
+  // Resizes bit vectors of field f to n vectors of zeros
+  void Reset(FieldIdx f, size_t n);
+  // Sets bit of rule r in vector v of field f
+  void Set(FieldIdx f, size_t v, size_t r);
+  void BuildAddr(FieldIdx f);
+  void BuildPort(FieldIdx f);
+  void BuildProto(void);
+};
+
+//-----------------------------------------------------------------------------
+} } } // namespace asarcar { namespace utils { namespace ds {
+
+#endif // _UTILS_DS_PACKET_CLASSIFIER_H_
@@ -0,0 +1,166 @@
+// Copyright 2016 asarcar Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Author: Arijit Sarcar <sarcar_a@yahoo.com>
+
+// Standard C++ Headers
+#include <sstream>          // std::ostringstream
+// Standard C Headers
+// Google Headers
+#include <glog/logging.h>
+// Local Headers
+#include "utils/ds/poptrie.h"
+
+using namespace std;
+using namespace asarcar::utils::nwk;
+
+namespace asarcar { namespace utils { namespace ds {
+//-----------------------------------------------------------------------------
+template <typename Value>
+constexpr int      Poptrie<Value>::DIRECT_BITS;
+template <typename Value>
+constexpr int      Poptrie<Value>::STRIDE;
+template <typename Value>
+constexpr uint32_t Poptrie<Value>::NO_ROUTE;
+template <typename Value>
+constexpr uint32_t Poptrie<Value>::LEAF_FLAG;
+template <typename Value>
+constexpr int      Poptrie<Value>::FANOUT;
+
+// 1. Routes (in trie order) are inserted in a binary trie: a binary node
+//    holds the index of the route whose prefix ends at the node.
+// 2. Every direct array entry descends DIRECT_BITS in the binary trie.
+//    Entry is a leaf when the binary node reached has no descendants.
+//    Otherwise the binary subtrie is compiled into a multibit node.
+//    Longest match on the way down is pushed to the leaves.
+template <typename Value>
+void Poptrie<Value>::Build(const Trie& rt) {
+  direct_.assign(1 << DIRECT_BITS, LEAF_FLAG | NO_ROUTE);
+  nodes_.clear();
+  leaves_.clear();
+  routes_.clear();
+  routes_.reserve(rt.Size());
+
+  // 1.
+  vector<BNode> bt{BNode{{-1, -1}, NO_ROUTE}};
+  for (auto it = rt.Begin(); it != rt.End(); ++it) {
+    routes_.push_back(*it);
+    uint32_t addr = it->first.ip().to_scalar();
+    int32_t  b    = 0;
+    for (size_t i=0; i<it->first.size(); ++i) {
+      uint32_t bit = (addr >> (IPv4::MAX_LEN - 1 - i)) & 1;
+      if (bt[b].children[bit] < 0) {
+        bt[b].children[bit] = bt.size();
+        bt.push_back(BNode{{-1, -1}, NO_ROUTE});
+      }
+      b = bt[b].children[bit];
+    }
+    bt[b].route = routes_.size();
+  }
+
+  // 2.
+  for (uint32_t i=0; i<direct_.size(); ++i) {
+    uint32_t route = bt[0].route;
+    int32_t  b     = Descend(bt, 0, i, DIRECT_BITS, &route);
+    if ((b < 0) || ((bt[b].children[0] < 0) && (bt[b].children[1] < 0))) {
+      direct_[i] = LEAF_FLAG | route;
+      continue;
+    }
+    direct_[i] = nodes_.size();
+    nodes_.emplace_back();
+    BuildNode(bt, b, route, direct_[i]);
+  }
+  CHECK_LT(nodes_.size(), LEAF_FLAG) << "Poptrie node index overflow";
+
+  return;
+}
+
+template <typename Value>
+int32_t Poptrie<Value>::Descend(const vector<BNode>& bt, int32_t b,
+                                uint32_t chunk, int bits, uint32_t* route_p) {
+  for (int i=bits-1; (i >= 0) && (b >= 0); --i) {
+    b = bt[b].children[(chunk >> i) & 1];
+    if ((b >= 0) && (bt[b].route != NO_ROUTE))
+      *route_p = bt[b].route;
+  }
+  return b;
+}
+
+// Children of node are allocated contiguously before any grandchild
+// so that base1 + rank indexes them. Leaves are appended in chunk order:
+// a leaf is stored only when its route differs from the previous leaf.
+template <typename Value>
+void Poptrie<Value>::BuildNode(const vector<BNode>& bt, int32_t b,
+                               uint32_t route, size_t idx) {
+  PNode node{0, 0, static_cast<uint32_t>(leaves_.size()), 0};
+  vector<pair<int32_t, uint32_t>> children; // <binary node, route>
+  uint32_t prev = NO_ROUTE;
+  bool     first = true;
+
+  for (uint32_t v=0; v<FANOUT; ++v) {
+    uint32_t r = route;
+    int32_t  c = Descend(bt, b, v, STRIDE, &r);
+    if ((c >= 0) && ((bt[c].children[0] >= 0) || (bt[c].children[1] >= 0))) {
+      node.vector |= (1ULL << v);
+      children.emplace_back(c, r);
+      continue;
+    }
+    if (first || (r != prev)) {
+      node.leafvec |= (1ULL << v);
+      leaves_.push_back(r);
+    }
+    first = false;
+    prev  = r;
+  }
+
+  node.base1 = nodes_.size();
+  nodes_.resize(nodes_.size() + children.size());
+  nodes_[idx] = node;
+  for (size_t i=0; i<children.size(); ++i)
+    BuildNode(bt, children[i].first, children[i].second, node.base1 + i);
+
+  return;
+}
+
+template <typename Value>
+size_t Poptrie<Value>::MemSize() const {
+  return (direct_.size()*sizeof(uint32_t) + nodes_.size()*sizeof(PNode) +
+          leaves_.size()*sizeof(uint32_t));
+}
+
+template <typename Value>
+std::string Poptrie<Value>::to_string(void) const {
+  ostringstream oss;
+  oss << "#routes " << Size() << ": #nodes " << NSize()
+      << ": #leaves " << LSize() << ": #bytes " << MemSize();
+  return oss.str();
+}
+
+template <typename Value>
+std::ostream& operator << (std::ostream& os, const Poptrie<Value>& p) {
+  os << p.to_string();
+  return os;
+}
+
+//-----------------------------------------------------------------------------
+// Instantiate the Poptrie class for the RadixTrie IPv4Prefix instantiations
+template class Poptrie<void*>;
+template std::ostream& operator << (std::ostream &os, const Poptrie<void*>&);
+template class Poptrie<string>;
+template std::ostream& operator << (std::ostream &os, const Poptrie<string>&);
+template class Poptrie<uint32_t>;
+template std::ostream& operator << (std::ostream &os, const Poptrie<uint32_t>&);
+
+//-----------------------------------------------------------------------------
+} } } // namespace asarcar { namespace utils { namespace ds {
@@ -0,0 +1,165 @@
+// Copyright 2016 asarcar Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+//! @file   poptrie.h
+//! @brief  Read optimized IPv4 longest prefix match engine (Poptrie)
+//! @detail RadixTrie is a binary trie: an IPv4 lookup may chase 32 pointers
+//!         across separately allocated nodes. Poptrie is compiled from a
+//!         RadixTrie<IPv4Prefix,Value> into three contiguous arrays:
+//!         1. Direct array: top DIRECT_BITS of the address index an entry
+//!            that is either a leaf (route) or the index of a root node.
+//!         2. Nodes: multibit nodes with a STRIDE bit stride. A node has a
+//!            2^STRIDE bit vector of internal children and a leaf vector
+//!            marking where a run of identical leaves begins. Children &
+//!            leaves of a node are contiguous: the i-th set bit is at
+//!            base + i i.e. index is computed with popcount.
+//!         3. Leaves: route indices with identical neighbours compressed.
+//!         A lookup visits the direct array and at most 2 nodes (20+6*2 =
+//!         32) before reading the leaf: <= 4 dependent memory accesses.
+//!         The direct array costs 4MB (2^20 entries) regardless of the
+//!         number of routes.
+//!         Poptrie is immutable: updates to the RadixTrie are applied by
+//!         compiling again.
+//!
+//!         Reference: Asai & Ohara, "Poptrie: A Compressed Trie with
+//!         Population Count for Fast and Scalable Software IP Routing
+//!         Table Lookup", SIGCOMM 2015.
+//!
+//!         Complexity
+//!         - LongestPrefixMatch: O(1) i.e. <= 4 memory accesses
+//!         - Build: O(n * 32) [n: # prefixes]
+//!         - Thread Safety: Lookups are thread safe. Build is not.
+//! @author Arijit Sarcar <sarcar_a@yahoo.com>
+
+#ifndef _UTILS_DS_POPTRIE_H_
+#define _UTILS_DS_POPTRIE_H_
+
+// C++ Standard Headers
+#include <iostream>         // std::ostream
+#include <string>           // std::string
+#include <utility>          // std::pair
+#include <vector>           // std::vector
+// C Standard Headers
+// Google Headers
+// Local Headers
+#include "utils/ds/radix_trie.h"
+#include "utils/nwk/ipv4_prefix.h"
+
+//! @addtogroup ds
+//! @{
+
+namespace asarcar { namespace utils { namespace ds {
+//-----------------------------------------------------------------------------
+
+// Forward Declarations
+template <typename Value>
+class Poptrie;
+
+template <typename Value>
+std::ostream& operator << (std::ostream& os, const Poptrie<Value>& p);
+
+template <typename Value>
+class Poptrie {
+ public:
+  using KeyValue = std::pair<nwk::IPv4Prefix, Value>;
+  using Trie     = RadixTrie<nwk::IPv4Prefix, Value>;
+
+  static constexpr int      DIRECT_BITS = 20;
+  static constexpr int      STRIDE      = 6;
+  static constexpr uint32_t NO_ROUTE    = 0;
+
+  Poptrie() : direct_(1 << DIRECT_BITS, LEAF_FLAG | NO_ROUTE) {}
+  explicit Poptrie(const Trie& rt) { Build(rt); }
+  ~Poptrie() = default;
+  Poptrie(const Poptrie&)             = delete;
+  Poptrie& operator =(const Poptrie&) = delete;
+  Poptrie(Poptrie&&)                  = default;
+  Poptrie& operator =(Poptrie&&)      = default;
+
+  // Compiles the routes of rt: discards previously compiled routes
+  void Build(const Trie& rt);
+
+  inline size_t Size() const { return routes_.size(); }
+  inline size_t NSize() const { return nodes_.size(); }
+  inline size_t LSize() const { return leaves_.size(); }
+  // Bytes used by the lookup arrays (excludes routes)
+  size_t MemSize() const;
+
+  // Returns route with longest prefix matching addr or nullptr
+  inline const KeyValue* LongestPrefixMatch(nwk::IPv4 addr) const {
+    uint32_t idx = Lookup(addr.to_scalar());
+    return (idx == NO_ROUTE) ? nullptr : &routes_[idx - 1];
+  }
+  // Returns 1 + index of route in route order or NO_ROUTE
+  inline uint32_t Lookup(uint32_t addr) const {
+    uint32_t e = direct_[addr >> (nwk::IPv4::MAX_LEN - DIRECT_BITS)];
+    if ((e & LEAF_FLAG) != 0)
+      return (e & ~LEAF_FLAG);
+    const PNode* node_p = &nodes_[e];
+    for (int offset = DIRECT_BITS; ; offset += STRIDE) {
+      uint64_t bit  = 1ULL << Chunk(addr, offset);
+      uint64_t mask = (bit << 1) - 1; // bits [0, chunk]
+      if ((node_p->vector & bit) == 0)
+        return leaves_[node_p->base0 + Popcount(node_p->leafvec & mask) - 1];
+      node_p = &nodes_[node_p->base1 + Popcount(node_p->vector & mask) - 1];
+    }
+  }
+
+  std::string to_string(void) const;
+
+ private:
+  static constexpr uint32_t LEAF_FLAG = 0x80000000;
+  static constexpr int      FANOUT    = 1 << STRIDE;
+  struct PNode {
+    uint64_t vector;  // bit i set: i-th chunk value is an internal node
+    uint64_t leafvec; // bit i set: i-th chunk value starts a leaf run
+    uint32_t base0;   // index of first leaf
+    uint32_t base1;   // index of first child node
+  };
+  // Binary trie of routes used only while compiling
+  struct BNode {
+    int32_t  children[2];
+    uint32_t route;   // NO_ROUTE or route index
+  };
+
+  std::vector<uint32_t> direct_;
+  std::vector<PNode>    nodes_;
+  std::vector<uint32_t> leaves_;
+  std::vector<KeyValue> routes_;
+
+  // STRIDE bits of addr starting at bit offset: bits past the address
+  // are 0
+  static inline uint32_t Chunk(uint32_t addr, int offset) {
+    return static_cast<uint32_t>(
+        (static_cast<uint64_t>(addr) << nwk::IPv4::MAX_LEN) >>
+        (2*nwk::IPv4::MAX_LEN - offset - STRIDE)) & (FANOUT - 1);
+  }
+  static inline uint32_t Popcount(uint64_t x) {
+    return __builtin_popcountll(x);
+  }
+
+  // Descends bits of chunk from binary node b: returns the node reached
+  // (or -1) and updates route to the longest match on the way
+  static int32_t Descend(const std::vector<BNode>& bt, int32_t b,
+                         uint32_t chunk, int bits, uint32_t* route_p);
+  // Compiles binary subtrie at b into node at index idx
+  void BuildNode(const std::vector<BNode>& bt, int32_t b, uint32_t route,
+                 size_t idx);
+};
+
+//-----------------------------------------------------------------------------
+} } } // namespace asarcar { namespace utils { namespace ds {
+
+#endif // _UTILS_DS_POPTRIE_H_
@@ -15,23 +15,53 @@
 // Author: Arijit Sarcar <sarcar_a@yahoo.com>
 
 // Standard C++ Headers
+#include <algorithm>        // std::min
+#include <type_traits>      // std::is_trivially_destructible
 // Standard C Headers
 // Google Headers
 #include <glog/logging.h>   
 // Local Headers
+#include "utils/concur/barrier.h"
+#include "utils/concur/thread_pool.h"
 #include "utils/ds/radix_trie.h"
 #include "utils/ds/string_prefix.h"
 #include "utils/nwk/ipv4_prefix.h"
+#include "utils/nwk/ipv6_prefix.h"
 
 using namespace std;
+using namespace asarcar::utils::concur;
 using namespace asarcar::utils::nwk;
 
 namespace asarcar { namespace utils { namespace ds {
 //-----------------------------------------------------------------------------
-template <typename Key, typename Value>
-RadixTrie<Key,Value>::Node::Node(Key k, KeyValueUPtr kv, 
-                                 NodePtr par_p,
-                                 NodeUPtr lchild_p, NodeUPtr rchild_p) : 
+namespace {
+// Length of the common prefix of k1 & k2. StringPrefix counts it
+// (SIMD for long keys) without building the prefix.
+template <typename Key>
+inline size_t PrefixSize(const Key& k1, const Key& k2) {
+  return k1.prefix(k2).size();
+}
+inline size_t PrefixSize(const StringPrefix& k1, const StringPrefix& k2) {
+  return k1.prefix_size(k2);
+}
+
+// Trie order: negative (positive) when k1 precedes (follows) k2 i.e. k1
+// prefixes k2 or has 0 at the first mismatching bit; 0 when equal
+template <typename Key>
+inline int TrieCompare(const Key& k1, const Key& k2) {
+  size_t lcp = PrefixSize(k1, k2);
+  if (lcp == k1.size())
+    return (lcp == k2.size()) ? 0 : -1;
+  if (lcp == k2.size())
+    return 1;
+  return k1[lcp] ? 1 : -1;
+}
+} // namespace
+
+template <typename Key, typename Value, typename Alloc>
+RadixTrie<Key,Value,Alloc>::Node::Node(Key k, KeyValueUPtr kv, 
+                                       NodePtr par_p,
+                                       NodeUPtr lchild_p, NodeUPtr rchild_p) : 
     key{std::move(k)}, keyvalue_p{std::move(kv)}, 
   parent_p{par_p}, 
   children_p{std::move(lchild_p), std::move(rchild_p)} {
@@ -41,40 +71,114 @@ RadixTrie<Key,Value>::Node::Node(Key k, KeyValueUPtr kv,
     children_p.at(Node::RIGHT_CHILD)->parent_p = this;
 }
 
-template <typename Key, typename Value>
-ItR<Key,Value>
-RadixTrie<Key,Value>::Begin(NodePtr root_p) const { 
+// Bulk free: nodes & key values hold no memory outside the allocator's
+// chunks. Drop the tree without visiting the nodes. Keys or values with
+// destructors (e.g. StringPrefix) are destroyed walking the tree.
+template <typename Key, typename Value, typename Alloc>
+void RadixTrie<Key,Value,Alloc>::Clear() {
+  if (Alloc::BULK_FREE &&
+      std::is_trivially_destructible<Key>::value &&
+      std::is_trivially_destructible<Value>::value)
+    root_p_.release();
+  else
+    root_p_.reset(nullptr);
+  alloc_.Clear();
+  value_size_ = 0;
+  node_size_ = 0;
+}
+
+template <typename Key, typename Value, typename Alloc>
+ItR<Key,Value,Alloc>
+RadixTrie<Key,Value,Alloc>::Begin(NodePtr root_p) const { 
   root_p = (root_p == nullptr) ? root_p_.get() : root_p;
-  return ItR<Key,Value>{this, root_p, GetFirst(root_p)}; 
+  return ItR<Key,Value,Alloc>{this, root_p, GetFirst(root_p)}; 
 }
 
-template <typename Key, typename Value>
-ItR<Key,Value>
-RadixTrie<Key,Value>::Find(const Key& key) const { 
+template <typename Key, typename Value, typename Alloc>
+ItR<Key,Value,Alloc>
+RadixTrie<Key,Value,Alloc>::Find(const Key& key) const { 
   NodePtr lm_node_p = LongestPrefixMatchNode(key);
   if ((lm_node_p == nullptr) ||
       (lm_node_p->keyvalue_p == nullptr) || 
       (lm_node_p->keyvalue_p->first != key))
     return End();
   
-  return ItR<Key,Value>{this, nullptr, lm_node_p};
+  return ItR<Key,Value,Alloc>{this, nullptr, lm_node_p};
 }
 
-template <typename Key, typename Value>
-ItR<Key,Value>
-RadixTrie<Key,Value>::LongestPrefixMatch(const Key& key) const {
+template <typename Key, typename Value, typename Alloc>
+ItR<Key,Value,Alloc>
+RadixTrie<Key,Value,Alloc>::LongestPrefixMatch(const Key& key) const {
   // Traverse up from the longest match node to the first and nearest
   // ancestor that has value associated
   NodePtr lm_node_p = LongestPrefixMatchNode(key);
   while ((lm_node_p != nullptr) && (lm_node_p->keyvalue_p == nullptr)) {
     lm_node_p = lm_node_p->parent_p;
   }
-  return ItR<Key,Value>{this, nullptr, lm_node_p};
+  return ItR<Key,Value,Alloc>{this, nullptr, lm_node_p};
+}
+
+template <typename Key, typename Value, typename Alloc>
+constexpr size_t RadixTrie<Key,Value,Alloc>::BATCH_WIDTH;
+
+// AMAC style interleaving: a slot holds the state of one lookup. A pass
+// over the slots advances every lookup by one node (same steps as
+// LongestPrefixMatchNode) & prefetches the child it descends to. By the
+// time the pass returns to a slot its node is likely in cache. A slot
+// whose lookup finished is refilled with the next key.
+template <typename Key, typename Value, typename Alloc>
+void RadixTrie<Key,Value,Alloc>::LongestPrefixMatchBatch(
+    const Key* keys, size_t n, ItR<Key,Value,Alloc>* out) const {
+  struct Lookup {
+    size_t  idx;      // n: slot idle
+    NodePtr node_p;
+    NodePtr parent_p;
+    Key     k;        // key bits not matched yet
+  };
+  vector<Lookup> slots;
+  size_t         next = 0;
+  slots.reserve(std::min(n, BATCH_WIDTH));
+  for (; next < std::min(n, BATCH_WIDTH); ++next)
+    slots.push_back({next, root_p_.get(), nullptr, keys[next]});
+
+  for (size_t active = slots.size(); active > 0; ) {
+    for (Lookup& l : slots) {
+      if (l.idx == n)
+        continue;
+      NodePtr lm_node_p = l.parent_p;
+      if (l.node_p != nullptr) {
+        int len_key    = l.k.size();
+        int len_node   = l.node_p->key.size();
+        int len_common = PrefixSize(l.k, l.node_p->key);
+        if ((len_common == len_node) && (len_common < len_key)) {
+          NodePtr child_p = l.node_p->children_p.at(l.k[len_common]).get();
+          __builtin_prefetch(child_p);
+          l.k        = l.k.substr(len_common, (len_key - len_common));
+          l.parent_p = l.node_p;
+          l.node_p   = child_p;
+          continue;
+        }
+        if (len_common == len_node)
+          lm_node_p = l.node_p;
+      }
+      while ((lm_node_p != nullptr) && (lm_node_p->keyvalue_p == nullptr))
+        lm_node_p = lm_node_p->parent_p;
+      out[l.idx] = ItR<Key,Value,Alloc>{this, nullptr, lm_node_p};
+
+      if (next < n) {
+        l = Lookup{next, root_p_.get(), nullptr, keys[next]};
+        ++next;
+      } else {
+        l.idx = n;
+        --active;
+      }
+    }
+  }
 }
 
-template <typename Key, typename Value>
-ItR<Key,Value>
-RadixTrie<Key,Value>::Erase(const ItR<Key,Value> it) {
+template <typename Key, typename Value, typename Alloc>
+ItR<Key,Value,Alloc>
+RadixTrie<Key,Value,Alloc>::Erase(const ItR<Key,Value,Alloc> it) {
   if (it == End())
     return it;
   NodePtr node_p = it.node_p_;
@@ -98,7 +202,7 @@ RadixTrie<Key,Value>::Erase(const ItR<Key,Value> it) {
   //    child exists: we will fall through to case (c).
   if ((lchild_p != nullptr) && (rchild_p != nullptr)) {
     next_p = GetNext(root_p_.get(), node_p);
-    return ItR<Key,Value>{this, nullptr, next_p};
+    return ItR<Key,Value,Alloc>{this, nullptr, next_p};
   }
 
   // b. Node is leaf. Discard leaf node. 
@@ -108,7 +212,7 @@ RadixTrie<Key,Value>::Erase(const ItR<Key,Value> it) {
       // frees node_p and unreleased descendants of node_p
       root_p_.reset(nullptr); 
       --node_size_;
-      return ItR<Key,Value>{this, nullptr, next_p};
+      return ItR<Key,Value,Alloc>{this, nullptr, next_p};
     }
 
     child_p = parent_p->children_p.at(Node::LEFT_CHILD).get();
@@ -141,7 +245,7 @@ RadixTrie<Key,Value>::Erase(const ItR<Key,Value> it) {
 
   // b. fallthrough
   if (node_p->keyvalue_p != nullptr)
-    return ItR<Key,Value>{this, nullptr, next_p};
+    return ItR<Key,Value,Alloc>{this, nullptr, next_p};
 
   // c. Node intermediate with no value and only one child.
   //    Discard Node and "Promote" its single child to its place.
@@ -158,7 +262,7 @@ RadixTrie<Key,Value>::Erase(const ItR<Key,Value> it) {
     root_p_.reset(child_p); 
     --node_size_;
     child_p->parent_p = nullptr;
-    return ItR<Key,Value>{this, nullptr, next_p};
+    return ItR<Key,Value,Alloc>{this, nullptr, next_p};
   }
 
   // parent_p exists: Link the child to node's parent in the same branch path
@@ -169,12 +273,12 @@ RadixTrie<Key,Value>::Erase(const ItR<Key,Value> it) {
   parent_p->children_p.at(idx).reset(child_p); 
   --node_size_;
 
-  return ItR<Key,Value>{this, nullptr, next_p};
+  return ItR<Key,Value,Alloc>{this, nullptr, next_p};
 }
 
-template <typename Key, typename Value>
-typename RadixTrie<Key,Value>::NodePtr
-RadixTrie<Key,Value>::LongestPrefixMatchNode(const Key& key,
+template <typename Key, typename Value, typename Alloc>
+typename RadixTrie<Key,Value,Alloc>::NodePtr
+RadixTrie<Key,Value,Alloc>::LongestPrefixMatchNode(const Key& key,
                                              const NodePtr root_p,
                                              NodePtr* first_mm_node_pp,
                                              size_t* lm_key_len_p,
@@ -201,8 +305,7 @@ RadixTrie<Key,Value>::LongestPrefixMatchNode(const Key& key,
     int len_key    = k.size();
     int len_node   = node_p->key.size();
   
-    Key pref       = k.prefix(node_p->key);
-    int len_common = pref.size();
+    int len_common = PrefixSize(k, node_p->key);
     *lp_key_len_p += len_common;
 
     // Node Key is not subsumed within key - longest match is the parent of node
@@ -212,7 +315,7 @@ RadixTrie<Key,Value>::LongestPrefixMatchNode(const Key& key,
     }
 
     // Assured that len_common = len_node => key of longest match 
-    // node at least extends upto pref.
+    // node at least extends upto the common prefix.
     *lm_key_len_p  += len_common;
 
     // Node Key subsumed within key: From here on: len_common == len_node
@@ -249,8 +352,8 @@ RadixTrie<Key,Value>::LongestPrefixMatchNode(const Key& key,
 // prefix match is partial to the Node 
 // After the split node operation the node returned will exactly 
 // match the key until len bits (aka symbols)
-template <typename Key, typename Value>
-void RadixTrie<Key,Value>::SplitNode(NodePtr node_to_split_p, 
+template <typename Key, typename Value, typename Alloc>
+void RadixTrie<Key,Value,Alloc>::SplitNode(NodePtr node_to_split_p, 
                                      int len,
                                      NodePtr sibling_p) {
   DCHECK(node_to_split_p != nullptr);
@@ -261,11 +364,11 @@ void RadixTrie<Key,Value>::SplitNode(NodePtr node_to_split_p,
   // Insert a New Node between node_to_split and its children i.e. 
   // New Node inherits all fields of node_to_split: e.g. kv, children, ...
   NodePtr child_p =
-      new Node{node_to_split_p->key.substr(len, (key_size - len)), 
-               std::move(node_to_split_p->keyvalue_p),
-               node_to_split_p, 
-               std::move(node_to_split_p->children_p.at(Node::LEFT_CHILD)), 
-               std::move(node_to_split_p->children_p.at(Node::RIGHT_CHILD))};
+      NewNode(node_to_split_p->key.substr(len, (key_size - len)), 
+              std::move(node_to_split_p->keyvalue_p),
+              node_to_split_p, 
+              std::move(node_to_split_p->children_p.at(Node::LEFT_CHILD)), 
+              std::move(node_to_split_p->children_p.at(Node::RIGHT_CHILD)));
   node_size_++;
 
   // Link the new node as the split node's child
@@ -284,9 +387,9 @@ void RadixTrie<Key,Value>::SplitNode(NodePtr node_to_split_p,
   node_to_split_p->key.resize(len);
 }
 
-template <typename Key, typename Value>
-typename RadixTrie<Key,Value>::InsertRetType
-RadixTrie<Key,Value>::Insert(KeyValue kv) {
+template <typename Key, typename Value, typename Alloc>
+typename RadixTrie<Key,Value,Alloc>::InsertRetType
+RadixTrie<Key,Value,Alloc>::Insert(KeyValue kv) {
   size_t  key_len = kv.first.size();
   NodePtr root_p{root_p_.get()};
   NodePtr first_mm_node_p{nullptr};
@@ -329,10 +432,11 @@ RadixTrie<Key,Value>::Insert(KeyValue kv) {
   if (lm_node_p == nullptr) {
     DCHECK(lm_key_len == 0); 
     DCHECK(root_p == nullptr);
-    root_p = new Node{Key{kv.first}, KeyValueUPtr{new KeyValue{std::move(kv)}}};
+    Key key{kv.first}; // copy key before kv is moved
+    root_p = NewNode(std::move(key), NewKeyValue(std::move(kv)));
     root_p_.reset(root_p);
     ++node_size_; ++value_size_;
-    return InsertRetType{ItR<Key,Value>{this, root_p, root_p}, true};
+    return InsertRetType{ItR<Key,Value,Alloc>{this, root_p, root_p}, true};
   }
 
   // Longest Match Node Found cases from here on
@@ -341,11 +445,11 @@ RadixTrie<Key,Value>::Insert(KeyValue kv) {
     DCHECK(lp_key_len == key_len);
     bool new_insert = false;
     if (lm_node_p->keyvalue_p == nullptr) {
-      lm_node_p->keyvalue_p.reset(new KeyValue{std::move(kv)});
+      lm_node_p->keyvalue_p = NewKeyValue(std::move(kv));
       ++value_size_;
       new_insert = true;
     }
-    return InsertRetType{ItR<Key,Value>{this, root_p, lm_node_p}, new_insert};
+    return InsertRetType{ItR<Key,Value,Alloc>{this, root_p, lm_node_p}, new_insert};
   }
 
   // d. New Leaf Node. 
@@ -353,18 +457,18 @@ RadixTrie<Key,Value>::Insert(KeyValue kv) {
   DCHECK(lm_key_len < key_len && lp_key_len < key_len);
   size_t child_idx = kv.first[lm_key_len];
   DCHECK(lm_node_p->children_p.at(child_idx) == nullptr);
+  Key key = kv.first.substr(lm_key_len, (key_len - lm_key_len));
   NodePtr child_p = 
-      new Node{kv.first.substr(lm_key_len, (key_len - lm_key_len)), 
-               KeyValueUPtr{new KeyValue{std::move(kv)}}, lm_node_p};
+      NewNode(std::move(key), NewKeyValue(std::move(kv)), lm_node_p);
   ++node_size_; ++value_size_;
   lm_node_p->children_p.at(child_idx).reset(child_p);
-  return InsertRetType{ItR<Key,Value>{this, root_p, child_p}, true};
+  return InsertRetType{ItR<Key,Value,Alloc>{this, root_p, child_p}, true};
 }
 
 
-template <typename Key, typename Value>
-typename RadixTrie<Key,Value>::NodePtr 
-RadixTrie<Key,Value>::GetFirst(const NodePtr root_p) const {  
+template <typename Key, typename Value, typename Alloc>
+typename RadixTrie<Key,Value,Alloc>::NodePtr 
+RadixTrie<Key,Value,Alloc>::GetFirst(const NodePtr root_p) const {  
   NodePtr node_p = root_p; 
   NodePtr child_p;
 
@@ -383,9 +487,9 @@ RadixTrie<Key,Value>::GetFirst(const NodePtr root_p) const {
   return nullptr;
 }
 
-template <typename Key, typename Value>
-typename RadixTrie<Key,Value>::NodePtr 
-RadixTrie<Key,Value>::GetNext(const NodePtr root_p, 
+template <typename Key, typename Value, typename Alloc>
+typename RadixTrie<Key,Value,Alloc>::NodePtr 
+RadixTrie<Key,Value,Alloc>::GetNext(const NodePtr root_p, 
                               const NodePtr node_p) const {
   DCHECK(root_p != nullptr);
   DCHECK(node_p != nullptr);
@@ -403,9 +507,9 @@ RadixTrie<Key,Value>::GetNext(const NodePtr root_p,
   return next_p;
 }
 
-template <typename Key, typename Value>
-typename RadixTrie<Key,Value>::NodePtr 
-RadixTrie<Key,Value>::GetNextUp(const NodePtr root_p, 
+template <typename Key, typename Value, typename Alloc>
+typename RadixTrie<Key,Value,Alloc>::NodePtr 
+RadixTrie<Key,Value,Alloc>::GetNextUp(const NodePtr root_p, 
                                 const NodePtr node_p) const {
   DCHECK(root_p != nullptr);
   DCHECK(node_p != nullptr);
@@ -439,9 +543,9 @@ RadixTrie<Key,Value>::GetNextUp(const NodePtr root_p,
   return nullptr;
 }
 
-template <typename Key, typename Value>
+template <typename Key, typename Value, typename Alloc>
 std::string 
-RadixTrie<Key,Value>::to_string(bool dump_internal_nodes) {
+RadixTrie<Key,Value,Alloc>::to_string(bool dump_internal_nodes) {
   std::ostringstream oss;  
 
   oss << "#nodes " << node_size_ << ": #values " << value_size_ << std::endl;
@@ -452,9 +556,9 @@ RadixTrie<Key,Value>::to_string(bool dump_internal_nodes) {
   return oss.str();
 }
 
-template <typename Key, typename Value>
+template <typename Key, typename Value, typename Alloc>
 std::string 
-RadixTrie<Key,Value>::to_string(NodePtr node_p, int depth, bool dump_internal_nodes) {
+RadixTrie<Key,Value,Alloc>::to_string(NodePtr node_p, int depth, bool dump_internal_nodes) {
   if (node_p == nullptr)
     return std::string("");
   
@@ -488,9 +592,9 @@ RadixTrie<Key,Value>::to_string(NodePtr node_p, int depth, bool dump_internal_no
 //      Longest Match Node ! Found or Found with shorter key
 //      Note: Longest Match Node Found with equal key not
 //      possible as First Mismatch Node is returned as nullptr in that case
-template <typename Key, typename Value>
-typename RadixTrie<Key,Value>::InsertRetType
-RadixTrie<Key,Value>::SetUpTreeBranch(
+template <typename Key, typename Value, typename Alloc>
+typename RadixTrie<Key,Value,Alloc>::InsertRetType
+RadixTrie<Key,Value,Alloc>::SetUpTreeBranch(
     KeyValue&& kv,
     NodePtr    first_mm_node_p, 
     int        lm_key_len, 
@@ -501,33 +605,336 @@ RadixTrie<Key,Value>::SetUpTreeBranch(
 
   // Case a.1: SplitNode with two Children Branch
   if (lp_key_len < key_len) {
+    Key key = kv.first.substr(lp_key_len, (kv.first.size() - lp_key_len));
     NodePtr sibling_p = 
-        new Node{kv.first.substr(lp_key_len, (kv.first.size() - lp_key_len)), 
-                 KeyValueUPtr{new KeyValue{std::move(kv)}}, first_mm_node_p};
+        NewNode(std::move(key), NewKeyValue(std::move(kv)), first_mm_node_p);
     ++node_size_; ++value_size_;
     
     SplitNode(first_mm_node_p, lp_key_len - lm_key_len, sibling_p);
-    return InsertRetType{ItR<Key,Value>{this, root_p_.get(), sibling_p}, true};
+    return InsertRetType{ItR<Key,Value,Alloc>{this, root_p_.get(), sibling_p}, true};
   }
 
   // Case a.2 SplitNode with one Child Branch
   // Case lp_key_len == key_len
   SplitNode(first_mm_node_p, lp_key_len - lm_key_len, nullptr);
-  first_mm_node_p->keyvalue_p.reset(new KeyValue{std::move(kv)});
+  first_mm_node_p->keyvalue_p = NewKeyValue(std::move(kv));
   ++value_size_;
-  return InsertRetType{ItR<Key,Value>{this, root_p_.get(), first_mm_node_p}, true};
+  return InsertRetType{ItR<Key,Value,Alloc>{this, root_p_.get(), first_mm_node_p}, true};
 }
 
+template <typename Key, typename Value, typename Alloc>
+ItR<Key,Value,Alloc>
+RadixTrie<Key,Value,Alloc>::SubtreeBegin(const Key& key) const {
+  NodePtr node_p = root_p_.get();
+  Key     k      = key;
+  while (node_p != nullptr) {
+    int len_key    = k.size();
+    int len_node   = node_p->key.size();
+    int len_common = PrefixSize(k, node_p->key);
+    // key ends within node key: every key of the subtree extends key
+    if (len_common == len_key)
+      return Begin(node_p);
+    if (len_common < len_node)
+      break;
+    node_p = node_p->children_p.at(k[len_common]).get();
+    k      = k.substr(len_common, (len_key - len_common));
+  }
+  return End();
+}
+
+template <typename Key, typename Value, typename Alloc>
+void RadixTrie<Key,Value,Alloc>::Diff(const RadixTrie& a, const RadixTrie& b,
+                                      Delta* delta_p) {
+  if (&a == &b)
+    return;
+  DiffNodes(a, a.root_p_.get(), b, b.root_p_.get(), delta_p);
+}
+
+template <typename Key, typename Value, typename Alloc>
+void RadixTrie<Key,Value,Alloc>::DiffNodes(const RadixTrie& a, NodePtr a_p,
+                                           const RadixTrie& b, NodePtr b_p,
+                                           Delta* delta_p) {
+  if ((a_p == nullptr) && (b_p == nullptr))
+    return;
+
+  // Same key at the same position: compare values & pair up children
+  if ((a_p != nullptr) && (b_p != nullptr) && (a_p->key == b_p->key)) {
+    KeyValuePtr akv_p = a_p->keyvalue_p.get();
+    KeyValuePtr bkv_p = b_p->keyvalue_p.get();
+    if ((akv_p != nullptr) && (bkv_p != nullptr)) {
+      if (!(akv_p->second == bkv_p->second))
+        delta_p->modify.push_back(*bkv_p);
+    } else if (akv_p != nullptr) {
+      delta_p->remove.push_back(akv_p->first);
+    } else if (bkv_p != nullptr) {
+      delta_p->add.push_back(*bkv_p);
+    }
+    for (size_t c=0; c<Node::NUM_CHILDREN; ++c)
+      DiffNodes(a, a_p->children_p.at(c).get(), b, b_p->children_p.at(c).get(),
+                delta_p);
+    return;
+  }
+
+  // Shapes differ (or one side is empty): merge both subtrees in trie order
+  ItR<Key,Value,Alloc> ita = (a_p == nullptr) ? a.End() : a.Begin(a_p);
+  ItR<Key,Value,Alloc> itb = (b_p == nullptr) ? b.End() : b.Begin(b_p);
+  while ((ita != a.End()) || (itb != b.End())) {
+    int cmp = (ita == a.End()) ? 1 :
+        ((itb == b.End()) ? -1 : TrieCompare(ita->first, itb->first));
+    if (cmp < 0) {
+      delta_p->remove.push_back(ita->first);
+      ++ita;
+    } else if (cmp > 0) {
+      delta_p->add.push_back(*itb);
+      ++itb;
+    } else {
+      if (!(ita->second == itb->second))
+        delta_p->modify.push_back(*itb);
+      ++ita;
+      ++itb;
+    }
+  }
+}
+
+template <typename Key, typename Value, typename Alloc>
+void RadixTrie<Key,Value,Alloc>::Apply(Delta delta) {
+  for (const Key& k : delta.remove) {
+    DCHECK(Find(k) != End()) << "Apply: " << k << " not found";
+    Erase(Find(k));
+  }
+  for (KeyValue& kv : delta.modify) {
+    ItR<Key,Value,Alloc> it = Find(kv.first);
+    DCHECK(it != End()) << "Apply: " << kv.first << " not found";
+    it->second = std::move(kv.second);
+  }
+  for (KeyValue& kv : delta.add)
+    Insert(std::move(kv));
+}
+
+template <typename Key, typename Value, typename Alloc>
+void RadixTrie<Key,Value,Alloc>::MergeFrom(const RadixTrie& other) {
+  if ((&other == this) || (other.root_p_ == nullptr))
+    return;
+  MergeNodes(&root_p_, nullptr, other, other.root_p_.get());
+}
+
+// Slot t_up (child of par_p) & o_p are at the same key length:
+// 1. empty slot: o_p's subtree is copied node by node (no lookups).
+// 2. equal keys: value of o_p wins & children are merged pairwise.
+// 3. shapes differ: key values of o_p's subtree are inserted one by one.
+template <typename Key, typename Value, typename Alloc>
+void RadixTrie<Key,Value,Alloc>::MergeNodes(NodeUPtr* t_up, NodePtr par_p,
+                                            const RadixTrie& other,
+                                            NodePtr o_p) {
+  if (o_p == nullptr)
+    return;
+  NodePtr t_p = t_up->get();
+  if (t_p == nullptr) {
+    *t_up = CloneNodes(o_p, par_p);
+    return;
+  }
+  if (t_p->key == o_p->key) {
+    KeyValuePtr okv_p = o_p->keyvalue_p.get();
+    if (okv_p != nullptr) {
+      if (t_p->keyvalue_p != nullptr) {
+        t_p->keyvalue_p->second = okv_p->second;
+      } else {
+        t_p->keyvalue_p = NewKeyValue(KeyValue{*okv_p});
+        ++value_size_;
+      }
+    }
+    for (size_t c=0; c<Node::NUM_CHILDREN; ++c)
+      MergeNodes(&t_p->children_p.at(c), t_p, other,
+                 o_p->children_p.at(c).get());
+    return;
+  }
+  for (auto it = other.Begin(o_p); it != other.End(); ++it) {
+    InsertRetType ret = Insert(*it);
+    if (!ret.second)
+      ret.first->second = it->second;
+  }
+}
+
+template <typename Key, typename Value, typename Alloc>
+typename RadixTrie<Key,Value,Alloc>::NodeUPtr
+RadixTrie<Key,Value,Alloc>::CloneNodes(NodePtr o_p, NodePtr par_p) {
+  if (o_p == nullptr)
+    return nullptr;
+  KeyValueUPtr kv_p = nullptr;
+  if (o_p->keyvalue_p != nullptr) {
+    kv_p = NewKeyValue(KeyValue{*o_p->keyvalue_p});
+    ++value_size_;
+  }
+  NodeUPtr node_p{NewNode(o_p->key, std::move(kv_p), par_p)};
+  ++node_size_;
+  for (size_t c=0; c<Node::NUM_CHILDREN; ++c)
+    node_p->children_p.at(c) =
+        CloneNodes(o_p->children_p.at(c).get(), node_p.get());
+  return node_p;
+}
+
+template <typename Key, typename Value, typename Alloc>
+constexpr size_t RadixTrie<Key,Value,Alloc>::PARTITION_BITS;
+
+// Parallel: partitions are runs of keys that share the first
+// PARTITION_BITS bits. Every partition is loaded in a separate trie by a
+// pool worker. Stitching pass walks the keys in order again: keys shorter
+// than PARTITION_BITS are loaded and partition subtries are grafted
+// (their allocator chunks are handed over to this trie).
+template <typename Key, typename Value, typename Alloc>
+void RadixTrie<Key,Value,Alloc>::BulkLoad(vector<KeyValue> kvs, Pool* pool_p) {
+  DCHECK(root_p_ == nullptr) << "BulkLoad expects an empty trie";
+  if (kvs.empty())
+    return;
+  if (pool_p == nullptr) {
+    BulkLoad(kvs.data(), kvs.data() + kvs.size());
+    return;
+  }
+
+  vector<pair<size_t, size_t>> parts; // [begin, end) indices
+  for (size_t i=0; i<kvs.size(); ) {
+    if (kvs[i].first.size() < PARTITION_BITS) {
+      ++i;
+      continue;
+    }
+    size_t j = i + 1;
+    while ((j < kvs.size()) &&
+           (PrefixSize(kvs[j].first, kvs[i].first) >= PARTITION_BITS))
+      ++j;
+    parts.emplace_back(i, j);
+    i = j;
+  }
 
-template <typename Key, typename Value>
+  vector<RadixTrie> tries(parts.size());
+  Latch             latch{static_cast<int>(parts.size())};
+  for (size_t p=0; p<parts.size(); ++p) {
+    RadixTrie* t_p     = &tries[p];
+    KeyValue*  begin_p = kvs.data() + parts[p].first;
+    KeyValue*  end_p   = kvs.data() + parts[p].second;
+    pool_p->AddTask([t_p, begin_p, end_p, &latch]() {
+        t_p->BulkLoad(begin_p, end_p);
+        latch.CountDown();
+      });
+  }
+  latch.Wait();
+
+  BulkState state{{}, kvs.front().first};
+  size_t    p = 0;
+  for (size_t i=0; i<kvs.size(); ) {
+    if ((p < parts.size()) && (i == parts[p].first)) {
+      RadixTrie& t = tries[p];
+      alloc_.Splice(&t.alloc_);
+      BulkGraft(std::move(t.root_p_), t.node_size_, t.value_size_, &state);
+      t.node_size_ = t.value_size_ = 0;
+      i = parts[p++].second;
+      continue;
+    }
+    Key key{kvs[i].first}; // copy key before kv is moved
+    BulkGraft(NodeUPtr{NewNode(std::move(key), NewKeyValue(std::move(kvs[i])))},
+              1, 1, &state);
+    ++i;
+  }
+}
+
+template <typename Key, typename Value, typename Alloc>
+void RadixTrie<Key,Value,Alloc>::BulkLoad(KeyValue* begin_p, KeyValue* end_p) {
+  if (begin_p == end_p)
+    return;
+  BulkState state{{}, begin_p->first};
+  for (KeyValue* kv_p = begin_p; kv_p != end_p; ++kv_p) {
+    Key key{kv_p->first}; // copy key before kv is moved
+    BulkGraft(NodeUPtr{NewNode(std::move(key), NewKeyValue(std::move(*kv_p)))},
+              1, 1, &state);
+  }
+}
+
+// Sorted keys: item attaches to the rightmost path at lcp, the length of
+// common prefix of the item and the last key loaded. Cases:
+// a. Trie empty: item is root.
+// b. Path node straddles lcp: split node at lcp (refer SplitNode).
+//    Root is split at 0 when item & root have no common prefix.
+// c. Item key ends at lcp i.e. equals a path node's key: node adopts
+//    the value unless it has one (duplicate key).
+// d. Item is attached as right child of path node ending at lcp.
+template <typename Key, typename Value, typename Alloc>
+void RadixTrie<Key,Value,Alloc>::BulkGraft(NodeUPtr item_p, size_t num_nodes,
+                                           size_t num_values,
+                                           BulkState* state_p) {
+  vector<PathEntry>& path = state_p->path;
+  size_t             len  = item_p->key.size();
+
+  // a.
+  if (root_p_ == nullptr) {
+    DCHECK(path.empty());
+    state_p->prev = item_p->key;
+    path.push_back({item_p.get(), len});
+    root_p_ = std::move(item_p);
+    node_size_ += num_nodes; value_size_ += num_values;
+    return;
+  }
+
+  size_t lcp = PrefixSize(item_p->key, state_p->prev);
+  DCHECK((lcp == len) || (lcp == state_p->prev.size()) ||
+         (!state_p->prev[lcp] && item_p->key[lcp]))
+      << "BulkLoad keys not sorted: " << state_p->prev << " before "
+      << item_p->key;
+  NodePtr last_p = nullptr;
+  while (!path.empty() && (path.back().end > lcp)) {
+    last_p = path.back().node_p;
+    path.pop_back();
+  }
+
+  // b.
+  size_t start = path.empty() ? 0 : path.back().end;
+  if ((last_p != nullptr) && ((start < lcp) || path.empty())) {
+    NodePtr   parent_p = path.empty() ? nullptr : path.back().node_p;
+    NodeUPtr& slot     = (parent_p == nullptr) ? root_p_ :
+        parent_p->children_p.at(last_p->key[0]);
+    size_t    split    = lcp - start;
+    size_t    idx      = last_p->key[split];
+    NodePtr   split_p  = NewNode(last_p->key.substr(0, split), nullptr,
+                                 parent_p);
+    last_p->key = last_p->key.substr(split, last_p->key.size() - split);
+    last_p->parent_p = split_p;
+    split_p->children_p.at(idx) = std::move(slot);
+    slot.reset(split_p);
+    ++node_size_;
+    path.push_back({split_p, lcp});
+  }
+  DCHECK(!path.empty() && (path.back().end == lcp));
+  NodePtr top_p = path.back().node_p;
+
+  // c.
+  if (lcp == len) {
+    DCHECK_EQ(num_nodes, 1) << "grafted subtrie collides with key";
+    if ((top_p->keyvalue_p == nullptr) && (num_values != 0)) {
+      top_p->keyvalue_p = std::move(item_p->keyvalue_p);
+      ++value_size_;
+    }
+    return;
+  }
+
+  // d.
+  size_t idx = item_p->key[lcp];
+  DCHECK(top_p->children_p.at(idx) == nullptr)
+      << "BulkLoad keys not sorted: " << item_p->key;
+  state_p->prev = item_p->key;
+  item_p->key = item_p->key.substr(lcp, len - lcp);
+  item_p->parent_p = top_p;
+  path.push_back({item_p.get(), len});
+  top_p->children_p.at(idx) = std::move(item_p);
+  node_size_ += num_nodes; value_size_ += num_values;
+}
+
+template <typename Key, typename Value, typename Alloc>
 std::ostream& operator << (std::ostream& os, 
-                           const RadixTrie<Key,Value>& rt) {
+                           const RadixTrie<Key,Value,Alloc>& rt) {
 
   os << "#nodes " << rt.NSize() << ": #values " << rt.Size() << std::endl;
   os << "---------------------------" << std::endl;
 
-  ItR<Key,Value> it = rt.Begin();
-  ItR<Key,Value> itend = rt.End();
+  ItR<Key,Value,Alloc> it = rt.Begin();
+  ItR<Key,Value,Alloc> itend = rt.End();
 
   for(; it != itend; ++it)
     os << "<" << it->first << "," << it->second << ">" << std::endl;
@@ -537,9 +944,9 @@ std::ostream& operator << (std::ostream& os,
   return os;
 }
 
-template <typename Key, typename Value>
+template <typename Key, typename Value, typename Alloc>
 std::ostream& operator << (std::ostream& os, 
-                           const ItR<Key,Value>& it) {
+                           const ItR<Key,Value,Alloc>& it) {
   os << "RadixTriePtr=" << hex << it.rt_p_
      << ": SubRootPtr=" << it.sub_root_p_
      << ": NodePtr=" << it.node_p_;
@@ -575,5 +982,77 @@ template std::ostream& operator << (std::ostream &os,
 template class ItR<StringPrefix, string>;
 template std::ostream& operator << (std::ostream &os,
                                     const ItR<StringPrefix, string>&);
+
+// Instantiation for IPv6Prefix
+template class RadixTrie<IPv6Prefix, void*>;
+template std::ostream& operator << (std::ostream &os,
+                                    const RadixTrie<IPv6Prefix, void*>&);
+template class ItR<IPv6Prefix, void*>;
+template std::ostream& operator << (std::ostream &os,
+                                    const ItR<IPv6Prefix, void*>&);
+template class RadixTrie<IPv6Prefix, string>;
+template std::ostream& operator << (std::ostream &os,
+                                    const RadixTrie<IPv6Prefix, string>&);
+template class ItR<IPv6Prefix, string>;
+template std::ostream& operator << (std::ostream &os,
+                                    const ItR<IPv6Prefix, string>&);
+template class RadixTrie<IPv6Prefix, void*, SlabAlloc>;
+template std::ostream& operator << (std::ostream &os,
+                                    const RadixTrie<IPv6Prefix, void*,
+                                    SlabAlloc>&);
+template class ItR<IPv6Prefix, void*, SlabAlloc>;
+template std::ostream& operator << (std::ostream &os,
+                                    const ItR<IPv6Prefix, void*, SlabAlloc>&);
+template class RadixTrie<IPv6Prefix, string, SlabAlloc>;
+template std::ostream& operator << (std::ostream &os,
+                                    const RadixTrie<IPv6Prefix, string,
+                                    SlabAlloc>&);
+template class ItR<IPv6Prefix, string, SlabAlloc>;
+template std::ostream& operator << (std::ostream &os,
+                                    const ItR<IPv6Prefix, string, SlabAlloc>&);
+
+// Instantiation for trivially copyable value (refer RadixTrieSnapshot)
+template class RadixTrie<IPv4Prefix, uint32_t>;
+template std::ostream& operator << (std::ostream &os,
+                                    const RadixTrie<IPv4Prefix, uint32_t>&);
+template class RadixTrie<StringPrefix, uint32_t>;
+template std::ostream& operator << (std::ostream &os,
+                                    const RadixTrie<StringPrefix, uint32_t>&);
+template class ItR<IPv4Prefix, uint32_t>;
+template std::ostream& operator << (std::ostream &os,
+                                    const ItR<IPv4Prefix, uint32_t>&);
+template class ItR<StringPrefix, uint32_t>;
+template std::ostream& operator << (std::ostream &os,
+                                    const ItR<StringPrefix, uint32_t>&);
+
+// Instantiation for slab allocation policy
+template class RadixTrie<IPv4Prefix, void*, SlabAlloc>;
+template std::ostream& operator << (std::ostream &os,
+                                    const RadixTrie<IPv4Prefix, void*,
+                                    SlabAlloc>&);
+template class RadixTrie<StringPrefix, void*, SlabAlloc>;
+template std::ostream& operator << (std::ostream &os,
+                                    const RadixTrie<StringPrefix, void*,
+                                    SlabAlloc>&);
+template class ItR<IPv4Prefix, void*, SlabAlloc>;
+template std::ostream& operator << (std::ostream &os,
+                                    const ItR<IPv4Prefix, void*, SlabAlloc>&);
+template class ItR<StringPrefix, void*, SlabAlloc>;
+template std::ostream& operator << (std::ostream &os,
+                                    const ItR<StringPrefix, void*, SlabAlloc>&);
+template class RadixTrie<IPv4Prefix, string, SlabAlloc>;
+template std::ostream& operator << (std::ostream &os,
+                                    const RadixTrie<IPv4Prefix, string,
+                                    SlabAlloc>&);
+template class RadixTrie<StringPrefix, string, SlabAlloc>;
+template std::ostream& operator << (std::ostream &os,
+                                    const RadixTrie<StringPrefix, string,
+                                    SlabAlloc>&);
+template class ItR<IPv4Prefix, string, SlabAlloc>;
+template std::ostream& operator << (std::ostream &os,
+                                    const ItR<IPv4Prefix, string, SlabAlloc>&);
+template class ItR<StringPrefix, string, SlabAlloc>;
+template std::ostream& operator << (std::ostream &os,
+                                    const ItR<StringPrefix, string, SlabAlloc>&);
 //-----------------------------------------------------------------------------
 } } } // namespace asarcar { namespace utils { namespace ds {
@@ -26,7 +26,7 @@
 //!         - FindNext: log(n) time. 
 //!         - 
 //!         - Thread Safety: NOT thread safe i.e. NOT internally synchronized. 
-//!           TODO: ConcurTrie: concurrent trie that is interally synchronized.
+//!           ConcurRadixTrie: trie with lock free readers (concur_radix_trie.h).
 //!         
 //! @author Arijit Sarcar <sarcar_a@yahoo.com>
 
@@ -35,57 +35,76 @@
 
 // C++ Standard Headers
 #include <array>            // std::array
+#include <functional>       // std::function
 #include <iomanip>          // std::setwidth
 #include <memory>           // std::unique_ptr
 #include <sstream>          // std::stringstream
 #include <string>           // std::string
 #include <utility>          // std::pair
+#include <vector>           // std::vector
 // C Standard Headers
 // Google Headers
 // Local Headers
+#include "utils/basic/slab_alloc.h"
 
 // The RadixTrie class is templatized to take in <Key,Value> as a
 // template argument. 
 // To avoid polluting the .h file with implementation details, 
 // the method implementations have been moved to the .cc file, and
 // specific instantiations are supported for the relevant <Key,Value> 
-// types. Currently we support IPv4Prefix and StringPrefix.
-// TODO: Add IPv6Prefix.
+// types. Currently we support IPv4Prefix, IPv6Prefix and StringPrefix.
+// Alloc is the allocation policy of nodes & key values (slab_alloc.h):
+// HeapAlloc (default) or SlabAlloc. SlabAlloc places nodes & key values
+// in contiguous chunks. Clear is O(#chunks) only when Key & Value are
+// trivially destructible (e.g. IPv4Prefix keys with pointer or integer
+// values): the chunks are released without visiting nodes. Otherwise
+// (e.g. StringPrefix keys or string values) Clear still walks the trie
+// destroying every node: O(#nodes).
 
 //! @addtogroup ds
 //! @{
 
-namespace asarcar { namespace utils { namespace ds {
+namespace asarcar { namespace utils {
+namespace concur {
+template <typename F>
+class ThreadPool;
+} // namespace concur
+namespace ds {
 //-----------------------------------------------------------------------------
 
 // Forward Declarations
-template <typename Key, typename Value>
+template <typename Key, typename Value, typename Alloc = HeapAlloc>
 class RadixTrie;
 
-template <typename Key, typename Value>
+template <typename Key, typename Value, typename Alloc = HeapAlloc>
 class ItR;
 
-template <typename Key, typename Value>
+template <typename Key, typename Value, typename Alloc>
 std::ostream& operator << (std::ostream& os, 
-                           const RadixTrie<Key,Value>& r);
+                           const RadixTrie<Key,Value,Alloc>& r);
 
-template <typename Key, typename Value>
+template <typename Key, typename Value, typename Alloc>
 std::ostream& operator << (std::ostream& os, 
-                           const ItR<Key,Value>& it);
+                           const ItR<Key,Value,Alloc>& it);
 
 template <typename Key, typename Value>
+class RadixTrieSnapshot;
+
+template <typename Key, typename Value, typename Alloc>
 class RadixTrie {
  public:
   using KeyValue     = std::pair<Key,Value>;
   using KeyValuePtr  = KeyValue*;
-  using KeyValueUPtr = std::unique_ptr<KeyValue>;
-  using InsertRetType= std::pair<ItR<Key,Value>, bool>;
-  friend class ItR<Key,Value>;
+  using KeyValueUPtr =
+      std::unique_ptr<KeyValue, typename Alloc::template Deleter<KeyValue>>;
+  using InsertRetType= std::pair<ItR<Key,Value,Alloc>, bool>;
+  friend class ItR<Key,Value,Alloc>;
+  friend class RadixTrieSnapshot<Key,Value>;
 
  private:
   // Forward Declarations
   class Node;
-  using NodeUPtr = std::unique_ptr<Node>;
+  using NodeUPtr = std::unique_ptr<Node, typename Alloc::template Deleter<Node>>;
   using NodePtr  = Node*;
   class Node {
    public:
@@ -111,27 +130,41 @@ class RadixTrie {
   };
   
  public:
-  RadixTrie() : root_p_{nullptr}, node_size_{0}, value_size_{0} {}
-  ~RadixTrie() = default;
+  RadixTrie() : alloc_{}, root_p_{nullptr}, node_size_{0}, value_size_{0} {}
+  ~RadixTrie() { Clear(); }
 
   inline size_t Size() const { return value_size_; }
   inline size_t NSize() const { return node_size_; }
   inline bool Empty() const { return (value_size_ == 0); }
-  inline void Clear() {root_p_.reset(nullptr); value_size_ = 0; node_size_ = 0;}
+  // Removes all key values: O(#chunks) with SlabAlloc & trivially
+  // destructible Key & Value, otherwise O(#nodes)
+  void Clear();
+  // Bytes used by nodes & key values: excludes memory owned by keys and
+  // values (e.g. StringPrefix bytes) and heap allocator overheads
+  inline size_t MemSize() const {
+    return alloc_.MemSize(node_size_*sizeof(Node) +
+                          value_size_*sizeof(KeyValue));
+  }
   std::string to_string(bool dump_internal_nodes=false);
 
  private:
   std::string to_string(NodePtr node_p, int depth, bool dump_internal_nodes);
 
-  ItR<Key,Value> Begin(NodePtr root_p) const;  
-  inline ItR<Key,Value> End(NodePtr root_p) const { 
-    return ItR<Key,Value>{this, root_p, nullptr};
+  ItR<Key,Value,Alloc> Begin(NodePtr root_p) const;  
+  inline ItR<Key,Value,Alloc> End(NodePtr root_p) const { 
+    return ItR<Key,Value,Alloc>{this, root_p, nullptr};
   }
  public:
-  inline ItR<Key,Value> Begin() const { return Begin(nullptr); }
-  inline ItR<Key,Value> End() const { return End(nullptr); }
-  ItR<Key,Value> Find(const Key& key) const; 
-  ItR<Key,Value> LongestPrefixMatch(const Key& key) const;
+  inline ItR<Key,Value,Alloc> Begin() const { return Begin(nullptr); }
+  inline ItR<Key,Value,Alloc> End() const { return End(nullptr); }
+  ItR<Key,Value,Alloc> Find(const Key& key) const; 
+  ItR<Key,Value,Alloc> LongestPrefixMatch(const Key& key) const;
+  // out[i] = LongestPrefixMatch(keys[i]) for i in [0, n).
+  // BATCH_WIDTH lookups walk the trie in lock step: a lookup prefetches
+  // its next node & yields to the others, so their cache misses overlap.
+  static constexpr size_t BATCH_WIDTH = 16;
+  void LongestPrefixMatchBatch(const Key* keys, size_t n,
+                               ItR<Key,Value,Alloc>* out) const;
 
   // Intentionally we pass input param by value.
   // Users are encouraged to pass rvalue for efficiency
@@ -140,7 +173,41 @@ class RadixTrie {
   // copy the argument. 
   // Beware as otherwise, we add a copy overhead if param is lvalue.
   InsertRetType Insert(KeyValue kv);
-  ItR<Key,Value> Erase(ItR<Key,Value> it);
+  ItR<Key,Value,Alloc> Erase(ItR<Key,Value,Alloc> it);
+
+  // Loads key values into an empty trie in one pass: no lookup from the
+  // root per key. kvs are sorted in trie order i.e. a key precedes keys
+  // it prefixes, otherwise 0 bit precedes 1 bit at the first mismatch.
+  // Duplicate keys are dropped.
+  // pool_p: when set, disjoint subtries (by the first PARTITION_BITS of
+  // the keys) are built in parallel by pool workers & then stitched.
+  using Pool = concur::ThreadPool<std::function<void(void)>>;
+  static constexpr size_t PARTITION_BITS = 8;
+  void BulkLoad(std::vector<KeyValue> kvs, Pool* pool_p = nullptr);
+
+  // Iterates the subtree of key: key values whose key is prefixed by key
+  // (more specifics of key, key included) in trie order, then End().
+  ItR<Key,Value,Alloc> SubtreeBegin(const Key& key) const;
+
+  // Changes that turn trie a into trie b
+  struct Delta {
+    std::vector<KeyValue> add;    // keys only in b: value of b
+    std::vector<Key>      remove; // keys only in a
+    std::vector<KeyValue> modify; // keys in both with unequal values: value of b
+  };
+  // Walks a & b in lock step: nodes with equal keys at the same position
+  // are compared in place & their children paired up. Key values are
+  // merged in trie order only below the point where the shapes differ.
+  // O(|a| + |b|): identical subtrees are walked, not skipped. A per node
+  // subtree hash cannot be kept exact as values are written in place
+  // through ItR & operator[].
+  static void Diff(const RadixTrie& a, const RadixTrie& b, Delta* delta_p);
+  // Applies delta e.g. from Diff(*this, b): leaves this equal to b
+  void Apply(Delta delta);
+  // Inserts key values of other: value of other wins for keys in both.
+  // Structural: walks both in lock step, copies subtrees of other missing
+  // here without lookups & inserts key by key only where shapes differ.
+  void MergeFrom(const RadixTrie& other);
 
   // Avoid: operator for first insert - wastes time default constructing
   // Value only to override it later.
@@ -157,6 +224,7 @@ class RadixTrie {
   }
 
  private:
+  Alloc     alloc_;  // precedes root_p_: nodes are destroyed first
   NodeUPtr  root_p_;
   size_t    node_size_; // # trie node
   size_t    value_size_; // # trie nodes with value
@@ -175,16 +243,54 @@ class RadixTrie {
                                  size_t* lm_key_len_p = nullptr,
                                  size_t* lp_key_len_p = nullptr) const;
   void SplitNode(NodePtr node_to_split_p, int len, NodePtr sibling_p);
+  inline NodePtr NewNode(Key k, KeyValueUPtr kv = nullptr,
+                         NodePtr par_p = nullptr,
+                         NodeUPtr lchild_p = nullptr,
+                         NodeUPtr rchild_p = nullptr) {
+    return alloc_.template New<Node>(std::move(k), std::move(kv), par_p,
+                                     std::move(lchild_p), std::move(rchild_p));
+  }
+  inline KeyValueUPtr NewKeyValue(KeyValue&& kv) {
+    return KeyValueUPtr{alloc_.template New<KeyValue>(std::move(kv))};
+  }
+  // Diff of the subtrees a_p (of a) & b_p (of b) rooted at the same key
+  // length
+  static void DiffNodes(const RadixTrie& a, NodePtr a_p,
+                        const RadixTrie& b, NodePtr b_p, Delta* delta_p);
+  // MergeFrom: merges subtree o_p (of other) into slot t_up (a child of
+  // par_p) at the same key length
+  void MergeNodes(NodeUPtr* t_up, NodePtr par_p, const RadixTrie& other,
+                  NodePtr o_p);
+  // Copy of subtree o_p (of another trie) with parent par_p
+  NodeUPtr CloneNodes(NodePtr o_p, NodePtr par_p);
   InsertRetType SetUpTreeBranch(KeyValue&& kv,
                                 NodePtr    first_mm_node_p, 
                                 int        lm_key_len, 
                                 int        lp_key_len);
+
+  // BulkLoad: rightmost path of the trie (path to the last key loaded).
+  // end: key length from root to the end of node's key.
+  struct PathEntry {
+    NodePtr node_p;
+    size_t  end;
+  };
+  struct BulkState {
+    std::vector<PathEntry> path;
+    Key                    prev; // last key loaded
+  };
+  void BulkLoad(KeyValue* begin_p, KeyValue* end_p);
+  // Attaches subtrie item_p (with num_nodes & num_values) whose root key
+  // is relative to the trie root to the rightmost path.
+  void BulkGraft(NodeUPtr item_p, size_t num_nodes, size_t num_values,
+                 BulkState* state_p);
 };
 
-template <typename Key, typename Value>
+template <typename Key, typename Value, typename Alloc>
 class ItR {
  public:
-  friend class RadixTrie<Key,Value>;
+  friend class RadixTrie<Key,Value,Alloc>;
+  // Unbound iterator: assign before use e.g. output of a batch lookup
+  ItR() : rt_p_{nullptr}, sub_root_p_{nullptr}, node_p_{nullptr} {}
   inline bool operator ==(const ItR& other) const { 
     return ((rt_p_==other.rt_p_) &&
             (node_p_==other.node_p_));
@@ -196,13 +302,13 @@ class ItR {
     node_p_ = rt_p_->GetNext(sub_root_p_, node_p_);
     return *this;
   }
-  inline typename RadixTrie<Key,Value>::KeyValue
+  inline typename RadixTrie<Key,Value,Alloc>::KeyValue
   operator* () const { 
     DCHECK(node_p_ != nullptr);
     DCHECK(node_p_->keyvalue_p != nullptr);
     return *node_p_->keyvalue_p; 
   }
-  inline typename RadixTrie<Key,Value>::KeyValuePtr
+  inline typename RadixTrie<Key,Value,Alloc>::KeyValuePtr
   operator-> () const { 
     DCHECK(node_p_ != nullptr);
     DCHECK(node_p_->keyvalue_p != nullptr);
@@ -214,17 +320,17 @@ class ItR {
   friend std::ostream& operator << <>(std::ostream& os, const ItR& it);
   
  private:
-  ItR(const RadixTrie<Key,Value>* rt_p, 
-      const typename RadixTrie<Key,Value>::NodePtr root_p, 
-      typename RadixTrie<Key,Value>::NodePtr node_p) : 
+  ItR(const RadixTrie<Key,Value,Alloc>* rt_p, 
+      const typename RadixTrie<Key,Value,Alloc>::NodePtr root_p, 
+      typename RadixTrie<Key,Value,Alloc>::NodePtr node_p) : 
       rt_p_{rt_p}, 
       sub_root_p_{(root_p == nullptr)? rt_p->root_p_.get(): root_p}, 
       node_p_{node_p} {}
   
   // all nodes from root subtree to the next node we intend to visit
-  const RadixTrie<Key,Value>*                   rt_p_;
-  const typename RadixTrie<Key,Value>::NodePtr  sub_root_p_; 
-  typename RadixTrie<Key,Value>::NodePtr        node_p_; 
+  const RadixTrie<Key,Value,Alloc>*                   rt_p_;
+  typename RadixTrie<Key,Value,Alloc>::NodePtr        sub_root_p_; 
+  typename RadixTrie<Key,Value,Alloc>::NodePtr        node_p_; 
 };
 
 //-----------------------------------------------------------------------------
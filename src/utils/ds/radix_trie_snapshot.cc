@@ -0,0 +1,398 @@
+// Copyright 2016 asarcar Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Author: Arijit Sarcar <sarcar_a@yahoo.com>
+
+// Standard C++ Headers
+#include <algorithm>        // std::min
+#include <array>            // std::array
+#include <cstring>          // std::memcpy
+#include <vector>           // std::vector
+// Standard C Headers
+#include <fcntl.h>          // open
+#include <stdio.h>          // rename
+#include <sys/mman.h>       // mmap
+#include <sys/stat.h>       // fstat
+#include <unistd.h>         // close, fsync, write
+// Google Headers
+#include <glog/logging.h>
+// Local Headers
+#include "utils/ds/radix_trie_snapshot.h"
+#include "utils/ds/string_prefix.h"
+#include "utils/nwk/ipv4_prefix.h"
+
+using namespace std;
+using namespace asarcar::utils::nwk;
+
+namespace asarcar { namespace utils { namespace ds {
+//-----------------------------------------------------------------------------
+
+namespace {
+// Zero bytes after packed bits: 64 bit loads at any bit offset of the
+// bits stay within the buffer
+constexpr size_t PAD_BYTES = 16;
+constexpr size_t ALIGN     = 8;
+constexpr size_t WORD_BITS = 64;
+
+// Key bits packed MSB first: KeyBits<Key> is specialized per key type
+template <typename Key>
+struct KeyBits;
+
+template <>
+struct KeyBits<IPv4Prefix> {
+  static constexpr uint32_t TYPE = 1;
+  explicit KeyBits(const IPv4Prefix& key) : len{key.size()} {
+    uint32_t addr = key.ip().to_scalar();
+    for (size_t i=0; i<sizeof(addr); ++i)
+      bytes[i] = static_cast<uint8_t>(addr >> (CHAR_BIT*(sizeof(addr)-1-i)));
+  }
+  inline const uint8_t* data(void) const { return bytes.data(); }
+  size_t                                  len;
+  std::array<uint8_t, 4 + PAD_BYTES>      bytes{};
+};
+
+template <>
+struct KeyBits<StringPrefix> {
+  static constexpr uint32_t TYPE = 2;
+  // words of key hold bits MSB first: byte swapped into bytes
+  explicit KeyBits(const StringPrefix& key) :
+      len{key.size()},
+      bytes((len + WORD_BITS - 1)/WORD_BITS*sizeof(uint64_t) + PAD_BYTES, 0) {
+    const uint64_t* words = key.data();
+    for (size_t i=0; i<(len + WORD_BITS - 1)/WORD_BITS; ++i) {
+      uint64_t w = __builtin_bswap64(words[i]);
+      memcpy(&bytes[i*sizeof(w)], &w, sizeof(w));
+    }
+  }
+  inline const uint8_t* data(void) const { return bytes.data(); }
+  size_t                len;
+  std::vector<uint8_t>  bytes;
+};
+
+inline bool Bit(const uint8_t* p, size_t off) {
+  return ((p[off/CHAR_BIT] >> (CHAR_BIT - 1 - off%CHAR_BIT)) & 1) != 0;
+}
+
+// 64 bits of p starting at bit offset off
+inline uint64_t Window(const uint8_t* p, size_t off) {
+  uint64_t w;
+  p += off/CHAR_BIT;
+  memcpy(&w, p, sizeof(w));
+  w = __builtin_bswap64(w);
+  size_t shift = off%CHAR_BIT;
+  return (shift == 0) ? w : ((w << shift) | (p[sizeof(w)] >> (CHAR_BIT - shift)));
+}
+
+// Length of the common prefix of len bits of a (at a_off) & b (at b_off)
+inline size_t CommonBits(const uint8_t* a, size_t a_off,
+                         const uint8_t* b, size_t b_off, size_t len) {
+  for (size_t n=0; n<len; n+=64) {
+    uint64_t x = Window(a, a_off + n) ^ Window(b, b_off + n);
+    if (x != 0)
+      return std::min(len, n + __builtin_clzll(x));
+  }
+  return len;
+}
+
+inline uint64_t Align(uint64_t off) {
+  return (off + ALIGN - 1)/ALIGN*ALIGN;
+}
+
+// FNV-1a
+uint64_t Checksum(const uint8_t* p, size_t size) {
+  uint64_t h = 0xcbf29ce484222325ULL;
+  for (size_t i=0; i<size; ++i)
+    h = (h ^ p[i])*0x100000001b3ULL;
+  return h;
+}
+} // namespace
+
+template <typename Key, typename Value>
+constexpr uint32_t RadixTrieSnapshot<Key,Value>::MAGIC;
+template <typename Key, typename Value>
+constexpr uint32_t RadixTrieSnapshot<Key,Value>::VERSION;
+template <typename Key, typename Value>
+constexpr uint32_t RadixTrieSnapshot<Key,Value>::NO_VALUE;
+
+template <typename Key, typename Value>
+RadixTrieSnapshot<Key,Value>&
+RadixTrieSnapshot<Key,Value>::operator =(RadixTrieSnapshot&& other) {
+  if (this == &other)
+    return *this;
+  Close();
+  map_p_    = other.map_p_;
+  map_size_ = other.map_size_;
+  header_p_ = other.header_p_;
+  nodes_p_  = other.nodes_p_;
+  bits_p_   = other.bits_p_;
+  values_p_ = other.values_p_;
+  other.map_p_    = nullptr;
+  other.map_size_ = 0;
+  return *this;
+}
+
+// Nodes are numbered in preorder: left subtrie follows its parent
+template <typename Key, typename Value>
+template <typename Alloc>
+bool RadixTrieSnapshot<Key,Value>::Save(const RadixTrie<Key,Value,Alloc>& rt,
+                                        const string& path) {
+  using NodePtr = typename RadixTrie<Key,Value,Alloc>::NodePtr;
+  struct Item {
+    NodePtr  node_p;
+    uint32_t parent;  // NO_VALUE: root
+    size_t   child;
+  };
+  vector<SNode>   nodes;
+  vector<uint8_t> bits;
+  size_t          num_bits = 0;
+  vector<Value>   values;
+  vector<Item>    stack;
+  if (rt.root_p_ != nullptr)
+    stack.push_back({rt.root_p_.get(), NO_VALUE, 0});
+  while (!stack.empty()) {
+    Item item = stack.back();
+    stack.pop_back();
+    KeyBits<Key> kb{item.node_p->key};
+    CHECK_LT(num_bits + kb.len, NO_VALUE) << "snapshot bit pool overflow";
+    SNode node{{0, 0}, static_cast<uint32_t>(num_bits),
+               static_cast<uint32_t>(kb.len), NO_VALUE};
+    bits.resize((num_bits + kb.len + CHAR_BIT - 1)/CHAR_BIT, 0);
+    for (size_t i=0; i<kb.len; ++i, ++num_bits)
+      if (Bit(kb.data(), i))
+        bits[num_bits/CHAR_BIT] |= (0x80 >> (num_bits%CHAR_BIT));
+    if (item.node_p->keyvalue_p != nullptr) {
+      node.value = static_cast<uint32_t>(values.size());
+      values.push_back(item.node_p->keyvalue_p->second);
+    }
+    uint32_t idx = static_cast<uint32_t>(nodes.size());
+    nodes.push_back(node);
+    if (item.parent != NO_VALUE)
+      nodes[item.parent].children[item.child] = idx;
+    for (size_t c = item.node_p->children_p.size(); c-- > 0; )
+      if (item.node_p->children_p[c] != nullptr)
+        stack.push_back({item.node_p->children_p[c].get(), idx, c});
+  }
+  bits.resize(bits.size() + PAD_BYTES, 0);
+
+  Header h{MAGIC, VERSION, KeyBits<Key>::TYPE, sizeof(Value),
+           nodes.size(), values.size(), 0, 0, bits.size(), 0, 0, 0};
+  h.nodes_off  = Align(sizeof(Header));
+  h.bits_off   = h.nodes_off + nodes.size()*sizeof(SNode);
+  h.values_off = Align(h.bits_off + bits.size());
+  h.file_size  = h.values_off + values.size()*sizeof(Value);
+
+  vector<uint8_t> buf(h.file_size, 0);
+  if (!nodes.empty())
+    memcpy(&buf[h.nodes_off], nodes.data(), nodes.size()*sizeof(SNode));
+  memcpy(&buf[h.bits_off], bits.data(), bits.size());
+  if (!values.empty())
+    memcpy(&buf[h.values_off], values.data(), values.size()*sizeof(Value));
+  h.checksum = Checksum(&buf[sizeof(Header)], h.file_size - sizeof(Header));
+  memcpy(&buf[0], &h, sizeof(Header));
+
+  // Written aside & renamed over path: a reader mapping the old file keeps
+  // its inode intact & a crash never leaves a torn file at path
+  string tmp = path + ".tmp";
+  int    fd  = open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    LOG(ERROR) << "Snapshot " << tmp << ": open failed";
+    return false;
+  }
+  size_t written = 0;
+  while (written < buf.size()) {
+    ssize_t n = write(fd, buf.data() + written, buf.size() - written);
+    if (n <= 0)
+      break;
+    written += n;
+  }
+  bool ok = (written == buf.size()) && (fsync(fd) == 0);
+  ok = (close(fd) == 0) && ok;
+  if (!ok || (rename(tmp.c_str(), path.c_str()) != 0)) {
+    LOG(ERROR) << "Snapshot " << path << ": write failed";
+    unlink(tmp.c_str());
+    return false;
+  }
+  return true;
+}
+
+template <typename Key, typename Value>
+bool RadixTrieSnapshot<Key,Value>::Open(const string& path, bool verify) {
+  Close();
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    LOG(ERROR) << "Snapshot " << path << ": open failed";
+    return false;
+  }
+  struct stat st;
+  size_t size = (fstat(fd, &st) == 0) ? st.st_size : 0;
+  void*  map_p = (size < sizeof(Header)) ? MAP_FAILED :
+      mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map_p == MAP_FAILED) {
+    LOG(ERROR) << "Snapshot " << path << ": map failed: size " << size;
+    return false;
+  }
+
+  const uint8_t* base_p = static_cast<const uint8_t*>(map_p);
+  const Header*  h_p    = static_cast<const Header*>(map_p);
+  const char*    err    = nullptr;
+  if ((h_p->magic != MAGIC) || (h_p->version != VERSION))
+    err = "bad magic or version";
+  else if ((h_p->key_type != KeyBits<Key>::TYPE) ||
+           (h_p->value_size != sizeof(Value)))
+    err = "key or value type mismatch";
+  else if (!ValidSections(*h_p, size))
+    err = "truncated or bad section bounds";
+  else if (verify &&
+           (Checksum(base_p + sizeof(Header), size - sizeof(Header)) !=
+            h_p->checksum))
+    err = "checksum mismatch";
+  else if (verify &&
+           !ValidNodes(reinterpret_cast<const SNode*>(base_p + h_p->nodes_off),
+                       *h_p))
+    err = "bad node";
+  if (err != nullptr) {
+    LOG(ERROR) << "Snapshot " << path << ": " << err;
+    munmap(map_p, size);
+    return false;
+  }
+
+  map_p_    = map_p;
+  map_size_ = size;
+  header_p_ = h_p;
+  nodes_p_  = reinterpret_cast<const SNode*>(base_p + h_p->nodes_off);
+  bits_p_   = base_p + h_p->bits_off;
+  values_p_ = reinterpret_cast<const Value*>(base_p + h_p->values_off);
+  return true;
+}
+
+// Sections lie in order within size: sizes compared by division so that
+// a foreign header cannot overflow the bounds
+template <typename Key, typename Value>
+bool RadixTrieSnapshot<Key,Value>::ValidSections(const Header& h, size_t size) {
+  return ((h.file_size == size) &&
+          (h.nodes_off >= sizeof(Header)) && (h.nodes_off%ALIGN == 0) &&
+          (h.nodes_off <= size) && (h.bits_off >= h.nodes_off) &&
+          (h.bits_off <= size) &&
+          (h.num_nodes <= (h.bits_off - h.nodes_off)/sizeof(SNode)) &&
+          (h.num_nodes < NO_VALUE) &&
+          (h.bits_size >= PAD_BYTES) &&
+          (h.bits_size <= size - h.bits_off) &&
+          (h.bits_size <= NO_VALUE/CHAR_BIT) &&
+          (h.values_off >= h.bits_off + h.bits_size) &&
+          (h.values_off%ALIGN == 0) && (h.values_off <= size) &&
+          (h.num_values <= (size - h.values_off)/sizeof(Value)) &&
+          (h.num_values < NO_VALUE));
+}
+
+// Children, keys & values of nodes lie within their sections. Nodes are
+// in preorder: a child follows its parent, so a walk cannot cycle, and
+// keys of nodes other than root start with the bit selecting them.
+template <typename Key, typename Value>
+bool RadixTrieSnapshot<Key,Value>::ValidNodes(const SNode* nodes_p,
+                                              const Header& h) {
+  for (size_t i=0; i<h.num_nodes; ++i) {
+    const SNode& node = nodes_p[i];
+    if ((node.children[0] >= h.num_nodes) ||
+        (node.children[1] >= h.num_nodes) ||
+        ((node.children[0] != 0) && (node.children[0] <= i)) ||
+        ((node.children[1] != 0) && (node.children[1] <= i)) ||
+        ((i != 0) && (node.key_len == 0)) ||
+        (uint64_t{node.key_off} + node.key_len >
+         (h.bits_size - PAD_BYTES)*CHAR_BIT) ||
+        ((node.value != NO_VALUE) && (node.value >= h.num_values)))
+      return false;
+  }
+  return true;
+}
+
+template <typename Key, typename Value>
+void RadixTrieSnapshot<Key,Value>::Close(void) {
+  if (map_p_ == nullptr)
+    return;
+  munmap(map_p_, map_size_);
+  map_p_    = nullptr;
+  map_size_ = 0;
+  header_p_ = nullptr;
+  nodes_p_  = nullptr;
+  bits_p_   = nullptr;
+  values_p_ = nullptr;
+}
+
+template <typename Key, typename Value>
+const Value*
+RadixTrieSnapshot<Key,Value>::LongestPrefixMatch(const Key& key,
+                                                 size_t* len_p) const {
+  uint32_t value = Match(key, false, len_p);
+  return (value == NO_VALUE) ? nullptr : &values_p_[value];
+}
+
+template <typename Key, typename Value>
+const Value* RadixTrieSnapshot<Key,Value>::Find(const Key& key) const {
+  uint32_t value = Match(key, true, nullptr);
+  return (value == NO_VALUE) ? nullptr : &values_p_[value];
+}
+
+// Same walk as RadixTrie::LongestPrefixMatchNode: node key (which starts
+// with the bit that selected the node) must match the key bits at off
+template <typename Key, typename Value>
+uint32_t RadixTrieSnapshot<Key,Value>::Match(const Key& key, bool exact,
+                                             size_t* len_p) const {
+  if ((len_p != nullptr))
+    *len_p = 0;
+  if (!IsOpen() || (header_p_->num_nodes == 0))
+    return NO_VALUE;
+
+  // Node fields are bounded even when Open skipped ValidNodes: an
+  // unverified foreign file fails lookups but is never read out of bounds.
+  // Child indices must increase (preorder) so that a crafted cycle ends
+  // the walk.
+  KeyBits<Key> kb{key};
+  uint32_t     found = NO_VALUE;
+  size_t       off   = 0;
+  uint64_t     num_bits = (header_p_->bits_size - PAD_BYTES)*CHAR_BIT;
+  for (uint32_t idx = 0; ; ) {
+    const SNode& node = nodes_p_[idx];
+    if ((uint64_t{node.key_off} + node.key_len > num_bits) ||
+        ((node.value != NO_VALUE) && (node.value >= header_p_->num_values)))
+      break;
+    if ((off + node.key_len > kb.len) ||
+        (CommonBits(kb.data(), off, bits_p_, node.key_off, node.key_len) <
+         node.key_len))
+      break;
+    off += node.key_len;
+    if ((node.value != NO_VALUE) && (!exact || (off == kb.len))) {
+      found = node.value;
+      if (len_p != nullptr)
+        *len_p = off;
+    }
+    if (off == kb.len)
+      break;
+    uint32_t next = node.children[Bit(kb.data(), off)];
+    if ((next <= idx) || (next >= header_p_->num_nodes))
+      break;
+    idx = next;
+  }
+  return found;
+}
+
+// Explicit Instantiation
+template class RadixTrieSnapshot<IPv4Prefix, uint32_t>;
+template bool RadixTrieSnapshot<IPv4Prefix, uint32_t>::Save(
+    const RadixTrie<IPv4Prefix, uint32_t>&, const string&);
+template class RadixTrieSnapshot<StringPrefix, uint32_t>;
+template bool RadixTrieSnapshot<StringPrefix, uint32_t>::Save(
+    const RadixTrie<StringPrefix, uint32_t>&, const string&);
+//-----------------------------------------------------------------------------
+} } } // namespace asarcar { namespace utils { namespace ds {
@@ -0,0 +1,146 @@
+// Copyright 2016 asarcar Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+//! @file   radix_trie_snapshot.h
+//! @brief  Immutable on disk snapshot of a RadixTrie opened with mmap
+//! @detail A process restart otherwise rebuilds the RadixTrie key by key.
+//!         Save writes a trie to a file with the layout:
+//!         1. Header: magic, version, key type, value size, section
+//!            offsets & sizes, and FNV-1a checksum of everything after it.
+//!         2. Nodes: array of fixed size nodes in preorder. Children are
+//!            node indices (0: none, as root is never a child) greater
+//!            than the parent's (checked: a walk never cycles), node key
+//!            is a (bit offset, bit length) run in the bit pool and value
+//!            is an index in the value array.
+//!         3. Bit pool: node keys packed back to back (MSB first).
+//!         4. Values: array of trivially copyable Value.
+//!         Open maps the file read only: lookups run directly on the
+//!         mapped pages i.e. nothing is copied or rebuilt. Pages are read
+//!         from the file system (page cache) as lookups touch them.
+//!
+//!         Complexity
+//!         - Open: O(1) [O(file size) when verified]
+//!         - LongestPrefixMatch/Find(S): O(n) [n: bit length of S]
+//!         - Thread Safety: Lookups are thread safe. Open/Close are not.
+//! @author Arijit Sarcar <sarcar_a@yahoo.com>
+
+#ifndef _UTILS_DS_RADIX_TRIE_SNAPSHOT_H_
+#define _UTILS_DS_RADIX_TRIE_SNAPSHOT_H_
+
+// C++ Standard Headers
+#include <string>           // std::string
+#include <type_traits>      // std::is_trivially_copyable
+// C Standard Headers
+// Google Headers
+// Local Headers
+#include "utils/basic/basictypes.h"
+#include "utils/ds/radix_trie.h"
+
+//! @addtogroup ds
+//! @{
+
+namespace asarcar { namespace utils { namespace ds {
+//-----------------------------------------------------------------------------
+
+template <typename Key, typename Value>
+class RadixTrieSnapshot {
+ public:
+  static_assert(std::is_trivially_copyable<Value>::value,
+                "snapshot values are copied to file as is");
+  static_assert(alignof(Value) <= 8,
+                "values section is only 8 byte aligned");
+  static constexpr uint32_t MAGIC   = 0x52545350; // "RTSP"
+  static constexpr uint32_t VERSION = 1;
+
+  RadixTrieSnapshot() = default;
+  ~RadixTrieSnapshot() { Close(); }
+  RadixTrieSnapshot(const RadixTrieSnapshot&)             = delete;
+  RadixTrieSnapshot& operator =(const RadixTrieSnapshot&) = delete;
+  RadixTrieSnapshot(RadixTrieSnapshot&& other) { *this = std::move(other); }
+  RadixTrieSnapshot& operator =(RadixTrieSnapshot&& other);
+
+  // Writes rt to path.tmp, fsyncs & renames it over path: snapshots opened
+  // at path stay valid. Returns false on I/O failure.
+  template <typename Alloc>
+  static bool Save(const RadixTrie<Key,Value,Alloc>& rt,
+                   const std::string& path);
+
+  // Maps file at path: returns false (& stays closed) when file is missing,
+  // truncated, of another version, key or value type, has sections out of
+  // the file, or fails verification. verify: checksum, bounds & preorder
+  // check every node. Without it open reads only the header; lookups still
+  // bound node fields & only descend to later nodes so a bad file is never
+  // read past the mapping nor walked in a cycle.
+  bool Open(const std::string& path, bool verify = true);
+  void Close(void);
+  inline bool IsOpen(void) const { return map_p_ != nullptr; }
+
+  inline size_t Size(void) const {
+    return IsOpen() ? header_p_->num_values : 0;
+  }
+  inline size_t NSize(void) const {
+    return IsOpen() ? header_p_->num_nodes : 0;
+  }
+  // Bytes mapped
+  inline size_t MemSize(void) const { return map_size_; }
+
+  // Value of longest prefix of key or nullptr. len_p: set to length of the
+  // matched prefix.
+  const Value* LongestPrefixMatch(const Key& key,
+                                  size_t* len_p = nullptr) const;
+  // Value of key or nullptr
+  const Value* Find(const Key& key) const;
+
+ private:
+  static constexpr uint32_t NO_VALUE = 0xFFFFFFFF;
+  struct Header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t key_type;
+    uint32_t value_size;
+    uint64_t num_nodes;
+    uint64_t num_values;
+    uint64_t nodes_off;
+    uint64_t bits_off;
+    uint64_t bits_size;   // bytes: includes padding for 64 bit loads
+    uint64_t values_off;
+    uint64_t file_size;
+    uint64_t checksum;
+  };
+  struct SNode {
+    uint32_t children[2];
+    uint32_t key_off;     // bit offset in bit pool
+    uint32_t key_len;
+    uint32_t value;       // index in values or NO_VALUE
+  };
+
+  void*          map_p_    = nullptr;
+  size_t         map_size_ = 0;
+  const Header*  header_p_ = nullptr;
+  const SNode*   nodes_p_  = nullptr;
+  const uint8_t* bits_p_   = nullptr;
+  const Value*   values_p_ = nullptr;
+
+  // Value index of the longest prefix of key (exact: of key) or NO_VALUE.
+  // len_p: length of the matched prefix.
+  uint32_t Match(const Key& key, bool exact, size_t* len_p) const;
+  static bool ValidSections(const Header& h, size_t size);
+  static bool ValidNodes(const SNode* nodes_p, const Header& h);
+};
+
+//-----------------------------------------------------------------------------
+} } } // namespace asarcar { namespace utils { namespace ds {
+
+#endif // _UTILS_DS_RADIX_TRIE_SNAPSHOT_H_
@@ -34,6 +34,14 @@
 //!           not as good as skip lists (trade-off memory).
 //!         - Thread Safety: NOT thread safe. For concurrent R/RW access use
 //!           synchronization.
+//!         - MaxNum bounds # entries & fixes # levels at compile time.
+//!           SkipList<T> (MaxNum = SKIPLIST_UNBOUNDED) is unbounded: head
+//!           starts with 1 level and grows as nodes of higher levels are
+//!           drawn. Node levels are capped at log2(Size()) + 1.
+//!         - Indexable: every forward link also records its span i.e. # of
+//!           level 0 links it skips. Select(k), Rank(val) and
+//!           CountRange(lo, hi) sum spans along the search path: O(log n)
+//!           instead of a linear walk. Costs one word per link.
 //!         
 //! @author Arijit Sarcar <sarcar_a@yahoo.com>
 
@@ -41,15 +49,18 @@
 #define _UTILS_DS_SKIP_LISTS_H_
 
 // C++ Standard Headers
+#include <algorithm>        // std::fill_n
 #include <array>            // array
 #include <iomanip>          // std::setfill, std::setw, std::left/right, ...
 #include <functional>       // std::function
-#include <random>           // std::distribution, random engine, ...
+#include <new>              // placement new
+#include <random>           // std::random_device
 #include <utility>          // std::pair
 // C Standard Headers
 // Google Headers
+#include <glog/logging.h>   // DCHECK
 // Local Headers
-#include "utils/basic/fassert.h"
+#include "utils/basic/basictypes.h"
 
 //! @addtogroup utils
 //! @{
@@ -78,8 +89,11 @@ constexpr uint32_t TrailingOnes(const uint32_t N) {
     return (((N & 0x00000001) == 0) ? 0 : TrailingOnes(N>>1) + 1);
 }
 
+// MaxNum of a SkipList without bound on # entries
+constexpr uint32_t SKIPLIST_UNBOUNDED = 0;
+
 // Forward Declarations
-template <typename T, uint32_t MaxNum>
+template <typename T, uint32_t MaxNum = SKIPLIST_UNBOUNDED>
 class SkipList;
 
 template <typename T, uint32_t MaxNum>
@@ -93,10 +107,14 @@ class SkipList {
  public:
   using SkipListPtr = SkipList<T,MaxNum> *;
 
+  static constexpr bool     UNBOUNDED  = (MaxNum == SKIPLIST_UNBOUNDED);
+  // Levels of an unbounded SkipList: bits of the random word
+  static constexpr uint32_t MAX_LEVELS = 64;
+
   static constexpr uint32_t MaxLevel(void) {
-    static_assert(MaxNum <= (1 << 16), 
+    static_assert(UNBOUNDED || MaxNum <= (1 << 16), 
                   "Maximum entries supported for SkipList limited to 2^16 entries"); 
-    return MsbOnePos(MaxNum);
+    return UNBOUNDED ? MAX_LEVELS : MsbOnePos(MaxNum);
   }
 
   class Node;
@@ -104,50 +122,68 @@ class SkipList {
   using ValCRef  = const T&;
   using AccFn    = const std::function<uint32_t(const NodePtr)>&;
 
+  // Node of Size() levels: a single allocation holds the node followed by
+  // its Size() forward pointers and Size() spans i.e. no virtual dispatch
+  // or per level indirection to reach the next node.
+  // Span(i): rank(Next(i)) - rank(node) where rank(head) = 0 and
+  // rank(nullptr) = SkipList Size() + 1.
   class Node {
    public:
-    virtual ~Node() {}
-    virtual size_t Size(void) const = 0;
-    virtual NodePtr& Next(uint32_t index) = 0;
-    virtual const NodePtr& Next(uint32_t index) const = 0;
-    virtual ValCRef  Value(void) const = 0;
-  };
-
-  template <uint32_t Level>  
-  class ValNode : public Node {
-   public:
-    using ValNodePtr = ValNode *;
-    // Value Initialization of Array _next
-    ValNode(T&& val) : Node{}, _val{std::move(val)}, _next{} {}
-    ValNode(const T& val) : Node{}, _val{val} {}
-    
-    // Override Methods
-    size_t Size(void) const override {
-      return _next.size();
+    inline size_t Size(void) const { return _level; }
+    inline NodePtr& Next(uint32_t index) {
+      DCHECK_LT(index, _level);
+      return NextArray()[index];
     }
-    NodePtr& Next(uint32_t index) override {
-      return _next.at(index);
+    inline const NodePtr& Next(uint32_t index) const {
+      DCHECK_LT(index, _level);
+      return NextArray()[index];
     }
-    const NodePtr& Next(uint32_t index) const override {
-      return _next.at(index);
+    inline size_t& Span(uint32_t index) {
+      DCHECK_LT(index, _level);
+      return SpanArray()[index];
     }
-    ValCRef Value(void) const override {
-      return _val;
+    inline size_t Span(uint32_t index) const {
+      DCHECK_LT(index, _level);
+      return SpanArray()[index];
     }
+    inline ValCRef Value(void) const { return _val; }
 
    private:
-    using NodePtrArray = std::array<NodePtr, Level>;
-
+    friend class SkipList<T,MaxNum>;
     T             _val;
-    NodePtrArray  _next;
+    uint32_t      _level;
+
+    Node(T&& val, uint32_t level) : _val{std::move(val)}, _level{level} {
+      std::fill_n(NextArray(), level, nullptr);
+      std::fill_n(SpanArray(), level, 0);
+    }
+    inline NodePtr* NextArray(void) {
+      return reinterpret_cast<NodePtr*>(
+          reinterpret_cast<char*>(this) + Offset());
+    }
+    inline const NodePtr* NextArray(void) const {
+      return reinterpret_cast<const NodePtr*>(
+          reinterpret_cast<const char*>(this) + Offset());
+    }
+    inline size_t* SpanArray(void) {
+      return reinterpret_cast<size_t*>(NextArray() + _level);
+    }
+    inline const size_t* SpanArray(void) const {
+      return reinterpret_cast<const size_t*>(NextArray() + _level);
+    }
+    // Forward pointers start at the first pointer aligned offset past node
+    static constexpr size_t Offset(void) {
+      return (sizeof(Node) + alignof(NodePtr) - 1) /
+          alignof(NodePtr) * alignof(NodePtr);
+    }
   };
 
   SkipList() : 
-    _num_nodes{0}, _head{T{}}, _seed{std::random_device{}()},
-    _random{std::bind(std::uniform_int_distribution<uint32_t>
-                      // random number between 0 to 2^MaxLevel()-1
-                      {0, static_cast<uint32_t>(static_cast<int>(1 >> MaxLevel())-1)}, 
-                      std::default_random_engine{_seed})} {} 
+    _num_nodes{0}, _mem_size{sizeof(*this)},
+    _head{AllocNode(T{}, UNBOUNDED ? 1 : MaxLevel())},
+    _seed{std::random_device{}()}, _random{Seed(_seed)} {
+    std::fill_n(_head->SpanArray(), _head->Size(), 1);
+  }
   ~SkipList() {
     // Free up memory for all nodes in the linked list
     NodePtr next_np, np = Head()->Next(0);
@@ -156,10 +192,18 @@ class SkipList {
       DeleteNode(np);
       np = next_np;
     }
+    FreeNode(_head);
   }
-  inline NodePtr  Head(void) { return &_head; }
-  inline const SkipList<T,MaxNum>::Node* Head(void) const { return &_head; }
+  SkipList(const SkipList&)             = delete;
+  SkipList& operator =(const SkipList&) = delete;
+
+  inline NodePtr  Head(void) { return _head; }
+  inline const SkipList<T,MaxNum>::Node* Head(void) const { return _head; }
   inline size_t   Size(void) const { return _num_nodes; }
+  // # levels in use i.e. of head: MaxLevel() unless unbounded
+  inline uint32_t Level(void) const { return _head->Size(); }
+  // Bytes used: list & nodes including head
+  inline size_t   MemSize(void) const { return _mem_size; }
 
 
   // Iterator
@@ -173,12 +217,12 @@ class SkipList {
 
   // Operations: Find/Insert/Remove...
   ItC Find(const T& val) {
-    NodePtr np=Head();
-    for(int lvl = static_cast<int>(MaxLevel()) - 1; lvl >= 0; --lvl) {
-      for(;np->Next(lvl) != nullptr && np->Next(lvl)->Value() < val; 
-          np = np->Next(lvl));
-      if (np->Next(lvl) != nullptr && np->Next(lvl)->Value() == val) 
-        return ItC{this, np->Next(lvl)};
+    NodePtr np=Head(), nxt;
+    for(int lvl = static_cast<int>(Level()) - 1; lvl >= 0; --lvl) {
+      for(nxt = np->Next(lvl); nxt != nullptr && nxt->Value() < val; 
+          np = nxt, nxt = np->Next(lvl));
+      if (nxt != nullptr && nxt->Value() == val) 
+        return ItC{this, nxt};
     }
     return end();
   }
@@ -187,29 +231,45 @@ class SkipList {
   // Returns <Iterator,false> if element exists (insert failed) else <iterator, true>
   ModPr Emplace(T&& val) {
     // Cache Nodes at every level whose next is insert node so we can insert if needed
+    // and their rank so spans can be split around the insert node
     std::array<NodePtr, MaxLevel()> nodeptrs;
-    NodePtr np=Head();
-
-    for(int lvl = static_cast<int>(MaxLevel()) - 1; lvl >= 0; --lvl) {
-      for(;np->Next(lvl) != nullptr && np->Next(lvl)->Value() < val; 
-          np = np->Next(lvl));
-      if ((np->Next(lvl) != nullptr) && (np->Next(lvl)->Value() == val))
-        return ModPr{ItC{this, np->Next(lvl)},false};
+    std::array<size_t, MaxLevel()>  ranks;
+    NodePtr np=Head(), nxt;
+    size_t  pos=0;
+
+    for(int lvl = static_cast<int>(Level()) - 1; lvl >= 0; --lvl) {
+      for(nxt = np->Next(lvl); nxt != nullptr && nxt->Value() < val; 
+          pos += np->Span(lvl), np = nxt, nxt = np->Next(lvl));
+      if ((nxt != nullptr) && (nxt->Value() == val))
+        return ModPr{ItC{this, nxt},false};
       // np is the previous node candidate. cache it.
       // i.e. np == head || np->Value < val AND
       //      np->Next(lvl) == nullptr OR np->Next(lvl)->Value > val
       nodeptrs[lvl] = np;
+      ranks[lvl]    = pos;
     }
 
     // create a new node with a random number of levels 
-    NodePtr insp = NewNode(std::move(val));
+    uint32_t level = Level();
+    NodePtr  insp  = NewNode(std::move(val));
+    if (insp->Size() > level) {
+      GrowHead(insp->Size(), &nodeptrs);
+      std::fill(ranks.begin() + level, ranks.begin() + insp->Size(), 0);
+    }
     // link node with the previous nodes in the list
-    // at all levels this node should participate in the linked list
+    // at all levels this node should participate in the linked list:
+    // the previous node's span is split at the new node's rank pos + 1
+    ++pos;
     for(int lvl = 0; lvl < static_cast<int>(insp->Size()); ++lvl) {
       NodePtr tmp = nodeptrs[lvl];
       insp->Next(lvl) = tmp->Next(lvl);
       tmp->Next(lvl) = insp;
+      insp->Span(lvl) = tmp->Span(lvl) + ranks[lvl] + 1 - pos;
+      tmp->Span(lvl)  = pos - ranks[lvl];
     }
+    // links above the new node now skip one more node
+    for(uint32_t lvl = insp->Size(); lvl < Level(); ++lvl)
+      ++nodeptrs[lvl]->Span(lvl);
 
     return ModPr{ItC{this, insp}, true};
   }
@@ -221,11 +281,11 @@ class SkipList {
   ModPr Remove(const T& val) {
     // Cache Nodes at every level whose next is insert node so we can insert if needed
     std::array<NodePtr, MaxLevel()> nodeptrs;
-    NodePtr np=Head();
+    NodePtr np=Head(), nxt;
 
-    for(int lvl = static_cast<int>(MaxLevel()) - 1; lvl >= 0; --lvl) {
-      for(;np->Next(lvl) != nullptr && np->Next(lvl)->Value() < val; 
-          np = np->Next(lvl));
+    for(int lvl = static_cast<int>(Level()) - 1; lvl >= 0; --lvl) {
+      for(nxt = np->Next(lvl); nxt != nullptr && nxt->Value() < val; 
+          np = nxt, nxt = np->Next(lvl));
       // np is the previous node candidate. cache it.
       // i.e. np == head || np->Value < val AND
       //      np->Next(lvl) == nullptr OR np->Next(lvl)->Value >= val
@@ -239,24 +299,71 @@ class SkipList {
       return ModPr{ItC{this, rem}, false};
 
     // 1. Remove node from all the previous nodes in the list
-    //    at all levels of this node.
-    // 2. Delete the node
-    for(int lvl = 0; lvl < static_cast<int>(rem->Size()); ++lvl)
-      nodeptrs[lvl]->Next(lvl) = rem->Next(lvl);
+    //    at all levels of this node: previous node absorbs its span.
+    // 2. Links above the node skip one node less.
+    // 3. Delete the node
+    for(int lvl = 0; lvl < static_cast<int>(rem->Size()); ++lvl) {
+      nodeptrs[lvl]->Next(lvl)  = rem->Next(lvl);
+      nodeptrs[lvl]->Span(lvl) += rem->Span(lvl) - 1;
+    }
+    for(uint32_t lvl = rem->Size(); lvl < Level(); ++lvl)
+      --nodeptrs[lvl]->Span(lvl);
     ModPr res{ItC{this, rem->Next(0)}, true};
     DeleteNode(rem);
     
     return res;
   }
 
+  // k-th smallest element (k: 0 based) or end() when k >= Size()
+  ItC Select(size_t k) {
+    NodePtr np=Head();
+    size_t  pos=0;
+    for(int lvl = static_cast<int>(Level()) - 1; lvl >= 0; --lvl) {
+      for(; np->Next(lvl) != nullptr && pos + np->Span(lvl) <= k + 1;
+          pos += np->Span(lvl), np = np->Next(lvl));
+      if (pos == k + 1)
+        return ItC{this, np};
+    }
+    return end();
+  }
+
+  // # elements < val i.e. 0 based position val has or would have
+  size_t Rank(const T& val) const {
+    const Node* np  = Head();
+    const Node* nxt;
+    size_t      pos = 0;
+    for(int lvl = static_cast<int>(Level()) - 1; lvl >= 0; --lvl) {
+      for(nxt = np->Next(lvl); nxt != nullptr && nxt->Value() < val; 
+          pos += np->Span(lvl), np = nxt, nxt = np->Next(lvl));
+    }
+    return pos;
+  }
+
+  // # elements in [lo, hi)
+  inline size_t CountRange(const T& lo, const T& hi) const {
+    return (lo < hi) ? Rank(hi) - Rank(lo) : 0;
+  }
+
   // For repeatable & predictable node level generation, we 
   // generate the same seeds for random number when testing 
   // such that same random number is generated every time
   void SetPredictableNodeLevel(void) {
     _seed = kFixedCostSeedForRandomEngine;
-    _random = std::bind(std::uniform_int_distribution<uint32_t>
-                        {0, MaxLevel()}, 
-                        std::default_random_engine{_seed}); 
+    _random = Seed(_seed);
+  }
+
+  // # nodes compared by Find(val): search path length
+  size_t PathLength(const T& val) const {
+    size_t      len = 0;
+    const Node* np  = Head();
+    const Node* nxt;
+    for(int lvl = static_cast<int>(Level()) - 1; lvl >= 0; --lvl) {
+      for(nxt = np->Next(lvl); nxt != nullptr && (++len, nxt->Value() < val);
+          np = nxt, nxt = np->Next(lvl));
+      if (nxt != nullptr && nxt->Value() == val) 
+        break;
+    }
+    return len;
   }
 
   //! @fn         inorder traverses nodes of treap
@@ -276,67 +383,97 @@ class SkipList {
   friend std::ostream& operator << <>(std::ostream& os, const SkipList<T,MaxNum>& s);
   
  private:
-  uint32_t                      _num_nodes;
-  ValNode<MaxLevel()>           _head;
+  size_t                        _num_nodes;
+  size_t                        _mem_size;
+  NodePtr                       _head;
   uint32_t                      _seed;
-  std::function<uint32_t(void)> _random;
+  uint64_t                      _random; // xorshift64 state: never 0
                          
   //! Fixed seed generates predictable MC runs when running test SW or debugging
   const static uint32_t kFixedCostSeedForRandomEngine = 13607; 
 
   NodePtr NewNode(T&& val) {
-    uint32_t level = NodeLevel();
-    
-    FASSERT(level >= 1 && level <= MaxLevel());
-    NodePtr np;
-
-    switch(level) {
-      case 1 : np = new ValNode<1>{std::move(val)}; break;
-      case 2 : np = new ValNode<2>{std::move(val)}; break;
-      case 3 : np = new ValNode<3>{std::move(val)}; break;
-      case 4 : np = new ValNode<4>{std::move(val)}; break;
-      case 5 : np = new ValNode<5>{std::move(val)}; break;
-      case 6 : np = new ValNode<6>{std::move(val)}; break;
-      case 7 : np = new ValNode<7>{std::move(val)}; break;
-      case 8 : np = new ValNode<8>{std::move(val)}; break;
-      case 9 : np = new ValNode<9>{std::move(val)}; break;
-      case 10: np = new ValNode<10>{std::move(val)}; break;
-      case 11: np = new ValNode<11>{std::move(val)}; break;
-      case 12: np = new ValNode<12>{std::move(val)}; break;
-      case 13: np = new ValNode<13>{std::move(val)}; break;
-      case 14: np = new ValNode<14>{std::move(val)}; break;
-      case 15: np = new ValNode<15>{std::move(val)}; break;
-      default: np = new ValNode<16>{std::move(val)}; break;
-    }
-
     _num_nodes++;
-    return np;
+    return AllocNode(std::move(val), NodeLevel());
+  }
+
+  static inline size_t NodeSize(uint32_t level) {
+    return Node::Offset() + level*(sizeof(NodePtr) + sizeof(size_t));
+  }
+
+  NodePtr AllocNode(T&& val, uint32_t level) {
+    DCHECK(level >= 1 && level <= MaxLevel());
+    _mem_size += NodeSize(level);
+    void* mem_p = ::operator new(NodeSize(level));
+    return new (mem_p) Node{std::move(val), level};
+  }
+
+  inline void FreeNode(NodePtr node_p) {
+    _mem_size -= NodeSize(node_p->Size());
+    node_p->~Node();
+    ::operator delete(node_p);
+  }
+
+  // Replaces head with one of level levels: nodeptrs referring to the
+  // old head (on the search path) are redirected to the new head.
+  // Called by Emplace once the new node is counted but not yet linked:
+  // new levels span the Size() - 1 linked nodes to nullptr.
+  void GrowHead(uint32_t level, std::array<NodePtr, MaxLevel()>* nodeptrs_p) {
+    NodePtr old_p = _head;
+    _head = AllocNode(T{}, level);
+    for (uint32_t lvl = 0; lvl < old_p->Size(); ++lvl) {
+      _head->Next(lvl) = old_p->Next(lvl);
+      _head->Span(lvl) = old_p->Span(lvl);
+      if ((*nodeptrs_p)[lvl] == old_p)
+        (*nodeptrs_p)[lvl] = _head;
+    }
+    for (uint32_t lvl = old_p->Size(); lvl < level; ++lvl) {
+      _head->Span(lvl)   = _num_nodes;
+      (*nodeptrs_p)[lvl] = _head;
+    }
+    FreeNode(old_p);
   }
 
   inline void DeleteNode(NodePtr node_p) {
     _num_nodes--;
-    delete node_p;
+    FreeNode(node_p);
     return;
   }
 
+  // Scrambles seed (golden ratio multiply) into a non zero xorshift state
+  static inline uint64_t Seed(uint32_t seed) {
+    return ((seed + 1)*0x9E3779B97F4A7C15ULL) | 0x1;
+  }
+
   //! @fn        NodeLevel
   //! @details   Provides a number between 1 and MaxLevel() with a 
   //!            specific probability distribution - refer below.
-  //!            Generates a random number and measures the number of 
-  //!            contiguous trailing 1s in the generated number.
+  //!            Generates a random word (xorshift64) and measures the
+  //!            number of trailing 0s (ctz) in the generated word.
   //!            This yield a number with probability distribution, such that:
   //!            Level = 1 i.e. default     = 1
   //!            Level = 2 i.e. prob(num=1) = 1/2
   //!            Level = 3 i.e. prob(num=2) = 1/4
   //!            Level = k i.e. prob(num=k) = 1/2^k; ... 
+  //!            Unbounded: Level <= log2(Size()) + 1 (Size() includes
+  //!            the node being added).
   //! @returns   Level
   uint32_t inline NodeLevel(void) {
-    uint32_t num = _random(); 
-    uint32_t level = TrailingOnes(num) + 1;
-    return (level <= MaxLevel() ? level : MaxLevel());
+    _random ^= _random << 13;
+    _random ^= _random >> 7;
+    _random ^= _random << 17;
+    uint32_t level = __builtin_ctzll(_random) + 1;
+    uint32_t cap   = UNBOUNDED ? 
+        (64 - __builtin_clzll(static_cast<uint64_t>(_num_nodes))) : MaxLevel();
+    return (level <= cap ? level : cap);
   }
 };
 
+template <typename T, uint32_t MaxNum>
+constexpr bool     SkipList<T,MaxNum>::UNBOUNDED;
+template <typename T, uint32_t MaxNum>
+constexpr uint32_t SkipList<T,MaxNum>::MAX_LEVELS;
+
 // Forward Iterator for SkipLists. TODO: Should have READ ONLY access 
 // to key (i.e. key attribute of T).
 template <typename T, uint32_t MaxNum>
@@ -351,18 +488,18 @@ class SkipListCIter {
   SkipListCIter(SkipListPtr slp, NodePtr np) : 
       _sl{slp}, _cur{np} {}
   inline const T& operator*() {
-    FASSERT(_cur != nullptr);
+    DCHECK(_cur != nullptr);
     return _cur->Value();
   }
   inline ItC& operator++() {
-    FASSERT(_cur != nullptr);
+    DCHECK(_cur != nullptr);
     _cur = _cur->Next(0);
     return *this;
   }
   inline ItC& Next(uint32_t i) {
-    FASSERT(_cur != nullptr);
-    FASSERT(_cur->Size() > i);
-    FASSERT(SList::MaxLevel() > i);
+    DCHECK(_cur != nullptr);
+    DCHECK_GT(_cur->Size(), i);
+    DCHECK_GT(SList::MaxLevel(), i);
     _cur = _cur->Next(i);
     return *this;
   }
@@ -399,7 +536,8 @@ std::ostream& operator << (std::ostream& os, const SkipList<T,MaxNum>& s) {
   s.InOrder([&os] (NodePtr np) {
       os << np->Value() << ": nextptrs #" << np->Size() << " [";
       for (int j=0; j < static_cast<int>(np->Size()); j++) 
-        os << std::hex << " 0x" << np->Next(j) << std::dec;
+        os << std::hex << " 0x" << np->Next(j) << std::dec
+           << "(" << np->Span(j) << ")";
       os << " ]" << std::endl;
       return 1;
     }, 0);
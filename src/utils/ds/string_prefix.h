@@ -16,6 +16,12 @@
 //! @file     string_prefix.h
 //! @brief    Prefix class built for string. 
 //! @details  Useful construct used to store string in prefix ordered trie. 
+//!           Bits are kept MSB first in 64 bit words: bit i is bit
+//!           (63 - i%64) of word i/64. Bits past size() are 0, so equality
+//!           is a word compare, common prefix is XOR & count leading zeros
+//!           (SIMD for long keys: refer CommonPrefix) and
+//!           substr/concatenation shift whole words.
+//!           Keys up to INLINE_BYTES are stored inline (no allocation).
 //! @author   Arijit Sarcar <sarcar_a@yahoo.com>
 
 #ifndef _UTILS_DS_STRING_PREFIX_H_
@@ -23,13 +29,16 @@
 
 // C++ Standard Headers
 #include <iostream>
+#include <string>           // std::string
 #include <vector>
 // C Standard Headers
 #include <climits>          // CHAR_BIT
+#include <cstring>          // strlen
 // Google Headers
 #include <glog/logging.h>   // DCHECK
 // Local Headers
 #include "utils/basic/basictypes.h"
+#include "utils/ds/common_prefix.h"
 
 //! @addtogroup ds
 //! @{
@@ -38,37 +47,49 @@ namespace asarcar { namespace utils { namespace ds {
 //-----------------------------------------------------------------------------
 class StringPrefix {
  public:
-  static constexpr int ALL_BYTE = CHAR_BIT - 1;
+  static constexpr int    ALL_BYTE     = CHAR_BIT - 1;
+  static constexpr size_t WORD_BITS    = 64;
+  static constexpr size_t INLINE_WORDS = 4;
+  static constexpr size_t INLINE_BYTES = INLINE_WORDS*WORD_BITS/CHAR_BIT;
   using vchar=std::vector<char>;
+  // last: bit offset of the last bit in the last byte of v
   StringPrefix(vchar&& v, int last): 
-      last_{last}, v_{std::move(v)} {
-    DCHECK(((v_.size() > 0) && (last_ >= 0)) || 
-           ((v_.size() == 0) && (last_ == ALL_BYTE))) 
-        << "v_.size()=" << v_.size() << ": last_=" << last_;
+      StringPrefix{v.data(), v.size()*CHAR_BIT + last + 1 - CHAR_BIT} {
+    DCHECK(((v.size() > 0) && (last >= 0)) || 
+           ((v.size() == 0) && (last == ALL_BYTE))) 
+        << "v.size()=" << v.size() << ": last=" << last;
   }
   StringPrefix(std::string&& str): 
-      StringPrefix{vchar(str.begin(), str.end()), ALL_BYTE} {}
+      StringPrefix{str.data(), str.size()*CHAR_BIT} {}
 
   StringPrefix(const char str_p[]): 
-      StringPrefix{std::string(str_p)} {}
-
-  inline size_t size(void) const { 
-    return (v_.size()*CHAR_BIT + last_ + 1 - CHAR_BIT); 
-  }
-  void resize(int len); 
+      StringPrefix{str_p, strlen(str_p)*CHAR_BIT} {}
+
+  StringPrefix(const StringPrefix& other);
+  StringPrefix(StringPrefix&& other) noexcept;
+  StringPrefix& operator =(const StringPrefix& other);
+  StringPrefix& operator =(StringPrefix&& other) noexcept;
+  ~StringPrefix() { if (!IsInline()) delete [] heap_p_; }
+
+  inline size_t size(void) const { return len_; }
+  // NumWords(size()) words of bits MSB first: bits past size() are 0
+  inline const uint64_t* data(void) const { return words(); }
+  void resize(int len);
   StringPrefix  substr(int begin, int runlen) const;
   inline bool operator ==(const StringPrefix& other) const {
-    return ((size() == other.size()) &&
-            std::equal(v_.begin(), v_.end(), other.v_.begin()));
+    // bits past len_ are 0: a mismatch, if any, is within len_
+    return ((len_ == other.len_) &&
+            (CommonPrefix::Bits(words(), other.words(), NumWords(len_))
+             >= len_));
   }
   inline bool operator !=(const StringPrefix& other) const {
     return !this->operator==(other);
   }
   
   // True when 'n'th (0 < n < prefix length) most significant bit is 1
-  bool operator [](int n) const {
+  inline bool operator [](int n) const {
     DCHECK_GE(n, 0); DCHECK_LT(n, size());
-    return ((v_.at(ByteIndex(n+1)) & ExtractBitNum(GetLast(n+1))) != 0);
+    return ((words()[n/WORD_BITS] >> (WORD_BITS - 1 - n%WORD_BITS)) & 1) != 0;
   }
 
   // Returns new string after concatenation of this and other 
@@ -81,41 +102,44 @@ class StringPrefix {
 
   // Returns the common prefix substring as compared to argument
   StringPrefix prefix(const StringPrefix& other) const;
+  // Length of the common prefix: prefix(other).size() without the copy
+  size_t prefix_size(const StringPrefix& other) const;
 
   std::string to_string(bool debug=false) const;
 
  private:
-  // #bit offset of last byte that is part of symbol
-  int    last_;  
-  vchar  v_;
-
-  static inline size_t ArraySize(int len) {
-    return (len + CHAR_BIT - 1)/CHAR_BIT; // Ceiling(len/CHAR_BIT)
-  }
-  static inline size_t ByteIndex(int len) {
-    return ((len+CHAR_BIT-1)/CHAR_BIT - 1);
-  }
-  static inline size_t GetLast(int len) {
-    return (len + CHAR_BIT - 1)%CHAR_BIT;
+  uint32_t    len_;   // # bits
+  uint32_t    cap_;   // # words: heap allocated when > INLINE_WORDS
+  union {
+    uint64_t  inline_[INLINE_WORDS];
+    uint64_t* heap_p_;
+  };
+
+  // len bits of bytes (MSB first)
+  StringPrefix(const char* bytes, size_t len);
+
+  static inline size_t NumWords(size_t len) {
+    return (len + WORD_BITS - 1)/WORD_BITS; // Ceiling(len/WORD_BITS)
   }
-  // [begin, runlen) range
-  static inline uint8_t GetMask(int begin, int runlen) {
-    DCHECK_GE(begin, 0); DCHECK_LT(begin, CHAR_BIT);
-    DCHECK_GE(runlen, 0); DCHECK_LE(runlen, CHAR_BIT); 
-    return (0xFF << (CHAR_BIT - runlen)) >> begin;
+  // Leading n bits (0 < n <= WORD_BITS) set
+  static inline uint64_t GetMask(size_t n) {
+    return ~0ULL << (WORD_BITS - n);
   }
-  static inline uint8_t GetMask(int last_len) {
-    return GetMask(0, last_len+1);
+  inline bool IsInline(void) const { return cap_ <= INLINE_WORDS; }
+  inline uint64_t* words(void) { return IsInline() ? inline_ : heap_p_; }
+  inline const uint64_t* words(void) const {
+    return IsInline() ? inline_ : heap_p_;
   }
-  static inline uint8_t ExtractBitNum(int last_len) {
-    return 0x80 >> last_len;
+  // Capacity for at least num_words words: keeps bits
+  void Reserve(size_t num_words);
+  // Zeroes bits of the last word past len_
+  inline void MaskLast(void) {
+    if (len_%WORD_BITS != 0)
+      words()[len_/WORD_BITS] &= GetMask(len_%WORD_BITS);
   }
-  static int CopyBits(vchar                *dst_v_p, 
-                      const int            cur_last,
-                      const vchar&         src_v,
-                      const int            src_last,
-                      const int            src_offset,
-                      const int            src_num_bytes);
+  // Appends len bits of src starting at bit offset src_off: shifts
+  // whole words when this or src is not word aligned
+  void AppendBits(const uint64_t* src, size_t src_off, size_t len);
 };
 
 inline std::ostream& operator << (std::ostream& os, const StringPrefix& pref) {
@@ -0,0 +1,296 @@
+// Copyright 2015 asarcar Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Author: Arijit Sarcar <sarcar_a@yahoo.com>
+// Standard C++ Headers
+#include <map>              // std::map
+#include <random>           // std::default_random_engine
+#include <string>           // std::string
+#include <vector>           // std::vector
+// Standard C Headers
+// Google Headers
+// Local Headers
+#include "utils/basic/basictypes.h"
+#include "utils/basic/clock.h"
+#include "utils/basic/init.h"
+#include "utils/ds/adaptive_radix_tree.h"
+#include "utils/ds/radix_trie.h"
+#include "utils/ds/string_prefix.h"
+
+using namespace asarcar;
+using namespace asarcar::utils;
+using namespace asarcar::utils::ds;
+using namespace std;
+
+// Flag Declarations
+DECLARE_bool(auto_test);
+DECLARE_bool(benchmark);
+
+class AdaptiveRadixTreeTester {
+ public:
+  void SanityTest(void);
+  void RandomTest(void);
+  void BenchmarkTest(void);
+ private:
+  using Art   = AdaptiveRadixTree<uint32_t>;
+  using Model = map<string, uint32_t>;
+  static constexpr const char* kUnitStr      = "ns/op";
+  static constexpr int         kNumRandomOps = 20000;
+  static constexpr int         kNumBenchKeys = 1 << 18;
+
+  // Random key: alphabet & length are varied so that keys share long
+  // prefixes, prefix other keys and fill every node type
+  static string RandomKey(default_random_engine* gen_p);
+  // Model lookup: longest key of model that is a prefix of key
+  static Model::const_iterator LongestPrefix(const Model& model,
+                                             const string& key);
+  static void Check(const Art& art, const Model& model);
+};
+
+constexpr const char* AdaptiveRadixTreeTester::kUnitStr;
+constexpr int AdaptiveRadixTreeTester::kNumRandomOps;
+constexpr int AdaptiveRadixTreeTester::kNumBenchKeys;
+
+string AdaptiveRadixTreeTester::RandomKey(default_random_engine* gen_p) {
+  uniform_int_distribution<int> dis{0, 255};
+  static const string prefixes[] = {"", "a", "www.", 
+                                    "https://www.example.com/index/"};
+  string key    = prefixes[dis(*gen_p) % 4];
+  int    len    = dis(*gen_p) % 6;
+  int    fanout = (dis(*gen_p) % 2 == 0) ? 4 : 256;
+  for (int i=0; i<len; ++i)
+    key.push_back(static_cast<char>(dis(*gen_p) % fanout));
+  return key;
+}
+
+AdaptiveRadixTreeTester::Model::const_iterator
+AdaptiveRadixTreeTester::LongestPrefix(const Model& model,
+                                       const string& key) {
+  for (int len=key.size(); len>=0; --len) {
+    auto it = model.find(key.substr(0, len));
+    if (it != model.end())
+      return it;
+  }
+  return model.end();
+}
+
+void AdaptiveRadixTreeTester::Check(const Art& art, const Model& model) {
+  CHECK_EQ(art.Size(), model.size());
+  auto it = art.Begin();
+  for (const auto& kv : model) {
+    CHECK(it != art.End());
+    CHECK(it->first == kv.first);
+    CHECK_EQ(it->second, kv.second);
+    ++it;
+  }
+  CHECK(it == art.End());
+}
+
+void AdaptiveRadixTreeTester::SanityTest(void) {
+  Art art;
+  CHECK(art.Empty());
+  CHECK(art.Begin() == art.End());
+  CHECK(art.Find("") == art.End());
+  CHECK(art.LongestPrefixMatch("abc") == art.End());
+
+  CHECK(art.Insert({"romane", 1}).second);
+  CHECK(art.Insert({"romanus", 2}).second);
+  CHECK(art.Insert({"romulus", 3}).second);
+  CHECK(art.Insert({"rubens", 4}).second);
+  CHECK(art.Insert({"rom", 5}).second);
+  CHECK(art.Insert({"", 6}).second);
+  CHECK(!art.Insert({"rom", 7}).second);
+  art["ruber"] = 8;
+  CHECK_EQ(art.Size(), 7);
+  CHECK_EQ(art.Find("rom")->second, 5);
+  CHECK_EQ(art.Find("romanus")->second, 2);
+  CHECK_EQ(art.Find("")->second, 6);
+  CHECK(art.Find("roman") == art.End());
+  CHECK(art.Find("romanes") == art.End());
+
+  CHECK(art.LongestPrefixMatch("romanesque")->first == "romane");
+  CHECK(art.LongestPrefixMatch("roman")->first == "rom");
+  CHECK(art.LongestPrefixMatch("rubicon")->first == "");
+  CHECK(art.LongestPrefixMatch("rom")->first == "rom");
+
+  vector<string> keys;
+  for (auto it = art.Begin(); it != art.End(); ++it)
+    keys.push_back(it->first);
+  CHECK((keys == vector<string>{"", "rom", "romane", "romanus", "romulus",
+          "rubens", "ruber"}));
+  // Iterator returned by a lookup continues in order
+  auto it = art.Find("romanus");
+  CHECK((++it)->first == "romulus");
+
+  it = art.Erase(art.Find("rom"));
+  CHECK(it->first == "romane");
+  CHECK_EQ(art.Erase("rom"), 0);
+  CHECK_EQ(art.Erase("romulus"), 1);
+  CHECK(art.LongestPrefixMatch("romulus")->first == "");
+  CHECK_EQ(art.Size(), 5);
+
+  // Path compression: prefix longer than MAX_PREFIX_LEN is split
+  string long_key(3*Art::MAX_PREFIX_LEN, 'x');
+  art[long_key + "1"] = 9;
+  art[long_key + "2"] = 10;
+  art[long_key.substr(0, 2*Art::MAX_PREFIX_LEN) + "y"] = 11;
+  CHECK_EQ(art.Find(long_key + "2")->second, 10);
+  CHECK(art.LongestPrefixMatch(long_key + "1234")->first == long_key + "1");
+  CHECK(art.LongestPrefixMatch(long_key) == art.Find(""));
+
+  art.Clear();
+  CHECK(art.Empty());
+  CHECK_EQ(art.NSize(), 0);
+
+  LOG(INFO) << __FUNCTION__ << " passed";
+}
+
+// Inserts & erases against a std::map: lookups, iteration order & node
+// counts agree after every phase
+void AdaptiveRadixTreeTester::RandomTest(void) {
+  default_random_engine         gen{};
+  uniform_int_distribution<int> dis{};
+  Art                           art;
+  Model                         model;
+  for (int phase=0; phase<4; ++phase) {
+    for (int i=0; i<kNumRandomOps; ++i) {
+      string key = RandomKey(&gen);
+      // grow in even phases, shrink in odd phases
+      if ((dis(gen) % 3 == 0) == (phase % 2 == 0)) {
+        CHECK_EQ(art.Erase(key), model.erase(key));
+      } else {
+        bool ins = model.insert({key, i}).second;
+        CHECK_EQ(art.Insert({key, static_cast<uint32_t>(i)}).second, ins);
+      }
+
+      string q  = RandomKey(&gen) + RandomKey(&gen);
+      auto   it = art.Find(q);
+      CHECK_EQ(it == art.End(), model.find(q) == model.end());
+      auto   lm = LongestPrefix(model, q);
+      auto   la = art.LongestPrefixMatch(q);
+      CHECK_EQ(la == art.End(), lm == model.end()) << q;
+      if (lm != model.end())
+        CHECK(la->first == lm->first) << q;
+    }
+    Check(art, model);
+    LOG(INFO) << "phase " << phase << ": " << art;
+  }
+
+  // Erase by iterator: every other key
+  auto mit = model.begin();
+  for (auto it = art.Begin(); it != art.End(); ) {
+    CHECK(it->first == mit->first);
+    if (mit->second % 2 == 0) {
+      it  = art.Erase(it);
+      mit = model.erase(mit);
+    } else {
+      ++it;
+      ++mit;
+    }
+  }
+  CHECK(mit == model.end());
+  Check(art, model);
+  while (!model.empty()) {
+    CHECK_EQ(art.Erase(model.begin()->first), 1);
+    model.erase(model.begin());
+  }
+  CHECK(art.Empty());
+  CHECK_EQ(art.NSize(), 0);
+
+  LOG(INFO) << __FUNCTION__ << " passed";
+}
+
+// Insert, Find & LongestPrefixMatch of URL like keys & memory per key:
+// ART vs RadixTrie<StringPrefix>
+void AdaptiveRadixTreeTester::BenchmarkTest(void) {
+  default_random_engine              gen{};
+  uniform_int_distribution<uint32_t> dis{};
+  vector<string>                     keys;
+  for (int i=0; i<kNumBenchKeys; ++i) {
+    keys.push_back("www.host" + std::to_string(dis(gen) % (kNumBenchKeys/16)) +
+                   ".com/" + std::to_string(dis(gen)));
+  }
+  vector<StringPrefix> skeys;
+  for (const auto& k : keys)
+    skeys.push_back(StringPrefix{string{k}});
+  vector<string>       queries;
+  vector<StringPrefix> squeries;
+  for (const auto& k : keys) {
+    queries.push_back(k + "/index.html");
+    squeries.push_back(StringPrefix{queries.back() + ""});
+  }
+
+  Art                                art;
+  RadixTrie<StringPrefix, uint32_t>  rt;
+  Clock::TimeDuration                dur[2][3];
+  size_t                             sum[2] = {0, 0};
+
+  Clock::TimePoint now = Clock::USecs();
+  for (int i=0; i<kNumBenchKeys; ++i)
+    art.Insert({keys[i], static_cast<uint32_t>(i)});
+  dur[0][0] = Clock::USecs() - now;
+  now = Clock::USecs();
+  for (int i=0; i<kNumBenchKeys; ++i)
+    rt.Insert({skeys[i], static_cast<uint32_t>(i)});
+  dur[1][0] = Clock::USecs() - now;
+  CHECK_EQ(art.Size(), rt.Size());
+
+  now = Clock::USecs();
+  for (const auto& k : keys)
+    sum[0] += art.Find(k)->second;
+  dur[0][1] = Clock::USecs() - now;
+  now = Clock::USecs();
+  for (const auto& k : skeys)
+    sum[1] += rt.Find(k)->second;
+  dur[1][1] = Clock::USecs() - now;
+
+  now = Clock::USecs();
+  for (const auto& q : queries)
+    sum[0] += art.LongestPrefixMatch(q)->second;
+  dur[0][2] = Clock::USecs() - now;
+  now = Clock::USecs();
+  for (const auto& q : squeries)
+    sum[1] += rt.LongestPrefixMatch(q)->second;
+  dur[1][2] = Clock::USecs() - now;
+  CHECK_EQ(sum[0], sum[1]);
+
+  LOG(INFO) << art.Size() << " keys: ART " << art;
+  const char* names[] = {"ART", "RadixTrie"};
+  size_t      mem[]   = {art.MemSize(), rt.MemSize()};
+  for (int t=0; t<2; ++t) {
+    LOG(INFO) << names[t] << ": insert/find/longest prefix match "
+              << 1000.0*dur[t][0]/kNumBenchKeys << "/"
+              << 1000.0*dur[t][1]/kNumBenchKeys << "/"
+              << 1000.0*dur[t][2]/kNumBenchKeys << kUnitStr << ": "
+              << static_cast<double>(mem[t])/art.Size() << " bytes/key";
+  }
+}
+
+int main(int argc, char **argv) {
+  Init::InitEnv(&argc, &argv);
+
+  AdaptiveRadixTreeTester artt;
+
+  artt.SanityTest();
+  artt.RandomTest();
+  if (FLAGS_benchmark)
+    artt.BenchmarkTest();
+
+  return 0;
+}
+
+DEFINE_bool(auto_test, false, 
+            "test run programmatically (when true) or manually (when false)");
+DEFINE_bool(benchmark, false,
+            "test run when benchmarking ART against RadixTrie");
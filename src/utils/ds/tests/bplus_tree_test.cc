@@ -0,0 +1,315 @@
+// Copyright 2014 asarcar Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Author: Arijit Sarcar <sarcar_a@yahoo.com>
+
+// Standard C++ Headers
+#include <map>              // std::map
+#include <random>           // std::default_random_engine
+#include <string>           // std::string
+#include <vector>           // std::vector
+// Standard C Headers
+// Google Headers
+#include <glog/logging.h>
+// Local Headers
+#include "utils/basic/basictypes.h"
+#include "utils/basic/clock.h"
+#include "utils/basic/init.h"
+#include "utils/ds/bplus_tree.h"
+#include "utils/ds/skip_lists.h"
+#include "utils/ds/treap.h"
+
+using namespace asarcar;
+using namespace asarcar::utils;
+using namespace std;
+
+// Flag Declarations
+DECLARE_bool(auto_test);
+DECLARE_bool(benchmark);
+
+class BPlusTreeTester {
+ public:
+  // Smallest nodes: 4-5 keys per node i.e. tall trees that split & merge
+  using Bt    = BPlusTree<uint32_t,uint32_t,CACHE_LINE_SIZE>;
+  using ItC   = Bt::ItC;
+
+  void ZeroEntryTest(void);
+  void BasicTest(void);
+  void RandomTest(void);
+  void StringTest(void);
+  void BenchmarkTest(void);
+ private:
+  static constexpr const char* kUnitStr      = "ns";
+  static constexpr int         kNumKeys      = 4096;
+  static constexpr int         kNumRandOps   = 1 << 17;
+  static constexpr int         kNumLookups   = 1 << 20;
+  static constexpr int         kNumScans     = 1 << 14;
+  static constexpr int         kScanLen      = 100;
+
+  // Tree walks forward, backward & from LowerBound agree with ref
+  static void CheckEqual(const Bt& t, const map<uint32_t,uint32_t>& ref);
+  // distinct pseudo random key i: multiplication by odd number is a
+  // bijection of uint32_t
+  static inline uint32_t Key(uint32_t i) { return i*2654435761u; }
+};
+
+constexpr const char* BPlusTreeTester::kUnitStr;
+constexpr int BPlusTreeTester::kNumKeys;
+constexpr int BPlusTreeTester::kNumRandOps;
+constexpr int BPlusTreeTester::kNumLookups;
+constexpr int BPlusTreeTester::kNumScans;
+constexpr int BPlusTreeTester::kScanLen;
+
+void BPlusTreeTester::CheckEqual(const Bt& t,
+                                 const map<uint32_t,uint32_t>& ref) {
+  CHECK_EQ(t.Size(), ref.size());
+  auto it = ref.begin();
+  for (ItC bit = t.begin(); bit != t.end(); ++bit, ++it) {
+    CHECK(it != ref.end());
+    CHECK_EQ(*((*bit).first), it->first);
+    CHECK_EQ(*((*bit).second), it->second);
+  }
+  CHECK(it == ref.end());
+  auto rit = ref.rbegin();
+  for (ItC bit = t.end(); rit != ref.rend(); ++rit)
+    CHECK_EQ(*((*(--bit)).first), rit->first);
+  CHECK(t.last() == ((t.Size() == 0) ? t.end() : --t.end()));
+}
+
+void BPlusTreeTester::ZeroEntryTest(void) {
+  Bt t;
+
+  CHECK_EQ(t.Size(), 0); // size 0
+  CHECK_EQ(t.Height(), 0);
+  CHECK(t.Find(1) == t.end()); // Key 1 does not exists
+  CHECK(t.begin() == t.end()); // begin iterator is the end iterator
+  CHECK(t.LowerBound(0) == t.end());
+  CHECK(!t.Remove(1));
+  CHECK_EQ(t.Scan(0, 10, [](const uint32_t&, uint32_t&) {}), 0);
+
+  LOG(INFO) << __FUNCTION__ << " passed";
+}
+
+// Ascending & descending inserts split leaves & inners: removes in
+// between keys merge them back to an empty tree
+void BPlusTreeTester::BasicTest(void) {
+  Bt                       t;
+  map<uint32_t,uint32_t>   ref;
+  for (uint32_t key=0; key<kNumKeys; key += 2) {
+    CHECK(t.Emplace(uint32_t{key}, key + 1).second);
+    ref.emplace(key, key + 1);
+  }
+  for (uint32_t key=2*kNumKeys-1; key<2*kNumKeys; key -= 2) {
+    auto pr = t.Emplace(uint32_t{key}, key + 1);
+    CHECK(pr.second);
+    CHECK_EQ(*((*pr.first).first), key);
+    ref.emplace(key, key + 1);
+  }
+  CHECK(!t.Emplace(2, 0).second);
+  CHECK_EQ(*((*t.Find(2)).second), 3);
+  CHECK_GT(t.Height(), 3);
+  // nodes at least half full: inners fewer than leaves
+  CHECK_LE(t.MemSize(), 2*(t.Size()/Bt::LEAF_MIN + 1)*CACHE_LINE_SIZE);
+  CheckEqual(t, ref);
+  DLOG(INFO) << t;
+
+  // LowerBound & Scan of [lo, hi)
+  // evens below kNumKeys & all odds
+  CHECK_EQ(*((*t.LowerBound(kNumKeys - 2)).first), kNumKeys - 2);
+  CHECK_EQ(*((*t.LowerBound(kNumKeys)).first), kNumKeys + 1);
+  CHECK(t.LowerBound(2*kNumKeys) == t.end());
+  uint32_t next = 11;
+  CHECK_EQ(t.Scan(11, 101, [&](const uint32_t& key, uint32_t& val) {
+        CHECK_EQ(key, next);
+        ++next;
+        ++val;
+        ++ref[key];
+      }), 90);
+  CHECK_EQ(*((*t.Find(12)).second), 14);
+
+  for (uint32_t key=0; key<2*kNumKeys; key += 3)
+    CHECK_EQ(t.Remove(key), ref.erase(key) == 1);
+  CheckEqual(t, ref);
+  for (uint32_t key=0; key<2*kNumKeys; ++key)
+    CHECK_EQ(t.Remove(key), ref.erase(key) == 1);
+  CHECK_EQ(t.Size(), 0);
+  CHECK_EQ(t.Height(), 0);
+  CHECK_EQ(t.MemSize(), 0);
+  CHECK(t.begin() == t.end());
+
+  LOG(INFO) << __FUNCTION__ << " passed";
+}
+
+// Random Emplace/Remove/Find agree with std::map
+void BPlusTreeTester::RandomTest(void) {
+  default_random_engine              gen{};
+  uniform_int_distribution<uint32_t> dis{0, 2*kNumKeys};
+  Bt                                 t;
+  map<uint32_t,uint32_t>             ref;
+  for (int i=0; i<kNumRandOps; ++i) {
+    uint32_t key = dis(gen);
+    switch (gen() % 3) {
+      case 0:
+        CHECK_EQ(t.Emplace(uint32_t{key}, uint32_t(i)).second,
+                 ref.emplace(key, i).second);
+        break;
+      case 1:
+        CHECK_EQ(t.Remove(key), ref.erase(key) == 1);
+        break;
+      default: {
+        auto it = ref.lower_bound(key);
+        ItC  bit = t.LowerBound(key);
+        CHECK_EQ(bit == t.end(), it == ref.end());
+        if (it != ref.end())
+          CHECK_EQ(*((*bit).first), it->first);
+        CHECK_EQ(t.Find(key) == t.end(), ref.count(key) == 0);
+      }
+    }
+    if (i % (kNumRandOps/16) == 0)
+      CheckEqual(t, ref);
+  }
+  CheckEqual(t, ref);
+
+  LOG(INFO) << __FUNCTION__ << " passed";
+}
+
+// Non trivial K & V are moved across nodes & destroyed
+void BPlusTreeTester::StringTest(void) {
+  BPlusTree<string,string> t;
+  for (int i=0; i<kNumKeys; ++i)
+    CHECK(t.Emplace(to_string(Key(i)), string(32, 'a' + i % 26)).second);
+  for (int i=0; i<kNumKeys; i += 2)
+    CHECK(t.Remove(to_string(Key(i))));
+  CHECK_EQ(t.Size(), kNumKeys/2);
+  CHECK_EQ(*((*t.Find(to_string(Key(1)))).second), string(32, 'b'));
+  string prev;
+  for (auto it = t.begin(); it != t.end(); ++it) {
+    CHECK_LT(prev, *((*it).first));
+    prev = *((*it).first);
+  }
+
+  LOG(INFO) << __FUNCTION__ << " passed";
+}
+
+// BPlusTree vs Treap vs SkipList: 10^4 to 10^7 random keys.
+// Inserts, point lookups & range scans of kScanLen keys.
+void BPlusTreeTester::BenchmarkTest(void) {
+  using Tb = BPlusTree<uint32_t,uint32_t>;
+  using Tt = Treap<uint32_t,uint32_t>;
+  using Ts = SkipList<uint32_t>;
+  LOG(INFO) << "BPlusTree: keys/leaf " << Tb::LEAF_CAP << ": keys/inner "
+            << Tb::INNER_CAP;
+  default_random_engine gen{};
+  for (uint32_t num_keys : {10000, 100000, 1000000, 10000000}) {
+    uniform_int_distribution<uint32_t> dis{0, num_keys - 1};
+    vector<uint32_t>                   lookups, scans;
+    for (int i=0; i<kNumLookups; ++i)
+      lookups.push_back(Key(dis(gen)));
+    for (int i=0; i<kNumScans; ++i)
+      scans.push_back(Key(dis(gen)));
+    // insert, lookup & scan ns per key
+    auto report = [num_keys](const char* name, Clock::TimeDuration ins,
+                             Clock::TimeDuration find,
+                             Clock::TimeDuration scan, size_t num_scanned) {
+      LOG(INFO) << name << ": " << num_keys << " keys: insert/find/scan = "
+                << ins*1000/num_keys << "/" << find*1000/kNumLookups << "/"
+                << scan*1000/num_scanned << kUnitStr << " per key";
+    };
+    {
+      Tb t;
+      Clock::TimePoint now = Clock::USecs();
+      for (uint32_t i=0; i<num_keys; ++i)
+        t.Emplace(Key(i), uint32_t{i});
+      Clock::TimeDuration ins = Clock::USecs() - now;
+      now = Clock::USecs();
+      for (uint32_t key : lookups)
+        CHECK(t.Find(key) != t.end());
+      Clock::TimeDuration find = Clock::USecs() - now;
+      size_t num = 0;
+      now = Clock::USecs();
+      for (uint32_t lo : scans) {
+        int j = 0;
+        for (Tb::ItC it = t.LowerBound(lo); j<kScanLen && it != t.end();
+             ++j, ++it);
+        num += j;
+      }
+      Clock::TimeDuration scan = Clock::USecs() - now;
+      report("BPlusTree", ins, find, scan, num);
+      LOG(INFO) << "BPlusTree: " << num_keys << " keys: height " << t.Height()
+                << ": " << static_cast<double>(t.MemSize())/num_keys
+                << " bytes/key";
+    }
+    {
+      Tt t;
+      Clock::TimePoint now = Clock::USecs();
+      for (uint32_t i=0; i<num_keys; ++i)
+        t.Emplace(Key(i), uint32_t{i});
+      Clock::TimeDuration ins = Clock::USecs() - now;
+      now = Clock::USecs();
+      for (uint32_t key : lookups)
+        CHECK(t.Find(key) != t.end());
+      Clock::TimeDuration find = Clock::USecs() - now;
+      size_t num = 0;
+      now = Clock::USecs();
+      for (uint32_t lo : scans) {
+        int j = 0;
+        for (Tt::ItC it = t.Select(t.Rank(lo)); j<kScanLen && it != t.end();
+             ++j, ++it);
+        num += j;
+      }
+      Clock::TimeDuration scan = Clock::USecs() - now;
+      report("Treap", ins, find, scan, num);
+    }
+    {
+      Ts t;
+      Clock::TimePoint now = Clock::USecs();
+      for (uint32_t i=0; i<num_keys; ++i)
+        t.Emplace(Key(i));
+      Clock::TimeDuration ins = Clock::USecs() - now;
+      now = Clock::USecs();
+      for (uint32_t key : lookups)
+        CHECK(t.Find(key) != t.end());
+      Clock::TimeDuration find = Clock::USecs() - now;
+      size_t num = 0;
+      now = Clock::USecs();
+      for (uint32_t lo : scans) {
+        int j = 0;
+        for (Ts::ItC it = t.Select(t.Rank(lo)); j<kScanLen && it != t.end();
+             ++j, ++it);
+        num += j;
+      }
+      Clock::TimeDuration scan = Clock::USecs() - now;
+      report("SkipList", ins, find, scan, num);
+    }
+  }
+}
+
+int main(int argc, char **argv) {
+  Init::InitEnv(&argc, &argv);
+
+  BPlusTreeTester bt;
+  bt.ZeroEntryTest();
+  bt.BasicTest();
+  bt.RandomTest();
+  bt.StringTest();
+  if (FLAGS_benchmark)
+    bt.BenchmarkTest();
+
+  return 0;
+}
+
+DEFINE_bool(auto_test, false,
+            "test run programmatically (when true) or manually (when false)");
+DEFINE_bool(benchmark, false,
+            "test run when benchmarking BPlusTree vs Treap vs SkipList");
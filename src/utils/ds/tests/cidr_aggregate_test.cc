@@ -0,0 +1,229 @@
+// Copyright 2016 asarcar Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Author: Arijit Sarcar <sarcar_a@yahoo.com>
+
+// Standard C++ Headers
+#include <random>           // std::default_random_engine
+#include <string>           // std::string
+#include <utility>          // std::pair
+#include <vector>           // std::vector
+// Standard C Headers
+// Google Headers
+#include <glog/logging.h>
+// Local Headers
+#include "utils/basic/basictypes.h"
+#include "utils/basic/clock.h"
+#include "utils/basic/init.h"
+#include "utils/ds/cidr_aggregate.h"
+#include "utils/ds/radix_trie.h"
+#include "utils/nwk/ipv4_prefix.h"
+
+using namespace asarcar;
+using namespace asarcar::utils;
+using namespace asarcar::utils::nwk;
+using namespace asarcar::utils::ds;
+using namespace std;
+
+// Declarations
+DECLARE_bool(auto_test);
+DECLARE_bool(benchmark);
+
+class CidrAggregateTester {
+ public:
+  void SanityTest(void);
+  void RandomTest(void);
+  void BenchmarkTest(void);
+
+ private:
+  using PrefixTrie = RadixTrie<IPv4Prefix, uint32_t>;
+  using KeyValues  = vector<pair<IPv4Prefix, uint32_t>>;
+
+  static constexpr const char* kUnitStr        = "ns";
+  static constexpr int         kNumKeys        = 20000;
+  static constexpr int         kNumLookups     = 20000;
+  static constexpr int         kNumBenchRoutes = 1 << 19;
+  static constexpr int         kNumBenchLookups= 1 << 20;
+
+  // Synthetic table: /24s (& more specifics) under a few covering /16s with
+  // values drawn from few next hops i.e. plenty of redundancy to aggregate
+  static void RouteTable(int num_routes, uint32_t mask, int num_hops,
+                         PrefixTrie* rt_p);
+  // Every address has the same longest prefix match value in rt1 & rt2
+  static void CheckSameLookup(const PrefixTrie& rt1, const PrefixTrie& rt2,
+                              uint32_t addr);
+};
+
+constexpr const char* CidrAggregateTester::kUnitStr;
+constexpr int CidrAggregateTester::kNumKeys;
+constexpr int CidrAggregateTester::kNumLookups;
+constexpr int CidrAggregateTester::kNumBenchRoutes;
+constexpr int CidrAggregateTester::kNumBenchLookups;
+
+void CidrAggregateTester::RouteTable(int num_routes, uint32_t mask,
+                                     int num_hops, PrefixTrie* rt_p) {
+  default_random_engine              gen{};
+  uniform_int_distribution<uint32_t> dis{};
+  for (int i=0; i<num_routes/16; ++i)
+    rt_p->Insert({IPv4Prefix{dis(gen) & mask, 16}, dis(gen) % num_hops});
+  for (int i=0; i<num_routes; ++i)
+    rt_p->Insert({IPv4Prefix{dis(gen) & mask,
+            static_cast<int>(24 + dis(gen) % 9)}, dis(gen) % num_hops});
+}
+
+void CidrAggregateTester::CheckSameLookup(const PrefixTrie& rt1,
+                                          const PrefixTrie& rt2,
+                                          uint32_t addr) {
+  IPv4Prefix key{addr, IPv4::MAX_LEN};
+  auto it1 = rt1.LongestPrefixMatch(key);
+  auto it2 = rt2.LongestPrefixMatch(key);
+  CHECK_EQ(it1 == rt1.End(), it2 == rt2.End()) << key;
+  if (it1 != rt1.End())
+    CHECK_EQ(it1->second, it2->second) << key;
+}
+
+void CidrAggregateTester::SanityTest(void) {
+  KeyValues kvs;
+  AggregateStats stats = Aggregate(&kvs);
+  CHECK_EQ(stats.num_in, 0);
+  CHECK_EQ(stats.num_out, 0);
+
+  PrefixTrie rt;
+  rt[IPv4Prefix{"10.0.0.0", 8}]      = 1;
+  rt[IPv4Prefix{"10.1.0.0", 16}]     = 1; // covered
+  rt[IPv4Prefix{"10.1.2.0", 24}]     = 2;
+  rt[IPv4Prefix{"10.1.2.0", 25}]     = 3; // 10.1.2.0/24 siblings
+  rt[IPv4Prefix{"10.1.2.128", 25}]   = 3;
+  rt[IPv4Prefix{"10.1.3.0", 24}]     = 1; // covered
+  rt[IPv4Prefix{"192.168.0.0", 26}]  = 4; // cascades to 192.168.0.0/24
+  rt[IPv4Prefix{"192.168.0.64", 26}] = 4;
+  rt[IPv4Prefix{"192.168.0.128", 25}]= 4;
+  rt[IPv4Prefix{"192.168.1.0", 24}]  = 5; // sibling with another value
+  stats = Aggregate(&rt);
+  CHECK_EQ(stats.num_in, 10);
+  CHECK_EQ(stats.num_out, 4);
+  CHECK_EQ(stats.num_covered, 2);
+  CHECK_EQ(stats.num_merged, 3);
+  CHECK_EQ(rt.Size(), 4);
+
+  kvs.clear();
+  for (auto it = rt.Begin(); it != rt.End(); ++it)
+    kvs.push_back(*it);
+  KeyValues exp{{IPv4Prefix{"10.0.0.0", 8}, 1},
+                {IPv4Prefix{"10.1.2.0", 24}, 3},
+                {IPv4Prefix{"192.168.0.0", 24}, 4},
+                {IPv4Prefix{"192.168.1.0", 24}, 5}};
+  CHECK(kvs == exp) << stats.to_string();
+
+  // Merged parent overrides the parent in the table & is then covered
+  kvs = {{IPv4Prefix{"10.0.0.0", 8}, 1},
+         {IPv4Prefix{"10.0.0.0", 9}, 2},
+         {IPv4Prefix{"10.0.0.0", 10}, 1},
+         {IPv4Prefix{"10.64.0.0", 10}, 1}};
+  stats = Aggregate(&kvs);
+  CHECK_EQ(stats.num_out, 1) << stats.to_string();
+  CHECK(kvs[0].first == IPv4Prefix("10.0.0.0", 8));
+  CHECK_EQ(kvs[0].second, 1);
+
+  LOG(INFO) << __FUNCTION__ << " passed";
+}
+
+// Aggregated tables agree with the input on lookups of random addresses
+void CidrAggregateTester::RandomTest(void) {
+  default_random_engine              gen{};
+  uniform_int_distribution<uint32_t> dis{};
+  for (int num_hops : {1, 2, 4, 64}) {
+    PrefixTrie rt1, rt2;
+    for (int i=0; i<kNumKeys; ++i) {
+      IPv4Prefix pref{dis(gen) & 0xFF0FFFFF, static_cast<int>(dis(gen) % 33)};
+      uint32_t   hop = dis(gen) % num_hops;
+      rt1.Insert({pref, hop});
+      rt2.Insert({pref, hop});
+    }
+    AggregateStats stats = Aggregate(&rt2);
+    CHECK_EQ(stats.num_in, rt1.Size());
+    CHECK_EQ(stats.num_out, rt2.Size());
+    CHECK_LE(rt2.Size(), rt1.Size());
+    for (auto it = rt1.Begin(); it != rt1.End(); ++it) {
+      CheckSameLookup(rt1, rt2, it->first.ip().to_scalar());
+      CheckSameLookup(rt1, rt2, it->first.ip().to_scalar() |
+                      ~(0xFFFFFFFF << (IPv4::MAX_LEN - it->first.size()) >> 1));
+    }
+    for (int i=0; i<kNumLookups; ++i)
+      CheckSameLookup(rt1, rt2, dis(gen) & 0xFF0FFFFF);
+    // Aggregation is idempotent
+    stats = Aggregate(&rt2);
+    CHECK_EQ(stats.num_in, stats.num_out) << stats.to_string();
+  }
+
+  LOG(INFO) << __FUNCTION__ << " passed";
+}
+
+// Trie size & lookup latency before and after aggregation
+void CidrAggregateTester::BenchmarkTest(void) {
+  default_random_engine              gen{};
+  uniform_int_distribution<uint32_t> dis{};
+  vector<IPv4Prefix>                 addrs;
+  addrs.reserve(kNumBenchLookups);
+  for (int i=0; i<kNumBenchLookups; ++i)
+    addrs.push_back(IPv4Prefix{dis(gen) & 0x0FFFFFFF, IPv4::MAX_LEN});
+
+  for (int num_hops : {4, 16}) {
+    PrefixTrie rt;
+    RouteTable(kNumBenchRoutes, 0x0FFFFFFF, num_hops, &rt);
+    size_t     sizes[2][3];
+    uint64_t   durs[2];
+    uint64_t   durA = 0;
+    for (int i=0; i<2; ++i) {
+      if (i == 1) {
+        Clock::TimePoint now = Clock::USecs();
+        AggregateStats stats = Aggregate(&rt);
+        durA = Clock::USecs() - now;
+        LOG(INFO) << "#hops " << num_hops << ": " << stats.to_string();
+      }
+      sizes[i][0] = rt.Size();
+      sizes[i][1] = rt.NSize();
+      sizes[i][2] = rt.MemSize();
+      size_t           found = 0;
+      Clock::TimePoint now   = Clock::USecs();
+      for (auto& addr : addrs)
+        found += (rt.LongestPrefixMatch(addr) != rt.End());
+      durs[i] = (Clock::USecs() - now)*1000/kNumBenchLookups;
+      CHECK_GE(found, 0);
+    }
+    LOG(INFO) << "#hops " << num_hops << ": aggregate " << durA << "us: "
+              << "before/after: #prefixes " << sizes[0][0] << "/" << sizes[1][0]
+              << ": #nodes " << sizes[0][1] << "/" << sizes[1][1]
+              << ": bytes " << sizes[0][2] << "/" << sizes[1][2]
+              << ": lookup " << durs[0] << "/" << durs[1] << kUnitStr;
+  }
+}
+
+int main(int argc, char *argv[]) {
+  Init::InitEnv(&argc, &argv);
+
+  CidrAggregateTester test{};
+  test.SanityTest();
+  test.RandomTest();
+  if (FLAGS_benchmark)
+    test.BenchmarkTest();
+
+  return 0;
+}
+
+DEFINE_bool(auto_test, false,
+            "test run programmatically (when true) or manually (when false)");
+DEFINE_bool(benchmark, false,
+            "test run when benchmarking trie size & lookups before and after "
+            "aggregation");
@@ -0,0 +1,217 @@
+// Copyright 2015 asarcar Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Author: Arijit Sarcar <sarcar_a@yahoo.com>
+// Standard C++ Headers
+#include <random>           // std::default_random_engine
+#include <string>           // std::string
+#include <vector>           // std::vector
+// Standard C Headers
+// Google Headers
+// Local Headers
+#include "utils/basic/basictypes.h"
+#include "utils/basic/clock.h"
+#include "utils/basic/init.h"
+#include "utils/ds/common_prefix.h"
+#include "utils/ds/radix_trie.h"
+#include "utils/ds/string_prefix.h"
+
+using namespace asarcar;
+using namespace asarcar::utils;
+using namespace asarcar::utils::ds;
+using namespace std;
+
+// Flag Declarations
+DECLARE_bool(auto_test);
+DECLARE_bool(benchmark);
+
+class CommonPrefixTester {
+ public:
+  void KernelTest(void);
+  void StringPrefixTest(void);
+  void BenchmarkTest(void);
+ private:
+  using Level = CommonPrefix::Level;
+  using Words = vector<uint64_t>;
+  static constexpr const char* kUnitStr      = "ns/op";
+  static constexpr int         kMaxWords     = 40;
+  static constexpr int         kNumRandomOps = 20000;
+  static constexpr int         kNumBenchOps  = 1 << 20;
+  static constexpr int         kNumBenchKeys = 1 << 12;
+
+  // Levels supported by the processor: scalar first
+  static vector<Level> Levels(void);
+  // Reference: bit by bit
+  static size_t SlowBits(const Words& w1, const Words& w2);
+};
+
+constexpr const char* CommonPrefixTester::kUnitStr;
+constexpr int CommonPrefixTester::kMaxWords;
+constexpr int CommonPrefixTester::kNumRandomOps;
+constexpr int CommonPrefixTester::kNumBenchOps;
+constexpr int CommonPrefixTester::kNumBenchKeys;
+
+vector<CommonPrefixTester::Level> CommonPrefixTester::Levels(void) {
+  vector<Level> levels;
+  for (Level l : {Level::SCALAR, Level::SSE2, Level::AVX2}) {
+    if (static_cast<int>(l) <= static_cast<int>(CommonPrefix::Supported()))
+      levels.push_back(l);
+  }
+  return levels;
+}
+
+size_t CommonPrefixTester::SlowBits(const Words& w1, const Words& w2) {
+  size_t n = 0;
+  for (size_t i=0; i<w1.size()*CommonPrefix::WORD_BITS; ++i, ++n) {
+    size_t w = i/CommonPrefix::WORD_BITS;
+    size_t b = CommonPrefix::WORD_BITS - 1 - i%CommonPrefix::WORD_BITS;
+    if (((w1[w] >> b) & 1) != ((w2[w] >> b) & 1))
+      break;
+  }
+  return n;
+}
+
+// Every kernel agrees with the reference on a mismatch at every word
+// (& bit) position of every block & tail
+void CommonPrefixTester::KernelTest(void) {
+  default_random_engine              gen{};
+  uniform_int_distribution<uint64_t> dis{};
+  Level                              level = CommonPrefix::Get();
+  CHECK_EQ(static_cast<int>(level),
+           static_cast<int>(CommonPrefix::Supported()));
+  for (Level l : Levels()) {
+    CommonPrefix::Set(l);
+    CHECK(CommonPrefix::Get() == l);
+    for (int i=0; i<kNumRandomOps; ++i) {
+      size_t num_words = dis(gen) % (kMaxWords + 1);
+      Words  w1(num_words), w2;
+      for (auto& w : w1)
+        w = dis(gen);
+      w2 = w1;
+      // no mismatch when mm == num_words*WORD_BITS
+      size_t mm = dis(gen) % (num_words*CommonPrefix::WORD_BITS + 1);
+      if (mm < num_words*CommonPrefix::WORD_BITS)
+        w2[mm/CommonPrefix::WORD_BITS] ^=
+            1ULL << (CommonPrefix::WORD_BITS - 1 - mm%CommonPrefix::WORD_BITS);
+      // bits past the first mismatch are random
+      for (size_t j=mm/CommonPrefix::WORD_BITS + 1; j<num_words; ++j)
+        w2[j] = dis(gen);
+      CHECK_EQ(CommonPrefix::Bits(w1.data(), w2.data(), num_words),
+               SlowBits(w1, w2)) << CommonPrefix::ToString(l);
+      CHECK_EQ(SlowBits(w1, w2), mm) << CommonPrefix::ToString(l);
+    }
+  }
+  CommonPrefix::Set(level);
+  LOG(INFO) << __FUNCTION__ << " passed: kernel " 
+            << CommonPrefix::ToString(level);
+}
+
+// prefix, prefix_size & == of long keys agree across kernels
+void CommonPrefixTester::StringPrefixTest(void) {
+  Level  level = CommonPrefix::Get();
+  string path  = "https://www.example.com";
+  for (int i=0; i<64; ++i)
+    path += "/dir" + std::to_string(i);
+  StringPrefix a{string{path}};
+  for (Level l : Levels()) {
+    CommonPrefix::Set(l);
+    for (size_t len=0; len<=path.size(); len+=7) {
+      string       mod = path;
+      if (len < mod.size())
+        mod[len] ^= 0x1;
+      StringPrefix b{std::move(mod)};
+      size_t       exp = (len < path.size()) ? 
+          len*CHAR_BIT + CHAR_BIT - 1 : path.size()*CHAR_BIT;
+      CHECK_EQ(a.prefix_size(b), exp) << CommonPrefix::ToString(l);
+      CHECK_EQ(a.prefix(b).size(), exp) << CommonPrefix::ToString(l);
+      CHECK_EQ(a == b, len >= path.size()) << CommonPrefix::ToString(l);
+      CHECK(a.substr(0, exp) == b.substr(0, exp));
+    }
+  }
+  CommonPrefix::Set(level);
+  LOG(INFO) << __FUNCTION__ << " passed";
+}
+
+// Per kernel: common prefix of keys differing in the last bit across key
+// lengths and LongestPrefixMatch of long URL keys in a RadixTrie
+void CommonPrefixTester::BenchmarkTest(void) {
+  Level level = CommonPrefix::Get();
+  for (size_t num_words : {2, 8, 32, 128, 512}) {
+    Words  w1(num_words, 0x5A5A5A5A5A5A5A5AULL), w2{w1};
+    size_t len = num_words*CommonPrefix::WORD_BITS;
+    w2.back() ^= 1;
+    string str = to_string(len) + " bit keys: common prefix";
+    for (Level l : Levels()) {
+      CommonPrefix::Set(l);
+      size_t           sum = 0;
+      Clock::TimePoint now = Clock::USecs();
+      for (int i=0; i<kNumBenchOps; ++i)
+        sum += CommonPrefix::Bits(w1.data(), w2.data(), num_words);
+      Clock::TimeDuration dur = Clock::USecs() - now;
+      CHECK_EQ(sum, static_cast<size_t>(kNumBenchOps)*(len - 1));
+      str += " " + CommonPrefix::ToString(l) + "=" +
+          to_string(1000.0*dur/kNumBenchOps) + kUnitStr;
+    }
+    LOG(INFO) << str;
+  }
+
+  // URLs sharing a long path: LongestPrefixMatch compares the long
+  // node keys of the path
+  string base = "https://www.example.com";
+  for (int i=0; i<32; ++i)
+    base += "/dir" + std::to_string(i);
+  RadixTrie<StringPrefix, uint32_t> rt;
+  vector<StringPrefix>         keys;
+  for (int i=0; i<kNumBenchKeys; ++i) {
+    string key = base + "/file" + std::to_string(i);
+    rt.Insert({StringPrefix{string{key}}, static_cast<uint32_t>(i)});
+    keys.push_back(StringPrefix{key + "?query"});
+  }
+  string str = to_string(base.size()*CHAR_BIT) +
+      " bit path: LongestPrefixMatch";
+  for (Level l : Levels()) {
+    CommonPrefix::Set(l);
+    size_t           sum = 0;
+    Clock::TimePoint now = Clock::USecs();
+    for (int n=0; n<kNumBenchOps/kNumBenchKeys; ++n) {
+      for (const auto& k : keys)
+        sum += rt.LongestPrefixMatch(k)->second;
+    }
+    Clock::TimeDuration dur = Clock::USecs() - now;
+    CHECK_EQ(sum, static_cast<size_t>(kNumBenchOps/kNumBenchKeys)*
+             kNumBenchKeys*(kNumBenchKeys - 1)/2);
+    str += " " + CommonPrefix::ToString(l) + "=" +
+        to_string(1000.0*dur/kNumBenchOps) + kUnitStr;
+  }
+  LOG(INFO) << str;
+  CommonPrefix::Set(level);
+}
+
+int main(int argc, char **argv) {
+  Init::InitEnv(&argc, &argv);
+
+  CommonPrefixTester cpt;
+
+  cpt.KernelTest();
+  cpt.StringPrefixTest();
+  if (FLAGS_benchmark)
+    cpt.BenchmarkTest();
+
+  return 0;
+}
+
+DEFINE_bool(auto_test, false, 
+            "test run programmatically (when true) or manually (when false)");
+DEFINE_bool(benchmark, false,
+            "test run when benchmarking common prefix kernels");
@@ -0,0 +1,403 @@
+// Copyright 2016 asarcar Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Author: Arijit Sarcar <sarcar_a@yahoo.com>
+
+// Standard C++ Headers
+#include <atomic>           // std::atomic
+#include <chrono>           // std::chrono
+#include <iostream>         // std::cout
+#include <random>           // std::default_random_engine
+#include <thread>           // std::thread
+#include <vector>           // std::vector
+// Standard C Headers
+// Google Headers
+#include <glog/logging.h>
+// Local Headers
+#include "utils/basic/basictypes.h"
+#include "utils/basic/init.h"
+#include "utils/concur/epoch.h"
+#include "utils/concur/lock_guard.h"
+#include "utils/concur/spin_lock.h"
+#include "utils/ds/concur_radix_trie.h"
+#include "utils/ds/radix_trie.h"
+#include "utils/ds/string_prefix.h"
+#include "utils/nwk/ipv4_prefix.h"
+
+using namespace asarcar;
+using namespace asarcar::utils;
+using namespace asarcar::utils::concur;
+using namespace asarcar::utils::nwk;
+using namespace asarcar::utils::ds;
+using namespace std;
+
+// Declarations
+DECLARE_bool(auto_test);
+DECLARE_bool(benchmark);
+
+class ConcurRadixTrieTester {
+ public:
+  using CTrie    = ConcurRadixTrie<IPv4Prefix, string>;
+  using Trie     = RadixTrie<IPv4Prefix, string>;
+  using KeyValue = CTrie::KeyValue;
+
+  ConcurRadixTrieTester() {}
+  ~ConcurRadixTrieTester() = default;
+
+  void RouteTest();
+  void StringTest();
+  void ModelTest();
+  void ConcurTest();
+  void ReclaimTest();
+  void BenchmarkTest();
+
+ private:
+  static constexpr int      kNumModelOps    = 20000;
+  static constexpr int      kNumModelLPMs   = 64;
+  static constexpr int      kNumReaders     = 3;
+  static constexpr int      kNumUpdates     = 20000;
+  static constexpr int      kNumBenchRoutes = 1 << 16;
+  static constexpr int      kBenchUpdateRate= 10000; // updates per sec
+  static constexpr int      kBenchDurMSecs  = 1000;
+
+  // Random prefix within 10.0.0.0/8 with length in [lo, hi]
+  static IPv4Prefix RandPrefix(default_random_engine* gen_p, int lo, int hi) {
+    uniform_int_distribution<uint32_t> adis(0, 0x00FFFFFF);
+    uniform_int_distribution<int>      ldis(lo, hi);
+    return IPv4Prefix{0x0A000000 | adis(*gen_p), ldis(*gen_p)};
+  }
+  static string LPM(const CTrie& t, const char* addr) {
+    KeyValue kv;
+    return t.LongestPrefixMatch(IPv4Prefix{addr, IPv4::MAX_LEN}, &kv) ?
+        kv.first.to_string() : "";
+  }
+  static string LPM(const Trie& t, const IPv4Prefix& addr) {
+    auto it = t.LongestPrefixMatch(addr);
+    return (it == t.End()) ? "" : it->first.to_string();
+  }
+  static string LPM(const CTrie& t, const IPv4Prefix& addr) {
+    KeyValue kv;
+    return t.LongestPrefixMatch(addr, &kv) ? kv.first.to_string() : "";
+  }
+  // Route lookup throughput in Mlookups/sec with num_readers threads
+  // while a writer churns routes at kBenchUpdateRate
+  template <typename Table>
+  double BenchmarkHelper(int num_readers);
+};
+
+constexpr int ConcurRadixTrieTester::kNumModelOps;
+constexpr int ConcurRadixTrieTester::kNumModelLPMs;
+constexpr int ConcurRadixTrieTester::kNumReaders;
+constexpr int ConcurRadixTrieTester::kNumUpdates;
+constexpr int ConcurRadixTrieTester::kNumBenchRoutes;
+constexpr int ConcurRadixTrieTester::kBenchUpdateRate;
+constexpr int ConcurRadixTrieTester::kBenchDurMSecs;
+
+// Exercises every insert (split, root, exact match, leaf) and erase
+// (two children, leaf with merge of parent, one child) case
+void ConcurRadixTrieTester::RouteTest() {
+  CTrie t{};
+  CHECK(t.Empty());
+  CHECK_EQ(LPM(t, "10.1.1.1"), "");
+  CHECK(!t.Erase(IPv4Prefix{"10.0.0.0", 8}));
+
+  CHECK(t.Insert({IPv4Prefix{"10.1.0.0", 16}, "A"}));            // root
+  CHECK(!t.Insert({IPv4Prefix{"10.1.0.0", 16}, "X"}));           // exists
+  CHECK(t.Insert({IPv4Prefix{"10.1.1.0", 24}, "B"}));            // leaf
+  CHECK(t.Insert({IPv4Prefix{"10.2.0.0", 16}, "C"}));            // split a.1
+  CHECK(t.Insert({IPv4Prefix{"10.0.0.0", 8}, "D"}));             // split a.2
+  CHECK_EQ(t.Size(), 4);
+  CHECK_EQ(t.NSize(), 5);
+
+  KeyValue kv;
+  CHECK(t.Find(IPv4Prefix{"10.1.0.0", 16}, &kv));
+  CHECK_EQ(kv.second, "A");
+  CHECK(!t.Find(IPv4Prefix{"10.0.0.0", 14}));                    // internal
+  CHECK_EQ(LPM(t, "10.1.1.1"), "10.1.1.0/24");
+  CHECK_EQ(LPM(t, "10.1.2.1"), "10.1.0.0/16");
+  CHECK_EQ(LPM(t, "10.2.2.1"), "10.2.0.0/16");
+  CHECK_EQ(LPM(t, "10.3.2.1"), "10.0.0.0/8");
+  CHECK_EQ(LPM(t, "11.1.1.1"), "");
+
+  CHECK(!t.Update({IPv4Prefix{"10.1.0.0", 16}, "A2"}));          // replace
+  CHECK(t.Update({IPv4Prefix{"10.0.0.0", 14}, "E"}));            // internal
+  CHECK(t.Find(IPv4Prefix{"10.1.0.0", 16}, &kv));
+  CHECK_EQ(kv.second, "A2");
+  CHECK_EQ(t.Size(), 5);
+
+  CHECK(t.Erase(IPv4Prefix{"10.0.0.0", 14}));                    // a.
+  CHECK(!t.Erase(IPv4Prefix{"10.0.0.0", 14}));
+  CHECK(t.Erase(IPv4Prefix{"10.2.0.0", 16}));                    // b. merge
+  CHECK_EQ(t.NSize(), 3);
+  CHECK(t.Erase(IPv4Prefix{"10.1.0.0", 16}));                    // c.
+  CHECK_EQ(t.NSize(), 2);
+  CHECK_EQ(LPM(t, "10.1.2.1"), "10.0.0.0/8");
+  CHECK_EQ(LPM(t, "10.1.1.1"), "10.1.1.0/24");
+  CHECK(t.Erase(IPv4Prefix{"10.0.0.0", 8}));                     // c. root
+  CHECK(t.Erase(IPv4Prefix{"10.1.1.0", 24}));                    // b. root
+  CHECK(t.Empty());
+  CHECK_EQ(t.NSize(), 0);
+
+  CHECK(t.Insert({IPv4Prefix{"0.0.0.0", 0}, "default"}));
+  CHECK(t.Insert({IPv4Prefix{"10.1.0.0", 16}, "A"}));
+  CHECK_EQ(LPM(t, "11.1.1.1"), "0.0.0.0/0");
+  t.Clear();
+  CHECK(t.Empty());
+  CHECK_EQ(LPM(t, "11.1.1.1"), "");
+  LOG(INFO) << t;
+
+  LOG(INFO) << __FUNCTION__ << " passed";
+  return;
+}
+
+void ConcurRadixTrieTester::StringTest() {
+  ConcurRadixTrie<StringPrefix, string> t{};
+  ConcurRadixTrie<StringPrefix, string>::KeyValue kv{StringPrefix{""}, ""};
+  for (const char* s : {"abc", "abd", "ab", "b", "abcdef"})
+    CHECK(t.Insert({StringPrefix{s}, s}));
+  CHECK_EQ(t.Size(), 5);
+  CHECK(t.Find(StringPrefix{"ab"}, &kv));
+  CHECK_EQ(kv.second, "ab");
+  CHECK(!t.Find(StringPrefix{"a"}));
+  CHECK(t.LongestPrefixMatch(StringPrefix{"abcde"}, &kv));
+  CHECK_EQ(kv.second, "abc");
+  CHECK(t.LongestPrefixMatch(StringPrefix{"abx"}, &kv));
+  CHECK_EQ(kv.second, "ab");
+  CHECK(!t.LongestPrefixMatch(StringPrefix{"c"}, &kv));
+
+  CHECK(t.Erase(StringPrefix{"abc"}));
+  CHECK(t.LongestPrefixMatch(StringPrefix{"abcdefg"}, &kv));
+  CHECK_EQ(kv.second, "abcdef");
+  CHECK(t.LongestPrefixMatch(StringPrefix{"abcde"}, &kv));
+  CHECK_EQ(kv.second, "ab");
+  CHECK_EQ(t.InOrder([](const ConcurRadixTrie<StringPrefix, string>::
+                        KeyValue&) { return 1; }), 4);
+
+  LOG(INFO) << __FUNCTION__ << " passed";
+  return;
+}
+
+// Random inserts & erases applied to both RadixTrie (model) and
+// ConcurRadixTrie: trie shapes (#nodes) and lookups agree.
+void ConcurRadixTrieTester::ModelTest() {
+  CTrie                 t{};
+  Trie                  m{};
+  default_random_engine gen{};
+
+  for (int i=0; i<kNumModelOps; ++i) {
+    IPv4Prefix pref = RandPrefix(&gen, 8, 16);
+    if (i % 3 == 2) {
+      auto it = m.Find(pref);
+      bool found = (it != m.End());
+      if (found)
+        m.Erase(it);
+      CHECK_EQ(t.Erase(pref), found);
+    } else {
+      CHECK_EQ(t.Insert({pref, pref.to_string()}),
+               m.Insert({pref, pref.to_string()}).second);
+    }
+    CHECK_EQ(t.Size(), m.Size());
+    CHECK_EQ(t.NSize(), m.NSize());
+    if (i % 1000 != 0)
+      continue;
+    for (int j=0; j<kNumModelLPMs; ++j) {
+      IPv4Prefix addr = RandPrefix(&gen, IPv4::MAX_LEN, IPv4::MAX_LEN);
+      CHECK_EQ(LPM(t, addr), LPM(m, addr));
+    }
+  }
+  CHECK_EQ(t.InOrder([](const KeyValue& kv) {
+        CHECK_EQ(kv.first.to_string(), kv.second); return 1;
+      }), m.Size());
+
+  LOG(INFO) << __FUNCTION__ << " passed: #nodes=" << t.NSize()
+            << ": #values=" << t.Size();
+  return;
+}
+
+// Readers look up addresses in 10.0.0.0/8 while a writer churns more
+// specific routes: every lookup finds a route covering the address with
+// a consistent value.
+void ConcurRadixTrieTester::ConcurTest() {
+  CTrie          t{};
+  atomic_bool    done{false};
+  atomic_int     num_lookups{0};
+  vector<thread> th;
+  CHECK(t.Insert({IPv4Prefix{"10.0.0.0", 8}, "10.0.0.0/8"}));
+
+  for (int i=0; i<kNumReaders; ++i) {
+    th.emplace_back([&t, &done, &num_lookups, i]() {
+        default_random_engine gen(i);
+        KeyValue              kv;
+        int                   n = 0;
+        while (!done) {
+          IPv4Prefix addr = RandPrefix(&gen, IPv4::MAX_LEN, IPv4::MAX_LEN);
+          CHECK(t.LongestPrefixMatch(addr, &kv));
+          CHECK_EQ(addr.prefix(kv.first).size(), kv.first.size());
+          CHECK_EQ(kv.first.to_string(), kv.second);
+          ++n;
+        }
+        num_lookups += n;
+      });
+  }
+
+  default_random_engine gen{};
+  for (int i=0; i<kNumUpdates; ++i) {
+    IPv4Prefix pref = RandPrefix(&gen, 9, 20);
+    if (!t.Insert({pref, pref.to_string()}))
+      CHECK(t.Erase(pref));
+    if (i % 64 == 0)
+      this_thread::yield();
+  }
+  done = true;
+  for (auto &th_ : th)
+    th_.join();
+  CHECK(t.Find(IPv4Prefix{"10.0.0.0", 8}));
+  LOG(INFO) << "#lookups=" << num_lookups << ": #routes=" << t.Size();
+
+  LOG(INFO) << __FUNCTION__ << " passed";
+  return;
+}
+
+// Replaced nodes & values retired by the writers are reclaimed after the
+// grace period
+void ConcurRadixTrieTester::ReclaimTest() {
+  {
+    CTrie t{};
+    for (int i=0; i<256; ++i)
+      CHECK(t.Insert({IPv4Prefix{0x0A000000u | (i << 8), 24}, "v"}));
+    t.Clear();
+  }
+  EpochMgr::Singleton()->Synchronize();
+  CHECK_EQ(EpochMgr::Singleton()->NumRetired(), 0);
+  LOG(INFO) << *EpochMgr::Singleton();
+
+  LOG(INFO) << __FUNCTION__ << " passed";
+  return;
+}
+
+// RadixTrie serialized by a reader writer SpinLock vs ConcurRadixTrie
+struct LockedTable {
+  using Trie = RadixTrie<IPv4Prefix, string>;
+  Trie     t;
+  SpinLock lck;
+  inline bool LPM(const IPv4Prefix& addr) {
+    LockGuard<SpinLock> lkg{lck, LockMode::SHARE_LOCK};
+    return t.LongestPrefixMatch(addr) != t.End();
+  }
+  inline void Insert(const IPv4Prefix& pref) {
+    LockGuard<SpinLock> lkg{lck};
+    t.Insert({pref, pref.to_string()});
+  }
+  inline void Erase(const IPv4Prefix& pref) {
+    LockGuard<SpinLock> lkg{lck};
+    auto it = t.Find(pref);
+    if (it != t.End())
+      t.Erase(it);
+  }
+};
+struct ConcurTable {
+  ConcurRadixTrie<IPv4Prefix, string> t;
+  inline bool LPM(const IPv4Prefix& addr) {
+    ConcurRadixTrie<IPv4Prefix, string>::KeyValue kv;
+    return t.LongestPrefixMatch(addr, &kv);
+  }
+  inline void Insert(const IPv4Prefix& pref) {
+    t.Insert({pref, pref.to_string()});
+  }
+  inline void Erase(const IPv4Prefix& pref) { t.Erase(pref); }
+};
+
+template <typename Table>
+double ConcurRadixTrieTester::BenchmarkHelper(int num_readers) {
+  using Tick = chrono::steady_clock;
+  Table                 table;
+  atomic_bool           done{false};
+  atomic<uint64_t>      num_lookups{0};
+  vector<thread>        th;
+  vector<IPv4Prefix>    routes;
+  default_random_engine gen{};
+
+  for (int i=0; i<kNumBenchRoutes; ++i) {
+    routes.emplace_back(RandPrefix(&gen, 12, 28));
+    table.Insert(routes.back());
+  }
+
+  for (int i=0; i<num_readers; ++i) {
+    th.emplace_back([&table, &done, &num_lookups, i]() {
+        default_random_engine g(i);
+        uint64_t              n = 0;
+        while (!done) {
+          table.LPM(RandPrefix(&g, IPv4::MAX_LEN, IPv4::MAX_LEN));
+          ++n;
+        }
+        num_lookups += n;
+      });
+  }
+
+  // Writer: withdraw & re-announce a random route at kBenchUpdateRate
+  Tick::time_point start = Tick::now();
+  Tick::time_point end   = start + chrono::milliseconds(kBenchDurMSecs);
+  Tick::duration   gap   = chrono::duration_cast<Tick::duration>(
+      chrono::seconds(1))/kBenchUpdateRate;
+  uniform_int_distribution<int> rdis(0, kNumBenchRoutes-1);
+  int num_updates = 0;
+  for (Tick::time_point next = start; next < end; next += gap) {
+    this_thread::sleep_until(next);
+    const IPv4Prefix& pref = routes.at(rdis(gen));
+    if ((num_updates++ % 2) == 0)
+      table.Erase(pref);
+    else
+      table.Insert(pref);
+  }
+  done = true;
+  for (auto &t : th)
+    t.join();
+
+  double secs = chrono::duration<double>(Tick::now() - start).count();
+  LOG(INFO) << "#updates=" << num_updates << " in " << secs << "s";
+  return static_cast<double>(num_lookups)/secs/1000000;
+}
+
+void ConcurRadixTrieTester::BenchmarkTest() {
+  for (int n=1; n<=4; n*=2) {
+    double mlookupsL = BenchmarkHelper<LockedTable>(n);
+    double mlookupsC = BenchmarkHelper<ConcurTable>(n);
+    LOG(INFO) << "LPM with " << n << " readers & " << kBenchUpdateRate
+              << " updates/sec for Locked RadixTrie/ConcurRadixTrie: "
+              << "Mlookups/sec = " << mlookupsL << "/" << mlookupsC;
+  }
+
+  return;
+}
+
+int main(int argc, char *argv[]) {
+  Init::InitEnv(&argc, &argv);
+
+  ConcurRadixTrieTester test{};
+  test.RouteTest();
+  test.StringTest();
+  test.ModelTest();
+  test.ConcurTest();
+  test.ReclaimTest();
+  if (FLAGS_benchmark)
+    test.BenchmarkTest();
+
+  return 0;
+}
+
+DEFINE_bool(auto_test, false,
+            "test run programmatically (when true) or manually (when false)");
+DEFINE_bool(benchmark, false,
+            "test run when benchmarking route lookups of concurrent radix "
+            "trie against locked radix trie under route updates");
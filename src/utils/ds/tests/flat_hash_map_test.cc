@@ -0,0 +1,266 @@
+// Copyright 2016 asarcar Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Author: Arijit Sarcar <sarcar_a@yahoo.com>
+
+// Standard C++ Headers
+#include <random>           // std::default_random_engine
+#include <string>           // std::string
+#include <unordered_map>    // std::unordered_map
+#include <vector>           // std::vector
+// Standard C Headers
+// Google Headers
+#include <glog/logging.h>
+// Local Headers
+#include "utils/basic/basictypes.h"
+#include "utils/basic/clock.h"
+#include "utils/basic/init.h"
+#include "utils/ds/flat_hash_map.h"
+
+using namespace asarcar;
+using namespace asarcar::utils;
+using namespace asarcar::utils::ds;
+using namespace std;
+
+// Flag Declarations
+DECLARE_bool(auto_test);
+DECLARE_bool(benchmark);
+
+// Few distinct hashes: long probe sequences across groups & wraparound
+struct BadHash {
+  size_t operator()(uint32_t key) const { return key % 3; }
+};
+
+class FlatHashMapTester {
+ public:
+  using Fm = FlatHashMap<uint32_t,uint32_t>;
+
+  void ZeroEntryTest(void);
+  void RandomTest(void);
+  void CollisionTest(void);
+  void StringTest(void);
+  void BenchmarkTest(void);
+ private:
+  static constexpr const char* kUnitStr    = "ns";
+  static constexpr int         kNumKeys    = 4096;
+  static constexpr int         kNumRandOps = 1 << 18;
+  static constexpr int         kNumOps     = 1 << 20;
+
+  // Inserts keys, finds hits & misses, erases keys of map m_p
+  template <typename Map>
+  static void Benchmark(const char* name, Map* m_p,
+                        const vector<uint64_t>& keys,
+                        const vector<uint64_t>& hits,
+                        const vector<uint64_t>& misses);
+  // Map iteration & lookups agree with ref
+  template <typename Map>
+  static void CheckEqual(const Map& m,
+                         const unordered_map<uint32_t,uint32_t>& ref);
+};
+
+constexpr const char* FlatHashMapTester::kUnitStr;
+constexpr int FlatHashMapTester::kNumKeys;
+constexpr int FlatHashMapTester::kNumRandOps;
+constexpr int FlatHashMapTester::kNumOps;
+
+template <typename Map>
+void FlatHashMapTester::CheckEqual(const Map& m,
+                                   const unordered_map<uint32_t,uint32_t>& ref) {
+  CHECK_EQ(m.size(), ref.size());
+  size_t num = 0;
+  for (const auto& kv : m) {
+    auto it = ref.find(kv.first);
+    CHECK(it != ref.end());
+    CHECK_EQ(kv.second, it->second);
+    ++num;
+  }
+  CHECK_EQ(num, ref.size());
+  for (const auto& kv : ref)
+    CHECK_EQ(m.find(kv.first)->second, kv.second);
+}
+
+void FlatHashMapTester::ZeroEntryTest(void) {
+  Fm m;
+
+  CHECK_EQ(m.size(), 0);
+  CHECK_EQ(m.capacity(), 0);
+  CHECK(m.find(1) == m.end());
+  CHECK(m.begin() == m.end());
+  CHECK_EQ(m.erase(1), 0);
+  m.clear();
+
+  auto pr = m.insert(Fm::value_type{1, 2});
+  CHECK(pr.second);
+  CHECK_EQ(pr.first->second, 2);
+  CHECK(!m.emplace(1, 3).second);
+  CHECK_EQ(m.find(1)->second, 2);
+  CHECK_EQ(m.capacity(), Fm::GROUP_WIDTH);
+  m.erase(m.find(1));
+  CHECK(m.empty());
+
+  LOG(INFO) << __FUNCTION__ << " passed";
+}
+
+// Random insert/erase/find agree with std::unordered_map: churn at a
+// steady size recycles tombstones & rehashes in place
+void FlatHashMapTester::RandomTest(void) {
+  default_random_engine              gen{};
+  uniform_int_distribution<uint32_t> dis{0, 2*kNumKeys};
+  Fm                                 m;
+  unordered_map<uint32_t,uint32_t>   ref;
+  size_t                             max_cap = 0;
+  for (int i=0; i<kNumRandOps; ++i) {
+    uint32_t key = dis(gen);
+    switch (gen() % 3) {
+      case 0:
+        CHECK_EQ(m.emplace(uint32_t{key}, uint32_t(i)).second,
+                 ref.emplace(key, i).second);
+        break;
+      case 1:
+        CHECK_EQ(m.erase(key), ref.erase(key));
+        break;
+      default:
+        CHECK_EQ(m.count(key), ref.count(key));
+    }
+    if (i % (kNumRandOps/16) == 0)
+      CheckEqual(m, ref);
+    max_cap = max(max_cap, m.capacity());
+  }
+  CheckEqual(m, ref);
+  // steady state churn does not grow the table past load of 2*kNumKeys keys
+  CHECK_LE(max_cap, 4*kNumKeys);
+
+  m.reserve(16*kNumKeys);
+  CHECK_GE(m.capacity(), 16*kNumKeys);
+  CheckEqual(m, ref);
+  m.clear();
+  CHECK(m.begin() == m.end());
+
+  LOG(INFO) << __FUNCTION__ << " passed";
+}
+
+// All keys on 3 probe sequences: every find walks many full groups &
+// erase leaves tombstones
+void FlatHashMapTester::CollisionTest(void) {
+  FlatHashMap<uint32_t,uint32_t,BadHash> m;
+  unordered_map<uint32_t,uint32_t>       ref;
+  for (uint32_t key=0; key<kNumKeys/8; ++key) {
+    CHECK(m.emplace(uint32_t{key}, key + 1).second);
+    ref.emplace(key, key + 1);
+  }
+  CheckEqual(m, ref);
+  for (uint32_t round=0; round<8; ++round) {
+    for (uint32_t key=0; key<kNumKeys/8; key += 2) {
+      CHECK_EQ(m.erase(key), 1);
+      CHECK(m.find(key + 1) != m.end());
+    }
+    for (uint32_t key=0; key<kNumKeys/8; key += 2)
+      CHECK(m.emplace(uint32_t{key}, key + 1).second);
+  }
+  CheckEqual(m, ref);
+
+  LOG(INFO) << __FUNCTION__ << " passed";
+}
+
+// Non trivial K & V are moved on rehash & destroyed on erase/clear
+void FlatHashMapTester::StringTest(void) {
+  FlatHashMap<string,string> m;
+  for (int i=0; i<kNumKeys; ++i)
+    CHECK(m.emplace(to_string(i), string(32, 'a' + i % 26)).second);
+  for (int i=0; i<kNumKeys; i += 2)
+    CHECK_EQ(m.erase(to_string(i)), 1);
+  CHECK_EQ(m.size(), kNumKeys/2);
+  CHECK_EQ(m.find("1")->second, string(32, 'b'));
+  CHECK(m.find("0") == m.end());
+
+  LOG(INFO) << __FUNCTION__ << " passed";
+}
+
+template <typename Map>
+void FlatHashMapTester::Benchmark(const char* name, Map* m_p,
+                                  const vector<uint64_t>& keys,
+                                  const vector<uint64_t>& hits,
+                                  const vector<uint64_t>& misses) {
+  size_t              num_keys = keys.size();
+  Clock::TimeDuration dur[4] = {};
+  Clock::TimePoint    now = Clock::USecs();
+  for (uint64_t key : keys)
+    m_p->emplace(uint64_t{key}, uint64_t{key});
+  dur[0] = Clock::USecs() - now;
+  size_t num = 0;
+  now = Clock::USecs();
+  for (uint64_t key : hits)
+    num += (m_p->find(key) != m_p->end());
+  dur[1] = Clock::USecs() - now;
+  now = Clock::USecs();
+  for (uint64_t key : misses)
+    num += (m_p->find(key) != m_p->end());
+  dur[2] = Clock::USecs() - now;
+  CHECK_EQ(num, hits.size());
+  now = Clock::USecs();
+  for (uint64_t key : keys)
+    num += m_p->erase(key);
+  dur[3] = Clock::USecs() - now;
+  CHECK_EQ(num, hits.size() + num_keys);
+  LOG(INFO) << name << ": " << num_keys << " keys: insert/hit/miss/erase = "
+            << dur[0]*1000/num_keys << "/" << dur[1]*1000/hits.size() << "/"
+            << dur[2]*1000/misses.size() << "/" << dur[3]*1000/num_keys
+            << kUnitStr;
+}
+
+// FlatHashMap vs std::unordered_map: 10^3 to 10^7 entries.
+// Insert, lookup hit & miss, erase: ns per op.
+void FlatHashMapTester::BenchmarkTest(void) {
+  default_random_engine gen{};
+  for (uint32_t num_keys : {1000, 10000, 100000, 1000000, 10000000}) {
+    // key i: i times an odd constant is a bijection of uint64_t i.e. keys
+    // are distinct & keys of i >= num_keys miss
+    vector<uint64_t> keys, misses, hits;
+    for (uint64_t i=0; i<num_keys; ++i)
+      keys.push_back(i*0x9E3779B97F4A7C15ULL);
+    for (uint64_t i=0; i<kNumOps; ++i)
+      misses.push_back((num_keys + i)*0x9E3779B97F4A7C15ULL);
+    uniform_int_distribution<uint32_t> idx{0, num_keys - 1};
+    for (int i=0; i<kNumOps; ++i)
+      hits.push_back(keys[idx(gen)]);
+
+    {
+      FlatHashMap<uint64_t,uint64_t> m;
+      Benchmark("FlatHashMap", &m, keys, hits, misses);
+    }
+    {
+      unordered_map<uint64_t,uint64_t> m;
+      Benchmark("unordered_map", &m, keys, hits, misses);
+    }
+  }
+}
+
+int main(int argc, char **argv) {
+  Init::InitEnv(&argc, &argv);
+
+  FlatHashMapTester ft;
+  ft.ZeroEntryTest();
+  ft.RandomTest();
+  ft.CollisionTest();
+  ft.StringTest();
+  if (FLAGS_benchmark)
+    ft.BenchmarkTest();
+
+  return 0;
+}
+
+DEFINE_bool(auto_test, false,
+            "test run programmatically (when true) or manually (when false)");
+DEFINE_bool(benchmark, false,
+            "test run when benchmarking FlatHashMap vs std::unordered_map");
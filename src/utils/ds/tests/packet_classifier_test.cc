@@ -0,0 +1,309 @@
+// Copyright 2016 asarcar Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Author: Arijit Sarcar <sarcar_a@yahoo.com>
+
+// Standard C++ Headers
+#include <random>           // std::default_random_engine
+#include <string>           // std::string
+#include <vector>           // std::vector
+// Standard C Headers
+// Google Headers
+#include <glog/logging.h>
+// Local Headers
+#include "utils/basic/basictypes.h"
+#include "utils/basic/clock.h"
+#include "utils/basic/init.h"
+#include "utils/ds/packet_classifier.h"
+#include "utils/nwk/ipv4_prefix.h"
+
+using namespace asarcar;
+using namespace asarcar::utils;
+using namespace asarcar::utils::nwk;
+using namespace asarcar::utils::ds;
+using namespace std;
+
+// Declarations
+DECLARE_bool(auto_test);
+DECLARE_bool(benchmark);
+
+class PacketClassifierTester {
+ public:
+  PacketClassifierTester() : gen_{}, dis_{} {}
+  void SanityTest(void);
+  void RandomTest(void);
+  void UpdateTest(void);
+  void BenchmarkTest(void);
+
+ private:
+  static constexpr const char* kUnitStr        = "ns";
+  static constexpr int         kNumRules       = 2000;
+  static constexpr int         kNumPackets     = 20000;
+  static constexpr int         kNumUpdates     = 2000;
+  static constexpr int         kNumBenchPackets= 1 << 18;
+  static constexpr int         kMaxPoolSize    = 2048;
+  static constexpr int         kNumPortRanges  = 64;
+
+  default_random_engine              gen_;
+  uniform_int_distribution<uint32_t> dis_;
+  vector<IPv4Prefix>                 pool_;
+  vector<PortRange>                  port_pool_;
+
+  // Synthetic rule set: prefixes are drawn from a pool of pool_size
+  // prefixes, ports from a pool of wildcards, well known ports & ranges
+  vector<PacketRule> Rules(int num_rules, int pool_size);
+  PortRange Ports(void);
+  // Packet matching rule (random addresses & ports within its fields)
+  PacketHeader Packet(const PacketRule& rule);
+  // Highest priority rule of rules (insertion order) matching hdr
+  static const PacketRule* Linear(const vector<PacketRule>& rules,
+                                  const PacketHeader& hdr);
+  static void Check(const PacketClassifier& pc,
+                    const vector<PacketRule>& rules, const PacketHeader& hdr);
+};
+
+constexpr const char* PacketClassifierTester::kUnitStr;
+constexpr int PacketClassifierTester::kNumRules;
+constexpr int PacketClassifierTester::kNumPackets;
+constexpr int PacketClassifierTester::kNumUpdates;
+constexpr int PacketClassifierTester::kNumBenchPackets;
+constexpr int PacketClassifierTester::kMaxPoolSize;
+constexpr int PacketClassifierTester::kNumPortRanges;
+
+PortRange PacketClassifierTester::Ports(void) {
+  switch (dis_(gen_) % 4) {
+    case 0: return {0, 0xFFFF};
+    case 1: return {1024, 0xFFFF};
+    case 2: {
+      uint16_t port = dis_(gen_) % 1024;
+      return {port, port};
+    }
+    default: {
+      uint16_t lo = dis_(gen_) % 0xFFFF;
+      return {lo, lo + dis_(gen_) % (0x10000 - lo)};
+    }
+  }
+}
+
+vector<PacketRule> PacketClassifierTester::Rules(int num_rules,
+                                                 int pool_size) {
+  port_pool_.clear();
+  while (port_pool_.size() < kNumPortRanges)
+    port_pool_.push_back(Ports());
+  pool_.clear();
+  pool_.push_back(IPv4Prefix{});
+  while (static_cast<int>(pool_.size()) < pool_size)
+    pool_.push_back(IPv4Prefix{dis_(gen_) & 0x0FFFFFFF,
+            static_cast<int>(8 + dis_(gen_) % 25)});
+  static const int protos[] = {6, 17, 1, PacketRule::ANY_PROTO};
+  vector<PacketRule> rules;
+  for (int i=0; i<num_rules; ++i) {
+    PacketRule rule{static_cast<uint32_t>(i),
+          static_cast<uint32_t>(dis_(gen_) % num_rules),
+          pool_[dis_(gen_) % pool_.size()], pool_[dis_(gen_) % pool_.size()]};
+    rule.sport = port_pool_[dis_(gen_) % port_pool_.size()];
+    rule.dport = port_pool_[dis_(gen_) % port_pool_.size()];
+    rule.proto = protos[dis_(gen_) % 4];
+    rules.push_back(rule);
+  }
+  return rules;
+}
+
+PacketHeader PacketClassifierTester::Packet(const PacketRule& rule) {
+  auto addr = [this](const IPv4Prefix& p) {
+    uint32_t host = (p.size() == IPv4::MAX_LEN) ? 0 :
+        (dis_(gen_) & (0xFFFFFFFF >> p.size()));
+    return p.ip().to_scalar() | host;
+  };
+  auto port = [this](const PortRange& r) {
+    return static_cast<uint16_t>(
+        r.first + dis_(gen_) % (r.second - r.first + 1));
+  };
+  return PacketHeader{addr(rule.src), addr(rule.dst), port(rule.sport),
+        port(rule.dport), static_cast<uint8_t>(
+            (rule.proto == PacketRule::ANY_PROTO) ? dis_(gen_) % 256 :
+            rule.proto)};
+}
+
+const PacketRule* PacketClassifierTester::Linear(
+    const vector<PacketRule>& rules, const PacketHeader& hdr) {
+  const PacketRule* match_p = nullptr;
+  for (const PacketRule& rule : rules) {
+    if (((match_p == nullptr) || (rule.priority < match_p->priority)) &&
+        rule.Matches(hdr.src, hdr.dst, hdr.sport, hdr.dport, hdr.proto))
+      match_p = &rule;
+  }
+  return match_p;
+}
+
+void PacketClassifierTester::Check(const PacketClassifier& pc,
+                                   const vector<PacketRule>& rules,
+                                   const PacketHeader& hdr) {
+  const PacketRule* exp_p = Linear(rules, hdr);
+  const PacketRule* res_p = pc.Classify(hdr);
+  CHECK_EQ(exp_p == nullptr, res_p == nullptr)
+      << ((exp_p == nullptr) ? res_p : exp_p)->to_string();
+  if (exp_p != nullptr)
+    CHECK_EQ(exp_p->id, res_p->id)
+        << exp_p->to_string() << " vs " << res_p->to_string();
+}
+
+void PacketClassifierTester::SanityTest(void) {
+  PacketClassifier pc;
+  PacketHeader     hdr{IPv4{"10.1.2.3"}.to_scalar(),
+                       IPv4{"192.168.1.1"}.to_scalar(), 5000, 80, 6};
+  CHECK(pc.Classify(hdr) == nullptr);
+
+  vector<PacketRule> rules{
+    {1, 10, IPv4Prefix{"10.0.0.0", 8}, IPv4Prefix{"192.168.0.0", 16},
+     {0, 0xFFFF}, {80, 80}, 6},
+    {2, 5,  IPv4Prefix{"10.1.0.0", 16}, IPv4Prefix{}, {1024, 0xFFFF},
+     {0, 0xFFFF}, 17},
+    {3, 20, IPv4Prefix{}, IPv4Prefix{}},
+    {4, 1,  IPv4Prefix{"10.1.2.3", 32}, IPv4Prefix{"192.168.1.0", 24},
+     {4000, 4999}, {0, 0xFFFF}, PacketRule::ANY_PROTO},
+  };
+  pc.Build(rules);
+  CHECK_EQ(pc.Size(), 4);
+  CHECK_EQ(pc.Classify(hdr)->id, 1);
+  hdr.dport = 81;
+  CHECK_EQ(pc.Classify(hdr)->id, 3);
+  hdr.proto = 17;
+  CHECK_EQ(pc.Classify(hdr)->id, 2);
+  hdr.sport = 1023;
+  CHECK_EQ(pc.Classify(hdr)->id, 3);
+  hdr.sport = 4999;
+  CHECK_EQ(pc.Classify(hdr)->id, 4);
+  hdr.src++;
+  CHECK_EQ(pc.Classify(hdr)->id, 2);
+
+  // Incremental updates
+  CHECK(!pc.Insert(rules[0]));
+  CHECK(pc.Insert({5, 0, IPv4Prefix{"10.1.2.0", 24}, IPv4Prefix{}}));
+  CHECK_EQ(pc.NumPending(), 1);
+  CHECK_EQ(pc.Classify(hdr)->id, 5);
+  CHECK(pc.Erase(5));
+  CHECK(!pc.Erase(5));
+  CHECK_EQ(pc.Classify(hdr)->id, 2);
+  CHECK(pc.Erase(2));
+  CHECK_EQ(pc.Classify(hdr)->id, 3);
+  pc.Rebuild();
+  CHECK_EQ(pc.Size(), 3);
+  CHECK_EQ(pc.NumPending(), 0);
+  CHECK_EQ(pc.Classify(hdr)->id, 3);
+  CHECK(pc.Erase(3));
+  CHECK(pc.Classify(hdr) == nullptr);
+
+  LOG(INFO) << __FUNCTION__ << " passed";
+}
+
+// Compiled rules agree with a linear scan on packets matching rules &
+// random packets
+void PacketClassifierTester::RandomTest(void) {
+  for (int pool_size : {16, 256, kNumRules}) {
+    vector<PacketRule> rules = Rules(kNumRules, pool_size);
+    PacketClassifier   pc;
+    pc.Build(rules);
+    CHECK_EQ(pc.Size(), rules.size());
+    for (int i=0; i<kNumPackets; ++i) {
+      Check(pc, rules, Packet(rules[dis_(gen_) % rules.size()]));
+      Check(pc, rules, PacketHeader{
+          pool_[dis_(gen_) % pool_.size()].ip().to_scalar() | (dis_(gen_) & 0xFF),
+          dis_(gen_), static_cast<uint16_t>(dis_(gen_)),
+          static_cast<uint16_t>(dis_(gen_)), static_cast<uint8_t>(dis_(gen_))});
+    }
+    DLOG(INFO) << pc.to_string();
+  }
+
+  LOG(INFO) << __FUNCTION__ << " passed";
+}
+
+// Inserts & erases interleaved with lookups: pending & erased rules
+// trigger rebuilds
+void PacketClassifierTester::UpdateTest(void) {
+  vector<PacketRule> all   = Rules(kNumRules + kNumUpdates, 256);
+  vector<PacketRule> rules{all.begin(), all.begin() + kNumRules};
+  PacketClassifier   pc{64};
+  pc.Build(rules);
+  for (int i=0; i<kNumUpdates; ++i) {
+    if ((dis_(gen_) % 2) == 0) {
+      CHECK(pc.Insert(all[kNumRules + i]));
+      rules.push_back(all[kNumRules + i]);
+    } else {
+      size_t r = dis_(gen_) % rules.size();
+      CHECK(pc.Erase(rules[r].id));
+      rules.erase(rules.begin() + r);
+    }
+    CHECK_EQ(pc.Size(), rules.size());
+    CHECK_LE(pc.NumPending(), 64);
+    for (int j=0; j<kNumPackets/kNumUpdates; ++j)
+      Check(pc, rules, Packet(all[dis_(gen_) % all.size()]));
+  }
+
+  LOG(INFO) << __FUNCTION__ << " passed";
+}
+
+// Classification rate & build time of 1K, 10K & 100K rules: compiled vs
+// linear scan
+void PacketClassifierTester::BenchmarkTest(void) {
+  for (int num_rules : {1000, 10000, 100000}) {
+    vector<PacketRule> rules = Rules(num_rules, min(num_rules, kMaxPoolSize));
+    vector<PacketHeader> pkts;
+    pkts.reserve(kNumBenchPackets);
+    for (int i=0; i<kNumBenchPackets; ++i)
+      pkts.push_back(Packet(rules[dis_(gen_) % rules.size()]));
+
+    PacketClassifier pc;
+    Clock::TimePoint now = Clock::USecs();
+    pc.Build(rules);
+    Clock::TimeDuration durB = Clock::USecs() - now;
+
+    size_t found = 0;
+    now = Clock::USecs();
+    for (auto& hdr : pkts)
+      found += (pc.Classify(hdr) != nullptr);
+    uint64_t durC = (Clock::USecs() - now)*1000/pkts.size();
+    CHECK_EQ(found, pkts.size());
+
+    // Linear scan is slow: fewer packets
+    int num_linear = max(kNumBenchPackets/(num_rules/100), 64);
+    now = Clock::USecs();
+    for (int i=0; i<num_linear; ++i)
+      found += (Linear(rules, pkts[i]) != nullptr);
+    uint64_t durL = (Clock::USecs() - now)*1000/num_linear;
+
+    LOG(INFO) << num_rules << " rules: " << pc.to_string() << ": build "
+              << durB << "us: classify compiled/linear " << durC << "/"
+              << durL << kUnitStr << " (" << 1000.0/max(durC, uint64_t{1})
+              << " Mpps)";
+  }
+}
+
+int main(int argc, char *argv[]) {
+  Init::InitEnv(&argc, &argv);
+
+  PacketClassifierTester test{};
+  test.SanityTest();
+  test.RandomTest();
+  test.UpdateTest();
+  if (FLAGS_benchmark)
+    test.BenchmarkTest();
+
+  return 0;
+}
+
+DEFINE_bool(auto_test, false,
+            "test run programmatically (when true) or manually (when false)");
+DEFINE_bool(benchmark, false,
+            "test run when benchmarking classification against linear scan");
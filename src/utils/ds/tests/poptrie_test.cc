@@ -0,0 +1,232 @@
+// Copyright 2016 asarcar Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Author: Arijit Sarcar <sarcar_a@yahoo.com>
+
+// Standard C++ Headers
+#include <iostream>         // std::cout
+#include <random>           // std::default_random_engine
+#include <vector>           // std::vector
+// Standard C Headers
+// Google Headers
+#include <glog/logging.h>
+// Local Headers
+#include "utils/basic/basictypes.h"
+#include "utils/basic/clock.h"
+#include "utils/basic/init.h"
+#include "utils/ds/poptrie.h"
+#include "utils/ds/radix_trie.h"
+#include "utils/nwk/ipv4_prefix.h"
+
+using namespace asarcar;
+using namespace asarcar::utils;
+using namespace asarcar::utils::nwk;
+using namespace asarcar::utils::ds;
+using namespace std;
+
+// Declarations
+DECLARE_bool(auto_test);
+DECLARE_bool(benchmark);
+
+class PoptrieTester {
+ public:
+  PoptrieTester() {}
+  ~PoptrieTester() = default;
+
+  void RouteTest();
+  void RandomTest();
+  void BenchmarkTest();
+
+ private:
+  static constexpr const char* kUnitStr       = "us";
+  static constexpr int         kNumRoutes     = 20000;
+  static constexpr int         kNumLookups    = 200000;
+  static constexpr int         kNumBenchRoutes= 900000;
+  static constexpr int         kNumBenchOps   = 1 << 22;
+
+  static string LPM(const Poptrie<string>& p, const char* addr) {
+    const Poptrie<string>::KeyValue* kv_p = p.LongestPrefixMatch(IPv4{addr});
+    return (kv_p == nullptr) ? "" : kv_p->second;
+  }
+  static string LPM(const RadixTrie<IPv4Prefix, string>& rt, uint32_t addr) {
+    auto it = rt.LongestPrefixMatch(IPv4Prefix{addr, IPv4::MAX_LEN});
+    return (it == rt.End()) ? "" : it->second;
+  }
+  static string LPM(const Poptrie<string>& p, uint32_t addr) {
+    const Poptrie<string>::KeyValue* kv_p = p.LongestPrefixMatch(IPv4{addr});
+    return (kv_p == nullptr) ? "" : kv_p->second;
+  }
+  // Prefix length distribution loosely modeled on the internet routing
+  // table: /24 dominates, few prefixes shorter than /16 or longer than /24
+  static int RandLen(default_random_engine* gen_p);
+};
+
+constexpr const char* PoptrieTester::kUnitStr;
+constexpr int PoptrieTester::kNumRoutes;
+constexpr int PoptrieTester::kNumLookups;
+constexpr int PoptrieTester::kNumBenchRoutes;
+constexpr int PoptrieTester::kNumBenchOps;
+
+int PoptrieTester::RandLen(default_random_engine* gen_p) {
+  static const vector<int> kLens    = { 8, 12, 16, 17, 18, 19, 20, 21, 22,
+                                       23, 24, 26, 28, 30, 32};
+  static const vector<int> kWeights = { 1,  1, 30, 20, 30, 40, 50, 50,100,
+                                       100,560,  5,  5,  5,  3};
+  discrete_distribution<int> dis(kWeights.begin(), kWeights.end());
+  return kLens.at(dis(*gen_p));
+}
+
+void PoptrieTester::RouteTest() {
+  Poptrie<string> empty{};
+  CHECK_EQ(LPM(empty, "10.1.1.1"), "");
+
+  RadixTrie<IPv4Prefix, string> rt{};
+  rt[IPv4Prefix{"0.0.0.0", 0}]       = "default";
+  rt[IPv4Prefix{"10.0.0.0", 8}]      = "A";
+  rt[IPv4Prefix{"10.1.0.0", 16}]     = "B";
+  rt[IPv4Prefix{"10.1.2.0", 24}]     = "C";
+  rt[IPv4Prefix{"10.1.2.128", 25}]   = "D";
+  rt[IPv4Prefix{"10.1.2.129", 32}]   = "E";
+  rt[IPv4Prefix{"10.1.2.252", 30}]   = "F";
+  rt[IPv4Prefix{"192.168.0.0", 17}]  = "G";
+
+  Poptrie<string> p{rt};
+  CHECK_EQ(p.Size(), rt.Size());
+  CHECK_EQ(LPM(p, "11.1.1.1"), "default");
+  CHECK_EQ(LPM(p, "10.2.1.1"), "A");
+  CHECK_EQ(LPM(p, "10.1.1.1"), "B");
+  CHECK_EQ(LPM(p, "10.1.3.0"), "B");
+  CHECK_EQ(LPM(p, "10.1.2.0"), "C");
+  CHECK_EQ(LPM(p, "10.1.2.127"), "C");
+  CHECK_EQ(LPM(p, "10.1.2.128"), "D");
+  CHECK_EQ(LPM(p, "10.1.2.129"), "E");
+  CHECK_EQ(LPM(p, "10.1.2.130"), "D");
+  CHECK_EQ(LPM(p, "10.1.2.251"), "D");
+  CHECK_EQ(LPM(p, "10.1.2.252"), "F");
+  CHECK_EQ(LPM(p, "10.1.2.255"), "F");
+  CHECK_EQ(LPM(p, "192.168.127.255"), "G");
+  CHECK_EQ(LPM(p, "192.168.128.0"), "default");
+  const Poptrie<string>::KeyValue* kv_p = p.LongestPrefixMatch(IPv4{"10.1.2.3"});
+  CHECK(kv_p != nullptr);
+  CHECK(kv_p->first == IPv4Prefix("10.1.2.0", 24));
+  LOG(INFO) << p;
+
+  // Recompile after route withdrawal
+  rt.Erase(rt.Find(IPv4Prefix{"0.0.0.0", 0}));
+  rt.Erase(rt.Find(IPv4Prefix{"10.1.2.128", 25}));
+  p.Build(rt);
+  CHECK_EQ(LPM(p, "11.1.1.1"), "");
+  CHECK_EQ(LPM(p, "10.1.2.130"), "C");
+  CHECK_EQ(LPM(p, "10.1.2.129"), "E");
+
+  LOG(INFO) << __FUNCTION__ << " passed";
+  return;
+}
+
+// Lookups of random addresses & of the boundaries of every prefix agree
+// with RadixTrie::LongestPrefixMatch
+void PoptrieTester::RandomTest() {
+  RadixTrie<IPv4Prefix, string>      rt{};
+  default_random_engine              gen{};
+  uniform_int_distribution<uint32_t> dis{};
+  vector<IPv4Prefix>                 prefs;
+
+  for (int i=0; i<kNumRoutes; ++i) {
+    // cluster routes in a few /8s so that prefixes nest
+    uint32_t addr = (dis(gen) & 0x03FFFFFF) | 0x0C000000;
+    IPv4Prefix pref{addr, (i % 16 == 0) ? static_cast<int>(dis(gen) % 33) :
+          RandLen(&gen)};
+    rt.Insert({pref, pref.to_string()});
+    prefs.push_back(pref);
+  }
+  Poptrie<string> p{rt};
+  CHECK_EQ(p.Size(), rt.Size());
+  LOG(INFO) << p;
+
+  for (const auto& pref : prefs) {
+    uint32_t first = pref.ip().to_scalar();
+    uint32_t last  = first | (pref.size() == 0 ? 0xFFFFFFFF :
+                              ~(0xFFFFFFFF << (IPv4::MAX_LEN - pref.size())));
+    for (uint32_t addr : {first, last, first - 1, last + 1})
+      CHECK_EQ(LPM(p, addr), LPM(rt, addr)) << "addr=" << IPv4{addr};
+  }
+  for (int i=0; i<kNumLookups; ++i) {
+    uint32_t addr = (dis(gen) & 0x07FFFFFF) | 0x08000000;
+    CHECK_EQ(LPM(p, addr), LPM(rt, addr)) << "addr=" << IPv4{addr};
+  }
+
+  LOG(INFO) << __FUNCTION__ << " passed";
+  return;
+}
+
+// Synthetic internet like table: lookups of random unicast addresses by
+// one core on RadixTrie vs Poptrie
+void PoptrieTester::BenchmarkTest() {
+  RadixTrie<IPv4Prefix, void*>       rt{};
+  default_random_engine              gen{};
+  uniform_int_distribution<uint32_t> dis{0x01000000, 0xDFFFFFFF};
+
+  while (rt.Size() < kNumBenchRoutes)
+    rt.Insert({IPv4Prefix{dis(gen), RandLen(&gen)}, nullptr});
+
+  Clock::TimePoint now = Clock::USecs();
+  Poptrie<void*>   p{rt};
+  Clock::TimeDuration durB = Clock::USecs() - now;
+  LOG(INFO) << "Build: " << p << ": time " << durB << kUnitStr;
+
+  vector<uint32_t> addrs(kNumBenchOps);
+  for (auto& addr : addrs)
+    addr = dis(gen);
+
+  uint64_t found = 0;
+  now = Clock::USecs();
+  for (auto addr : addrs)
+    found += (rt.LongestPrefixMatch(IPv4Prefix{addr, IPv4::MAX_LEN}) !=
+              rt.End()) ? 1 : 0;
+  Clock::TimeDuration durR = Clock::USecs() - now;
+
+  uint64_t foundP = 0;
+  now = Clock::USecs();
+  for (auto addr : addrs)
+    foundP += (p.Lookup(addr) != Poptrie<void*>::NO_ROUTE) ? 1 : 0;
+  Clock::TimeDuration durP = Clock::USecs() - now;
+  CHECK_EQ(found, foundP);
+
+  LOG(INFO) << "Time: " << kNumBenchOps << " lookups (" << found
+            << " matched) on " << rt.Size()
+            << " prefixes for RadixTrie/Poptrie = "
+            << durR << "/" << durP << kUnitStr
+            << ": Mlookups/sec/core = "
+            << static_cast<double>(kNumBenchOps)/durR << "/"
+            << static_cast<double>(kNumBenchOps)/durP;
+
+  return;
+}
+
+int main(int argc, char *argv[]) {
+  Init::InitEnv(&argc, &argv);
+
+  PoptrieTester test{};
+  test.RouteTest();
+  test.RandomTest();
+  if (FLAGS_benchmark)
+    test.BenchmarkTest();
+
+  return 0;
+}
+
+DEFINE_bool(auto_test, false,
+            "test run programmatically (when true) or manually (when false)");
+DEFINE_bool(benchmark, false,
+            "test run when benchmarking Poptrie against RadixTrie lookups");
@@ -0,0 +1,357 @@
+// Copyright 2016 asarcar Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Author: Arijit Sarcar <sarcar_a@yahoo.com>
+
+// Standard C++ Headers
+#include <fstream>          // std::ifstream & std::ofstream
+#include <random>           // std::default_random_engine
+#include <string>           // std::string
+#include <vector>           // std::vector
+// Standard C Headers
+#include <unistd.h>         // access, getpid & unlink
+// Google Headers
+#include <glog/logging.h>
+// Local Headers
+#include "utils/basic/basictypes.h"
+#include "utils/basic/clock.h"
+#include "utils/basic/init.h"
+#include "utils/ds/radix_trie.h"
+#include "utils/ds/radix_trie_snapshot.h"
+#include "utils/ds/string_prefix.h"
+#include "utils/nwk/ipv4_prefix.h"
+
+using namespace asarcar;
+using namespace asarcar::utils;
+using namespace asarcar::utils::nwk;
+using namespace asarcar::utils::ds;
+using namespace std;
+
+// Declarations
+DECLARE_bool(auto_test);
+DECLARE_bool(benchmark);
+
+class RadixTrieSnapshotTester {
+ public:
+  RadixTrieSnapshotTester() :
+      path_{"/tmp/radix_trie_snapshot_test." + std::to_string(getpid())} {}
+  ~RadixTrieSnapshotTester() { unlink(path_.c_str()); }
+
+  void RouteTest(void);
+  void RandomTest(void);
+  void ErrorTest(void);
+  void ReplaceTest(void);
+  void BenchmarkTest(void);
+
+ private:
+  using PrefixTrie     = RadixTrie<IPv4Prefix, uint32_t>;
+  using PrefixSnapshot = RadixTrieSnapshot<IPv4Prefix, uint32_t>;
+  using StringTrie     = RadixTrie<StringPrefix, uint32_t>;
+  using StringSnapshot = RadixTrieSnapshot<StringPrefix, uint32_t>;
+
+  static constexpr const char* kUnitStr       = "us";
+  static constexpr int         kNumKeys       = 20000;
+  static constexpr int         kNumBenchRoutes= 1 << 20;
+  const string                 path_;
+
+  // Snapshot lookups of key agree with the trie: value & matched length
+  template <typename Trie, typename Snapshot, typename Key>
+  static void CheckLookup(const Trie& rt, const Snapshot& ss, const Key& key);
+};
+
+constexpr const char* RadixTrieSnapshotTester::kUnitStr;
+constexpr int RadixTrieSnapshotTester::kNumKeys;
+constexpr int RadixTrieSnapshotTester::kNumBenchRoutes;
+
+template <typename Trie, typename Snapshot, typename Key>
+void RadixTrieSnapshotTester::CheckLookup(const Trie& rt, const Snapshot& ss,
+                                          const Key& key) {
+  size_t          len = 0;
+  const uint32_t* v_p = ss.LongestPrefixMatch(key, &len);
+  auto            it  = rt.LongestPrefixMatch(key);
+  if (it == rt.End()) {
+    CHECK(v_p == nullptr) << key;
+  } else {
+    CHECK(v_p != nullptr) << key;
+    CHECK_EQ(*v_p, it->second) << key;
+    CHECK_EQ(len, it->first.size()) << key;
+  }
+  it  = rt.Find(key);
+  v_p = ss.Find(key);
+  CHECK_EQ(v_p == nullptr, it == rt.End()) << key;
+  if (v_p != nullptr)
+    CHECK_EQ(*v_p, it->second) << key;
+}
+
+void RadixTrieSnapshotTester::RouteTest(void) {
+  PrefixTrie rt;
+  rt[IPv4Prefix{"0.0.0.0", 0}]     = 1;
+  rt[IPv4Prefix{"10.0.0.0", 8}]    = 2;
+  rt[IPv4Prefix{"10.1.0.0", 16}]   = 3;
+  rt[IPv4Prefix{"10.1.2.128", 25}] = 4;
+  rt[IPv4Prefix{"192.168.0.0", 17}]= 5;
+  CHECK(PrefixSnapshot::Save(rt, path_));
+
+  PrefixSnapshot ss;
+  CHECK(!ss.IsOpen());
+  CHECK(ss.LongestPrefixMatch(IPv4Prefix{"10.1.1.1", 32}) == nullptr);
+  CHECK(ss.Open(path_));
+  CHECK_EQ(ss.Size(), rt.Size());
+  CHECK_EQ(ss.NSize(), rt.NSize());
+
+  size_t len;
+  CHECK_EQ(*ss.LongestPrefixMatch(IPv4Prefix{"11.1.1.1", 32}, &len), 1);
+  CHECK_EQ(len, 0);
+  CHECK_EQ(*ss.LongestPrefixMatch(IPv4Prefix{"10.2.1.1", 32}, &len), 2);
+  CHECK_EQ(len, 8);
+  CHECK_EQ(*ss.LongestPrefixMatch(IPv4Prefix{"10.1.2.1", 32}), 3);
+  CHECK_EQ(*ss.LongestPrefixMatch(IPv4Prefix{"10.1.2.129", 32}), 4);
+  CHECK_EQ(*ss.LongestPrefixMatch(IPv4Prefix{"192.168.128.1", 32}), 1);
+  CHECK_EQ(*ss.Find(IPv4Prefix{"10.1.0.0", 16}), 3);
+  CHECK(ss.Find(IPv4Prefix{"10.1.0.0", 17}) == nullptr);
+  CHECK(ss.Find(IPv4Prefix{"10.1.2.0", 24}) == nullptr);
+
+  // Snapshot is independent of the trie
+  rt.Clear();
+  PrefixSnapshot moved{std::move(ss)};
+  CHECK(!ss.IsOpen());
+  CHECK_EQ(*moved.LongestPrefixMatch(IPv4Prefix{"10.1.2.129", 32}), 4);
+  moved.Close();
+  CHECK_EQ(moved.Size(), 0);
+
+  // Empty trie
+  CHECK(PrefixSnapshot::Save(rt, path_));
+  CHECK(moved.Open(path_));
+  CHECK_EQ(moved.Size(), 0);
+  CHECK(moved.LongestPrefixMatch(IPv4Prefix{"10.1.2.129", 32}) == nullptr);
+
+  LOG(INFO) << __FUNCTION__ << " passed";
+}
+
+void RadixTrieSnapshotTester::RandomTest(void) {
+  default_random_engine              gen{};
+  uniform_int_distribution<uint32_t> dis{};
+  PrefixTrie                         rtp;
+  StringTrie                         rts;
+  for (int i=0; i<kNumKeys; ++i) {
+    rtp.Insert({IPv4Prefix{dis(gen) & 0x0FFFFFFF,
+            static_cast<int>(dis(gen) % 33)}, i});
+    string str = "www.host" + std::to_string(dis(gen) % kNumKeys);
+    rts.Insert({StringPrefix{str.substr(0, 1 + dis(gen) % str.size())}, i});
+  }
+
+  PrefixSnapshot ssp;
+  CHECK(PrefixSnapshot::Save(rtp, path_));
+  CHECK(ssp.Open(path_));
+  CHECK_EQ(ssp.Size(), rtp.Size());
+  for (auto it = rtp.Begin(); it != rtp.End(); ++it)
+    CheckLookup(rtp, ssp, it->first);
+  for (int i=0; i<kNumKeys; ++i)
+    CheckLookup(rtp, ssp, IPv4Prefix{dis(gen) & 0x0FFFFFFF,
+            static_cast<int>(dis(gen) % 33)});
+
+  StringSnapshot sss;
+  CHECK(StringSnapshot::Save(rts, path_));
+  CHECK(sss.Open(path_));
+  CHECK_EQ(sss.Size(), rts.Size());
+  for (auto it = rts.Begin(); it != rts.End(); ++it)
+    CheckLookup(rts, sss, it->first);
+  for (int i=0; i<kNumKeys; ++i) {
+    string str = "www.host" + std::to_string(dis(gen) % kNumKeys) + ".com";
+    CheckLookup(rts, sss, StringPrefix{std::move(str)});
+  }
+  CheckLookup(rts, sss, StringPrefix{""});
+
+  LOG(INFO) << __FUNCTION__ << " passed";
+}
+
+// Open fails on missing, truncated, corrupted or mismatched snapshots
+void RadixTrieSnapshotTester::ErrorTest(void) {
+  PrefixTrie rt;
+  for (uint32_t i=0; i<256; ++i)
+    rt.Insert({IPv4Prefix{0x0A000000u | (i << 8), 24}, i});
+  CHECK(PrefixSnapshot::Save(rt, path_));
+
+  PrefixSnapshot ss;
+  StringSnapshot sss;
+  CHECK(!ss.Open(path_ + ".missing"));
+  CHECK(!sss.Open(path_)); // key type mismatch
+  CHECK(ss.Open(path_));
+
+  string bytes;
+  {
+    ifstream inp{path_, std::ios::binary};
+    bytes.assign(istreambuf_iterator<char>{inp}, istreambuf_iterator<char>{});
+  }
+  auto write = [this](const string& data) {
+    ofstream out{path_, std::ios::binary | std::ios::trunc};
+    out.write(data.data(), data.size());
+  };
+  write(bytes.substr(0, bytes.size()/2));
+  CHECK(!ss.Open(path_));
+  CHECK(!ss.IsOpen());
+
+  string corrupt = bytes;
+  corrupt[corrupt.size() - 1] ^= 0x1;
+  write(corrupt);
+  CHECK(!ss.Open(path_));
+  CHECK(ss.Open(path_, false)); // checksum not verified
+
+  corrupt = bytes;
+  corrupt[0] ^= 0x1;
+  write(corrupt);
+  CHECK(!ss.Open(path_, false));
+
+  // num_nodes (header bytes 16-23) past the file: rejected unverified
+  corrupt = bytes;
+  corrupt.replace(16, 8, 8, '\xFF');
+  write(corrupt);
+  CHECK(!ss.Open(path_, false));
+
+  // children of root (first node) out of range: rejected when verified,
+  // unverified lookups stay within the mapping
+  corrupt = bytes;
+  corrupt.replace(80, 8, 8, '\xFF');
+  write(corrupt);
+  CHECK(!ss.Open(path_));
+  CHECK(ss.Open(path_, false));
+  for (uint32_t i=0; i<256; ++i)
+    ss.LongestPrefixMatch(IPv4Prefix{0x0A000001u | (i << 8), 32});
+
+  // node 1 (bytes 100-119) made an empty keyed self loop & the checksum
+  // (header bytes 72-79) recomputed as a crafted file would: rejected
+  // when verified, unverified lookups terminate
+  corrupt = bytes;
+  uint32_t self[] = {1, 1};
+  uint32_t zero   = 0;
+  corrupt.replace(100, sizeof(self), reinterpret_cast<const char*>(self),
+                  sizeof(self));
+  corrupt.replace(112, sizeof(zero), reinterpret_cast<const char*>(&zero),
+                  sizeof(zero));
+  uint64_t sum = 0xcbf29ce484222325ULL;  // FNV-1a of bytes after header
+  for (size_t i=80; i<corrupt.size(); ++i)
+    sum = (sum ^ static_cast<uint8_t>(corrupt[i]))*0x100000001b3ULL;
+  corrupt.replace(72, sizeof(sum), reinterpret_cast<const char*>(&sum),
+                  sizeof(sum));
+  write(corrupt);
+  CHECK(!ss.Open(path_));
+  CHECK(ss.Open(path_, false));
+  for (uint32_t i=0; i<256; ++i) {
+    ss.LongestPrefixMatch(IPv4Prefix{0x0A000001u | (i << 8), 32});
+    ss.Find(IPv4Prefix{0x0A000000u | (i << 8), 24});
+  }
+
+  LOG(INFO) << __FUNCTION__ << " passed";
+}
+
+// Save over the path of an open snapshot: the open snapshot keeps serving
+// its (old) file & a new Open sees the new file
+void RadixTrieSnapshotTester::ReplaceTest(void) {
+  PrefixTrie rt;
+  for (uint32_t i=0; i<4096; ++i)
+    rt.Insert({IPv4Prefix{0x0A000000u | (i << 8), 24}, i});
+  CHECK(PrefixSnapshot::Save(rt, path_));
+  PrefixSnapshot old_ss;
+  CHECK(old_ss.Open(path_));
+
+  PrefixTrie small;
+  small.Insert({IPv4Prefix{"192.168.0.0", 16}, 7});
+  CHECK(PrefixSnapshot::Save(small, path_));
+  CHECK(access((path_ + ".tmp").c_str(), F_OK) != 0);
+
+  // old mapping is larger than the new file: touching all of it would
+  // raise SIGBUS had the file been truncated in place
+  for (uint32_t i=0; i<4096; ++i)
+    CHECK_EQ(*old_ss.Find(IPv4Prefix{0x0A000000u | (i << 8), 24}), i);
+
+  PrefixSnapshot ss;
+  CHECK(ss.Open(path_));
+  CHECK_EQ(ss.Size(), 1);
+  CHECK_EQ(*ss.LongestPrefixMatch(IPv4Prefix{"192.168.1.1", 32}), 7);
+  CHECK(ss.LongestPrefixMatch(IPv4Prefix{"10.0.1.1", 32}) == nullptr);
+
+  // unwritable path: fails without touching path_
+  CHECK(!PrefixSnapshot::Save(small, "/nonexistent_dir/snapshot"));
+  CHECK(old_ss.Find(IPv4Prefix{"10.0.1.0", 24}) != nullptr);
+
+  LOG(INFO) << __FUNCTION__ << " passed";
+}
+
+// Cold start: rebuild trie from a text routing table vs open snapshot;
+// both followed by the first lookup
+void RadixTrieSnapshotTester::BenchmarkTest(void) {
+  default_random_engine              gen{};
+  uniform_int_distribution<uint32_t> dis{};
+  string                             text = path_ + ".txt";
+  {
+    ofstream out{text};
+    for (int i=0; i<kNumBenchRoutes; ++i)
+      out << IPv4Prefix{dis(gen), static_cast<int>(16 + dis(gen) % 17)} << " "
+          << i << "\n";
+  }
+
+  Clock::TimePoint now = Clock::USecs();
+  PrefixTrie rt;
+  {
+    ifstream inp{text};
+    string   pref;
+    uint32_t value;
+    while (inp >> pref >> value) {
+      size_t pos = pref.find('/');
+      rt.Insert({IPv4Prefix{pref.substr(0, pos), stoi(pref.substr(pos + 1))},
+              value});
+    }
+  }
+  IPv4Prefix addr{dis(gen), IPv4::MAX_LEN};
+  auto       it = rt.LongestPrefixMatch(addr);
+  Clock::TimeDuration durR = Clock::USecs() - now;
+  unlink(text.c_str());
+
+  CHECK(PrefixSnapshot::Save(rt, path_));
+  Clock::TimeDuration durO[2];
+  for (bool verify : {true, false}) {
+    now = Clock::USecs();
+    PrefixSnapshot  ss;
+    CHECK(ss.Open(path_, verify));
+    const uint32_t* v_p = ss.LongestPrefixMatch(addr);
+    durO[verify] = Clock::USecs() - now;
+    CHECK_EQ(v_p == nullptr, it == rt.End());
+    if (verify)
+      LOG(INFO) << "Snapshot: " << ss.Size() << " routes: " << ss.NSize()
+                << " nodes: " << ss.MemSize() << " bytes";
+  }
+
+  LOG(INFO) << "Cold start of " << rt.Size() << " routes + first lookup: "
+            << "rebuild from text/open verified/open unverified = "
+            << durR << "/" << durO[true] << "/" << durO[false] << kUnitStr;
+}
+
+int main(int argc, char *argv[]) {
+  Init::InitEnv(&argc, &argv);
+
+  RadixTrieSnapshotTester test{};
+  test.RouteTest();
+  test.RandomTest();
+  test.ErrorTest();
+  test.ReplaceTest();
+  if (FLAGS_benchmark)
+    test.BenchmarkTest();
+
+  return 0;
+}
+
+DEFINE_bool(auto_test, false,
+            "test run programmatically (when true) or manually (when false)");
+DEFINE_bool(benchmark, false,
+            "test run when benchmarking snapshot open against trie rebuild");
@@ -15,39 +15,79 @@
 // Author: Arijit Sarcar <sarcar_a@yahoo.com>
 
 // Standard C++ Headers
+#include <algorithm>                // std::sort
+#include <fstream>                  // std::ifstream
+#include <random>                   // std::default_random_engine
+#include <vector>                   // std::vector
 // Standard C Headers
 #include <climits>                  // CHAR_BIT
+#include <malloc.h>                 // malloc_trim
+#include <unistd.h>                 // sysconf
 // Google Headers
 #include <glog/logging.h>   
 // Local Headers
 #include "utils/basic/basictypes.h"
+#include "utils/basic/clock.h"
 #include "utils/basic/init.h"
+#include "utils/basic/slab_alloc.h"
+#include "utils/concur/thread_pool.h"
 #include "utils/ds/radix_trie.h"
 #include "utils/ds/string_prefix.h"
 #include "utils/nwk/ipv4_prefix.h"
+#include "utils/nwk/ipv6_prefix.h"
 
 using namespace asarcar;
 using namespace asarcar::utils;
+using namespace asarcar::utils::concur;
 using namespace asarcar::utils::nwk;
 using namespace asarcar::utils::ds;
 using namespace std;
 
 // Flag Declarations
 DECLARE_bool(auto_test);
+DECLARE_bool(benchmark);
 
 #define CHECK_STRINGEQ(str, cstr) CHECK_STREQ((str).c_str(), (cstr))
 
+// Trie order: a key precedes keys it prefixes, otherwise 0 bit precedes
+// 1 bit at the first mismatch
+struct TrieOrder {
+  template <typename KeyValue>
+  bool operator()(const KeyValue& a, const KeyValue& b) const {
+    size_t lcp = a.first.prefix(b.first).size();
+    if (lcp == static_cast<size_t>(b.first.size()))
+      return false;
+    return (lcp == static_cast<size_t>(a.first.size())) || !a.first[lcp];
+  }
+};
+
+template <typename Alloc>
 class RadixTrieTester {
  public:
-  using ItPrefix = ItR<IPv4Prefix,string>;
-  using ItString = ItR<StringPrefix,string>;
+  using ItPrefix = ItR<IPv4Prefix,string,Alloc>;
+  using ItString = ItR<StringPrefix,string,Alloc>;
 
   void RouteTest(void);
   void StringTest(void);
+  void ClearTest(void);
+  void BulkLoadTest(void);
+  void LPMBatchTest(void);
+  void IPv6Test(void);
+  void DiffTest(void);
 
  private:
-  RadixTrie<IPv4Prefix, string> rtpref_;
-  RadixTrie<StringPrefix, string>     rtstr_;
+  static constexpr int kNumClearRoutes = 4096;
+  static constexpr int kNumBulkKeys    = 20000;
+  static constexpr int kNumBulkThreads = 4;
+  static constexpr int kNumBatchKeys   = 300;
+  static constexpr int kNumV6Routes    = 1000;
+  static constexpr int kNumDiffKeys    = 5000;
+
+  // Loads kvs by Insert, BulkLoad & parallel BulkLoad: tries match
+  template <typename Key>
+  void BulkLoadHelper(vector<pair<Key, string>> kvs);
+  RadixTrie<IPv4Prefix, string, Alloc>   rtpref_;
+  RadixTrie<StringPrefix, string, Alloc> rtstr_;
 
   void AddRoute(const char pref[], int len, const char value[]) {
     IPv4Prefix rt{pref, len};
@@ -86,7 +126,21 @@ class RadixTrieTester {
   }
 };
 
-void RadixTrieTester::RouteTest(void) {
+template <typename Alloc>
+constexpr int RadixTrieTester<Alloc>::kNumClearRoutes;
+template <typename Alloc>
+constexpr int RadixTrieTester<Alloc>::kNumBulkKeys;
+template <typename Alloc>
+constexpr int RadixTrieTester<Alloc>::kNumBulkThreads;
+template <typename Alloc>
+constexpr int RadixTrieTester<Alloc>::kNumBatchKeys;
+template <typename Alloc>
+constexpr int RadixTrieTester<Alloc>::kNumV6Routes;
+template <typename Alloc>
+constexpr int RadixTrieTester<Alloc>::kNumDiffKeys;
+
+template <typename Alloc>
+void RadixTrieTester<Alloc>::RouteTest(void) {
   AddRoute("10.0.0.0",     8, "10.7.22.2");
   AddRoute("0.0.0.0",      0, "10.7.22.1");
   AddRoute("172.16.0.0",  16, "10.7.22.3");  
@@ -136,7 +190,8 @@ void RadixTrieTester::RouteTest(void) {
   DLOG(INFO) << "EraseRoute: All prefixes done. IPv4 Radix Trie: " << rtpref_;
 }
               
-void RadixTrieTester::StringTest(void) {
+template <typename Alloc>
+void RadixTrieTester<Alloc>::StringTest(void) {
   // Add
   rtstr_["Biswanath Dadu"] = "01-01-01";
 
@@ -160,16 +215,642 @@ void RadixTrieTester::StringTest(void) {
   DLOG(INFO) << "Longest Prefix Match \"Arijit B\"=" << lpstr;
 }
 
+// Trie is reusable after Clear: memory is reused or released
+template <typename Alloc>
+void RadixTrieTester<Alloc>::ClearTest(void) {
+  RadixTrie<IPv4Prefix, void*, Alloc> rt;
+  for (int round=0; round<2; ++round) {
+    for (int i=0; i<kNumClearRoutes; ++i)
+      CHECK(rt.Insert({IPv4Prefix{0x0A000000u | (i << 8), 24}, nullptr}).second);
+    CHECK_EQ(rt.Size(), kNumClearRoutes);
+    CHECK_GE(rt.MemSize(), rt.NSize()*sizeof(IPv4Prefix));
+    for (int i=0; i<kNumClearRoutes; i+=2)
+      rt.Erase(rt.Find(IPv4Prefix{0x0A000000u | (i << 8), 24}));
+    CHECK_EQ(rt.Size(), kNumClearRoutes/2);
+    rt.Clear();
+    CHECK_EQ(rt.Size(), 0);
+    CHECK_EQ(rt.NSize(), 0);
+    CHECK(rt.Begin() == rt.End());
+  }
+
+  rtstr_["Arijit"] = "08-08-08";
+  rtstr_.Clear();
+  CHECK(rtstr_.Find("Arijit") == rtstr_.End());
+  rtstr_["Arijit"] = "08-08-08";
+  CHECK_EQ(rtstr_.Size(), 1);
+
+  LOG(INFO) << __FUNCTION__ << " passed";
+}
+
+template <typename Alloc>
+template <typename Key>
+void RadixTrieTester<Alloc>::BulkLoadHelper(vector<pair<Key, string>> kvs) {
+  using Trie = RadixTrie<Key, string, Alloc>;
+  Trie rti;
+  for (const auto& kv : kvs)
+    rti.Insert(kv);
+  stable_sort(kvs.begin(), kvs.end(), TrieOrder{});
+
+  ThreadPool<> pool{kNumBulkThreads};
+  Trie         rtb, rtp;
+  rtb.BulkLoad(kvs);
+  rtp.BulkLoad(kvs, &pool);
+
+  for (const Trie* rt_p : {&rtb, &rtp}) {
+    CHECK_EQ(rt_p->Size(), rti.Size());
+    CHECK_EQ(rt_p->NSize(), rti.NSize());
+    auto it = rt_p->Begin();
+    for (auto iti = rti.Begin(); iti != rti.End(); ++iti, ++it) {
+      CHECK(it != rt_p->End());
+      CHECK(it->first == iti->first) << it->first << " vs " << iti->first;
+      CHECK_EQ(it->second, iti->second);
+    }
+    CHECK(it == rt_p->End());
+    for (const auto& kv : kvs) {
+      auto lpm = rt_p->LongestPrefixMatch(kv.first);
+      CHECK(lpm != rt_p->End());
+      CHECK(lpm->first == kv.first);
+    }
+  }
+
+  // Loaded trie supports updates
+  rtp.Erase(rtp.Find(kvs.back().first));
+  CHECK(rtp.Insert(kvs.back()).second);
+  CHECK_EQ(rtp.Size(), rti.Size());
+}
+
+template <typename Alloc>
+void RadixTrieTester<Alloc>::BulkLoadTest(void) {
+  RadixTrie<IPv4Prefix, string, Alloc> empty;
+  empty.BulkLoad({});
+  CHECK_EQ(empty.Size(), 0);
+
+  default_random_engine              gen{};
+  uniform_int_distribution<uint32_t> dis{};
+  vector<pair<IPv4Prefix, string>>   prefs;
+  vector<pair<StringPrefix, string>> strs;
+  prefs.push_back({IPv4Prefix{"0.0.0.0", 0}, "default"});
+  for (int i=0; i<kNumBulkKeys; ++i) {
+    // short & duplicate keys: first value in sorted order wins
+    IPv4Prefix pref{dis(gen), (i % 64 == 0) ? static_cast<int>(dis(gen) % 9) :
+          static_cast<int>(8 + dis(gen) % 25)};
+    prefs.push_back({pref, pref.to_string()});
+    if (i % 128 == 0)
+      prefs.push_back({pref, "duplicate"});
+    string str = "host" + std::to_string(dis(gen) % kNumBulkKeys);
+    strs.push_back({StringPrefix{string{str}}, str});
+    strs.push_back({StringPrefix{str.substr(0, 1 + i % 4)}, ""});
+  }
+  BulkLoadHelper(std::move(prefs));
+  BulkLoadHelper(std::move(strs));
+
+  LOG(INFO) << __FUNCTION__ << " passed";
+}
+
+// Batch lookups of every batch size agree with scalar lookups
+template <typename Alloc>
+void RadixTrieTester<Alloc>::LPMBatchTest(void) {
+  RadixTrie<IPv4Prefix, string, Alloc> rt;
+  vector<IPv4Prefix>                   keys;
+  vector<ItPrefix>                     out(kNumBatchKeys);
+  default_random_engine                gen{};
+  uniform_int_distribution<uint32_t>   dis{};
+
+  rt.LongestPrefixMatchBatch(nullptr, 0, out.data());
+  keys.emplace_back("10.1.1.1", 32);
+  rt.LongestPrefixMatchBatch(keys.data(), 1, out.data());
+  CHECK(out[0] == rt.End());
+
+  for (int i=0; i<kNumBatchKeys; ++i) {
+    uint32_t addr = 0x0A000000u | (dis(gen) & 0x00FFFFFF);
+    rt.Insert({IPv4Prefix{addr, static_cast<int>(8 + dis(gen) % 25)}, ""});
+    keys.emplace_back(addr, 32);
+    keys.emplace_back(dis(gen), static_cast<int>(dis(gen) % 33));
+  }
+  out.resize(keys.size());
+  for (size_t n : {size_t{1}, size_t{5}, rt.BATCH_WIDTH + 3, keys.size()}) {
+    rt.LongestPrefixMatchBatch(keys.data(), n, out.data());
+    for (size_t i=0; i<n; ++i)
+      CHECK(out[i] == rt.LongestPrefixMatch(keys[i])) << keys[i];
+  }
+
+  vector<StringPrefix> strs{StringPrefix{"Arijit B"}, StringPrefix{"Ari"},
+        StringPrefix{""}, StringPrefix{"Zebra"}};
+  vector<ItString>     outs(strs.size());
+  rtstr_["Arijit"] = "08-08-08";
+  rtstr_["Ar"]     = "01-01-01";
+  rtstr_.LongestPrefixMatchBatch(strs.data(), strs.size(), outs.data());
+  for (size_t i=0; i<strs.size(); ++i)
+    CHECK(outs[i] == rtstr_.LongestPrefixMatch(strs[i])) << strs[i];
+  CHECK_STRINGEQ(outs[0]->second, "08-08-08");
+  CHECK_STRINGEQ(outs[1]->second, "01-01-01");
+
+  LOG(INFO) << __FUNCTION__ << " passed";
+}
+
+// IPv6 routes: LPM agrees with a linear scan for the longest match
+template <typename Alloc>
+void RadixTrieTester<Alloc>::IPv6Test(void) {
+  RadixTrie<IPv6Prefix, string, Alloc> rt;
+  auto lpm = [&rt](const char* addr) -> string {
+    auto it = rt.LongestPrefixMatch(IPv6Prefix{addr, IPv6::MAX_LEN});
+    return (it == rt.End()) ? "" : it->second;
+  };
+  rt[IPv6Prefix{"::", 0}]                   = "default";
+  rt[IPv6Prefix{"2001:db8::", 32}]          = "A";
+  rt[IPv6Prefix{"2001:db8:1::", 48}]        = "B";
+  rt[IPv6Prefix{"2001:db8:1:2::", 64}]      = "C";
+  rt[IPv6Prefix{"2001:db8:1:2::1", 128}]    = "D";
+  rt[IPv6Prefix{"2400::", 12}]              = "E";
+  CHECK_EQ(rt.Size(), 6);
+  CHECK_STRINGEQ(lpm("2001:db9::1"), "default");
+  CHECK_STRINGEQ(lpm("2001:db8:2::1"), "A");
+  CHECK_STRINGEQ(lpm("2001:db8:1:3::1"), "B");
+  CHECK_STRINGEQ(lpm("2001:db8:1:2::2"), "C");
+  CHECK_STRINGEQ(lpm("2001:db8:1:2::1"), "D");
+  CHECK_STRINGEQ(lpm("240f:ffff::1"), "E");
+  CHECK_STRINGEQ(lpm("2410::1"), "default");
+  rt.Erase(rt.Find(IPv6Prefix{"2001:db8:1::", 48}));
+  CHECK_STRINGEQ(lpm("2001:db8:1:3::1"), "A");
+  CHECK_STRINGEQ(lpm("2001:db8:1:2::2"), "C");
+  rt.Clear();
+
+  default_random_engine              gen{};
+  uniform_int_distribution<uint64_t> dis{};
+  vector<IPv6Prefix>                 prefs;
+  for (int i=0; i<kNumV6Routes; ++i) {
+    // nest prefixes within 2001:db8::/32 & across the 64 bit halves
+    IPv6 ip{IPv6::FromHalves(0x20010DB800000000ULL | (dis(gen) >> 48),
+                             dis(gen))};
+    prefs.emplace_back(ip, static_cast<int>(32 + dis(gen) % 97));
+    rt.Insert({prefs.back(), prefs.back().to_string()});
+  }
+  for (int i=0; i<2*kNumV6Routes; ++i) {
+    IPv6Prefix addr{IPv6::FromHalves(0x20010DB800000000ULL | (dis(gen) >> 48),
+                                     dis(gen)), IPv6::MAX_LEN};
+    if (i % 2 == 0) {
+      const IPv6Prefix& pref = prefs[i/2];
+      addr = pref + addr.substr(pref.size(), IPv6::MAX_LEN - pref.size());
+    }
+    int best = -1;
+    for (const auto& pref : prefs)
+      if ((addr.prefix(pref) == pref) && (static_cast<int>(pref.size()) > best))
+        best = pref.size();
+    auto it = rt.LongestPrefixMatch(addr);
+    CHECK_EQ(it == rt.End(), best < 0) << addr;
+    if (best >= 0)
+      CHECK_EQ(static_cast<int>(it->first.size()), best) << addr;
+  }
+
+  LOG(INFO) << __FUNCTION__ << " passed";
+}
+
+// Subtree iteration, Diff of a trie against a churned copy, Apply &
+// MergeFrom
+template <typename Alloc>
+void RadixTrieTester<Alloc>::DiffTest(void) {
+  using Trie  = RadixTrie<IPv4Prefix, string, Alloc>;
+  using Delta = typename Trie::Delta;
+  Trie rt;
+  for (const auto& p : {IPv4Prefix{"0.0.0.0", 0}, IPv4Prefix{"10.0.0.0", 8},
+        IPv4Prefix{"10.1.0.0", 16}, IPv4Prefix{"10.1.2.0", 24},
+        IPv4Prefix{"10.2.0.0", 16}, IPv4Prefix{"11.0.0.0", 8}})
+    rt[p] = p.to_string();
+  auto subtree = [&rt](const IPv4Prefix& key) {
+    string str;
+    for (auto it = rt.SubtreeBegin(key); it != rt.End(); ++it)
+      str += it->second + " ";
+    return str;
+  };
+  CHECK_STRINGEQ(subtree(IPv4Prefix{"10.1.0.0", 16}),
+                 "10.1.0.0/16 10.1.2.0/24 ");
+  CHECK_STRINGEQ(subtree(IPv4Prefix{"10.1.0.0", 20}), "10.1.2.0/24 ");
+  CHECK_STRINGEQ(subtree(IPv4Prefix{"10.0.0.0", 7}),
+                 "10.0.0.0/8 10.1.0.0/16 10.1.2.0/24 10.2.0.0/16 11.0.0.0/8 ");
+  CHECK_STRINGEQ(subtree(IPv4Prefix{"12.0.0.0", 8}), "");
+  CHECK_STRINGEQ(subtree(IPv4Prefix{"10.1.2.0", 25}), "");
+  CHECK_EQ(subtree(IPv4Prefix{"0.0.0.0", 0}).size(),
+           subtree(IPv4Prefix{"10.0.0.0", 7}).size() + string{"0.0.0.0/0 "}.size());
+
+  // b: a with keys erased, modified & added (at new branch points too)
+  default_random_engine              gen{};
+  uniform_int_distribution<uint32_t> dis{};
+  Trie                               a, b;
+  vector<IPv4Prefix>                 keys;
+  for (int i=0; i<kNumDiffKeys; ++i) {
+    IPv4Prefix p{dis(gen), static_cast<int>(8 + dis(gen) % 25)};
+    a[p] = b[p] = std::to_string(i);
+    keys.push_back(p);
+  }
+  for (int i=0; i<kNumDiffKeys/10; ++i) {
+    const IPv4Prefix& p = keys[dis(gen) % keys.size()];
+    switch (dis(gen) % 3) {
+      case 0:  b.Erase(b.Find(p)); break;
+      case 1:  if (b.Find(p) != b.End()) b[p] = "modified"; break;
+      default: b[IPv4Prefix{dis(gen), static_cast<int>(dis(gen) % 33)}] = "new";
+    }
+  }
+  size_t num_add = 0, num_remove = 0, num_modify = 0;
+  for (auto it = a.Begin(); it != a.End(); ++it) {
+    auto itb = b.Find(it->first);
+    num_remove += (itb == b.End()) ? 1 : 0;
+    num_modify += ((itb != b.End()) && (itb->second != it->second)) ? 1 : 0;
+  }
+  for (auto it = b.Begin(); it != b.End(); ++it)
+    num_add += (a.Find(it->first) == a.End()) ? 1 : 0;
+
+  Delta delta;
+  Trie::Diff(a, b, &delta);
+  CHECK_EQ(delta.add.size(), num_add);
+  CHECK_EQ(delta.remove.size(), num_remove);
+  CHECK_EQ(delta.modify.size(), num_modify);
+  CHECK_GT(num_add*num_remove*num_modify, 0);
+  for (const auto& kv : delta.add)
+    CHECK(a.Find(kv.first) == a.End());
+  for (const auto& k : delta.remove)
+    CHECK(b.Find(k) == b.End());
+  for (const auto& kv : delta.modify)
+    CHECK_EQ(b.Find(kv.first)->second, kv.second);
+
+  a.Apply(std::move(delta));
+  CHECK_EQ(a.Size(), b.Size());
+  for (auto ita = a.Begin(), itb = b.Begin(); ita != a.End(); ++ita, ++itb) {
+    CHECK(ita->first == itb->first);
+    CHECK_EQ(ita->second, itb->second);
+  }
+  Delta none;
+  Trie::Diff(a, b, &none);
+  CHECK(none.add.empty() && none.remove.empty() && none.modify.empty());
+
+  // MergeFrom: value of b wins, keys only in rt are kept
+  size_t extra = 0;
+  for (auto it = rt.Begin(); it != rt.End(); ++it)
+    extra += (b.Find(it->first) == b.End()) ? 1 : 0;
+  rt.MergeFrom(b);
+  CHECK_EQ(rt.Size(), b.Size() + extra);
+  for (auto it = b.Begin(); it != b.End(); ++it)
+    CHECK_EQ(rt.Find(it->first)->second, it->second);
+
+  // MergeFrom into an empty trie copies b & into a churned copy of b
+  // matches inserting key by key: same key values & nodes
+  Trie copy, churned, inserted;
+  copy.MergeFrom(b);
+  CHECK_EQ(copy.Size(), b.Size());
+  CHECK_EQ(copy.NSize(), b.NSize());
+  for (int i=0; i<kNumDiffKeys/10; ++i) {
+    IPv4Prefix p{dis(gen), static_cast<int>(dis(gen) % 33)};
+    churned[p] = inserted[p] = "churned";
+  }
+  for (auto it = copy.Begin(); it != copy.End(); ++it)
+    if (dis(gen) % 2 == 0)
+      churned[it->first] = inserted[it->first] = "old";
+  churned.MergeFrom(copy);
+  for (auto it = copy.Begin(); it != copy.End(); ++it)
+    inserted[it->first] = it->second;
+  CHECK_EQ(churned.Size(), inserted.Size());
+  CHECK_EQ(churned.NSize(), inserted.NSize());
+  for (auto ita = churned.Begin(), itb = inserted.Begin();
+       ita != churned.End(); ++ita, ++itb) {
+    CHECK(ita->first == itb->first);
+    CHECK_EQ(ita->second, itb->second);
+  }
+
+  LOG(INFO) << __FUNCTION__ << " passed";
+}
+
+// Build time, RSS & lookup time of HeapAlloc vs SlabAlloc tries
+class RadixTrieBenchmark {
+ public:
+  void BenchmarkTest(void);
+
+ private:
+  static constexpr const char* kUnitStr     = "us";
+  static constexpr int         kNumPrefixes = 1 << 20;
+  static constexpr int         kNumStrings  = 1 << 18;
+  static constexpr int         kNumLookups  = 1 << 22;
+  static constexpr int         kNumV6Routes = 200000;
+  static constexpr int         kNumV6Blocks = 30000;
+
+  static size_t RSS(void) {
+    size_t size, resident;
+    ifstream{"/proc/self/statm"} >> size >> resident;
+    return resident*sysconf(_SC_PAGESIZE);
+  }
+  template <typename Trie, typename Key>
+  void BenchmarkHelper(const char* name, const vector<Key>& keys);
+  // Lookup time of scalar vs batch (of various sizes) LongestPrefixMatch
+  template <typename Trie>
+  void LPMBatchHelper(const char* name);
+  // Build & lookup time on a synthetic IPv6 table shaped like the
+  // internet table: allocations from RIR blocks, /48 & /32 dominate
+  template <typename Alloc>
+  void IPv6Helper(const char* name);
+  // Load time by Insert vs sequential & parallel BulkLoad
+  template <typename Trie, typename Key>
+  void BulkLoadHelper(const char* name, const vector<Key>& keys);
+  // Full table refresh with 1% churn: Diff & Apply to the live trie vs
+  // rebuild of the live trie
+  void DiffHelper(const vector<IPv4Prefix>& prefs);
+};
+
+constexpr const char* RadixTrieBenchmark::kUnitStr;
+constexpr int RadixTrieBenchmark::kNumPrefixes;
+constexpr int RadixTrieBenchmark::kNumStrings;
+constexpr int RadixTrieBenchmark::kNumLookups;
+constexpr int RadixTrieBenchmark::kNumV6Routes;
+constexpr int RadixTrieBenchmark::kNumV6Blocks;
+
+template <typename Trie, typename Key>
+void RadixTrieBenchmark::BenchmarkHelper(const char* name,
+                                         const vector<Key>& keys) {
+  malloc_trim(0);
+  size_t rss = RSS();
+  Clock::TimePoint now = Clock::USecs();
+  {
+    Trie rt;
+    for (const auto& key : keys)
+      rt.Insert({key, nullptr});
+    Clock::TimeDuration durB = Clock::USecs() - now;
+    size_t rssB = RSS() - rss;
+
+    int found = 0;
+    now = Clock::USecs();
+    for (const auto& key : keys)
+      found += (rt.LongestPrefixMatch(key) != rt.End()) ? 1 : 0;
+    Clock::TimeDuration durL = Clock::USecs() - now;
+    CHECK_EQ(found, static_cast<int>(keys.size()));
+    size_t mem = rt.MemSize();
+
+    now = Clock::USecs();
+    rt.Clear();
+    Clock::TimeDuration durC = Clock::USecs() - now;
+
+    LOG(INFO) << name << ": #keys " << keys.size()
+              << ": build/lookup/clear time " << durB << "/" << durL << "/"
+              << durC << kUnitStr << ": bytes/key MemSize/RSS "
+              << static_cast<double>(mem)/keys.size() << "/"
+              << static_cast<double>(rssB)/keys.size();
+  }
+}
+
+// Random prefixes over the whole address space: trie with kNumPrefixes
+// (~100MB of nodes) far exceeds the LLC, lookups miss at every level
+template <typename Trie>
+void RadixTrieBenchmark::LPMBatchHelper(const char* name) {
+  using It = decltype(std::declval<Trie>().End());
+  Trie                               rt;
+  default_random_engine              gen{};
+  uniform_int_distribution<uint32_t> dis{};
+  for (int i=0; i<kNumPrefixes; ++i)
+    rt.Insert({IPv4Prefix{dis(gen), static_cast<int>(16 + dis(gen) % 17)},
+          nullptr});
+  vector<IPv4Prefix> keys;
+  for (int i=0; i<kNumLookups; ++i)
+    keys.push_back(IPv4Prefix{dis(gen), IPv4::MAX_LEN});
+
+  vector<It> expected;
+  Clock::TimePoint now = Clock::USecs();
+  for (const auto& key : keys)
+    expected.push_back(rt.LongestPrefixMatch(key));
+  Clock::TimeDuration durS = Clock::USecs() - now;
+  LOG(INFO) << name << ": " << rt.Size() << " prefixes: " << kNumLookups
+            << " scalar lookups " << durS << kUnitStr << ": Mlookups/sec = "
+            << static_cast<double>(kNumLookups)/durS;
+
+  vector<It> out(kNumLookups);
+  for (size_t batch : {32, 64, 256}) {
+    now = Clock::USecs();
+    for (size_t i=0; i<keys.size(); i+=batch)
+      rt.LongestPrefixMatchBatch(&keys[i], std::min(batch, keys.size() - i),
+                                 &out[i]);
+    Clock::TimeDuration durB = Clock::USecs() - now;
+    CHECK(out == expected);
+    LOG(INFO) << name << ": batch " << batch << " lookups " << durB
+              << kUnitStr << ": Mlookups/sec = "
+              << static_cast<double>(kNumLookups)/durB;
+  }
+}
+
+template <typename Alloc>
+void RadixTrieBenchmark::IPv6Helper(const char* name) {
+  static const vector<uint64_t> kRIRs    = {0x200, 0x240, 0x260, 0x280,
+                                            0x2A0, 0x2C0}; // /12 blocks
+  static const vector<int>      kLens    = {19, 24, 28, 29, 32, 33, 34, 35,
+                                            36, 38, 40, 42, 44, 45, 46, 47,
+                                            48, 56, 64};
+  static const vector<int>      kWeights = { 1,  1,  1, 40,130, 10, 10, 10,
+                                            40, 10, 60, 10, 80, 20, 20, 20,
+                                           500, 10, 10};
+  default_random_engine              gen{};
+  uniform_int_distribution<uint64_t> dis{};
+  discrete_distribution<int>         len_dis(kWeights.begin(), kWeights.end());
+
+  // allocations: /32 in RIR blocks, more specifics are within them
+  vector<uint64_t> blocks;
+  for (int i=0; i<kNumV6Blocks; ++i)
+    blocks.push_back((kRIRs[dis(gen) % kRIRs.size()] << 52) |
+                     ((dis(gen) & 0xFFFFF) << 32));
+  vector<IPv6Prefix> prefs;
+  for (int i=0; i<kNumV6Routes; ++i) {
+    uint64_t hi = blocks[dis(gen) % blocks.size()] | (dis(gen) & 0xFFFFFFFF);
+    prefs.emplace_back(IPv6::FromHalves(hi, 0), kLens[len_dis(gen)]);
+  }
+  // 7 of 8 addresses are covered by a route
+  vector<IPv6Prefix> keys;
+  for (int i=0; i<kNumLookups; ++i) {
+    IPv6Prefix addr{IPv6::FromHalves(dis(gen) | (1ULL << 61), dis(gen)),
+          IPv6::MAX_LEN};
+    if (i % 8 != 0) {
+      const IPv6Prefix& pref = prefs[dis(gen) % prefs.size()];
+      addr = pref + addr.substr(pref.size(), IPv6::MAX_LEN - pref.size());
+    }
+    keys.push_back(addr);
+  }
+
+  malloc_trim(0);
+  size_t rss = RSS();
+  Clock::TimePoint now = Clock::USecs();
+  RadixTrie<IPv6Prefix, void*, Alloc> rt;
+  for (const auto& pref : prefs)
+    rt.Insert({pref, nullptr});
+  Clock::TimeDuration durB = Clock::USecs() - now;
+  size_t rssB = RSS() - rss;
+
+  int found = 0;
+  now = Clock::USecs();
+  for (const auto& key : keys)
+    found += (rt.LongestPrefixMatch(key) != rt.End()) ? 1 : 0;
+  Clock::TimeDuration durS = Clock::USecs() - now;
+
+  vector<ItR<IPv6Prefix, void*, Alloc>> out(keys.size());
+  now = Clock::USecs();
+  for (size_t i=0; i<keys.size(); i+=rt.BATCH_WIDTH*4)
+    rt.LongestPrefixMatchBatch(&keys[i],
+                               std::min(rt.BATCH_WIDTH*4, keys.size() - i),
+                               &out[i]);
+  Clock::TimeDuration durBt = Clock::USecs() - now;
+  int foundB = 0;
+  for (const auto& it : out)
+    foundB += (it != rt.End()) ? 1 : 0;
+  CHECK_EQ(found, foundB);
+
+  LOG(INFO) << name << ": " << rt.Size() << " routes (" << rt.NSize()
+            << " nodes): build " << durB << kUnitStr << ": bytes/route RSS "
+            << static_cast<double>(rssB)/rt.Size() << ": " << kNumLookups
+            << " lookups (" << found << " matched) scalar/batch "
+            << durS << "/" << durBt << kUnitStr << ": Mlookups/sec = "
+            << static_cast<double>(kNumLookups)/durS << "/"
+            << static_cast<double>(kNumLookups)/durBt;
+}
+
+template <typename Trie, typename Key>
+void RadixTrieBenchmark::BulkLoadHelper(const char* name,
+                                        const vector<Key>& keys) {
+  using KeyValue = typename Trie::KeyValue;
+  vector<KeyValue> kvs;
+  for (const auto& key : keys)
+    kvs.push_back({key, nullptr});
+  sort(kvs.begin(), kvs.end(), TrieOrder{});
+
+  Clock::TimePoint now = Clock::USecs();
+  {
+    Trie rt;
+    for (const auto& kv : kvs)
+      rt.Insert(kv);
+  }
+  Clock::TimeDuration durI = Clock::USecs() - now;
+
+  now = Clock::USecs();
+  {
+    Trie rt;
+    rt.BulkLoad(kvs);
+  }
+  Clock::TimeDuration durB = Clock::USecs() - now;
+
+  ThreadPool<> pool{};
+  now = Clock::USecs();
+  {
+    Trie rt;
+    rt.BulkLoad(kvs, &pool);
+  }
+  Clock::TimeDuration durP = Clock::USecs() - now;
+
+  LOG(INFO) << name << ": #sorted keys " << kvs.size()
+            << ": Insert/BulkLoad/parallel BulkLoad time (incl. clear) "
+            << durI << "/" << durB << "/" << durP << kUnitStr;
+}
+
+void RadixTrieBenchmark::DiffHelper(const vector<IPv4Prefix>& prefs) {
+  using Trie = RadixTrie<IPv4Prefix, uint32_t>;
+  default_random_engine              gen{};
+  uniform_int_distribution<uint32_t> dis{};
+  vector<Trie::KeyValue>             table, refresh;
+  for (size_t i=0; i<prefs.size(); ++i)
+    table.push_back({prefs[i], static_cast<uint32_t>(i)});
+  // 1% churn: a third each of withdrawn, changed & new routes
+  refresh = table;
+  for (size_t i=0; i<refresh.size()/100; ++i) {
+    auto& kv = refresh[dis(gen) % refresh.size()];
+    switch (i % 3) {
+      case 0:  kv.first = IPv4Prefix{dis(gen), 32}; break;
+      case 1:  kv.second = ~kv.second; break;
+      default: refresh.push_back({IPv4Prefix{dis(gen), 24}, 0}); break;
+    }
+  }
+  Trie live;
+  for (const auto& kv : table)
+    live.Insert(kv);
+
+  Clock::TimePoint now = Clock::USecs();
+  Trie next;
+  for (const auto& kv : refresh)
+    next.Insert(kv);
+  Clock::TimeDuration durB = Clock::USecs() - now;
+
+  now = Clock::USecs();
+  Trie::Delta delta;
+  Trie::Diff(live, next, &delta);
+  Clock::TimeDuration durD = Clock::USecs() - now;
+  size_t changes = delta.add.size() + delta.remove.size() + delta.modify.size();
+
+  now = Clock::USecs();
+  live.Apply(std::move(delta));
+  Clock::TimeDuration durA = Clock::USecs() - now;
+  CHECK_EQ(live.Size(), next.Size());
+
+  // Rebuild: the live trie is cleared & loaded with the refreshed table
+  now = Clock::USecs();
+  live.Clear();
+  for (const auto& kv : refresh)
+    live.Insert(kv);
+  Clock::TimeDuration durR = Clock::USecs() - now;
+
+  LOG(INFO) << "Refresh of " << live.Size() << " routes (" << changes
+            << " changed): build refresh trie " << durB << kUnitStr
+            << ": diff/apply " << durD << "/" << durA << kUnitStr
+            << " vs rebuild " << durR << kUnitStr;
+}
+
+void RadixTrieBenchmark::BenchmarkTest(void) {
+  default_random_engine              gen{};
+  uniform_int_distribution<uint32_t> dis{};
+  vector<IPv4Prefix>                 prefs;
+  vector<StringPrefix>               strs;
+  for (int i=0; i<kNumPrefixes; ++i)
+    prefs.emplace_back(dis(gen), 16 + dis(gen) % 17);
+  for (int i=0; i<kNumStrings; ++i)
+    strs.emplace_back("www.host" + std::to_string(dis(gen)) + ".com");
+
+  BenchmarkHelper<RadixTrie<IPv4Prefix, void*, HeapAlloc>>("IPv4 Heap", prefs);
+  BenchmarkHelper<RadixTrie<IPv4Prefix, void*, SlabAlloc>>("IPv4 Slab", prefs);
+  BenchmarkHelper<RadixTrie<StringPrefix, void*, HeapAlloc>>("String Heap",
+                                                             strs);
+  BenchmarkHelper<RadixTrie<StringPrefix, void*, SlabAlloc>>("String Slab",
+                                                             strs);
+
+  LPMBatchHelper<RadixTrie<IPv4Prefix, void*, HeapAlloc>>("LPM Heap");
+  LPMBatchHelper<RadixTrie<IPv4Prefix, void*, SlabAlloc>>("LPM Slab");
+  IPv6Helper<HeapAlloc>("IPv6 Heap");
+  IPv6Helper<SlabAlloc>("IPv6 Slab");
+
+  while (strs.size() < static_cast<size_t>(kNumPrefixes))
+    strs.emplace_back("www.host" + std::to_string(dis(gen)) + ".com");
+  BulkLoadHelper<RadixTrie<IPv4Prefix, void*, SlabAlloc>>("IPv4 Slab", prefs);
+  BulkLoadHelper<RadixTrie<StringPrefix, void*, SlabAlloc>>("String Slab",
+                                                            strs);
+  DiffHelper(prefs);
+}
+
 int main(int argc, char **argv) {
   Init::InitEnv(&argc, &argv);
 
-  RadixTrieTester rt;
-
+  RadixTrieTester<HeapAlloc> rt;
   rt.RouteTest();
   rt.StringTest();
+  rt.ClearTest();
+  rt.BulkLoadTest();
+  rt.LPMBatchTest();
+  rt.IPv6Test();
+  rt.DiffTest();
+
+  RadixTrieTester<SlabAlloc> rts;
+  rts.RouteTest();
+  rts.StringTest();
+  rts.ClearTest();
+  rts.BulkLoadTest();
+  rts.LPMBatchTest();
+  rts.IPv6Test();
+  rts.DiffTest();
+
+  if (FLAGS_benchmark)
+    RadixTrieBenchmark{}.BenchmarkTest();
 
   return 0;
 }
 
 DEFINE_bool(auto_test, false, 
             "test run programmatically (when true) or manually (when false)");
+DEFINE_bool(benchmark, false,
+            "test run when benchmarking heap vs slab allocated radix trie "
+            "& bulk load vs insert & batch vs scalar lookup & IPv6 table "
+            "& diff/apply vs rebuild");
@@ -15,13 +15,19 @@
 // Author: Arijit Sarcar <sarcar_a@yahoo.com>
 
 // Standard C++ Headers
+#include <algorithm>        // std::shuffle
+#include <random>           // std::default_random_engine
+#include <set>              // std::set
+#include <vector>           // std::vector
 // Standard C Headers
 // Google Headers
 #include <glog/logging.h>   
 // Local Headers
 #include "utils/basic/basictypes.h"
+#include "utils/basic/clock.h"
 #include "utils/basic/init.h"
 #include "utils/ds/skip_lists.h"
+#include "utils/ds/treap.h"
 
 using namespace asarcar;
 using namespace asarcar::utils;
@@ -29,6 +35,7 @@ using namespace std;
 
 // Flag Declarations
 DECLARE_bool(auto_test);
+DECLARE_bool(benchmark);
 
 class SkipListTester {
  public:
@@ -36,9 +43,41 @@ class SkipListTester {
   void NoNodeTest(void);
   void OneNodeTest(void);
   void FullTest(void);
+  void RandomTest(void);
+  void UnboundedTest(void);
+  void IndexTest(void);
+  void BenchmarkTest(void);
+  void UnboundedBenchmarkTest(void);
+  void PercentileBenchmarkTest(void);
  private:
+  template <typename SkipListType>
+  void RandomHelper(void);
+  template <typename SkipListType>
+  void IndexHelper(void);
+
+  static constexpr const char* kUnitStr         = "ns";
+  static constexpr uint32_t    kMaxNum          = 1 << 16;
+  static constexpr int         kNumKeys         = 60000;
+  static constexpr int         kNumRounds       = 4;
+  static constexpr int         kNumUnboundedKeys= 1 << 18;
+  static constexpr int         kNumPathSamples  = 100000;
+  static constexpr int         kNumIndexKeys    = 4096;
+  static constexpr int         kWindowSize      = 1000000;
+  static constexpr int         kNumSlides       = 1000000;
+  static constexpr int         kNumLinearQueries= 100;
 };
 
+constexpr const char* SkipListTester::kUnitStr;
+constexpr uint32_t SkipListTester::kMaxNum;
+constexpr int SkipListTester::kNumKeys;
+constexpr int SkipListTester::kNumRounds;
+constexpr int SkipListTester::kNumUnboundedKeys;
+constexpr int SkipListTester::kNumPathSamples;
+constexpr int SkipListTester::kNumIndexKeys;
+constexpr int SkipListTester::kWindowSize;
+constexpr int SkipListTester::kNumSlides;
+constexpr int SkipListTester::kNumLinearQueries;
+
 void SkipListTester::BitComputeTest(void) {
   constexpr uint32_t N = 0x01011001;
   constexpr uint32_t O = Ones(N);
@@ -166,6 +205,326 @@ void SkipListTester::FullTest(void) {
   return;
 }
 
+// Random inserts, finds & removes agree with std::set
+template <typename SkipListType>
+void SkipListTester::RandomHelper(void) {
+  default_random_engine              gen{};
+  uniform_int_distribution<uint32_t> dis{0, kNumKeys};
+  SkipListType                       s;
+  set<uint32_t>                      ref;
+  s.SetPredictableNodeLevel();
+  for (int i=0; i<kNumKeys; ++i) {
+    uint32_t val = dis(gen);
+    if ((dis(gen) % 3) == 0) {
+      auto pr = s.Remove(val);
+      CHECK_EQ(pr.second, ref.erase(val) == 1);
+      auto it = ref.upper_bound(val);
+      CHECK_EQ(pr.first == s.end(), it == ref.end());
+      if (it != ref.end())
+        CHECK_EQ(*pr.first, *it);
+    } else {
+      auto pr = s.Emplace(uint32_t{val});
+      CHECK_EQ(pr.second, ref.insert(val).second);
+      CHECK_EQ(*pr.first, val);
+    }
+    val = dis(gen);
+    CHECK_EQ(s.Find(val) != s.end(), ref.count(val) == 1);
+  }
+  CHECK_EQ(s.Size(), ref.size());
+  auto it = ref.begin();
+  for (auto itx = s.begin(); itx != s.end(); ++itx, ++it)
+    CHECK_EQ(*itx, *it);
+  CHECK(it == ref.end());
+}
+
+// Bounded & unbounded SkipList
+void SkipListTester::RandomTest(void) {
+  RandomHelper<SkipList<uint32_t,kMaxNum>>();
+  RandomHelper<SkipList<uint32_t>>();
+
+  LOG(INFO) << __FUNCTION__ << " passed";
+}
+
+// Head of an unbounded SkipList grows with log2(Size()) past 2^16 entries
+void SkipListTester::UnboundedTest(void) {
+  using SkipListType = SkipList<uint32_t>;
+  SkipListType s;
+  CHECK_EQ(s.Level(), 1);
+  CHECK_EQ(s.MaxLevel(), SkipListType::MAX_LEVELS);
+  size_t mem_size = s.MemSize();
+  CHECK(s.Find(1) == s.end());
+  CHECK_EQ(s.PathLength(1), 0);
+
+  for (uint32_t i=0; i<kNumUnboundedKeys; ++i) {
+    CHECK(s.Emplace(uint32_t{2*i}).second);
+    CHECK_LE(s.Level(), MsbOnePos(s.Size()));
+  }
+  CHECK_EQ(s.Size(), kNumUnboundedKeys);
+  CHECK_GE(s.Level(), MsbOnePos(kNumUnboundedKeys) - 4);
+  CHECK_GT(s.MemSize(), mem_size + kNumUnboundedKeys*sizeof(uint32_t));
+  uint32_t i = 0;
+  for (auto it = s.begin(); it != s.end(); ++it, i += 2)
+    CHECK_EQ(*it, i);
+  for (i=0; i<kNumUnboundedKeys; i += 97) {
+    CHECK(s.Find(2*i) != s.end());
+    CHECK(s.Find(2*i + 1) == s.end());
+    CHECK_GT(s.PathLength(2*i), 0);
+    // O(log n) path: 2 comparisons per level expected
+    CHECK_LT(s.PathLength(2*i), 8*s.Level());
+  }
+  for (i=0; i<kNumUnboundedKeys; ++i)
+    CHECK(s.Remove(2*i).second);
+  CHECK_EQ(s.Size(), 0);
+  CHECK_EQ(s.MemSize(),
+           mem_size + (s.Level() - 1)*(sizeof(void*) + sizeof(size_t)));
+
+  LOG(INFO) << __FUNCTION__ << " passed";
+}
+
+// Select, Rank & CountRange agree with a sorted vector across random
+// Emplace & Remove
+template <typename SkipListType>
+void SkipListTester::IndexHelper(void) {
+  default_random_engine              gen{};
+  uniform_int_distribution<uint32_t> dis{0, 2*kNumIndexKeys};
+  SkipListType                       s;
+  vector<uint32_t>                   ref;
+  CHECK(s.Select(0) == s.end());
+  CHECK_EQ(s.Rank(1), 0);
+  for (int i=0; i<4*kNumIndexKeys; ++i) {
+    uint32_t val = dis(gen);
+    auto     it  = lower_bound(ref.begin(), ref.end(), val);
+    bool     has = (it != ref.end() && *it == val);
+    // grow to kNumIndexKeys then shrink back
+    if ((dis(gen) % 4) < (i < 2*kNumIndexKeys ? 1 : 3)) {
+      CHECK_EQ(s.Remove(val).second, has);
+      if (has)
+        ref.erase(it);
+    } else {
+      CHECK_EQ(s.Emplace(uint32_t{val}).second, !has);
+      if (!has)
+        ref.insert(it, val);
+    }
+    CHECK_EQ(s.Size(), ref.size());
+    size_t k = dis(gen) % (ref.size() + 1);
+    auto   sit = s.Select(k);
+    CHECK_EQ(sit == s.end(), k == ref.size());
+    if (k < ref.size()) {
+      CHECK_EQ(*sit, ref[k]);
+      CHECK_EQ(s.Rank(ref[k]), k);
+    }
+    uint32_t lo = dis(gen), hi = dis(gen);
+    CHECK_EQ(s.Rank(lo), lower_bound(ref.begin(), ref.end(), lo) - ref.begin());
+    CHECK_EQ(s.CountRange(lo, hi), (lo < hi) ? 
+             lower_bound(ref.begin(), ref.end(), hi) - 
+             lower_bound(ref.begin(), ref.end(), lo) : 0);
+  }
+  for (size_t k=0; k<ref.size(); ++k)
+    CHECK_EQ(*s.Select(k), ref[k]);
+  CHECK(s.Select(ref.size()) == s.end());
+}
+
+// Bounded & unbounded SkipList
+void SkipListTester::IndexTest(void) {
+  IndexHelper<SkipList<uint32_t,kMaxNum>>();
+  IndexHelper<SkipList<uint32_t>>();
+
+  LOG(INFO) << __FUNCTION__ << " passed";
+}
+
+// Emplace, Find, iterate & Remove of random keys: SkipList vs std::set
+void SkipListTester::BenchmarkTest(void) {
+  using SkipListType = SkipList<uint32_t,kMaxNum>;
+  default_random_engine              gen{};
+  uniform_int_distribution<uint32_t> dis{};
+  vector<uint32_t>                   keys;
+  for (int i=0; i<kNumKeys; ++i)
+    keys.push_back(dis(gen));
+  vector<uint32_t>                   order{keys};
+  shuffle(order.begin(), order.end(), gen);
+
+  Clock::TimeDuration dur[2][4] = {};
+  size_t              found = 0;
+  for (int r=0; r<kNumRounds; ++r) {
+    SkipListType s;
+    Clock::TimePoint now = Clock::USecs();
+    for (auto key : keys)
+      s.Emplace(uint32_t{key});
+    dur[0][0] += Clock::USecs() - now;
+    now = Clock::USecs();
+    for (auto key : order)
+      found += (s.Find(key) != s.end());
+    dur[0][1] += Clock::USecs() - now;
+    now = Clock::USecs();
+    for (auto it = s.begin(); it != s.end(); ++it)
+      found += (*it & 0x1);
+    dur[0][2] += Clock::USecs() - now;
+    now = Clock::USecs();
+    for (auto key : order)
+      found += s.Remove(key).second;
+    dur[0][3] += Clock::USecs() - now;
+
+    set<uint32_t> ref;
+    now = Clock::USecs();
+    for (auto key : keys)
+      ref.emplace(key);
+    dur[1][0] += Clock::USecs() - now;
+    now = Clock::USecs();
+    for (auto key : order)
+      found += (ref.find(key) != ref.end());
+    dur[1][1] += Clock::USecs() - now;
+    now = Clock::USecs();
+    for (auto key : ref)
+      found += (key & 0x1);
+    dur[1][2] += Clock::USecs() - now;
+    now = Clock::USecs();
+    for (auto key : order)
+      found += ref.erase(key);
+    dur[1][3] += Clock::USecs() - now;
+  }
+  CHECK_GT(found, 0);
+
+  const char* names[] = {"SkipList", "std::set"};
+  for (int i=0; i<2; ++i) {
+    LOG(INFO) << names[i] << ": " << kNumKeys << " keys: emplace/find/iterate/"
+              << "remove = " << dur[i][0]*1000/(kNumRounds*kNumKeys) << "/"
+              << dur[i][1]*1000/(kNumRounds*kNumKeys) << "/"
+              << dur[i][2]*1000/(kNumRounds*kNumKeys) << "/"
+              << dur[i][3]*1000/(kNumRounds*kNumKeys) << kUnitStr;
+  }
+}
+
+// Unbounded SkipList vs Treap at 10^5, 10^6 & 10^7 keys: throughput,
+// search path length (nodes compared) & memory
+void SkipListTester::UnboundedBenchmarkTest(void) {
+  default_random_engine              gen{};
+  uniform_int_distribution<uint32_t> dis{};
+  for (int num_keys : {100000, 1000000, 10000000}) {
+    vector<uint32_t> keys;
+    keys.reserve(num_keys);
+    for (int i=0; i<num_keys; ++i)
+      keys.push_back(dis(gen));
+    vector<uint32_t> order{keys};
+    shuffle(order.begin(), order.end(), gen);
+
+    Clock::TimeDuration dur[2][3] = {};
+    size_t              found = 0;
+    double              path[2];
+    size_t              mem_size;
+    {
+      SkipList<uint32_t> s;
+      Clock::TimePoint now = Clock::USecs();
+      for (auto key : keys)
+        s.Emplace(uint32_t{key});
+      dur[0][0] = Clock::USecs() - now;
+      now = Clock::USecs();
+      for (auto key : order)
+        found += (s.Find(key) != s.end());
+      dur[0][1] = Clock::USecs() - now;
+      size_t len = 0;
+      for (int i=0; i<kNumPathSamples; ++i)
+        len += s.PathLength(order[i % num_keys]);
+      path[0]  = static_cast<double>(len)/kNumPathSamples;
+      mem_size = s.MemSize();
+      LOG(INFO) << "SkipList: " << s.Size() << " keys: " << s.Level()
+                << " levels: " << mem_size << " bytes";
+      now = Clock::USecs();
+      for (auto key : order)
+        found += s.Remove(key).second;
+      dur[0][2] = Clock::USecs() - now;
+    }
+    {
+      Treap<uint32_t,uint32_t> t;
+      Clock::TimePoint now = Clock::USecs();
+      for (auto key : keys)
+        t.Emplace(uint32_t{key}, uint32_t{key});
+      dur[1][0] = Clock::USecs() - now;
+      now = Clock::USecs();
+      for (auto key : order)
+        found += (t.Find(key) != t.end());
+      dur[1][1] = Clock::USecs() - now;
+      // Nodes compared by a find: depth + 1, averaged over keys
+      uint64_t len = 0;
+      t.InOrder([&len](Treap<uint32_t,uint32_t>::NodePtr, uint32_t level) {
+          len += level + 1;
+          return 1;
+        });
+      path[1] = static_cast<double>(len)/t.Size();
+      now = Clock::USecs();
+      for (auto key : order)
+        found += t.Delete(key);
+      dur[1][2] = Clock::USecs() - now;
+    }
+    CHECK_GT(found, 0);
+
+    const char* names[] = {"SkipList", "Treap"};
+    for (int i=0; i<2; ++i) {
+      LOG(INFO) << names[i] << ": " << num_keys << " keys: path " << path[i]
+                << ": emplace/find/remove = " << dur[i][0]*1000/num_keys << "/"
+                << dur[i][1]*1000/num_keys << "/" << dur[i][2]*1000/num_keys
+                << kUnitStr;
+    }
+    LOG(INFO) << "SkipList: " << static_cast<double>(mem_size)/num_keys
+              << " bytes/key";
+  }
+}
+
+// Sliding window of the last kWindowSize samples: each slide emplaces the
+// new sample & removes the oldest. p50/p90/p99 of the window by Select vs
+// a linear walk of the window.
+void SkipListTester::PercentileBenchmarkTest(void) {
+  // sample in the upper half & sequence # in the lower half keep keys unique
+  default_random_engine              gen{};
+  uniform_int_distribution<uint32_t> dis{};
+  SkipList<uint64_t>                 s;
+  vector<uint64_t>                   window(kWindowSize);
+  auto next = [&dis, &gen](uint64_t seq) {
+    return (static_cast<uint64_t>(dis(gen)) << 32) | (seq & 0xFFFFFFFF);
+  };
+  for (int i=0; i<kWindowSize; ++i) {
+    window[i] = next(i);
+    s.Emplace(uint64_t{window[i]});
+  }
+
+  constexpr double    kPercentiles[] = {0.5, 0.9, 0.99};
+  Clock::TimeDuration dur[3] = {};
+  uint64_t            sum = 0;
+  for (uint64_t i=kWindowSize; i<kWindowSize + kNumSlides; ++i) {
+    uint64_t&        oldest = window[i % kWindowSize];
+    Clock::TimePoint now = Clock::USecs();
+    s.Remove(oldest);
+    oldest = next(i);
+    s.Emplace(uint64_t{oldest});
+    dur[0] += Clock::USecs() - now;
+    now = Clock::USecs();
+    for (double p : kPercentiles)
+      sum += *s.Select(static_cast<size_t>(p*(s.Size() - 1)));
+    dur[1] += Clock::USecs() - now;
+  }
+
+  // Linear walk: same percentiles in one pass of the window
+  for (int q=0; q<kNumLinearQueries; ++q) {
+    Clock::TimePoint now = Clock::USecs();
+    size_t           k = 0, j = 0;
+    for (auto it = s.begin(); it != s.end() && j < 3; ++it, ++k) {
+      if (k == static_cast<size_t>(kPercentiles[j]*(s.Size() - 1))) {
+        CHECK_EQ(*it, *s.Select(k));
+        sum += *it;
+        ++j;
+      }
+    }
+    dur[2] += Clock::USecs() - now;
+  }
+  CHECK_GT(sum, 0);
+  CHECK_EQ(s.CountRange(0, UINT64_MAX), kWindowSize);
+
+  LOG(INFO) << "SkipList: window " << kWindowSize << ": slide (remove + "
+            << "emplace) = " << dur[0]*1000/kNumSlides << kUnitStr
+            << ": p50/p90/p99 select/linear walk = "
+            << dur[1]*1000/kNumSlides << "/"
+            << dur[2]*1000/kNumLinearQueries << kUnitStr;
+}
+
 int main(int argc, char **argv) {
   Init::InitEnv(&argc, &argv);
 
@@ -174,9 +533,20 @@ int main(int argc, char **argv) {
   st.NoNodeTest();
   st.OneNodeTest();
   st.FullTest();
+  st.RandomTest();
+  st.UnboundedTest();
+  st.IndexTest();
+  if (FLAGS_benchmark) {
+    st.BenchmarkTest();
+    st.UnboundedBenchmarkTest();
+    st.PercentileBenchmarkTest();
+  }
 
   return 0;
 }
 
 DEFINE_bool(auto_test, false, 
             "test run programmatically (when true) or manually (when false)");
+DEFINE_bool(benchmark, false,
+            "test run when benchmarking SkipList against std::set & Treap "
+            "and percentiles of a sliding window");
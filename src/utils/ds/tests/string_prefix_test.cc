@@ -15,10 +15,13 @@
 // Author: Arijit Sarcar <sarcar_a@yahoo.com>
 
 // Standard C++ Headers
+#include <random>           // std::default_random_engine
+#include <vector>           // std::vector
 // Standard C Headers
 // Google Headers
 // Local Headers
 #include "utils/basic/basictypes.h"
+#include "utils/basic/clock.h"
 #include "utils/basic/init.h"
 #include "utils/ds/string_prefix.h"
 
@@ -29,15 +32,49 @@ using namespace std;
 
 // Flag Declarations
 DECLARE_bool(auto_test);
+DECLARE_bool(benchmark);
 
 class StringPrefixTester {
  public:
   void SanityTest(void);
   void PlusSubstrTest(void);
   void PrefixTest(void);
+  void RandomTest(void);
+  void BenchmarkTest(void);
  private:
+  using Bits = vector<bool>;
+  static constexpr const char* kUnitStr      = "ns/op";
+  static constexpr int         kNumRandomOps = 2000;
+  static constexpr int         kMaxBytes     = 80;
+  static constexpr int         kNumBenchOps  = 1 << 20;
+
+  static StringPrefix RandomPrefix(default_random_engine* gen_p, int len);
+  static Bits ToBits(const StringPrefix& sp);
 };
 
+constexpr const char* StringPrefixTester::kUnitStr;
+constexpr int StringPrefixTester::kNumRandomOps;
+constexpr int StringPrefixTester::kMaxBytes;
+constexpr int StringPrefixTester::kNumBenchOps;
+
+StringPrefix StringPrefixTester::RandomPrefix(default_random_engine* gen_p,
+                                              int len) {
+  uniform_int_distribution<int> dis{0, 255};
+  string str;
+  for (int i=0; i<(len + CHAR_BIT - 1)/CHAR_BIT; ++i)
+    str.push_back(static_cast<char>(dis(*gen_p)));
+  StringPrefix sp{std::move(str)};
+  sp.resize(len);
+  return sp;
+}
+
+StringPrefixTester::Bits StringPrefixTester::ToBits(const StringPrefix& sp) {
+  Bits bits;
+  for (size_t i=0; i<sp.size(); ++i)
+    bits.push_back(sp[i]);
+  return bits;
+}
+
 void StringPrefixTester::SanityTest(void) {
   // Note r = 114; b = 98; r - b = 16 chars 
   StringPrefix spb{"b"};
@@ -138,6 +175,87 @@ void StringPrefixTester::PrefixTest(void) {
   CHECK_EQ(ad.prefix(ab).size(), 11);
 }
 
+// substr, +=, prefix, resize & == agree with a vector<bool> model across
+// byte & word boundaries
+void StringPrefixTester::RandomTest(void) {
+  default_random_engine         gen{};
+  uniform_int_distribution<int> dis{0, kMaxBytes*CHAR_BIT};
+  for (int i=0; i<kNumRandomOps; ++i) {
+    StringPrefix a    = RandomPrefix(&gen, dis(gen));
+    Bits         abits= ToBits(a);
+    int          begin= dis(gen) % (a.size() + 1);
+    int          len  = dis(gen) % (a.size() - begin + 1);
+
+    StringPrefix sub = a.substr(begin, len);
+    CHECK_EQ(sub.size(), len);
+    CHECK(ToBits(sub) == Bits(abits.begin() + begin,
+                              abits.begin() + begin + len));
+
+    StringPrefix b = RandomPrefix(&gen, dis(gen));
+    Bits         sum = ToBits(sub);
+    Bits         bbits = ToBits(b);
+    sum.insert(sum.end(), bbits.begin(), bbits.end());
+    StringPrefix c = sub + b;
+    CHECK(ToBits(c) == sum);
+    CHECK(c.substr(0, len) == sub);
+    CHECK(c.substr(len, b.size()) == b);
+
+    // b shares a prefix of random length with a
+    size_t common = dis(gen) % (a.size() + 1);
+    b = a.substr(0, common) + b;
+    size_t exp = 0;
+    Bits   b2 = ToBits(b);
+    while ((exp < abits.size()) && (exp < b2.size()) && (abits[exp] == b2[exp]))
+      ++exp;
+    CHECK_EQ(a.prefix(b).size(), exp);
+    CHECK(a.prefix(b) == b.prefix(a));
+    CHECK(a.prefix(b) == a.substr(0, exp));
+    CHECK_EQ(a == b, abits == b2);
+
+    StringPrefix r{a};
+    r.resize(len);
+    CHECK(r == a.substr(0, len));
+  }
+  LOG(INFO) << __FUNCTION__ << " passed";
+}
+
+// prefix (of keys differing in the last bit), substr (at a bit offset)
+// & += (to a key ending at a bit offset) of 8, 64 & 512 bit keys
+void StringPrefixTester::BenchmarkTest(void) {
+  default_random_engine gen{};
+  for (int len : {8, 64, 512}) {
+    StringPrefix a    = RandomPrefix(&gen, len);
+    StringPrefix b    = a.substr(0, len - 1) +
+        StringPrefix{string(1, a[len - 1] ? 0 : 0x80)}.substr(0, 1);
+    StringPrefix head = RandomPrefix(&gen, 5);
+    size_t       sum  = 0;
+
+    Clock::TimePoint now = Clock::USecs();
+    for (int i=0; i<kNumBenchOps; ++i)
+      sum += a.prefix(b).size();
+    Clock::TimeDuration durP = Clock::USecs() - now;
+    CHECK_EQ(sum, static_cast<size_t>(kNumBenchOps)*(len - 1));
+
+    now = Clock::USecs();
+    for (int i=0; i<kNumBenchOps; ++i)
+      sum += a.substr(3, len - 3).size();
+    Clock::TimeDuration durS = Clock::USecs() - now;
+
+    now = Clock::USecs();
+    for (int i=0; i<kNumBenchOps; ++i) {
+      StringPrefix c{head};
+      c += a;
+      sum += c.size();
+    }
+    Clock::TimeDuration durA = Clock::USecs() - now;
+
+    LOG(INFO) << len << " bit keys: prefix/substr/+= "
+              << 1000.0*durP/kNumBenchOps << "/"
+              << 1000.0*durS/kNumBenchOps << "/"
+              << 1000.0*durA/kNumBenchOps << kUnitStr << ": checksum " << sum;
+  }
+}
+
 int main(int argc, char **argv) {
   Init::InitEnv(&argc, &argv);
 
@@ -146,9 +264,14 @@ int main(int argc, char **argv) {
   spt.SanityTest();
   spt.PlusSubstrTest();
   spt.PrefixTest();
+  spt.RandomTest();
+  if (FLAGS_benchmark)
+    spt.BenchmarkTest();
 
   return 0;
 }
 
 DEFINE_bool(auto_test, false, 
             "test run programmatically (when true) or manually (when false)");
+DEFINE_bool(benchmark, false,
+            "test run when benchmarking prefix, substr & += of StringPrefix");
@@ -15,20 +15,34 @@
 // Author: Arijit Sarcar <sarcar_a@yahoo.com>
 
 // Standard C++ Headers
+#include <algorithm>        // std::lower_bound, std::set_union, ...
+#include <fstream>          // std::ifstream
+#include <iterator>         // std::inserter
+#include <memory>           // std::unique_ptr
+#include <random>           // std::default_random_engine
+#include <set>              // std::set
+#include <string>           // std::string
+#include <vector>           // std::vector
 // Standard C Headers
+#include <unistd.h>         // sysconf
 // Google Headers
 #include <glog/logging.h>   
 // Local Headers
 #include "utils/basic/basictypes.h"
+#include "utils/basic/clock.h"
 #include "utils/basic/init.h"
+#include "utils/basic/slab_alloc.h"
+#include "utils/concur/thread_pool.h"
 #include "utils/ds/treap.h"
 
 using namespace asarcar;
 using namespace asarcar::utils;
+using namespace asarcar::utils::concur;
 using namespace std;
 
 // Flag Declarations
 DECLARE_bool(auto_test);
+DECLARE_bool(benchmark);
 
 class TreapTester {
  public:
@@ -40,9 +54,65 @@ class TreapTester {
   void OneEntryTest(void);
   void TwoEntryTest(void);
   void FullTest(void);
+  void OrderTest(void);
+  void SplitJoinTest(void);
+  void SetOpTest(void);
+  void ForkJoinTest(void);
+  void AllocTest(void);
+  void BenchmarkTest(void);
+  void SetOpBenchmarkTest(void);
+  template <typename Alloc>
+  void ChurnBenchmarkTest(const char* name);
  private:
+  static constexpr const char* kUnitStr      = "us";
+  static constexpr int         kNumKeys      = 4096;
+  static constexpr int         kNumBenchKeys = 1 << 20;
+  static constexpr int         kNumRanges    = 64;
+  static constexpr int         kRangeSize    = 1 << 12;
+  static constexpr int         kNumSetRounds = 16;
+  static constexpr int         kNumForkRounds = 256;
+  static constexpr int         kNumThreads   = 4;
+  static constexpr size_t      kGrain        = 64;
+  static constexpr int         kNumSetKeys   = 10000000;
+  static constexpr int         kNumChurnKeys = 1 << 20;
+  static constexpr int         kNumChurnOps  = 1 << 20;
+  static constexpr int         kNumChurnRounds = 8;
+
+  // Treap walk in order agrees with ref
+  static void CheckEqual(Tt& t, const set<uint32_t>& ref);
 };
 
+constexpr const char* TreapTester::kUnitStr;
+constexpr int TreapTester::kNumKeys;
+constexpr int TreapTester::kNumBenchKeys;
+constexpr int TreapTester::kNumRanges;
+constexpr int TreapTester::kRangeSize;
+constexpr int TreapTester::kNumSetRounds;
+constexpr int TreapTester::kNumForkRounds;
+constexpr int TreapTester::kNumThreads;
+constexpr size_t TreapTester::kGrain;
+constexpr int TreapTester::kNumSetKeys;
+constexpr int TreapTester::kNumChurnKeys;
+constexpr int TreapTester::kNumChurnOps;
+constexpr int TreapTester::kNumChurnRounds;
+
+// Resident set size of the process in bytes
+static size_t RSS(void) {
+  size_t size, resident;
+  ifstream{"/proc/self/statm"} >> size >> resident;
+  return resident*sysconf(_SC_PAGESIZE);
+}
+
+void TreapTester::CheckEqual(Tt& t, const set<uint32_t>& ref) {
+  CHECK_EQ(t.Size(), ref.size());
+  auto it = ref.begin();
+  for (ItC itx = t.begin(); itx != t.end(); ++itx, ++it) {
+    CHECK(it != ref.end());
+    CHECK_EQ(*((*itx).first), *it);
+  }
+  CHECK(it == ref.end());
+}
+
 // Empty Tree Test
 void TreapTester::ZeroEntryTest(void) {
   Tt t;
@@ -171,6 +241,369 @@ void TreapTester::FullTest(void) {
   return;
 }
 
+// Select & Rank agree with a sorted vector across random Emplace & Delete
+void TreapTester::OrderTest(void) {
+  default_random_engine              gen{};
+  uniform_int_distribution<uint32_t> dis{0, 2*kNumKeys};
+  Tt                                 t;
+  vector<uint32_t>                   ref;
+  t.SetPredictablePriority();
+  CHECK(t.Select(0) == t.end());
+  CHECK_EQ(t.Rank(1), 0);
+  for (int i=0; i<4*kNumKeys; ++i) {
+    uint32_t val = dis(gen);
+    auto     it  = lower_bound(ref.begin(), ref.end(), val);
+    bool     has = (it != ref.end() && *it == val);
+    // grow to kNumKeys then shrink back
+    if ((dis(gen) % 4) < (i < 2*kNumKeys ? 1 : 3)) {
+      CHECK_EQ(t.Delete(val), has);
+      if (has)
+        ref.erase(it);
+    } else {
+      CHECK_EQ(t.Emplace(uint32_t{val}, 1.0*val).second, !has);
+      if (!has)
+        ref.insert(it, val);
+    }
+    CHECK_EQ(t.Size(), ref.size());
+    size_t k  = dis(gen) % (ref.size() + 1);
+    ItC    itx= t.Select(k);
+    CHECK_EQ(itx == t.end(), k == ref.size());
+    if (k < ref.size()) {
+      CHECK_EQ(*((*itx).first), ref[k]);
+      CHECK_EQ(t.Rank(ref[k]), k);
+    }
+    val = dis(gen);
+    CHECK_EQ(t.Rank(val), lower_bound(ref.begin(), ref.end(), val) - ref.begin());
+  }
+  for (size_t k=0; k<ref.size(); ++k)
+    CHECK_EQ(*((*t.Select(k)).first), ref[k]);
+
+  LOG(INFO) << __FUNCTION__ << " passed";
+}
+
+// Split, Join & EraseRange agree with std::set
+void TreapTester::SplitJoinTest(void) {
+  default_random_engine              gen{};
+  uniform_int_distribution<uint32_t> dis{0, 4*kNumKeys};
+  Tt                                 t;
+  set<uint32_t>                      ref;
+  for (int i=0; i<kNumKeys; ++i) {
+    uint32_t val = dis(gen);
+    t.Emplace(uint32_t{val}, 1.0*val);
+    ref.insert(val);
+  }
+
+  for (int i=0; i<kNumRanges; ++i) {
+    // Split at a random key & join back
+    uint32_t      key = dis(gen);
+    Tt            r;
+    set<uint32_t> refr{ref.lower_bound(key), ref.end()};
+    set<uint32_t> refl{ref.begin(), ref.lower_bound(key)};
+    t.Split(key, &r);
+    CheckEqual(t, refl);
+    CheckEqual(r, refr);
+    CHECK_EQ(t.Rank(key), t.Size());
+    CHECK_EQ(r.Rank(key), 0);
+    t.Join(&r);
+    CHECK_EQ(r.Size(), 0);
+    CHECK(r.begin() == r.end());
+    CheckEqual(t, ref);
+
+    // Erase a random range, reinsert half of it & keep treap searchable
+    uint32_t lo = dis(gen), hi = lo + dis(gen) % (kNumKeys/8);
+    size_t   num = distance(ref.lower_bound(lo), ref.lower_bound(hi));
+    CHECK_EQ(t.EraseRange(lo, hi), num);
+    ref.erase(ref.lower_bound(lo), ref.lower_bound(hi));
+    CHECK_EQ(t.EraseRange(hi, lo), 0);
+    CheckEqual(t, ref);
+    for (uint32_t val=lo; val<hi; val += 2) {
+      CHECK(t.Emplace(uint32_t{val}, 1.0*val).second);
+      ref.insert(val);
+    }
+    CHECK(t.Find(lo) != t.end());
+    CheckEqual(t, ref);
+  }
+
+  // Split to & join from empty treaps
+  Tt e;
+  t.Split(0, &e);
+  CHECK_EQ(t.Size(), 0);
+  t.Join(&e);
+  e.Join(&t);
+  CheckEqual(e, ref);
+  CHECK_EQ(e.EraseRange(0, UINT32_MAX), ref.size());
+  CHECK_EQ(e.Size(), 0);
+
+  LOG(INFO) << __FUNCTION__ << " passed";
+}
+
+// Union, Intersect & Difference agree with std::set: serial & on a pool
+// with a small grain. Values of this treap win for keys in both.
+void TreapTester::SetOpTest(void) {
+  default_random_engine              gen{};
+  ThreadPool<>                       pool{kNumThreads};
+  for (int i=0; i<kNumSetRounds; ++i) {
+    // sizes from empty to kNumKeys, key ranges from disjoint to overlapping
+    uniform_int_distribution<uint32_t> disa{0, 2*kNumKeys};
+    uniform_int_distribution<uint32_t> disb{static_cast<uint32_t>(i*kNumKeys/4),
+                                            static_cast<uint32_t>((i+8)*kNumKeys/4)};
+    int           numa = (i == 0) ? 0 : kNumKeys >> (i % 4);
+    int           numb = (i == 1) ? 0 : kNumKeys >> (i % 3);
+    set<uint32_t> refa, refb;
+    for (int j=0; j<numa; ++j)
+      refa.insert(disa(gen));
+    for (int j=0; j<numb; ++j)
+      refb.insert(disb(gen));
+
+    for (int op=0; op<3; ++op) {
+      Tt a, b;
+      for (auto key : refa)
+        a.Emplace(uint32_t{key}, 1.0);
+      for (auto key : refb)
+        b.Emplace(uint32_t{key}, 2.0);
+      set<uint32_t> ref;
+      Tt::Pool*     pool_p = (i % 2) ? &pool : nullptr;
+      if (op == 0) {
+        a.Union(&b, pool_p, kGrain);
+        set_union(refa.begin(), refa.end(), refb.begin(), refb.end(),
+                  inserter(ref, ref.end()));
+      } else if (op == 1) {
+        a.Intersect(&b, pool_p, kGrain);
+        set_intersection(refa.begin(), refa.end(), refb.begin(), refb.end(),
+                         inserter(ref, ref.end()));
+      } else {
+        a.Difference(&b, pool_p, kGrain);
+        set_difference(refa.begin(), refa.end(), refb.begin(), refb.end(),
+                       inserter(ref, ref.end()));
+      }
+      CHECK_EQ(b.Size(), 0);
+      CHECK(b.begin() == b.end());
+      CheckEqual(a, ref);
+      for (ItC it = a.begin(); it != a.end(); ++it)
+        CHECK_EQ(*((*it).second), refa.count(*((*it).first)) ? 1.0 : 2.0);
+      // sizes stay consistent: order statistics & further updates work
+      for (size_t k=0; k<a.Size(); k += 97)
+        CHECK_EQ(a.Rank(*((*a.Select(k)).first)), k);
+      CHECK_EQ(a.EraseRange(0, UINT32_MAX), ref.size());
+    }
+  }
+
+  LOG(INFO) << __FUNCTION__ << " passed";
+}
+
+// Many short parallel unions with a grain of 1: every fork's join latch
+// goes out of scope right after the wait while its worker counts down
+void TreapTester::ForkJoinTest(void) {
+  ThreadPool<> pool{kNumThreads};
+  for (int i=0; i<kNumForkRounds; ++i) {
+    Tt a, b;
+    for (uint32_t key=0; key<64; ++key)
+      ((key % 2) ? a : b).Emplace(uint32_t{key + i}, 1.0);
+    a.Union(&b, &pool, 1);
+    CHECK_EQ(a.Size(), 64);
+    CHECK_EQ(*((*a.begin()).first), i);
+  }
+
+  LOG(INFO) << __FUNCTION__ << " passed";
+}
+
+// Pooled nodes: deleted nodes are recycled, treaps exchanging nodes share
+// chunks & may be destroyed in any order, non trivial values are destroyed
+void TreapTester::AllocTest(void) {
+  using Ts = Treap<uint32_t,uint32_t,SlabAlloc>;
+  Ts t;
+  for (uint32_t key=0; key<kNumKeys; ++key)
+    t.Emplace(uint32_t{key}, uint32_t{key});
+  size_t mem = t.MemSize();
+  CHECK_GE(mem, kNumKeys*sizeof(uint32_t));
+  for (uint32_t key=0; key<8*kNumKeys; ++key) {
+    CHECK(t.Delete(key));
+    CHECK(t.Emplace(key + kNumKeys, uint32_t{key}).second);
+  }
+  CHECK_EQ(t.Size(), kNumKeys);
+  CHECK_EQ(t.MemSize(), mem);
+
+  // Split: receiver destroyed first. Join: giver destroyed first.
+  uint32_t lo = 8*kNumKeys, mid = lo + kNumKeys/2, hi = lo + kNumKeys;
+  {
+    Ts r;
+    t.Split(mid, &r);
+    CHECK_EQ(r.Size(), kNumKeys/2);
+    CHECK_EQ(r.MemSize(), t.MemSize());
+  }
+  CHECK_EQ(t.Size(), kNumKeys/2);
+  unique_ptr<Ts> j_p{new Ts};
+  for (uint32_t key=hi; key<hi+kNumKeys; ++key)
+    j_p->Emplace(uint32_t{key}, uint32_t{key});
+  t.Join(j_p.get());
+  j_p.reset();
+  CHECK_EQ(t.Size(), 3*kNumKeys/2);
+  CHECK_EQ(t.Rank(hi), kNumKeys/2);
+  CHECK_EQ(*((*t.Select(0)).first), lo);
+
+  // Set operations on a pool: either operand destroyed first
+  ThreadPool<> pool{kNumThreads};
+  for (int op=0; op<6; ++op) {
+    unique_ptr<Ts> a_p{new Ts}, b_p{new Ts};
+    for (uint32_t key=0; key<kNumKeys; ++key) {
+      a_p->Emplace(2*key, uint32_t{key});
+      b_p->Emplace(3*key, uint32_t{key});
+    }
+    if (op % 3 == 0)
+      a_p->Union(b_p.get(), &pool, kGrain);
+    else if (op % 3 == 1)
+      a_p->Intersect(b_p.get(), &pool, kGrain);
+    else
+      a_p->Difference(b_p.get(), &pool, kGrain);
+    CHECK_EQ(b_p->Size(), 0);
+    CHECK(a_p->Find(0) != a_p->end() || op % 3 == 2);
+    if (op < 3)
+      a_p.reset();
+    else
+      b_p.reset();
+    if (b_p != nullptr)
+      b_p->Emplace(1, 1);
+  }
+
+  Treap<uint32_t,string,SlabAlloc> v;
+  for (uint32_t key=0; key<kNumKeys; ++key)
+    v.Emplace(uint32_t{key}, string(64, 'a' + key % 26));
+  for (uint32_t key=0; key<kNumKeys; key += 2)
+    CHECK(v.Delete(key));
+  CHECK_EQ(*((*v.Find(1)).second), string(64, 'b'));
+
+  LOG(INFO) << __FUNCTION__ << " passed";
+}
+
+// EraseRange vs Delete of every key in the range & Join of a treap of
+// greater keys vs Emplace of every key
+void TreapTester::BenchmarkTest(void) {
+  using Tb = Treap<uint32_t,uint32_t>;
+  default_random_engine gen{};
+  vector<uint32_t>      keys(kNumBenchKeys);
+  for (int i=0; i<kNumBenchKeys; ++i)
+    keys[i] = 2*i;
+  shuffle(keys.begin(), keys.end(), gen);
+  Tb t[2];
+  for (auto& tr : t)
+    for (auto key : keys)
+      tr.Emplace(uint32_t{key}, uint32_t{key});
+
+  // Ranges of kRangeSize keys, one per kNumBenchKeys/kNumRanges keys
+  Clock::TimeDuration dur[2][2] = {};
+  size_t              num[2] = {};
+  for (int i=0; i<kNumRanges; ++i) {
+    uint32_t lo = 2*i*(kNumBenchKeys/kNumRanges), hi = lo + 2*kRangeSize;
+    Clock::TimePoint now = Clock::USecs();
+    num[0] += t[0].EraseRange(lo, hi);
+    dur[0][0] += Clock::USecs() - now;
+    now = Clock::USecs();
+    for (uint32_t key=lo; key<hi; key += 2)
+      num[1] += t[1].Delete(key);
+    dur[1][0] += Clock::USecs() - now;
+  }
+  CHECK_EQ(num[0], num[1]);
+  CHECK_EQ(t[0].Size(), t[1].Size());
+
+  // Append kNumRanges batches of kRangeSize keys past the last key
+  uint32_t base = 2*kNumBenchKeys;
+  for (int i=0; i<kNumRanges; ++i, base += 2*kRangeSize) {
+    Tb b;
+    for (int j=0; j<kRangeSize; ++j)
+      b.Emplace(base + 2*j, 0);
+    Clock::TimePoint now = Clock::USecs();
+    t[0].Join(&b);
+    dur[0][1] += Clock::USecs() - now;
+    now = Clock::USecs();
+    for (int j=0; j<kRangeSize; ++j)
+      t[1].Emplace(base + 2*j, 0);
+    dur[1][1] += Clock::USecs() - now;
+  }
+  CHECK_EQ(t[0].Size(), t[1].Size());
+  CHECK_EQ(t[0].Rank(base), t[0].Size());
+
+  LOG(INFO) << "Treap: " << kNumBenchKeys << " keys: " << kNumRanges
+            << " ranges of " << kRangeSize << " keys: erase range/delete = "
+            << dur[0][0]/kNumRanges << "/" << dur[1][0]/kNumRanges
+            << kUnitStr << ": join/emplace = " << dur[0][1]/kNumRanges << "/"
+            << dur[1][1]/kNumRanges << kUnitStr << " per range";
+}
+
+// Union, Intersect & Difference of two treaps of kNumSetKeys keys with
+// half the keys in common: serial vs pools of 2, 4 & 8 threads
+void TreapTester::SetOpBenchmarkTest(void) {
+  using Tb = Treap<uint32_t,uint32_t>;
+  // a: even keys, b: keys 0 or 1 mod 4, both in [0, 2*kNumSetKeys)
+  auto build = [](Tb* t_p, uint32_t mod, uint32_t rems) {
+    for (uint32_t key=0; key<2u*kNumSetKeys; ++key)
+      if ((rems >> (key % mod)) & 0x1)
+        t_p->Emplace(uint32_t{key}, uint32_t{key});
+  };
+  const char* names[] = {"union", "intersect", "difference"};
+  for (int num_threads : {1, 2, 4, 8}) {
+    unique_ptr<ThreadPool<>> pool_p;
+    if (num_threads > 1)
+      pool_p.reset(new ThreadPool<>{num_threads});
+    Clock::TimeDuration dur[3] = {};
+    for (int op=0; op<3; ++op) {
+      Tb a, b;
+      build(&a, 2, 0x1);
+      build(&b, 4, 0x3);
+      Clock::TimePoint now = Clock::USecs();
+      if (op == 0)
+        a.Union(&b, pool_p.get());
+      else if (op == 1)
+        a.Intersect(&b, pool_p.get());
+      else
+        a.Difference(&b, pool_p.get());
+      dur[op] = Clock::USecs() - now;
+      CHECK_EQ(a.Size(), (op == 0) ? 3*kNumSetKeys/2 : kNumSetKeys/2);
+      a.EraseRange(0, UINT32_MAX);
+    }
+    LOG(INFO) << "Treap: " << kNumSetKeys << " keys: " << num_threads
+              << " threads: " << names[0] << "/" << names[1] << "/"
+              << names[2] << " = " << dur[0]/1000 << "/" << dur[1]/1000
+              << "/" << dur[2]/1000 << "ms";
+  }
+}
+
+// Steady state churn: kNumChurnKeys keys, each op deletes a random key &
+// inserts a new one. Reports ops/sec & RSS per round and teardown time.
+template <typename Alloc>
+void TreapTester::ChurnBenchmarkTest(const char* name) {
+  using Tc = Treap<uint32_t,uint32_t,Alloc>;
+  default_random_engine              gen{};
+  uniform_int_distribution<uint32_t> dis{};
+  unique_ptr<Tc>                     t_p{new Tc};
+  vector<uint32_t>                   keys;
+  while (keys.size() < kNumChurnKeys) {
+    uint32_t key = dis(gen);
+    if (t_p->Emplace(uint32_t{key}, uint32_t{key}).second)
+      keys.push_back(key);
+  }
+  for (int i=0; i<kNumChurnRounds; ++i) {
+    Clock::TimePoint now = Clock::USecs();
+    for (int j=0; j<kNumChurnOps; ++j) {
+      uint32_t& key = keys[dis(gen) % kNumChurnKeys];
+      CHECK(t_p->Delete(key));
+      do {
+        key = dis(gen);
+      } while (!t_p->Emplace(uint32_t{key}, uint32_t{key}).second);
+    }
+    Clock::TimeDuration dur = Clock::USecs() - now;
+    LOG(INFO) << "Treap<" << name << ">: " << kNumChurnKeys << " keys: round "
+              << i << ": " << static_cast<double>(kNumChurnOps)/dur
+              << " Mops/s: rss "
+              << RSS()/(1 << 20) << "MB: mem "
+              << t_p->MemSize()/(1 << 20) << "MB";
+  }
+  CHECK_EQ(t_p->Size(), kNumChurnKeys);
+  Clock::TimePoint now = Clock::USecs();
+  t_p.reset();
+  LOG(INFO) << "Treap<" << name << ">: " << kNumChurnKeys << " keys: teardown "
+            << Clock::USecs() - now << kUnitStr;
+}
+
 int main(int argc, char **argv) {
   Init::InitEnv(&argc, &argv);
 
@@ -179,9 +612,22 @@ int main(int argc, char **argv) {
   tt.OneEntryTest();
   tt.TwoEntryTest();
   tt.FullTest();
+  tt.OrderTest();
+  tt.SplitJoinTest();
+  tt.SetOpTest();
+  tt.ForkJoinTest();
+  tt.AllocTest();
+  if (FLAGS_benchmark) {
+    tt.BenchmarkTest();
+    tt.SetOpBenchmarkTest();
+    tt.ChurnBenchmarkTest<HeapAlloc>("heap");
+    tt.ChurnBenchmarkTest<SlabAlloc>("slab");
+  }
 
   return 0;
 }
 
 DEFINE_bool(auto_test, false, 
             "test run programmatically (when true) or manually (when false)");
+DEFINE_bool(benchmark, false,
+            "test run when benchmarking range, set & churn operations of Treap");
@@ -22,7 +22,23 @@
 //!         - Allows to optimize access to frequently accessed data elements.
 //!           Prioritize nodes with keys/values that are accessed multiple time. 
 //!           Ensures that highly accessible nodes are accessed in fewer operations.
-//!         - Memory: One additioanl word per node for priority. 
+//!         - Memory: One additioanl word per node for priority and one for
+//!           subtree size.
+//!         - Order statistics: Select(k) & Rank(key) in log(n) using subtree
+//!           sizes.
+//!         - Split(key) & Join of key disjoint treaps in log(n): EraseRange
+//!           of k keys in log(n) + k. Split, Join, Select, Rank and
+//!           EraseRange are iterative i.e. stack depth is independent of
+//!           tree depth.
+//!         - Union, Intersect & Difference of treaps of sizes m <= n are
+//!           join based (Blelloch et al., "Just Join for Parallel Ordered
+//!           Sets"): root of higher priority splits the other treap & the
+//!           halves recurse, in parallel on a ThreadPool above a grain size.
+//!           Work O(m log(n/m + 1)), span O(log m log n).
+//!         - Nodes are allocated by the Alloc policy (utils/basic/slab_alloc.h):
+//!           HeapAlloc (default) or SlabAlloc that recycles deleted nodes in
+//!           64KB chunks & releases a treap of trivially destructible K,V
+//!           in O(#chunks).
 //!         - Thread Safety: NOT thread safe. For concurrent R/RW access use
 //!           synchronization. 
 //! @author Arijit Sarcar <sarcar_a@yahoo.com>
@@ -34,12 +50,21 @@
 #include <iomanip>          // std::setw
 #include <iostream>         // std::ostream
 #include <functional>       // std::function
+#include <limits>           // std::numeric_limits
+#include <atomic>           // std::atomic
+#include <memory>           // std::shared_ptr
 #include <random>           // std::distribution, random engine, ...
+#include <type_traits>      // std::is_trivially_destructible
+#include <utility>          // std::swap
+#include <vector>           // std::vector
 // C Standard Headers
 // Google Headers
-#include <glog/logging.h>
+#include <glog/logging.h>   // DCHECK
 // Local Headers
-#include "utils/basic/fassert.h"
+#include "utils/basic/basictypes.h"
+#include "utils/basic/slab_alloc.h"
+#include "utils/concur/barrier.h"
+#include "utils/concur/thread_pool.h"
 
 //! @addtogroup utils
 //! @{
@@ -48,43 +73,59 @@ namespace asarcar { namespace utils {
 //-----------------------------------------------------------------------------
 
 // Forward Declarations
-template <typename K, typename V>
+template <typename K, typename V, typename Alloc = HeapAlloc>
 class Treap;
 
-template <typename K, typename V>
+template <typename K, typename V, typename Alloc>
 class TreapCIter;
 
-template <typename K, typename V>
-std::ostream& operator << (std::ostream& os, const Treap<K,V>& t);
+template <typename K, typename V, typename Alloc>
+std::ostream& operator << (std::ostream& os, const Treap<K,V,Alloc>& t);
 
-template <typename K, typename V>
-std::ostream& operator << (std::ostream& os, const TreapCIter<K,V>& it);
+template <typename K, typename V, typename Alloc>
+std::ostream& operator << (std::ostream& os, const TreapCIter<K,V,Alloc>& it);
 
 // Assumed following "Concepts" defined.
 // 1. K ordering: Ki < Kj, Ki > Kj, and Ki == Kj
 // 2. K/V Initialization and Creation: Copy and Assign rval ctors 
 // 3. ostream operators defined: os << K. os << V
-template <typename K, typename V>
+template <typename K, typename V, typename Alloc>
 class Treap {
  private:
   struct Node;
  public:
   using NodePtr  = Node *;
-  using TreapPtr = const Treap<K,V>* const;
+  using TreapPtr = const Treap<K,V,Alloc>* const;
   using Priority = uint32_t;
   using AccFn    = const std::function<uint32_t(NodePtr, uint32_t)>&;
+  using Pool     = concur::ThreadPool<std::function<void(void)>>;
+
+  // Set operations recurse in parallel on subproblems of at least
+  // DEFAULT_GRAIN keys
+  static constexpr size_t DEFAULT_GRAIN = 1 << 16;
 
   Treap() : 
       _num_nodes{0}, _root{nullptr}, _seed{std::random_device{}()},
       _random{std::bind(std::uniform_int_distribution<uint32_t>
                       {1, std::numeric_limits<Priority>::max()}, 
-                      std::default_random_engine{_seed})} {} 
+                      std::default_random_engine{_seed})},
+      _alloc_p{std::make_shared<NodeAlloc>()} {} 
   ~Treap() {
-  }
+    // Sole user of a bulk free allocator releases nodes with its chunks:
+    // O(#chunks). Otherwise nodes are freed one by one i.e. recycled to
+    // the allocator still in use by other treaps.
+    alloc();
+    if (!Alloc::BULK_FREE || !std::is_trivially_destructible<K>::value ||
+        !std::is_trivially_destructible<V>::value ||
+        _alloc_p.use_count() > 1)
+      freeTree(_root);
+  }
+  Treap(const Treap&)             = delete;
+  Treap& operator =(const Treap&) = delete;
 
   // Iterator
-  friend class TreapCIter<K, V>;
-  using  ItC   = TreapCIter<K, V>;
+  friend class TreapCIter<K,V,Alloc>;
+  using  ItC   = TreapCIter<K,V,Alloc>;
   // type returned for Modify operations Emplace/Insert/Remove
   using  ModPr = std::pair<ItC,bool>; 
 
@@ -147,6 +188,102 @@ class Treap {
     return del(&_root, key);
   }
 
+  // Select: k-th smallest (k: 0 based) element or end() when k >= Size()
+  ItC Select(size_t k) const {
+    NodePtr p = _root;
+    while (p != nullptr) {
+      size_t lsz = size(p->l);
+      if (k == lsz)
+        break;
+      if (k < lsz) {
+        p = p->l;
+      } else {
+        k -= lsz + 1;
+        p  = p->r;
+      }
+    }
+    return ItC(this, _root, p);
+  }
+
+  // Rank: # keys < key i.e. 0 based position key has or would have
+  size_t Rank(const K& key) const {
+    size_t rank = 0;
+    for (NodePtr p = _root; p != nullptr; ) {
+      if (p->k < key) {
+        rank += size(p->l) + 1;
+        p     = p->r;
+      } else {
+        p     = p->l;
+      }
+    }
+    return rank;
+  }
+
+  // Split: moves keys >= key to right (must be empty): keys < key remain
+  void Split(const K& key, Treap<K,V,Alloc>* right_p) {
+    CHECK(right_p != nullptr && right_p != this && right_p->_root == nullptr);
+    // nodes moved to right stay in chunks of this allocator: share it
+    alloc();
+    right_p->_alloc_p = _alloc_p;
+    NodePtr l, r;
+    split(_root, key, &l, &r);
+    _root              = l;
+    _num_nodes         = size(l);
+    right_p->_root     = r;
+    right_p->_num_nodes= size(r);
+  }
+
+  // Join: moves all keys of right to this treap. Every key of right must be
+  // greater than every key of this treap.
+  void Join(Treap<K,V,Alloc>* right_p) {
+    CHECK(right_p != nullptr && right_p != this);
+    DCHECK(_root == nullptr || right_p->_root == nullptr ||
+           getLast(_root)->k < getFirst(right_p->_root)->k);
+    mergeAlloc(right_p);
+    _root               = join(_root, right_p->_root);
+    _num_nodes         += right_p->_num_nodes;
+    right_p->_root      = nullptr;
+    right_p->_num_nodes = 0;
+  }
+
+  // EraseRange: removes keys in [lo, hi) & returns # keys removed
+  size_t EraseRange(const K& lo, const K& hi) {
+    if (!(lo < hi))
+      return 0;
+    NodePtr l, m, r;
+    split(_root, lo, &l, &m);
+    split(m, hi, &m, &r);
+    _root = join(l, r);
+    size_t num = freeTree(m);
+    _num_nodes -= num;
+    return num;
+  }
+
+  // Set operations: consume other (left empty). Keys in both keep the value
+  // of this treap. pool_p: when set, subproblems of at least grain keys run
+  // on idle pool workers.
+  // Union: keys in this or other
+  void Union(Treap<K,V,Alloc>* other_p, Pool* pool_p = nullptr,
+             size_t grain = DEFAULT_GRAIN) {
+    Fork    f{pool_p, grain};
+    Discard d;
+    setRoot(unite(_root, takeRoot(other_p), true, &f, &d), d);
+  }
+  // Intersect: keys in this and other
+  void Intersect(Treap<K,V,Alloc>* other_p, Pool* pool_p = nullptr,
+                 size_t grain = DEFAULT_GRAIN) {
+    Fork    f{pool_p, grain};
+    Discard d;
+    setRoot(intersect(_root, takeRoot(other_p), true, &f, &d), d);
+  }
+  // Difference: keys in this and not in other
+  void Difference(Treap<K,V,Alloc>* other_p, Pool* pool_p = nullptr,
+                  size_t grain = DEFAULT_GRAIN) {
+    Fork    f{pool_p, grain};
+    Discard d;
+    setRoot(difference(_root, takeRoot(other_p), &f, &d), d);
+  }
+
   // InOrder: Inorder Traverses the tree embedded in treap
   // Executes function on every node and returns the accumulated result
   inline uint32_t InOrder(AccFn fn) const {
@@ -158,6 +295,12 @@ class Treap {
     return _num_nodes;
   }
 
+  // MemSize: bytes of nodes. Pooled allocator: bytes of all its chunks,
+  // shared with treaps this treap exchanged nodes with.
+  inline size_t MemSize(void) {
+    return alloc().MemSize(_num_nodes*sizeof(Node));
+  }
+
   // For repeatable & predictable node level generation, we 
   // generate the same seeds for random number when testing 
   // such that same random number is generated every time
@@ -170,7 +313,7 @@ class Treap {
 
   // helper function to allow chained cout cmds: example
   // cout << "Treap: " << endl << t << endl << "---------" << endl;
-  friend std::ostream& operator << <>(std::ostream& os, const Treap<K,V>& t);
+  friend std::ostream& operator << <>(std::ostream& os, const Treap<K,V,Alloc>& t);
   
  private:
   struct Node {
@@ -178,22 +321,51 @@ class Treap {
     const K   k; // immutable after creation
     V         v; // mutable
     Priority  pri; // mutable
+    size_t    sz; // # nodes in subtree rooted at node
     NodePtr   l; // left
     NodePtr   r; // right
   };
 
+  // Allocator of nodes. Treaps exchanging nodes (Split, Join & set
+  // operations) share one: allocator of the treap giving nodes away is
+  // spliced into the receiver's & forwards to it. Chunks are owned by the
+  // root of the forwarding chain & forwarders keep the root alive.
+  struct NodeAlloc {
+    Alloc                      alloc;
+    std::shared_ptr<NodeAlloc> fwd_p;
+  };
+
   uint32_t                      _num_nodes;
   NodePtr                       _root;
   Priority                      _seed;
   std::function<Priority(void)> _random;
+  std::shared_ptr<NodeAlloc>    _alloc_p;
                          
   //! Fixed seed generates predictable MC runs when running test SW or debugging
   const static uint32_t kFixedCostSeedForRandomEngine = 13607; 
 
+  // Allocator at the root of the forwarding chain: _alloc_p skips to it
+  inline Alloc& alloc(void) {
+    while (_alloc_p->fwd_p != nullptr)
+      _alloc_p = _alloc_p->fwd_p;
+    return _alloc_p->alloc;
+  }
+
+  // Nodes of other_p move to this treap: allocators are merged
+  void mergeAlloc(Treap<K,V,Alloc>* other_p) {
+    Alloc& other = other_p->alloc();
+    if (&alloc() == &other)
+      return;
+    alloc().Splice(&other);
+    other_p->_alloc_p->fwd_p = _alloc_p;
+    other_p->_alloc_p        = _alloc_p;
+  }
+
   inline NodePtr newNode(K&& key, V&& val) {
-    NodePtr np = new Node(std::move(key), std::move(val));
+    NodePtr np = alloc().template New<Node>(std::move(key), std::move(val));
     np->l   = np->r = nullptr;
     np->pri =_random();
+    np->sz  = 1;
     ++_num_nodes;
     return np;
   }
@@ -201,9 +373,305 @@ class Treap {
   inline void deleteNode(NodePtr np) {
     --_num_nodes;
     // reset fields: allows one to identify stale pointers
+    freeNode(np);
+  }
+
+  // frees node without accounting: a pooled allocator recycles it
+  static inline void freeNode(NodePtr np) {
     np->l   = np->r = nullptr;
     np->pri = 0;
-    delete np;
+    typename Alloc::template Deleter<Node>{}(np);
+  }
+
+  static inline size_t size(NodePtr np) {
+    return (np == nullptr) ? 0 : np->sz;
+  }
+
+  // recomputes subtree size of np from its children
+  static inline void update(NodePtr np) {
+    np->sz = size(np->l) + size(np->r) + 1;
+  }
+
+  //! @fn         split
+  //! @param[in]  root of subtree
+  //! @param[in]  key
+  //! @param[out] root of subtree with keys < key
+  //! @param[out] root of subtree with keys >= key (> key when m_p is set)
+  //! @param[out] when set: detached node of key or nullptr
+  //! @details    Top down: each node on the search path of key is appended
+  //!             to the left or right result i.e. path nodes end up on the
+  //!             right spine of left & the left spine of right. Sizes are
+  //!             then fixed along both spines.
+  static void split(NodePtr root, const K& key, NodePtr* l_p, NodePtr* r_p,
+                    NodePtr* m_p = nullptr) {
+    NodePtr *lslot_p = l_p, *rslot_p = r_p;
+    if (m_p != nullptr)
+      *m_p = nullptr;
+    while (root != nullptr) {
+      if (root->k < key) {
+        *lslot_p = root;
+        lslot_p  = &root->r;
+        root     = root->r;
+      } else if (m_p != nullptr && !(key < root->k)) {
+        *lslot_p = root->l;
+        *rslot_p = root->r;
+        root->l  = root->r = nullptr;
+        root->sz = 1;
+        *m_p     = root;
+        break;
+      } else {
+        *rslot_p = root;
+        rslot_p  = &root->l;
+        root     = root->l;
+      }
+    }
+    if (root == nullptr)
+      *lslot_p = *rslot_p = nullptr;
+    fixSpine(*l_p, true);
+    fixSpine(*r_p, false);
+  }
+
+  //! @fn         fixSpine
+  //! @param[in]  root of subtree
+  //! @param[in]  right spine (when true) or left spine
+  //! @details    Node size on the spine is the sum of 1 + size of the off
+  //!             spine child of itself & spine nodes below: two passes, no
+  //!             stack.
+  static void fixSpine(NodePtr root, bool right) {
+    size_t total = 0;
+    for (NodePtr p = root; p != nullptr; p = right ? p->r : p->l)
+      total += size(right ? p->l : p->r) + 1;
+    for (NodePtr p = root; p != nullptr; p = right ? p->r : p->l) {
+      p->sz  = total;
+      total -= size(right ? p->l : p->r) + 1;
+    }
+  }
+
+  //! @fn         join
+  //! @param[in]  root of subtree l
+  //! @param[in]  root of subtree r: every key of r > every key of l
+  //! @returns    root of merged subtree
+  //! @details    Top down along right spine of l & left spine of r: higher
+  //!             priority node is the next root. Its size grows by the
+  //!             size of the other subtree.
+  static NodePtr join(NodePtr l, NodePtr r) {
+    NodePtr  root;
+    NodePtr* slot_p = &root;
+    while (l != nullptr && r != nullptr) {
+      if (l->pri >= r->pri) {
+        l->sz  += r->sz;
+        *slot_p = l;
+        slot_p  = &l->r;
+        l       = l->r;
+      } else {
+        r->sz  += l->sz;
+        *slot_p = r;
+        slot_p  = &r->l;
+        r       = r->l;
+      }
+    }
+    *slot_p = (l != nullptr) ? l : r;
+    return root;
+  }
+
+  //! @fn         freeTree
+  //! @param[in]  root of subtree
+  //! @returns    # nodes deleted
+  //! @details    Right rotates until the root has no left child, then
+  //!             frees the root: no stack.
+  static size_t freeTree(NodePtr root) {
+    size_t num = 0;
+    while (root != nullptr) {
+      NodePtr p = root->l;
+      if (p != nullptr) {
+        root->l = p->r;
+        p->r    = root;
+        root    = p;
+      } else {
+        p = root->r;
+        freeNode(root);
+        root = p;
+        ++num;
+      }
+    }
+    return num;
+  }
+
+  // Fork join context of a set operation: idle counts pool workers not
+  // running a task of the operation. A task is forked only to an idle
+  // worker so a worker waiting on its fork never starves the pool.
+  struct Fork {
+    Fork(Pool* p, size_t g) :
+        pool_p{p}, grain{g},
+        idle{(p == nullptr) ? 0 : static_cast<int>(p->NumThreads())} {}
+    Pool*            pool_p;
+    size_t           grain;
+    std::atomic<int> idle;
+  };
+  // Subtrees dropped by a set operation: freed once the operation is done
+  // as the allocator need not be thread safe
+  using Discard = std::vector<NodePtr>;
+
+  // Runs lfn & rfn: rfn on an idle pool worker when work >= grain
+  template <typename LFn, typename RFn>
+  static void forkJoin(Fork* f_p, size_t work, Discard* d_p,
+                       const LFn& lfn, const RFn& rfn) {
+    int idle = (work < f_p->grain) ? 0 : f_p->idle.load();
+    while (idle > 0 && !f_p->idle.compare_exchange_weak(idle, idle - 1));
+    if (idle <= 0) {
+      lfn(d_p);
+      rfn(d_p);
+      return;
+    }
+    concur::Latch latch{1};
+    Discard       rd;
+    f_p->pool_p->AddTask([f_p, &rfn, &rd, &latch]() {
+        rfn(&rd);
+        f_p->idle.fetch_add(1);
+        latch.CountDown();
+      });
+    lfn(d_p);
+    // latch goes out of scope once Wait returns: Wait returns only after
+    // the worker's CountDown no longer touches it
+    latch.Wait();
+    d_p->insert(d_p->end(), rd.begin(), rd.end());
+  }
+
+  // drops node np (children are not dropped)
+  static inline void drop(NodePtr np, Discard* d_p) {
+    np->l = np->r = nullptr;
+    d_p->push_back(np);
+  }
+
+  // drops subtree of root
+  static inline void dropTree(NodePtr root, Discard* d_p) {
+    if (root != nullptr)
+      d_p->push_back(root);
+  }
+
+  NodePtr takeRoot(Treap<K,V,Alloc>* other_p) {
+    CHECK(other_p != nullptr && other_p != this);
+    mergeAlloc(other_p);
+    NodePtr root        = other_p->_root;
+    other_p->_root      = nullptr;
+    other_p->_num_nodes = 0;
+    return root;
+  }
+
+  // Completes a set operation of result root
+  void setRoot(NodePtr root, const Discard& d) {
+    for (NodePtr np : d)
+      freeTree(np);
+    _root      = root;
+    _num_nodes = size(root);
+  }
+
+  //! @fn         unite
+  //! @param[in]  root of subtree a
+  //! @param[in]  root of subtree b
+  //! @param[in]  values of a win for keys in both (when true) else of b
+  //! @returns    root of union: root of higher priority splits the other
+  //!             subtree & remains root of the halves' union.
+  static NodePtr unite(NodePtr a, NodePtr b, bool a_wins, Fork* f_p,
+                       Discard* d_p) {
+    if (a == nullptr)
+      return b;
+    if (b == nullptr)
+      return a;
+    if (a->pri < b->pri) {
+      std::swap(a, b);
+      a_wins = !a_wins;
+    }
+    NodePtr l, r, m;
+    split(b, a->k, &l, &r, &m);
+    if (m != nullptr) {
+      if (!a_wins)
+        a->v = std::move(m->v);
+      drop(m, d_p);
+    }
+    NodePtr al = a->l, ar = a->r;
+    forkJoin(f_p, a->sz + size(l) + size(r), d_p,
+             [&](Discard* dp) { a->l = unite(al, l, a_wins, f_p, dp); },
+             [&](Discard* dp) { a->r = unite(ar, r, a_wins, f_p, dp); });
+    update(a);
+    return a;
+  }
+
+  //! @fn         intersect
+  //! @param[in]  root of subtree a
+  //! @param[in]  root of subtree b
+  //! @param[in]  values of a win (when true) else of b
+  //! @returns    root of intersection: root of higher priority splits the
+  //!             other subtree & is kept when its key is in both.
+  static NodePtr intersect(NodePtr a, NodePtr b, bool a_wins, Fork* f_p,
+                           Discard* d_p) {
+    if (a == nullptr || b == nullptr) {
+      dropTree(a, d_p);
+      dropTree(b, d_p);
+      return nullptr;
+    }
+    if (a->pri < b->pri) {
+      std::swap(a, b);
+      a_wins = !a_wins;
+    }
+    NodePtr l, r, m;
+    split(b, a->k, &l, &r, &m);
+    NodePtr al = a->l, ar = a->r;
+    forkJoin(f_p, a->sz + size(l) + size(r), d_p,
+             [&](Discard* dp) { l = intersect(al, l, a_wins, f_p, dp); },
+             [&](Discard* dp) { r = intersect(ar, r, a_wins, f_p, dp); });
+    if (m == nullptr) {
+      drop(a, d_p);
+      return join(l, r);
+    }
+    if (!a_wins)
+      a->v = std::move(m->v);
+    drop(m, d_p);
+    a->l = l;
+    a->r = r;
+    update(a);
+    return a;
+  }
+
+  //! @fn         difference
+  //! @param[in]  root of subtree a
+  //! @param[in]  root of subtree b
+  //! @returns    root of a - b: root of higher priority splits the other
+  //!             subtree. Root of a is kept unless its key is in b.
+  static NodePtr difference(NodePtr a, NodePtr b, Fork* f_p, Discard* d_p) {
+    if (a == nullptr) {
+      dropTree(b, d_p);
+      return nullptr;
+    }
+    if (b == nullptr)
+      return a;
+    NodePtr l, r, m;
+    size_t  work = a->sz + b->sz;
+    if (a->pri >= b->pri) {
+      split(b, a->k, &l, &r, &m);
+      NodePtr al = a->l, ar = a->r;
+      forkJoin(f_p, work, d_p,
+               [&](Discard* dp) { l = difference(al, l, f_p, dp); },
+               [&](Discard* dp) { r = difference(ar, r, f_p, dp); });
+      if (m == nullptr) {
+        a->l = l;
+        a->r = r;
+        update(a);
+        return a;
+      }
+      drop(m, d_p);
+      drop(a, d_p);
+      return join(l, r);
+    }
+    split(a, b->k, &l, &r, &m);
+    NodePtr bl = b->l, br = b->r;
+    forkJoin(f_p, work, d_p,
+             [&](Discard* dp) { l = difference(l, bl, f_p, dp); },
+             [&](Discard* dp) { r = difference(r, br, f_p, dp); });
+    if (m != nullptr)
+      drop(m, d_p);
+    drop(b, d_p);
+    return join(l, r);
   }
 
   //! @fn            add
@@ -213,7 +681,7 @@ class Treap {
   //! @param[out]    result node added
   //! @returns       boolean set to true if node is added (doesn't exist before)
   bool add(NodePtr *root_p, K &&key, V &&val, NodePtr *res_p) {
-    FASSERT(root_p != nullptr);
+    DCHECK(root_p != nullptr);
     NodePtr root = *root_p;
     if (root == nullptr) {
       *root_p = *res_p = newNode(std::move(key), std::move(val));
@@ -231,6 +699,7 @@ class Treap {
     // traverse down the point where we should add the node
     if (key < root->k) {
       bool added = add(&root->l, std::move(key), std::move(val), res_p);
+      root->sz  += added;
       // "Bubble" up the node to the appropriate position in the heap
       if (root->l->pri <= root->pri)
         return added;
@@ -246,6 +715,7 @@ class Treap {
     }
     
     bool added = add(&root->r, std::move(key), std::move(val), res_p);
+    root->sz  += added;
     // "Bubble" up the node to the appropriate position in the heap
     if (root->r->pri <= root->pri)
       return added;
@@ -267,16 +737,16 @@ class Treap {
   //! @param[out]    result node added
   //! @returns       boolean set to true if node is deleted (doesn't exist before)
   bool del(NodePtr *root_p, const K& key) {
-    FASSERT(root_p != nullptr);
+    DCHECK(root_p != nullptr);
     NodePtr root = *root_p;
     if (root == nullptr)
       return false;
 
-    if (key < root->k)
-      return del(&root->l, key);
-
-    if (key > root->k)
-      return del(&root->r, key);
+    if (key < root->k || key > root->k) {
+      bool deleted = del((key < root->k) ? &root->l : &root->r, key);
+      root->sz    -= deleted;
+      return deleted;
+    }
 
     // Key found: delete the node, promote children, and maintain heap sanity
     // Node is leaf node: nothing to promote, heap sanity maintained
@@ -298,6 +768,7 @@ class Treap {
                  << lPri <<"," << rPri << ")";
       // Promote left child to maintain heap
       rotateRight(root_p);
+      --(*root_p)->sz;
       return del(&(*root_p)->r, key);
     }
 
@@ -307,6 +778,7 @@ class Treap {
                << ": Left Rotate as lPri<rPri (" 
                << lPri <<"," << rPri << ")";
     rotateLeft(root_p);
+    --(*root_p)->sz;
     return del(&(*root_p)->l, key);
   }
 
@@ -400,37 +872,44 @@ class Treap {
 
   // Left Rotation: return new root
   void rotateLeft(NodePtr* root_p) {
-    FASSERT(root_p != nullptr); 
+    DCHECK(root_p != nullptr); 
     NodePtr root = *root_p;
-    FASSERT(root != nullptr);
+    DCHECK(root != nullptr);
     NodePtr right = root->r;
-    FASSERT(right != nullptr);
+    DCHECK(right != nullptr);
     root->r = right->l;
     right->l = root;
+    right->sz = root->sz;
+    update(root);
     *root_p = right;
     return;
   }
 
   // Right Rotation: return new root
   void rotateRight(NodePtr* root_p) {
-    FASSERT(root_p != nullptr); 
+    DCHECK(root_p != nullptr); 
     NodePtr root = *root_p;
-    FASSERT(root != nullptr);
+    DCHECK(root != nullptr);
     NodePtr left = root->l;
-    FASSERT(left != nullptr);
+    DCHECK(left != nullptr);
     root->l = left->r;
     left->r = root;
+    left->sz = root->sz;
+    update(root);
     *root_p = left;
     return;
   }
 };
 
+template <typename K, typename V, typename Alloc>
+constexpr size_t Treap<K,V,Alloc>::DEFAULT_GRAIN;
+
 // Random Access Iterator for Treaps. TODO: Should have READ ONLY access 
 // to key (i.e. key attribute of T).
-template <typename K, typename V>
+template <typename K, typename V, typename Alloc>
 class TreapCIter {
  public:
-  using Tr          = Treap<K, V>;
+  using Tr          = Treap<K,V,Alloc>;
   using TreapPtr    = typename Tr::TreapPtr;
   using NodePtr     = typename Tr::NodePtr;
   using ItC         = typename Tr::ItC;
@@ -448,17 +927,17 @@ class TreapCIter {
     return *this;
   }
   inline const KVPtrPair& operator*() {
-    FASSERT(_cur != nullptr);
+    DCHECK(_cur != nullptr);
     return _kvp;
   }
   inline ItC& operator++() {
-    FASSERT(_cur != nullptr);
+    DCHECK(_cur != nullptr);
     _cur = _trp->getNext(_root, _cur->k);
     getKVP();
     return *this;
   }
   inline ItC& operator--() {
-    FASSERT(_cur != nullptr);
+    DCHECK(_cur != nullptr);
     _cur = _trp->getPrev(_root, _cur->k);
     getKVP();
     return *this;
@@ -476,7 +955,7 @@ class TreapCIter {
   }
   // helper function to allow chained cout cmds: example
   // cout << "TreapCIter: " << endl << t << endl << "---------" << endl;
-  friend std::ostream& operator << <>(std::ostream& os, const TreapCIter<K,V>& t);
+  friend std::ostream& operator << <>(std::ostream& os, const TreapCIter<K,V,Alloc>& t);
   
  private:
   TreapPtr    _trp;
@@ -492,9 +971,9 @@ class TreapCIter {
 // Treap Output
 // helper function to allow chained cout cmds: example
 // cout << "Treap: " << endl << t << endl << "---------" << endl;
-template <typename K, typename V>
-std::ostream& operator << (std::ostream& os, const Treap<K,V>& t) {
-  using NodePtr = typename Treap<K,V>::NodePtr;
+template <typename K, typename V, typename Alloc>
+std::ostream& operator << (std::ostream& os, const Treap<K,V,Alloc>& t) {
+  using NodePtr = typename Treap<K,V,Alloc>::NodePtr;
 
   os << std::endl << "#************************#" << std::endl;
   os << "# TREAP:                 #" << std::endl;
@@ -517,8 +996,8 @@ std::ostream& operator << (std::ostream& os, const Treap<K,V>& t) {
 // TreapCIter Output
 // helper function to allow chained cout cmds: example
 // cout << "Treap: " << endl << t << endl << "---------" << endl;
-template <typename K, typename V>
-std::ostream& operator << (std::ostream& os, const TreapCIter<K,V>& it) {
+template <typename K, typename V, typename Alloc>
+std::ostream& operator << (std::ostream& os, const TreapCIter<K,V,Alloc>& it) {
   os << std::hex << "TreapPtr=" << it._trp
      << ": Root=" << it._root << ": CurPtr=" << it._cur
      << ": KeyVal<" << it._kvp.first << "," << it._kvp.second << ">";
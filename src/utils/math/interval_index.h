@@ -0,0 +1,329 @@
+// Copyright 2014 asarcar Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+//! @file     interval_index.h
+//! @brief    Index of ranges answering which stored ranges overlap a query
+//! @detail   Ranges follow ComputeOverlap's convention: [from, from+length)
+//!           denoted by std::pair<from, length>, length > 0.
+//!           - Level: ranges sorted by from in one array viewed as an
+//!             implicit balanced tree (root of [lo, hi) is its mid) and
+//!             augmented with the max end of every subtree. A query [a, b)
+//!             prunes subtrees whose max end <= a and stops at the first
+//!             range with from >= b: O(log n + k log n) worst case.
+//!           - Insert buffer: up to MIN_BUFFER inserted ranges are scanned
+//!             linearly. A full buffer is sorted & carried into the levels
+//!             like a binary counter: level i is empty or holds about
+//!             MIN_BUFFER*2^i ranges; carrying into a non empty level
+//!             merges the two & moves on. O(log n) amortized insert and
+//!             O(log^2 n + k log n) query. Build & Compact leave 1 level.
+//!           - Overlaps(range)/Stabs(point) stream results through an
+//!             iterator with an explicit stack: results are not
+//!             materialized. Results of a level arrive in order of from,
+//!             levels one after another & buffered results last.
+//!           - Thread Safety: NOT thread safe. For concurrent R/RW access
+//!             use synchronization.
+//! @author   Arijit Sarcar <sarcar_a@yahoo.com>
+
+#ifndef _UTILS_MATH_INTERVAL_INDEX_H_
+#define _UTILS_MATH_INTERVAL_INDEX_H_
+
+// C++ Standard Headers
+#include <algorithm>        // std::sort, std::merge, std::max
+#include <limits>           // std::numeric_limits
+#include <utility>          // std::pair
+#include <vector>           // std::vector
+// C Standard Headers
+// Google Headers
+#include <glog/logging.h>   // DCHECK
+// Local Headers
+#include "utils/basic/basictypes.h"
+#include "utils/basic/meta.h"
+
+//! Namespace used for all math utility routines developed
+namespace asarcar { namespace utils { namespace math {
+//-----------------------------------------------------------------------------
+
+template <typename T>
+class IntervalIndex {
+  static_assert(IsIntegral<T>() && !IsSame<T, bool>(),
+                "ranges are of integral types");
+ public:
+  using Range = std::pair<T,T>;   // <from, length>
+
+  // Buffered inserts scanned linearly before carried into levels
+  static constexpr size_t MIN_BUFFER = 64;
+  // Depth of the implicit tree: log2(#ranges) + 1
+  static constexpr size_t MAX_DEPTH  = 64;
+
+ private:
+  struct Node {
+    T      from;
+    T      end;     // from + length: exclusive
+    T      maxend;  // max end of subtree rooted here: levels only
+    size_t id;
+    inline bool operator <(const Node& o) const { return from < o.from; }
+  };
+
+ public:
+  //! @class    OverlapIter
+  //! @brief    Streams ranges overlapping query [a, b): in order walk of
+  //!           each level's tree with an explicit stack, then the buffer
+  class OverlapIter {
+   public:
+    // end iterator
+    OverlapIter() : idx_p_{nullptr}, cur_p_{nullptr} {}
+    OverlapIter(const IntervalIndex* idx_p, T a, T b) :
+        idx_p_{idx_p}, a_{a}, b_{b}, level_{0}, depth_{0}, buf_i_{0},
+        cur_p_{nullptr} {
+      if (!idx_p_->levels_.empty())
+        descend(0, idx_p_->levels_[0].size());
+      advance();
+    }
+    // overlapping range <from, length>
+    inline Range operator*() const {
+      DCHECK(cur_p_ != nullptr);
+      return Range{cur_p_->from, cur_p_->end - cur_p_->from};
+    }
+    // id of overlapping range: as returned by Insert
+    inline size_t Id(void) const {
+      DCHECK(cur_p_ != nullptr);
+      return cur_p_->id;
+    }
+    inline OverlapIter& operator++() {
+      advance();
+      return *this;
+    }
+    inline bool operator==(const OverlapIter& o) const {
+      return cur_p_ == o.cur_p_;
+    }
+    inline bool operator!=(const OverlapIter& o) const {
+      return cur_p_ != o.cur_p_;
+    }
+
+   private:
+    const IntervalIndex* idx_p_;
+    T                    a_, b_;
+    size_t               level_;
+    size_t               depth_;
+    size_t               lo_[MAX_DEPTH], hi_[MAX_DEPTH]; // pending subtrees
+    size_t               buf_i_;
+    const Node*          cur_p_;
+
+    // pushes subtrees [lo, hi) along the left spine that may overlap
+    inline void descend(size_t lo, size_t hi) {
+      const Node* nodes = idx_p_->levels_[level_].data();
+      while (lo < hi) {
+        size_t mid = lo + (hi - lo)/2;
+        if (!(a_ < nodes[mid].maxend))
+          return;
+        DCHECK_LT(depth_, MAX_DEPTH);
+        lo_[depth_]   = lo;
+        hi_[depth_++] = hi;
+        hi = mid;
+      }
+    }
+    void advance(void) {
+      const std::vector<std::vector<Node>>& levels = idx_p_->levels_;
+      for (; level_ < levels.size(); ) {
+        const Node* nodes = levels[level_].data();
+        while (depth_ > 0) {
+          --depth_;
+          size_t      lo = lo_[depth_], hi = hi_[depth_];
+          size_t      mid = lo + (hi - lo)/2;
+          const Node& n = nodes[mid];
+          // n & all pending subtrees start at or past b
+          if (!(n.from < b_)) {
+            depth_ = 0;
+            break;
+          }
+          descend(mid + 1, hi);
+          if (a_ < n.end) {
+            cur_p_ = &n;
+            return;
+          }
+        }
+        if (++level_ < levels.size())
+          descend(0, levels[level_].size());
+      }
+      const std::vector<Node>& buf = idx_p_->buffer_;
+      while (buf_i_ < buf.size()) {
+        const Node& n = buf[buf_i_++];
+        if (n.from < b_ && a_ < n.end) {
+          cur_p_ = &n;
+          return;
+        }
+      }
+      cur_p_ = nullptr;
+    }
+  };
+
+  // Results of a query: for (auto it = q.begin(); it != q.end(); ++it)
+  class Query {
+   public:
+    Query(const IntervalIndex* idx_p, T a, T b) :
+        idx_p_{idx_p}, a_{a}, b_{b} {}
+    inline OverlapIter begin(void) const { return OverlapIter{idx_p_, a_, b_}; }
+    inline OverlapIter end(void)   const { return OverlapIter{}; }
+   private:
+    const IntervalIndex* idx_p_;
+    T                    a_, b_;
+  };
+
+  IntervalIndex() = default;
+  ~IntervalIndex() = default;
+  IntervalIndex(const IntervalIndex&)             = delete;
+  IntervalIndex& operator =(const IntervalIndex&) = delete;
+
+  //! @brief  replaces the index with ranges: range i gets id i.
+  //!         O(n log n)
+  void Build(const std::vector<Range>& ranges) {
+    std::vector<Node> nodes;
+    nodes.reserve(ranges.size());
+    for (size_t i=0; i<ranges.size(); ++i)
+      nodes.push_back(newNode(ranges[i], i));
+    std::sort(nodes.begin(), nodes.end());
+    levels_.clear();
+    buffer_.clear();
+    next_id_ = ranges.size();
+    setLevel(std::move(nodes));
+  }
+
+  //! @brief  adds range: id is # ranges added before
+  //! @return id of range
+  size_t Insert(const Range& range) {
+    buffer_.push_back(newNode(range, next_id_));
+    if (buffer_.size() >= MIN_BUFFER)
+      carry();
+    return next_id_++;
+  }
+
+  //! @brief  merges levels & buffered ranges into one level: O(n log n)
+  void Compact(void) {
+    size_t num_levels = 0;
+    for (const std::vector<Node>& level : levels_)
+      num_levels += !level.empty();
+    if (buffer_.empty() && num_levels <= 1)
+      return;
+    std::vector<Node> nodes{std::move(buffer_)};
+    buffer_.clear();
+    std::sort(nodes.begin(), nodes.end());
+    for (std::vector<Node>& level : levels_)
+      nodes = merge(std::move(level), std::move(nodes));
+    levels_.clear();
+    setLevel(std::move(nodes));
+  }
+
+  //! @brief  stored ranges overlapping range <from, length>
+  inline Query Overlaps(const Range& range) const {
+    DCHECK_GT(range.second, 0);
+    return Query{this, range.first, static_cast<T>(range.first + range.second)};
+  }
+  //! @brief  stored ranges containing point
+  inline Query Stabs(T point) const {
+    return Overlaps(Range{point, 1});
+  }
+  //! @brief  # stored ranges overlapping range
+  size_t CountOverlaps(const Range& range) const {
+    size_t num = 0;
+    Query  q = Overlaps(range);
+    for (OverlapIter it = q.begin(); it != q.end(); ++it)
+      ++num;
+    return num;
+  }
+
+  inline size_t Size(void) const {
+    size_t num = buffer_.size();
+    for (const std::vector<Node>& level : levels_)
+      num += level.size();
+    return num;
+  }
+  inline size_t MemSize(void) const {
+    size_t num = buffer_.capacity();
+    for (const std::vector<Node>& level : levels_)
+      num += level.capacity();
+    return num*sizeof(Node);
+  }
+
+ private:
+  std::vector<std::vector<Node>> levels_;   // each sorted by from
+  std::vector<Node>              buffer_;   // inserted since last carry
+  size_t                         next_id_ = 0;
+
+  static inline Node newNode(const Range& range, size_t id) {
+    DCHECK_GT(range.second, 0);
+    T end = range.first + range.second;
+    return Node{range.first, end, end, id};
+  }
+
+  static std::vector<Node> merge(std::vector<Node>&& n1,
+                                 std::vector<Node>&& n2) {
+    std::vector<Node> nodes(n1.size() + n2.size());
+    std::merge(n1.begin(), n1.end(), n2.begin(), n2.end(), nodes.begin());
+    n1.clear(); n1.shrink_to_fit();
+    n2.clear(); n2.shrink_to_fit();
+    return nodes;
+  }
+
+  // level i holds about MIN_BUFFER*2^i ranges: sorted nodes go to the
+  // first level at least as large
+  void setLevel(std::vector<Node>&& nodes) {
+    if (nodes.empty())
+      return;
+    size_t i = 0;
+    while ((MIN_BUFFER << i) < nodes.size())
+      ++i;
+    if (levels_.size() <= i)
+      levels_.resize(i + 1);
+    DCHECK(levels_[i].empty());
+    buildMax(&nodes, 0, nodes.size());
+    levels_[i] = std::move(nodes);
+  }
+
+  // sorted buffer ripples up through non empty levels like a binary carry
+  void carry(void) {
+    std::vector<Node> nodes{std::move(buffer_)};
+    buffer_.clear();
+    std::sort(nodes.begin(), nodes.end());
+    size_t i = 0;
+    for (; i < levels_.size() && !levels_[i].empty(); ++i)
+      nodes = merge(std::move(levels_[i]), std::move(nodes));
+    if (levels_.size() <= i)
+      levels_.resize(i + 1);
+    buildMax(&nodes, 0, nodes.size());
+    levels_[i] = std::move(nodes);
+  }
+
+  // max end of subtree [lo, hi) is kept at its root mid
+  static T buildMax(std::vector<Node>* nodes_p, size_t lo, size_t hi) {
+    DCHECK_LT(lo, hi + 1);
+    if (lo == hi)
+      return std::numeric_limits<T>::min();
+    size_t mid = lo + (hi - lo)/2;
+    Node&  n   = (*nodes_p)[mid];
+    n.maxend = std::max(n.end, std::max(buildMax(nodes_p, lo, mid),
+                                        buildMax(nodes_p, mid + 1, hi)));
+    return n.maxend;
+  }
+};
+
+template <typename T>
+constexpr size_t IntervalIndex<T>::MIN_BUFFER;
+template <typename T>
+constexpr size_t IntervalIndex<T>::MAX_DEPTH;
+
+//-----------------------------------------------------------------------------
+} } } // namespace asarcar { namespace utils { namespace math {
+
+#endif // _UTILS_MATH_INTERVAL_INDEX_H_
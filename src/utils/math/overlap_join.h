@@ -0,0 +1,305 @@
+// Copyright 2014 asarcar Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+//! @file     overlap_join.h
+//! @brief    All overlapping pairs of two sets of ranges: sweep line join
+//! @detail   Ranges follow ComputeOverlap's convention: [from, from+length)
+//!           denoted by std::pair<from, length>, length > 0.
+//!           - Both sets are sorted by from into struct of arrays storage:
+//!             from, end & input index are separate arrays.
+//!           - Forward scan sweep: the range starting first among the two
+//!             heads is the driver; every range of the other set starting
+//!             before the driver ends overlaps it. Those are a prefix of
+//!             the other set's from array found with blocks of branch free
+//!             compares that the compiler vectorizes.
+//!             O((n+m) log(n+m) + k) for k overlapping pairs.
+//!           - Parallel variant: pairs are partitioned by the later from of
+//!             the pair using splits sampled from both sets. A partition
+//!             sweeps its own ranges & joins ranges of earlier partitions
+//!             ending inside it (spans) against its own ranges.
+//! @author   Arijit Sarcar <sarcar_a@yahoo.com>
+
+#ifndef _UTILS_MATH_OVERLAP_JOIN_H_
+#define _UTILS_MATH_OVERLAP_JOIN_H_
+
+// C++ Standard Headers
+#include <algorithm>        // std::sort, std::lower_bound, std::upper_bound
+#include <functional>       // std::function
+#include <utility>          // std::pair
+#include <vector>           // std::vector
+// C Standard Headers
+// Google Headers
+#include <glog/logging.h>   // DCHECK
+// Local Headers
+#include "utils/basic/basictypes.h"
+#include "utils/basic/meta.h"
+#include "utils/concur/barrier.h"
+#include "utils/concur/thread_pool.h"
+
+//! Namespace used for all math utility routines developed
+namespace asarcar { namespace utils { namespace math {
+//-----------------------------------------------------------------------------
+
+//! @class    OverlapJoin
+//! @brief    Building blocks of ComputeOverlapJoin
+template <typename T>
+class OverlapJoin {
+  static_assert(IsIntegral<T>() && !IsSame<T, bool>(),
+                "ranges are of integral types");
+ public:
+  using Range = std::pair<T,T>;   // <from, length>
+  using Pool  = concur::ThreadPool<std::function<void(void)>>;
+
+  // compares per branch free block of the inner loop
+  static constexpr size_t BLOCK   = 8;
+  // samples per partition & set picking the partition splits
+  static constexpr size_t SAMPLES = 16;
+
+  //! @class    Ranges
+  //! @brief    Struct of arrays storage of ranges sorted by from
+  struct Ranges {
+    std::vector<T>      from;
+    std::vector<T>      end;    // from + length: exclusive
+    std::vector<size_t> id;     // index of range in input
+
+    Ranges() = default;
+    explicit Ranges(const std::vector<Range>& ranges) { Build(ranges); }
+    void Build(const std::vector<Range>& ranges) {
+      struct Entry {
+        T      from;
+        T      end;
+        size_t id;
+        inline bool operator <(const Entry& o) const { return from < o.from; }
+      };
+      std::vector<Entry> entries;
+      entries.reserve(ranges.size());
+      for (size_t i=0; i<ranges.size(); ++i) {
+        DCHECK_GT(ranges[i].second, 0);
+        entries.push_back(Entry{ranges[i].first,
+                                static_cast<T>(ranges[i].first + ranges[i].second),
+                                i});
+      }
+      std::sort(entries.begin(), entries.end());
+      from.resize(entries.size());
+      end.resize(entries.size());
+      id.resize(entries.size());
+      for (size_t i=0; i<entries.size(); ++i) {
+        from[i] = entries[i].from;
+        end[i]  = entries[i].end;
+        id[i]   = entries[i].id;
+      }
+    }
+    inline size_t Size(void) const { return from.size(); }
+  };
+
+  //! @brief  calls fn(a index, b index) for overlapping pairs of
+  //!         a[alo, ahi) & b[blo, bhi): forward scan sweep
+  //! @return # of pairs
+  template <typename Fn>
+  static size_t Sweep(const Ranges& a, size_t alo, size_t ahi,
+                      const Ranges& b, size_t blo, size_t bhi, const Fn& fn) {
+    size_t num = 0;
+    while (alo < ahi && blo < bhi) {
+      if (a.from[alo] <= b.from[blo]) {
+        size_t len = runLength(b.from.data(), blo, bhi, a.end[alo]);
+        for (size_t k=0; k<len; ++k)
+          fn(a.id[alo], b.id[blo + k]);
+        num += len;
+        ++alo;
+      } else {
+        size_t len = runLength(a.from.data(), alo, ahi, b.end[blo]);
+        for (size_t k=0; k<len; ++k)
+          fn(a.id[alo + k], b.id[blo]);
+        num += len;
+        ++blo;
+      }
+    }
+    return num;
+  }
+
+  //! @brief  calls fn(a index, b index) for overlapping pairs of a[i],
+  //!         i in spans, & b[blo, bhi): a[i] start before b[blo]
+  //! @return # of pairs
+  template <typename Fn>
+  static size_t Span(const Ranges& a, const std::vector<size_t>& spans,
+                     const Ranges& b, size_t blo, size_t bhi, const Fn& fn) {
+    size_t num = 0;
+    for (size_t i : spans) {
+      DCHECK(blo == bhi || a.from[i] < b.from[blo]);
+      size_t len = runLength(b.from.data(), blo, bhi, a.end[i]);
+      for (size_t k=0; k<len; ++k)
+        fn(a.id[i], b.id[blo + k]);
+      num += len;
+    }
+    return num;
+  }
+
+  template <typename Fn>
+  static size_t Run(const std::vector<Range>& ranges_a,
+                    const std::vector<Range>& ranges_b, const Fn& fn) {
+    Ranges a{ranges_a}, b{ranges_b};
+    return Sweep(a, 0, a.Size(), b, 0, b.Size(), fn);
+  }
+
+  template <typename Fn>
+  static size_t Run(const std::vector<Range>& ranges_a,
+                    const std::vector<Range>& ranges_b, const Fn& fn,
+                    Pool* pool_p, size_t num_parts) {
+    if (pool_p == nullptr)
+      return Run(ranges_a, ranges_b, fn);
+    size_t P = (num_parts != 0) ? num_parts : 4*pool_p->NumThreads();
+    P = std::max(P, size_t{1});
+
+    Ranges a, b;
+    forEachPart(pool_p, 2, [&](size_t p) {
+        if (p == 0)
+          a.Build(ranges_a);
+        else
+          b.Build(ranges_b);
+      });
+    if (a.Size() == 0 || b.Size() == 0)
+      return 0;
+
+    // partition p holds ranges starting in [splits[p-1], splits[p])
+    std::vector<T> samples;
+    for (const Ranges* r_p : {&a, &b})
+      for (size_t k=0; k<SAMPLES*P; ++k)
+        samples.push_back(r_p->from[k*r_p->Size()/(SAMPLES*P)]);
+    std::sort(samples.begin(), samples.end());
+    std::vector<T> splits;
+    for (size_t p=1; p<P; ++p)
+      splits.push_back(samples[p*samples.size()/P]);
+    std::vector<size_t> abounds = bounds(a, splits), bbounds = bounds(b, splits);
+
+    // spans[p*P + q]: ranges of partition p overlapping starts in q > p
+    std::vector<std::vector<size_t>> aspans(P*P), bspans(P*P);
+    forEachPart(pool_p, P, [&](size_t p) {
+        findSpans(a, abounds[p], abounds[p+1], splits, p, &aspans);
+        findSpans(b, bbounds[p], bbounds[p+1], splits, p, &bspans);
+      });
+
+    auto rfn = [&fn](size_t ib, size_t ia) { fn(ia, ib); };
+    std::vector<size_t> nums(P);
+    forEachPart(pool_p, P, [&](size_t q) {
+        std::vector<size_t> as, bs;
+        for (size_t p=0; p<q; ++p) {
+          as.insert(as.end(), aspans[p*P + q].begin(), aspans[p*P + q].end());
+          bs.insert(bs.end(), bspans[p*P + q].begin(), bspans[p*P + q].end());
+        }
+        nums[q] = Sweep(a, abounds[q], abounds[q+1],
+                        b, bbounds[q], bbounds[q+1], fn) +
+            Span(a, as, b, bbounds[q], bbounds[q+1], fn) +
+            Span(b, bs, a, abounds[q], abounds[q+1], rfn);
+      });
+    size_t num = 0;
+    for (size_t n : nums)
+      num += n;
+    return num;
+  }
+
+ private:
+  // # of ranges in [lo, hi) starting before e. from is sorted: those form
+  // a prefix. Each block of BLOCK compares has no branch; the first block
+  // not fully before e ends the run.
+  static inline size_t runLength(const T* from, size_t lo, size_t hi, T e) {
+    size_t i = lo;
+    for (; i + BLOCK <= hi; i += BLOCK) {
+      size_t num = 0;
+      for (size_t k=0; k<BLOCK; ++k)
+        num += (from[i + k] < e);
+      if (num != BLOCK)
+        return i + num - lo;
+    }
+    while (i < hi && from[i] < e)
+      ++i;
+    return i - lo;
+  }
+
+  // runs pfn(p) for p in [0, num_parts) on pool & waits for all
+  template <typename PartFn>
+  static void forEachPart(Pool* pool_p, size_t num_parts, const PartFn& pfn) {
+    concur::Latch latch{static_cast<int>(num_parts)};
+    for (size_t p=0; p<num_parts; ++p)
+      pool_p->AddTask([&pfn, &latch, p]() {
+          pfn(p);
+          latch.CountDown();
+        });
+    // latch goes out of scope once Wait returns: safe as Wait returns only
+    // after the last CountDown no longer touches it
+    latch.Wait();
+  }
+
+  // bounds[p]: first range of partition p; bounds[P]: # ranges
+  static std::vector<size_t> bounds(const Ranges& r,
+                                    const std::vector<T>& splits) {
+    std::vector<size_t> bs{0};
+    for (T s : splits)
+      bs.push_back(std::lower_bound(r.from.begin(), r.from.end(), s) -
+                   r.from.begin());
+    bs.push_back(r.Size());
+    return bs;
+  }
+
+  // ranges [lo, hi) of partition p ending past splits[p]: appended to
+  // spans of each later partition starting before the range ends
+  static void findSpans(const Ranges& r, size_t lo, size_t hi,
+                        const std::vector<T>& splits, size_t p,
+                        std::vector<std::vector<size_t>>* spans_p) {
+    size_t P = splits.size() + 1;
+    if (p + 1 == P)
+      return;
+    for (size_t i=lo; i<hi; ++i) {
+      if (!(splits[p] < r.end[i]))
+        continue;
+      // partition of end - 1: # of splits <= end - 1
+      size_t last = std::upper_bound(splits.begin() + p, splits.end(),
+                                     static_cast<T>(r.end[i] - 1)) -
+          splits.begin();
+      for (size_t q=p+1; q<=last; ++q)
+        (*spans_p)[p*P + q].push_back(i);
+    }
+  }
+};
+
+template <typename T>
+constexpr size_t OverlapJoin<T>::BLOCK;
+template <typename T>
+constexpr size_t OverlapJoin<T>::SAMPLES;
+
+//! @brief  calls fn(index in ranges_a, index in ranges_b) for every pair of
+//!         overlapping ranges: ComputeOverlap of the pair has length > 0
+//! @return # of overlapping pairs
+template <typename T, typename Fn>
+EnableIf<(IsIntegral<T>() && !IsSame<T, bool>()), size_t>
+ComputeOverlapJoin(const std::vector<std::pair<T,T>>& ranges_a,
+                   const std::vector<std::pair<T,T>>& ranges_b, const Fn& fn) {
+  return OverlapJoin<T>::Run(ranges_a, ranges_b, fn);
+}
+
+//! @brief  ComputeOverlapJoin on pool_p: fn is called concurrently from
+//!         pool workers. num_parts: # partitions, 4 per worker when 0.
+//!         Blocks the caller: not to be called from a worker of pool_p.
+template <typename T, typename Fn>
+EnableIf<(IsIntegral<T>() && !IsSame<T, bool>()), size_t>
+ComputeOverlapJoin(const std::vector<std::pair<T,T>>& ranges_a,
+                   const std::vector<std::pair<T,T>>& ranges_b, const Fn& fn,
+                   typename OverlapJoin<T>::Pool* pool_p, size_t num_parts = 0) {
+  return OverlapJoin<T>::Run(ranges_a, ranges_b, fn, pool_p, num_parts);
+}
+
+//-----------------------------------------------------------------------------
+} } } // namespace asarcar { namespace utils { namespace math {
+
+#endif // _UTILS_MATH_OVERLAP_JOIN_H_
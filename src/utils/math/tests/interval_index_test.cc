@@ -0,0 +1,245 @@
+// Copyright 2014 asarcar Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Author: Arijit Sarcar <sarcar_a@yahoo.com>
+
+//! @file     interval_index_test.cc
+//! @brief    Tests IntervalIndex against a linear ComputeOverlap scan
+//! @author   Arijit Sarcar <sarcar_a@yahoo.com>
+
+// Standard C++ Headers
+#include <algorithm>        // std::sort
+#include <random>           // std::default_random_engine
+#include <vector>           // std::vector
+// Standard C Headers
+// Google Headers
+#include <glog/logging.h>
+// Local Headers
+#include "utils/basic/basictypes.h"
+#include "utils/basic/clock.h"
+#include "utils/basic/fassert.h"
+#include "utils/basic/init.h"
+#include "utils/math/interval_index.h"
+#include "utils/math/overlap.h"
+
+using namespace asarcar;
+using namespace asarcar::utils;
+using namespace asarcar::utils::math;
+using namespace std;
+
+// Flag Declarations
+DECLARE_bool(auto_test);
+DECLARE_bool(benchmark);
+
+class IntervalIndexTester {
+ public:
+  using Type  = int64_t;
+  using Index = IntervalIndex<Type>;
+  using Range = Index::Range;
+
+  void ZeroEntryTest(void);
+  void BoundaryTest(void);
+  void RandomTest(void);
+  void BenchmarkTest(void);
+ private:
+  static constexpr const char* kUnitStr    = "ns";
+  static constexpr int         kNumRanges  = 4096;
+  static constexpr int         kNumQueries = 1024;
+  static constexpr int         kNumScans   = 16;
+  static constexpr Type        kMaxLen     = 4096;
+
+  // ids of ranges overlapping q: linear ComputeOverlap scan
+  static vector<size_t> LinearScan(const vector<Range>& ranges, const Range& q);
+  // ids of ranges overlapping q: index
+  static vector<size_t> IndexScan(const Index& idx, const Range& q);
+};
+
+constexpr const char* IntervalIndexTester::kUnitStr;
+constexpr int IntervalIndexTester::kNumRanges;
+constexpr int IntervalIndexTester::kNumQueries;
+constexpr int IntervalIndexTester::kNumScans;
+constexpr IntervalIndexTester::Type IntervalIndexTester::kMaxLen;
+
+vector<size_t>
+IntervalIndexTester::LinearScan(const vector<Range>& ranges, const Range& q) {
+  vector<size_t> ids;
+  for (size_t i=0; i<ranges.size(); ++i)
+    if (ComputeOverlap(ranges[i], q).second > 0)
+      ids.push_back(i);
+  return ids;
+}
+
+vector<size_t> IntervalIndexTester::IndexScan(const Index& idx, const Range& q) {
+  vector<size_t> ids;
+  Index::Query   res = idx.Overlaps(q);
+  for (Index::OverlapIter it = res.begin(); it != res.end(); ++it) {
+    CHECK_GT(ComputeOverlap(*it, q).second, 0);
+    ids.push_back(it.Id());
+  }
+  sort(ids.begin(), ids.end());
+  return ids;
+}
+
+void IntervalIndexTester::ZeroEntryTest(void) {
+  Index idx;
+  CHECK_EQ(idx.Size(), 0);
+  CHECK_EQ(idx.CountOverlaps(Range{0, 10}), 0);
+  CHECK(idx.Stabs(0).begin() == idx.Stabs(0).end());
+  idx.Compact();
+  idx.Build(vector<Range>{});
+  CHECK_EQ(idx.CountOverlaps(Range{-10, 20}), 0);
+
+  LOG(INFO) << __FUNCTION__ << " passed";
+}
+
+// Ranges are half open: adjacent ranges do not overlap
+void IntervalIndexTester::BoundaryTest(void) {
+  Index idx;
+  CHECK_EQ(idx.Insert(Range{0, 10}), 0);    // [0, 10)
+  CHECK_EQ(idx.Insert(Range{10, 5}), 1);    // [10, 15)
+  CHECK_EQ(idx.Insert(Range{-20, 100}), 2); // [-20, 80)
+
+  for (int compact=0; compact<2; ++compact) {
+    CHECK((IndexScan(idx, Range{10, 1}) == vector<size_t>{1, 2}));
+    CHECK((IndexScan(idx, Range{9, 1}) == vector<size_t>{0, 2}));
+    CHECK((IndexScan(idx, Range{9, 2}) == vector<size_t>{0, 1, 2}));
+    CHECK((IndexScan(idx, Range{-30, 10}) == vector<size_t>{}));
+    CHECK((IndexScan(idx, Range{-30, 11}) == vector<size_t>{2}));
+    CHECK_EQ(idx.CountOverlaps(Range{80, 1}), 0);
+    CHECK_EQ(idx.Stabs(-5).begin().Id(), 2);
+    CHECK((*idx.Stabs(-20).begin() == Range{-20, 100}));
+    idx.Compact();
+  }
+
+  LOG(INFO) << __FUNCTION__ << " passed";
+}
+
+// Inserted (buffered & merged) and built indices agree with linear scan
+void IntervalIndexTester::RandomTest(void) {
+  default_random_engine          gen{};
+  uniform_int_distribution<Type> from{-kNumRanges*kMaxLen/4,
+                                      kNumRanges*kMaxLen/4};
+  uniform_int_distribution<Type> len{1, kMaxLen};
+  vector<Range> ranges;
+  Index         idx;
+  for (int i=0; i<kNumRanges; ++i) {
+    // long ranges span many others: exercises pruning by max end
+    Type l = (i % 64 == 0) ? 64*len(gen) : len(gen);
+    ranges.push_back(Range{from(gen), l});
+    CHECK_EQ(idx.Insert(ranges.back()), i);
+    if (i % (kNumRanges/16) == 0) {
+      Range q{from(gen), len(gen)};
+      CHECK(IndexScan(idx, q) == LinearScan(ranges, q));
+    }
+  }
+  CHECK_EQ(idx.Size(), kNumRanges);
+
+  Index built;
+  built.Build(ranges);
+  size_t num = 0;
+  for (int i=0; i<kNumQueries/4; ++i) {
+    Range          q{from(gen), (i % 2) ? Type{1} : len(gen)};
+    vector<size_t> ids = LinearScan(ranges, q);
+    CHECK(IndexScan(idx, q) == ids);
+    CHECK(IndexScan(built, q) == ids);
+    num += ids.size();
+  }
+  // queries do see overlaps
+  CHECK_GT(num, kNumQueries/4);
+
+  LOG(INFO) << __FUNCTION__ << " passed";
+}
+
+// IntervalIndex vs linear scan: 10^4 to 4*10^6 memory regions. Build &
+// insert per range, overlap & stabbing query: ns per op. The scans run the
+// first kNumScans queries: via ComputeOverlap & via plain compares.
+void IntervalIndexTester::BenchmarkTest(void) {
+  default_random_engine gen{};
+  for (Type num_ranges : {10000, 100000, 1000000, 4000000}) {
+    uniform_int_distribution<Type> from{0, num_ranges*kMaxLen};
+    uniform_int_distribution<Type> len{1, kMaxLen};
+    vector<Range> ranges, queries;
+    for (Type i=0; i<num_ranges; ++i)
+      ranges.push_back(Range{from(gen), len(gen)});
+    for (int i=0; i<kNumQueries; ++i)
+      queries.push_back(Range{from(gen), len(gen)});
+
+    Clock::TimeDuration dur[6] = {};
+    Clock::TimePoint    now = Clock::USecs();
+    Index               built;
+    built.Build(ranges);
+    dur[0] = Clock::USecs() - now;
+    now = Clock::USecs();
+    Index inserted;
+    for (const Range& r : ranges)
+      inserted.Insert(r);
+    dur[1] = Clock::USecs() - now;
+
+    size_t num[5] = {};
+    now = Clock::USecs();
+    for (const Range& q : queries)
+      num[0] += inserted.CountOverlaps(q);
+    dur[2] = Clock::USecs() - now;
+    now = Clock::USecs();
+    for (const Range& q : queries)
+      num[1] += inserted.CountOverlaps(Range{q.first, 1});
+    dur[3] = Clock::USecs() - now;
+    for (int i=0; i<kNumScans; ++i)
+      num[2] += built.CountOverlaps(queries[i]);
+    now = Clock::USecs();
+    for (int i=0; i<kNumScans; ++i)
+      for (const Range& r : ranges)
+        num[3] += (ComputeOverlap(r, queries[i]).second > 0);
+    dur[4] = Clock::USecs() - now;
+    now = Clock::USecs();
+    for (int i=0; i<kNumScans; ++i) {
+      Type a = queries[i].first, b = a + queries[i].second;
+      for (const Range& r : ranges)
+        num[4] += (r.first < b && a < r.first + r.second);
+    }
+    dur[5] = Clock::USecs() - now;
+    CHECK_EQ(num[2], num[3]);
+    CHECK_EQ(num[2], num[4]);
+
+    LOG(INFO) << "IntervalIndex: " << num_ranges << " ranges: build/insert = "
+              << dur[0]*1000/num_ranges << "/" << dur[1]*1000/num_ranges
+              << kUnitStr << " overlap/stab query = "
+              << dur[2]*1000/kNumQueries << "/" << dur[3]*1000/kNumQueries
+              << kUnitStr << " (" << num[0]/kNumQueries << "/"
+              << num[1]/kNumQueries << " per query) mem = "
+              << inserted.MemSize()/num_ranges << "B per range";
+    LOG(INFO) << "Linear scan: " << num_ranges
+              << " ranges: ComputeOverlap/compare query = "
+              << dur[4]*1000/kNumScans << "/" << dur[5]*1000/kNumScans
+              << kUnitStr;
+  }
+}
+
+int main(int argc, char **argv) {
+  Init::InitEnv(&argc, &argv);
+
+  IntervalIndexTester it;
+  it.ZeroEntryTest();
+  it.BoundaryTest();
+  it.RandomTest();
+  if (FLAGS_benchmark)
+    it.BenchmarkTest();
+
+  return 0;
+}
+
+DEFINE_bool(auto_test, false,
+            "test run programmatically (when true) or manually (when false)");
+DEFINE_bool(benchmark, false,
+            "test run when benchmarking IntervalIndex vs ComputeOverlap scan");
@@ -0,0 +1,248 @@
+// Copyright 2014 asarcar Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Author: Arijit Sarcar <sarcar_a@yahoo.com>
+
+//! @file     overlap_join_test.cc
+//! @brief    Tests ComputeOverlapJoin against pairwise ComputeOverlap
+//! @author   Arijit Sarcar <sarcar_a@yahoo.com>
+
+// Standard C++ Headers
+#include <algorithm>        // std::sort
+#include <mutex>            // std::mutex
+#include <random>           // std::default_random_engine
+#include <utility>          // std::pair
+#include <vector>           // std::vector
+// Standard C Headers
+// Google Headers
+#include <glog/logging.h>
+// Local Headers
+#include "utils/basic/basictypes.h"
+#include "utils/basic/clock.h"
+#include "utils/basic/fassert.h"
+#include "utils/basic/init.h"
+#include "utils/concur/thread_pool.h"
+#include "utils/math/overlap.h"
+#include "utils/math/overlap_join.h"
+
+using namespace asarcar;
+using namespace asarcar::utils;
+using namespace asarcar::utils::concur;
+using namespace asarcar::utils::math;
+using namespace std;
+
+// Flag Declarations
+DECLARE_bool(auto_test);
+DECLARE_bool(benchmark);
+
+class OverlapJoinTester {
+ public:
+  using Type   = int64_t;
+  using Range  = pair<Type,Type>;
+  using Ranges = vector<Range>;
+  using Pairs  = vector<pair<size_t,size_t>>;
+
+  void ZeroEntryTest(void);
+  void BoundaryTest(void);
+  void RandomTest(void);
+  void PoolRepeatTest(void);
+  void BenchmarkTest(void);
+ private:
+  static constexpr const char* kUnitStr    = "ns";
+  static constexpr int         kNumThreads = 4;
+  static constexpr int         kNumRangesA = 1024;
+  static constexpr int         kNumRangesB = 768;
+  static constexpr Type        kMaxLen     = 4096;
+  static constexpr int         kNumScans   = 4;
+  static constexpr int         kNumRepeats = 512;
+
+  // overlapping pairs: pairwise ComputeOverlap
+  static Pairs PairwiseJoin(const Ranges& a, const Ranges& b);
+  // overlapping pairs: sorted ComputeOverlapJoin on pool_p when set
+  static Pairs Join(const Ranges& a, const Ranges& b,
+                    ThreadPool<>* pool_p = nullptr, size_t num_parts = 0);
+};
+
+constexpr const char* OverlapJoinTester::kUnitStr;
+constexpr int OverlapJoinTester::kNumThreads;
+constexpr int OverlapJoinTester::kNumRangesA;
+constexpr int OverlapJoinTester::kNumRangesB;
+constexpr OverlapJoinTester::Type OverlapJoinTester::kMaxLen;
+constexpr int OverlapJoinTester::kNumScans;
+constexpr int OverlapJoinTester::kNumRepeats;
+
+OverlapJoinTester::Pairs
+OverlapJoinTester::PairwiseJoin(const Ranges& a, const Ranges& b) {
+  Pairs pairs;
+  for (size_t i=0; i<a.size(); ++i)
+    for (size_t j=0; j<b.size(); ++j)
+      if (ComputeOverlap(a[i], b[j]).second > 0)
+        pairs.push_back({i, j});
+  return pairs;
+}
+
+OverlapJoinTester::Pairs
+OverlapJoinTester::Join(const Ranges& a, const Ranges& b,
+                        ThreadPool<>* pool_p, size_t num_parts) {
+  Pairs pairs;
+  mutex m;
+  auto  fn = [&pairs, &m](size_t i, size_t j) {
+    lock_guard<mutex> lg{m};
+    pairs.push_back({i, j});
+  };
+  size_t num = (pool_p == nullptr) ? ComputeOverlapJoin(a, b, fn) :
+      ComputeOverlapJoin(a, b, fn, pool_p, num_parts);
+  CHECK_EQ(num, pairs.size());
+  sort(pairs.begin(), pairs.end());
+  return pairs;
+}
+
+void OverlapJoinTester::ZeroEntryTest(void) {
+  ThreadPool<> pool{kNumThreads};
+  Ranges       a{{0, 10}};
+  CHECK(Join(Ranges{}, Ranges{}).empty());
+  CHECK(Join(a, Ranges{}).empty());
+  CHECK(Join(Ranges{}, a).empty());
+  CHECK(Join(Ranges{}, a, &pool).empty());
+  CHECK_EQ(Join(a, a, &pool, 8).size(), 1);
+
+  LOG(INFO) << __FUNCTION__ << " passed";
+}
+
+// Ranges are half open: adjacent ranges do not overlap. Equal starts,
+// nesting & ranges spanning every partition.
+void OverlapJoinTester::BoundaryTest(void) {
+  ThreadPool<> pool{kNumThreads};
+  Ranges a{{0, 10}, {10, 5}, {-20, 100}, {40, 1}};
+  Ranges b{{10, 1}, {0, 1}, {-30, 10}, {39, 2}, {-20, 1}, {79, 10}};
+  Pairs  ref{{0, 1}, {1, 0}, {2, 0}, {2, 1}, {2, 3}, {2, 4}, {2, 5},
+             {3, 3}};
+  CHECK(PairwiseJoin(a, b) == ref);
+  CHECK(Join(a, b) == ref);
+  for (size_t num_parts : {1, 2, 3, 7, 64})
+    CHECK(Join(a, b, &pool, num_parts) == ref);
+
+  LOG(INFO) << __FUNCTION__ << " passed";
+}
+
+// Sequential & partitioned joins agree with pairwise ComputeOverlap
+void OverlapJoinTester::RandomTest(void) {
+  default_random_engine          gen{};
+  uniform_int_distribution<Type> from{-kNumRangesA*kMaxLen/8,
+                                      kNumRangesA*kMaxLen/8};
+  uniform_int_distribution<Type> len{1, kMaxLen};
+  Ranges a, b;
+  // long ranges span many partitions; repeated starts tie across sets
+  for (int i=0; i<kNumRangesA; ++i)
+    a.push_back(Range{from(gen), (i % 64 == 0) ? 64*len(gen) : len(gen)});
+  for (int i=0; i<kNumRangesB; ++i)
+    b.push_back((i % 16 == 0) ? Range{a[i].first, len(gen)} :
+                Range{from(gen), (i % 64 == 1) ? 64*len(gen) : len(gen)});
+
+  Pairs ref = PairwiseJoin(a, b);
+  CHECK_GT(ref.size(), kNumRangesA);
+  CHECK(Join(a, b) == ref);
+  ThreadPool<> pool{kNumThreads};
+  for (size_t num_parts : {0, 1, 3, 16, 100})
+    CHECK(Join(a, b, &pool, num_parts) == ref);
+
+  LOG(INFO) << __FUNCTION__ << " passed";
+}
+
+// Many short joins on a pool: the join latch of every call goes out of
+// scope right after the wait while workers count down
+void OverlapJoinTester::PoolRepeatTest(void) {
+  ThreadPool<> pool{kNumThreads};
+  Ranges       a{{0, 10}, {10, 5}, {-20, 100}, {40, 1}};
+  Ranges       b{{10, 1}, {0, 1}, {-30, 10}, {39, 2}, {-20, 1}, {79, 10}};
+  Pairs        ref = PairwiseJoin(a, b);
+  for (int i=0; i<kNumRepeats; ++i)
+    CHECK(Join(a, b, &pool, 1 + i % kNumThreads) == ref);
+
+  LOG(INFO) << __FUNCTION__ << " passed";
+}
+
+// ComputeOverlapJoin sequential & on a ThreadPool vs pairwise scan:
+// 10^4 x 10^4 to 10^6 x 10^6 regions (allocation log vs free regions).
+// Join: ns per input range. Pairwise: kNumScans ranges of a against all
+// of b via ComputeOverlap & via plain compares: ns per pair.
+void OverlapJoinTester::BenchmarkTest(void) {
+  default_random_engine gen{};
+  ThreadPool<>          pool{};
+  for (Type num_ranges : {10000, 100000, 1000000}) {
+    uniform_int_distribution<Type> from{0, num_ranges*kMaxLen};
+    uniform_int_distribution<Type> len{1, kMaxLen};
+    Ranges a, b;
+    for (Type i=0; i<num_ranges; ++i) {
+      a.push_back(Range{from(gen), len(gen)});
+      b.push_back(Range{from(gen), len(gen)});
+    }
+
+    Clock::TimeDuration dur[4] = {};
+    size_t              num[4] = {};
+    size_t              sum = 0;
+    auto                fn = [&sum](size_t i, size_t j) { sum += i ^ j; };
+    Clock::TimePoint    now = Clock::USecs();
+    num[0] = ComputeOverlapJoin(a, b, fn);
+    dur[0] = Clock::USecs() - now;
+    now = Clock::USecs();
+    num[1] = ComputeOverlapJoin(a, b, [](size_t, size_t) {}, &pool);
+    dur[1] = Clock::USecs() - now;
+    CHECK_EQ(num[0], num[1]);
+    now = Clock::USecs();
+    for (int i=0; i<kNumScans; ++i)
+      for (const Range& r : b)
+        num[2] += (ComputeOverlap(a[i], r).second > 0);
+    dur[2] = Clock::USecs() - now;
+    now = Clock::USecs();
+    for (int i=0; i<kNumScans; ++i) {
+      Type s = a[i].first, e = s + a[i].second;
+      for (const Range& r : b)
+        num[3] += (r.first < e && s < r.first + r.second);
+    }
+    dur[3] = Clock::USecs() - now;
+    CHECK_EQ(num[2], num[3]);
+
+    LOG(INFO) << "ComputeOverlapJoin: " << num_ranges << " x " << num_ranges
+              << " ranges: " << num[0] << " pairs (sum " << sum
+              << "): sequential/pool of " << pool.NumThreads() << " = "
+              << dur[0]*1000/(2*num_ranges) << "/"
+              << dur[1]*1000/(2*num_ranges) << kUnitStr << " per range ("
+              << dur[0]/1000 << "/" << dur[1]/1000 << "ms)";
+    LOG(INFO) << "Pairwise scan: ComputeOverlap/compare = "
+              << dur[2]*1000.0/(kNumScans*num_ranges) << "/"
+              << dur[3]*1000.0/(kNumScans*num_ranges) << kUnitStr
+              << " per pair (" << dur[3]*1.0*num_ranges/kNumScans/1000000
+              << "s for all pairs via compare)";
+  }
+}
+
+int main(int argc, char **argv) {
+  Init::InitEnv(&argc, &argv);
+
+  OverlapJoinTester ot;
+  ot.ZeroEntryTest();
+  ot.BoundaryTest();
+  ot.RandomTest();
+  ot.PoolRepeatTest();
+  if (FLAGS_benchmark)
+    ot.BenchmarkTest();
+
+  return 0;
+}
+
+DEFINE_bool(auto_test, false,
+            "test run programmatically (when true) or manually (when false)");
+DEFINE_bool(benchmark, false,
+            "test run when benchmarking ComputeOverlapJoin vs pairwise scan");
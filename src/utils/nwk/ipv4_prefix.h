@@ -45,6 +45,7 @@ class IPv4Prefix {
   // Destructor and other ctors and = on both lvalue and rvalue reference
 
   inline size_t size(void) const { return len_; }
+  inline IPv4 ip(void) const { return ip_; }
 
   // We only support resizing to smaller values
   inline void resize(int len) { 
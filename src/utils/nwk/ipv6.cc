@@ -0,0 +1,51 @@
+// Copyright 2015 asarcar Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Author: Arijit Sarcar <sarcar_a@yahoo.com>
+
+// Standard C++ Headers
+// Standard C Headers
+#include <climits>          // CHAR_BIT
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+// Google Headers
+// Local Headers
+#include "utils/nwk/ipv6.h"
+
+using namespace std;
+
+namespace asarcar { namespace utils { namespace nwk {
+//-----------------------------------------------------------------------------
+
+IPv6::IPv6(const char* str) : addr_{0} {
+  in6_addr inaddr;
+  CHECK_EQ(inet_pton(AF_INET6, str, &inaddr), 1)
+      << "Badly formatted IPv6 address " << str;
+  for (uint8_t byte : inaddr.s6_addr)
+    addr_ = (addr_ << CHAR_BIT) | byte;
+}
+
+std::string IPv6::to_string(void) const {
+  in6_addr  inaddr;
+  uint128_t addr = addr_;
+  for (int i=sizeof(inaddr.s6_addr)-1; i>=0; --i, addr >>= CHAR_BIT)
+    inaddr.s6_addr[i] = static_cast<uint8_t>(addr);
+  char str[INET6_ADDRSTRLEN];
+  CHECK(inet_ntop(AF_INET6, &inaddr, str, sizeof(str)) != nullptr);
+  return str;
+}
+
+//-----------------------------------------------------------------------------
+} } } // namespace asarcar { namespace utils { namespace nwk {
@@ -0,0 +1,95 @@
+// Copyright 2015 asarcar Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+//! @file     ipv6.h
+//! @brief    Thin wrapper over IPv6 Address.
+//! @details  Wrapper for IPv6 with utility APIs. Address is a 128 bit
+//!           integer in host endian order i.e. bit operations (shift,
+//!           mask, clz) work on whole address as they do for IPv4.
+//!           NOT internally synchronized for Thread Safety.
+
+//! @author   Arijit Sarcar <sarcar_a@yahoo.com>
+
+#ifndef _UTILS_NWK_IPV6_H_
+#define _UTILS_NWK_IPV6_H_
+
+// C++ Standard Headers
+#include <iostream>
+// C Standard Headers
+// Google Headers
+#include <glog/logging.h>
+// Local Headers
+#include "utils/basic/basictypes.h"
+#include "utils/basic/int128_templates.h"
+
+namespace asarcar { namespace utils { namespace nwk {
+//-----------------------------------------------------------------------------
+class IPv6 {
+ public:
+  constexpr static int      MAX_LEN         = 128; // length of v6 bit stream
+
+  // address passed in host endian order
+  explicit IPv6(uint128_t addr=0) : addr_{addr} {}
+  explicit IPv6(const char* str);
+  // Pass rvalue reference for efficiency
+  explicit IPv6(std::string str) : IPv6{str.c_str()} {}
+  // Destructor and other ctors and = on both lvalue and rvalue reference
+
+  // Address from 64 bit halves in host endian order
+  static inline IPv6 FromHalves(uint64_t hi, uint64_t lo) {
+    return IPv6{(static_cast<uint128_t>(hi) << 64) | lo};
+  }
+
+  // reduce the effective number of non-zero symbols in the IP address
+  inline void resize(uint128_t addr) { 
+    DCHECK(((addr_ | addr) == addr_) && ((addr_ & addr) == addr));
+    addr_ = addr;
+  }
+
+  // Equality Check Operators
+  inline bool operator ==(const IPv6& other) const {
+    return (to_scalar() == other.to_scalar());
+  }
+  inline bool operator !=(const IPv6& other) const {
+    return !operator==(other);
+  }
+
+  // True when 'n'th (0 < n < MAX_LEN) most significant bit is 1
+  inline bool operator [](int n) const {
+    DCHECK(n >= 0 && n < MAX_LEN);
+    return (((addr_ >> (MAX_LEN - 1 - n)) & 1) != 0);
+  }
+
+  // LoopBack Interface: ::1
+  inline bool IsLoopbackAddress(void) const { return (addr_ == 1); }
+  
+  // cast operator to uint128_t
+  inline uint128_t to_scalar(void) const { return addr_; }
+
+  // cast operator to string: RFC 5952 format
+  std::string to_string(void) const;
+
+ private:
+  uint128_t addr_; // stored in host endian order
+};
+
+inline std::ostream& operator << (std::ostream& os, const IPv6& ipv6) { 
+  os << ipv6.to_string(); 
+  return os;
+}
+//-----------------------------------------------------------------------------
+} } } // namespace asarcar { namespace utils { namespace nwk {
+
+#endif // _UTILS_NWK_IPV6_H_
@@ -0,0 +1,61 @@
+// Copyright 2015 asarcar Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Author: Arijit Sarcar <sarcar_a@yahoo.com>
+
+// Standard C++ Headers
+#include <algorithm>    // std::min
+// Standard C Headers
+// Google Headers
+// Local Headers
+#include "utils/nwk/ipv6_prefix.h"
+
+using namespace std;
+
+namespace asarcar { namespace utils { namespace nwk {
+//-----------------------------------------------------------------------------
+
+IPv6Prefix IPv6Prefix::substr(int begin, int runlen) const {
+  DCHECK(begin >= 0);
+  DCHECK((runlen >= 0) && ((begin + runlen) <= len_));
+  if (runlen == 0)
+    return IPv6Prefix{};
+  uint128_t addr = ip_.to_scalar();
+  return IPv6Prefix{addr << begin, runlen};
+}
+
+IPv6Prefix& IPv6Prefix::operator +=(const IPv6Prefix& other) {
+  DCHECK((len_ + other.len_) <= IPv6::MAX_LEN);
+  if (other.len_ == 0)
+    return *this;
+  uint128_t addr1  = ip_.to_scalar();
+  uint128_t addr2  = other.ip_.to_scalar();
+  ip_= IPv6{addr1 | (addr2 >> len_)};
+  len_ += other.len_;
+  return *this;
+}
+
+IPv6Prefix IPv6Prefix::prefix(const IPv6Prefix& other) const {
+  uint128_t addr1  = ip_.to_scalar();
+  uint128_t addr2  = other.ip_.to_scalar();
+  int       len    = std::min(Clz(addr1 ^ addr2), std::min(len_, other.len_));
+  if (len == len_)
+    return *this;
+  if (len == other.len_)
+    return other;
+  return IPv6Prefix{addr1, len};
+}
+
+//-----------------------------------------------------------------------------
+} } } // namespace asarcar { namespace utils { namespace nwk {
@@ -0,0 +1,116 @@
+// Copyright 2015 asarcar Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+//! @file     ipv6_prefix.h
+//! @brief    IPv6 prefix: key type of RadixTrie (refer IPv4Prefix).
+//! @details  Bit string operations (substr, concatenation, common prefix)
+//!           are 128 bit shifts & masks. Common prefix counts leading zero
+//!           bits (clz) of the XOR of the addresses i.e. no per bit loop.
+//!           NOT internally synchronized for Thread Safety.
+
+//! @author   Arijit Sarcar <sarcar_a@yahoo.com>
+
+#ifndef _UTILS_NWK_IPV6_PREFIX_H_
+#define _UTILS_NWK_IPV6_PREFIX_H_
+
+// C++ Standard Headers
+#include <string>       // to_string(int)
+// C Standard Headers
+// Google Headers
+#include <glog/logging.h>
+// Local Headers
+#include "utils/nwk/ipv6.h"
+
+namespace asarcar { namespace utils { namespace nwk {
+//-----------------------------------------------------------------------------
+class IPv6Prefix {
+ public:
+  IPv6Prefix(uint128_t addr=0, int len=0) :ip_{addr & GetMask(len)},len_{len} {
+    DCHECK(len_ >= 0 && len_ <= IPv6::MAX_LEN);
+  }
+  IPv6Prefix(IPv6 ip, int len = 0): IPv6Prefix{ip.to_scalar(), len} {}
+  IPv6Prefix(const char* s, int len) : IPv6Prefix{IPv6{s}, len} {}
+  IPv6Prefix(std::string str, int len) : IPv6Prefix{IPv6{str}, len} {}
+  // Destructor and other ctors and = on both lvalue and rvalue reference
+
+  inline size_t size(void) const { return len_; }
+  inline IPv6 ip(void) const { return ip_; }
+
+  // We only support resizing to smaller values
+  inline void resize(int len) { 
+    DCHECK(len <= len_);
+    ip_.resize(ip_.to_scalar() & GetMask(len));
+    len_ = len;
+  }
+
+  // Substr operator returns an equivalent IPv6 Prefix address but only 
+  // with bits in the [begin, begin + len) range.
+  IPv6Prefix substr(int begin, int runlen) const;
+
+  // Equality Check Operators
+  inline bool operator ==(const IPv6Prefix& other) const {
+    return ((ip_ == other.ip_) && (len_ == other.len_));
+  }
+  inline bool operator !=(const IPv6Prefix& other) const {
+    return !operator==(other);
+  }
+
+  // True when 'n'th (0 < n < prefix length) most significant bit is 1
+  inline bool operator [](int n) const {
+    DCHECK_GE(n, 0); DCHECK_LT(n, len_);
+    return ip_[n];
+  }
+
+  // Concatenates the bit strings of host prefix class to the
+  // one passed in argument and creates a new prefix string
+  inline IPv6Prefix operator +(const IPv6Prefix& other) const {
+    return IPv6Prefix{*this}.operator+=(other);
+  }
+
+  // Concatenates other to this and returns this
+  IPv6Prefix& operator +=(const IPv6Prefix& other);
+
+  // Returns the common prefix substring as compared to argument
+  IPv6Prefix prefix(const IPv6Prefix& other) const;
+
+  inline std::string to_string(bool debug=false) const { 
+    return ip_.to_string() + "/" + std::to_string(len_);
+  }
+
+ private:
+  IPv6  ip_;
+  int   len_;
+  static inline uint128_t GetMask(int runlen) {
+    DCHECK(runlen <= IPv6::MAX_LEN);
+    // shift by the width of the type is undefined
+    return ((runlen == 0) ? 0 : (~uint128_t{0} << (IPv6::MAX_LEN - runlen)));
+  }
+  // # leading zero bits: MAX_LEN when x is 0
+  static inline int Clz(uint128_t x) {
+    uint64_t hi = static_cast<uint64_t>(x >> 64);
+    uint64_t lo = static_cast<uint64_t>(x);
+    return (hi != 0) ? __builtin_clzll(hi) :
+        ((lo != 0) ? 64 + __builtin_clzll(lo) : IPv6::MAX_LEN);
+  }
+};
+
+inline std::ostream& operator << (std::ostream& os, const IPv6Prefix& pref) {
+  os << pref.to_string(); 
+  return os;
+}
+//-----------------------------------------------------------------------------
+} } } // namespace asarcar { namespace utils { namespace nwk {
+
+#endif // _UTILS_NWK_IPV6_PREFIX_H_
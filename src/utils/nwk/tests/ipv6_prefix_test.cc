@@ -0,0 +1,107 @@
+// Copyright 2015 asarcar Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Author: Arijit Sarcar <sarcar_a@yahoo.com>
+// Standard C++ Headers
+// Standard C Headers
+// Google Headers
+#include <glog/logging.h>   
+// Local Headers
+#include "utils/basic/init.h"
+#include "utils/nwk/ipv6_prefix.h"
+
+using namespace asarcar;
+using namespace asarcar::utils;
+using namespace asarcar::utils::nwk;
+using namespace std;
+
+// Declarations
+DECLARE_bool(auto_test);
+
+class IPv6PrefixTest {
+ public:
+  IPv6PrefixTest()  = default;
+  ~IPv6PrefixTest() = default;
+
+  void   Test(void);
+  // Prefixes crossing the 64 bit halves & of length 0 and 128
+  void   EdgeTest(void);
+ private:
+};
+
+void IPv6PrefixTest::Test() {
+  IPv6Prefix pref{"2001:db8:1234::1", 48};
+  
+  CHECK(pref.size() == 48);
+  CHECK_EQ(pref.to_string(), "2001:db8:1234::/48");
+  CHECK((pref.substr(16, 16) == IPv6Prefix{"db8::", 16}));
+  CHECK((pref.substr(0,16) + pref.substr(16,32)) == pref);
+  CHECK((pref.substr(0,4) += pref.substr(4,44)) == pref);
+
+  CHECK(!pref[0]);
+  CHECK(pref[2]);
+  CHECK(pref[45]);
+  CHECK(!pref[47]);
+
+  CHECK((pref.prefix(IPv6Prefix{"2001:db8:1234:5::", 64}) == pref));
+  CHECK((pref.prefix(IPv6Prefix{"2001:db8:1234::", 48}) == pref));
+  CHECK((pref.prefix(IPv6Prefix{"2001:db8:1234::", 32}) ==
+         IPv6Prefix{"2001:db8::", 32}));
+  CHECK((pref.prefix(IPv6Prefix{"2001:db8:1334::", 48}) ==
+         IPv6Prefix{"2001:db8:1200::", 39}));
+
+  pref.resize(32);
+  CHECK((pref == IPv6Prefix{"2001:db8::", 32}));
+}
+
+void IPv6PrefixTest::EdgeTest() {
+  IPv6Prefix all{"::", 0};
+  IPv6Prefix host{"2001:db8::ffff:1", 128};
+  IPv6Prefix p64{"2001:db8::", 64};
+
+  CHECK(all.size() == 0);
+  CHECK((host.prefix(all) == all));
+  CHECK((all.prefix(host) == all));
+  CHECK((host.prefix(host) == host));
+  CHECK((host.prefix(p64) == p64));
+  CHECK((host.prefix(IPv6Prefix{"2001:db8::ffff:0", 128}) ==
+         IPv6Prefix{"2001:db8::ffff:0", 127}));
+  CHECK((host.prefix(IPv6Prefix{"2001:db8::1:ffff:1", 128}) ==
+         IPv6Prefix{"2001:db8::", 95}));
+
+  CHECK((host.substr(0, 0) == all));
+  CHECK((host.substr(128, 0) == all));
+  CHECK((host.substr(64, 64) == IPv6Prefix{"0:0:ffff:1::", 64}));
+  CHECK((host.substr(0, 64) + host.substr(64, 64)) == host);
+  CHECK((host.substr(0, 70) + host.substr(70, 58)) == host);
+  CHECK((IPv6Prefix{host} += all) == host);
+  CHECK((IPv6Prefix{all} += host) == host);
+  CHECK(host[127]);
+  CHECK(!host[126]);
+  CHECK(host[111]);
+  CHECK(!host[112]);
+}
+
+int main(int argc, char *argv[]) {
+  Init::InitEnv(&argc, &argv);
+
+  IPv6PrefixTest test{};
+  test.Test();
+  test.EdgeTest();
+
+  return 0;
+}
+
+DEFINE_bool(auto_test, false, 
+            "test run programmatically (when true) or manually (when false)");
@@ -0,0 +1,76 @@
+// Copyright 2015 asarcar Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Author: Arijit Sarcar <sarcar_a@yahoo.com>
+// Standard C++ Headers
+// Standard C Headers
+// Google Headers
+#include <glog/logging.h>   
+// Local Headers
+#include "utils/basic/init.h"
+#include "utils/nwk/ipv6.h"
+
+using namespace asarcar;
+using namespace asarcar::utils;
+using namespace asarcar::utils::nwk;
+using namespace std;
+
+// Declarations
+DECLARE_bool(auto_test);
+
+class IPv6Test {
+ public:
+  IPv6Test()  = default;
+  ~IPv6Test() = default;
+
+  void   Test(void);
+ private:
+};
+
+void IPv6Test::Test() {
+  const char *s = "2001:db8::ff00:42:8329";
+  IPv6 a{IPv6::FromHalves(0x20010DB800000000ULL, 0x0000FF0000428329ULL)};
+  IPv6 b{s};
+  IPv6 c{string(s)};
+
+  CHECK(a == b);
+  CHECK(a == c);
+  CHECK(a != IPv6{});
+  CHECK_EQ(a.to_string(), s);
+  CHECK_EQ(IPv6{}.to_string(), "::");
+
+  IPv6 lo{"::1"};
+  CHECK(lo.IsLoopbackAddress());
+  CHECK(!a.IsLoopbackAddress());
+
+  CHECK(!a[0]);
+  CHECK(a[2]);
+  CHECK(a[15]);
+  CHECK(!a[16]);
+  CHECK(a[127]);
+  CHECK(lo[127]);
+  CHECK(!lo[126]);
+}
+
+int main(int argc, char *argv[]) {
+  Init::InitEnv(&argc, &argv);
+
+  IPv6Test test{};
+  test.Test();
+
+  return 0;
+}
+
+DEFINE_bool(auto_test, false, 
+            "test run programmatically (when true) or manually (when false)");